@@ -19,9 +19,19 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
             }
         }
 
-        // 处理target list，再target list中添加上表名，例如 a.id
+        // 处理target list，再target list中添加上表名，例如 a.id；聚合函数的输出列以函数的写法为名，例如 SUM(score)
+        std::vector<bool> is_agg;
         for (auto &sv_sel_col : x->cols) {
             TabCol sel_col = {.tab_name = sv_sel_col->tab_name, .col_name = sv_sel_col->col_name};
+            auto sv_agg = std::dynamic_pointer_cast<ast::AggCol>(sv_sel_col);
+            if (sv_agg) {
+                AggExpr agg = {.type = convert_sv_agg_func(sv_agg->func), .arg = sel_col};
+                std::string arg_name = sel_col.tab_name.empty() ? sel_col.col_name : sel_col.tab_name + '.' + sel_col.col_name;
+                agg.output = {.tab_name = "", .col_name = agg2str(agg.type) + '(' + arg_name + ')'};
+                query->aggs.push_back(agg);
+                sel_col = agg.output;
+            }
+            is_agg.push_back(sv_agg != nullptr);
             query->cols.push_back(sel_col);
         }
         // auto all_cols = get_all_cols(query->tables);
@@ -32,16 +42,31 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
             for (auto &col : all_cols) {
                 TabCol sel_col = {.tab_name = col.tab_name, .col_name = col.name};
                 query->cols.push_back(sel_col);
+                is_agg.push_back(false);
             }
         } else {
             // infer table name from column name
-            for (auto &sel_col : query->cols) {
-                sel_col = check_column(all_cols, sel_col);  // 列元数据校验
+            for (size_t i = 0; i < query->cols.size(); i++) {
+                if (!is_agg[i]) {
+                    query->cols[i] = check_column(all_cols, query->cols[i]);  // 列元数据校验
+                }
             }
         }
+        for (auto &sv_group_col : x->group_cols) {
+            TabCol group_col = {.tab_name = sv_group_col->tab_name, .col_name = sv_group_col->col_name};
+            query->group_cols.push_back(check_column(all_cols, group_col));
+        }
+        check_aggregate(all_cols, is_agg, query);
         //处理where条件
         get_clause(x->conds, query->conds);
         check_clause(query->tables, query->conds);
+        if (x->limit) {
+            if (x->limit->limit < 0 || x->limit->offset < 0) {
+                throw RMDBError("LIMIT and OFFSET must not be negative");
+            }
+            query->limit = x->limit->limit;
+            query->offset = x->limit->offset;
+        }
     } else if (auto x = std::dynamic_pointer_cast<ast::UpdateStmt>(parse)) {
         // 处理 update 的set 值
         for (auto &sv_set_clause : x->set_clauses) {
@@ -172,6 +197,40 @@ Value Analyze::convert_sv_value(const std::shared_ptr<ast::Value> &sv_val) {
     return val;
 }
 
+/**
+ * @description: 检查聚合函数的参数，有聚合函数或GROUP BY时，选择列表中不在聚合函数里的列必须出现在GROUP BY中
+ */
+void Analyze::check_aggregate(const std::vector<ColMeta> &all_cols, const std::vector<bool> &is_agg,
+                              std::shared_ptr<Query> query) {
+    for (auto &agg : query->aggs) {
+        if (agg.arg.col_name == "*") {
+            continue;
+        }
+        agg.arg = check_column(all_cols, agg.arg);
+        auto col = sm_manager_->db_.get_table(agg.arg.tab_name).get_col(agg.arg.col_name);
+        if ((agg.type == AGG_SUM || agg.type == AGG_AVG) && col->type == TYPE_STRING) {
+            throw IncompatibleTypeError(coltype2str(col->type), agg2str(agg.type));
+        }
+    }
+    if (query->aggs.empty() && query->group_cols.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < query->cols.size(); i++) {
+        auto &sel_col = query->cols[i];
+        if (!is_agg[i] && std::find(query->group_cols.begin(), query->group_cols.end(), sel_col) == query->group_cols.end()) {
+            throw RMDBError("column " + sel_col.col_name + " must appear in the GROUP BY clause or be used in an aggregate function");
+        }
+    }
+}
+
+AggType Analyze::convert_sv_agg_func(ast::SvAggFunc func) {
+    std::map<ast::SvAggFunc, AggType> m = {
+        {ast::SV_AGG_COUNT, AGG_COUNT}, {ast::SV_AGG_SUM, AGG_SUM}, {ast::SV_AGG_MIN, AGG_MIN},
+        {ast::SV_AGG_MAX, AGG_MAX}, {ast::SV_AGG_AVG, AGG_AVG},
+    };
+    return m.at(func);
+}
+
 CompOp Analyze::convert_sv_comp_op(ast::SvCompOp op) {
     std::map<ast::SvCompOp, CompOp> m = {
         {ast::SV_OP_EQ, OP_EQ}, {ast::SV_OP_NE, OP_NE}, {ast::SV_OP_LT, OP_LT},
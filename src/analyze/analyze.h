@@ -30,10 +30,17 @@ class Query{
     std::vector<TabCol> cols;
     // 表名
     std::vector<std::string> tables;
+    // GROUP BY的各列
+    std::vector<TabCol> group_cols;
+    // 选择列表中的聚合函数，其output与cols中对应的项相同
+    std::vector<AggExpr> aggs;
     // update 的set 值
     std::vector<SetClause> set_clauses;
     //insert 的values值
     std::vector<Value> values;
+    // limit 最多输出的元组数，-1表示没有LIMIT；offset 输出之前跳过的元组数
+    int limit = -1;
+    int offset = 0;
 
     Query(){}
 
@@ -56,5 +63,7 @@ private:
     void check_clause(const std::vector<std::string> &tab_names, std::vector<Condition> &conds);
     Value convert_sv_value(const std::shared_ptr<ast::Value> &sv_val);
     CompOp convert_sv_comp_op(ast::SvCompOp op);
+    AggType convert_sv_agg_func(ast::SvAggFunc func);
+    void check_aggregate(const std::vector<ColMeta> &all_cols, const std::vector<bool> &is_agg, std::shared_ptr<Query> query);
 };
 
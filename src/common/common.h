@@ -26,6 +26,10 @@ struct TabCol {
     friend bool operator<(const TabCol &x, const TabCol &y) {
         return std::make_pair(x.tab_name, x.col_name) < std::make_pair(y.tab_name, y.col_name);
     }
+
+    friend bool operator==(const TabCol &x, const TabCol &y) {
+        return x.tab_name == y.tab_name && x.col_name == y.col_name;
+    }
 };
 
 struct Value {
@@ -82,6 +86,19 @@ struct Condition {
     Value rhs_val;    // right-hand side value
 };
 
+enum AggType { AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG };
+
+inline std::string agg2str(AggType type) {
+    static const char *names[] = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+    return names[type];
+}
+
+struct AggExpr {
+    AggType type;
+    TabCol arg;       // argument column; col_name is "*" for COUNT(*)
+    TabCol output;    // output column, tab_name is empty and col_name is the caption, e.g. "SUM(score)"
+};
+
 struct SetClause {
     TabCol lhs;
     Value rhs;
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <string>
 
 #define BUFFER_LENGTH 8192
 
@@ -36,6 +37,27 @@ static constexpr int BUFFER_POOL_SIZE = 65536;                                //
 // static constexpr int BUFFER_POOL_SIZE = 262144;                                // size of buffer pool 1GB
 static constexpr int LOG_BUFFER_SIZE = (1024 * PAGE_SIZE);                    // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int BUFFER_POOL_PARTITIONS = 16;                             // max number of buffer pool partitions
+static constexpr int BUFFER_POOL_PARTITION_MIN_SIZE = 1024;                   // min number of frames per partition
+static constexpr int BULK_READ_RING_SIZE = 32;                                // frames of a bulk read ring buffer  256KB
+static constexpr int FLUSHER_INTERVAL_MS = 50;                                // interval between two background flusher rounds
+static constexpr int FLUSHER_DIRTY_AGE_MS = 1000;                             // dirty pages older than this are flushed
+static constexpr int FLUSHER_BATCH_SIZE = 64;                                 // max pages written per partition per round
+static constexpr double FLUSHER_CLEAN_RATIO = 0.1;                            // share of frames the flusher keeps clean
+static constexpr int PREFETCH_MIN_PAGES = 4;                                  // first read-ahead window of a sequential scan
+static constexpr int PREFETCH_MAX_PAGES = 32;                                 // max read-ahead window  128KB
+static constexpr size_t BITMAP_SCAN_MIN_ROWS = 64;                            // index range scans with fewer rows visit the table in key order
+static constexpr size_t IX_BULK_LOAD_SORT_MEM = 64 << 20;                     // sort buffer of CREATE INDEX, larger inputs spill sorted runs  64MB
+static constexpr double IX_BULK_LOAD_FILL_FACTOR = 0.9;                       // share of btree_order filled per node by bulk load
+static constexpr int IX_BULK_LOAD_WRITE_BATCH = 64;                           // pages written per batch by bulk load
+static constexpr bool IX_PREFIX_COMPRESSION = true;                           // string and composite index keys use prefix-compressed B+ tree nodes
+static constexpr size_t HASH_JOIN_MEM = 64 << 20;                             // hash table of a hash join, larger build sides spill partitions  64MB
+static constexpr int HASH_JOIN_PARTITIONS = 16;                               // temp file partitions of each side when a hash join spills
+static constexpr size_t SORT_MEM = 64 << 20;                                  // sort buffer of ORDER BY, larger inputs spill sorted runs  64MB
+static constexpr size_t SORT_RUN_BUFFER = 1 << 20;                            // stdio buffer of each sorted run, reads and writes runs sequentially  1MB
+static constexpr size_t HASH_AGG_MEM = 64 << 20;                              // group table of GROUP BY, groups beyond it spill input partitions  64MB
+static constexpr int HASH_AGG_PARTITIONS = 16;                                // temp file partitions when a hash aggregation spills
+static constexpr size_t BATCH_SIZE = 1024;                                    // max rows in a DataChunk of the batch executor interface
 
 using frame_id_t = int32_t;  // frame id type, 帧页ID, 页在BufferPool中的存储单元称为帧,一帧对应一页
 using page_id_t = int32_t;   // page id type , 页ID
@@ -48,7 +70,13 @@ using timestamp_t = int32_t;  // timestamp type, used for transaction concurrenc
 // log file
 static const std::string LOG_FILE_NAME = "db.log";
 
-// replacer
+// disk io backend, 可选 "pread", "io_uring"
+static const std::string IO_BACKEND = "pread";
+static constexpr unsigned IO_URING_QUEUE_DEPTH = 64;                          // entries of the io_uring submission queue
+
+// replacer, 可选 "LRU", "CLOCK", "LRU-K", "2Q"
 static const std::string REPLACER_TYPE = "LRU";
+static constexpr size_t LRUK_REPLACER_K = 2;                                  // K of the LRU-K replacer
+static constexpr double TWOQ_A1_RATIO = 0.25;                                 // share of frames for the 2Q A1 queue
 
 static const std::string DB_META_NAME = "db.meta";
@@ -59,6 +59,11 @@ class FileNotFoundError : public RMDBError {
     FileNotFoundError(const std::string &filename) : RMDBError("File not found: " + filename) {}
 };
 
+class FileFormatError : public RMDBError {
+   public:
+    FileFormatError(const std::string &filename) : RMDBError("Unsupported file format: " + filename) {}
+};
+
 // RM errors
 class RecordNotFoundError : public RMDBError {
    public:
@@ -143,6 +148,11 @@ class StringOverflowError : public RMDBError {
     StringOverflowError() : RMDBError("String is too long") {}
 };
 
+class IntegerOverflowError : public RMDBError {
+   public:
+    IntegerOverflowError(const std::string &expr) : RMDBError("Integer overflow: " + expr) {}
+};
+
 class IncompatibleTypeError : public RMDBError {
    public:
     IncompatibleTypeError(const std::string &lhs, const std::string &rhs)
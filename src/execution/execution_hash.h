@@ -0,0 +1,43 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 哈希连接和哈希聚合中开放定址哈希表的槽位，index为元组或组的下标加一，0表示空槽；探测时先比较hash再比较key
+struct HashSlot {
+    uint32_t hash;
+    uint32_t index;
+};
+
+/**
+ * @brief 对规范化的key计算哈希值：FNV-1a之后再混合一次，使低位也分布均匀
+ * @param seed 溢出分区递归再分区时换用不同的种子；种子为0时与哈希索引中保存的哈希值相同
+ */
+inline uint32_t hash_key(const char *key, size_t len, int seed = 0) {
+    uint64_t h = 14695981039346656037ull ^ (static_cast<uint64_t>(seed) * 0x9e3779b97f4a7c15ull);
+    for (size_t i = 0; i < len; i++) {
+        h ^= static_cast<unsigned char>(key[i]);
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+}
+
+// 分区号取哈希值的高位，与哈希表槽位使用的低位无关
+template <int num_parts>
+inline int part_of(uint32_t hash) {
+    static_assert((num_parts & (num_parts - 1)) == 0, "the number of partitions must be a power of 2");
+    return static_cast<int>((static_cast<uint64_t>(hash) * num_parts) >> 32);
+}
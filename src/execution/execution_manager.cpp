@@ -63,6 +63,11 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context){
                 sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context);
                 break;
             }
+            case T_CreateHashIndex:
+            {
+                sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context, INDEX_HASH);
+                break;
+            }
             case T_DropIndex:
             {
                 sm_manager_->drop_index(x->tab_name_, x->tab_col_names_, context);
@@ -152,32 +157,36 @@ void QlManager::select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot,
 
     // Print records
     size_t num_rec = 0;
-    // 执行query_plan
-    for (executorTreeRoot->beginTuple(); !executorTreeRoot->is_end(); executorTreeRoot->nextTuple()) {
-        auto Tuple = executorTreeRoot->Next();
-        std::vector<std::string> columns;
-        for (auto &col : executorTreeRoot->cols()) {
-            std::string col_str;
-            char *rec_buf = Tuple->data + col.offset;
-            if (col.type == TYPE_INT) {
-                col_str = std::to_string(*(int *)rec_buf);
-            } else if (col.type == TYPE_FLOAT) {
-                col_str = std::to_string(*(float *)rec_buf);
-            } else if (col.type == TYPE_STRING) {
-                col_str = std::string((char *)rec_buf, col.len);
-                col_str.resize(strlen(col_str.c_str()));
+    // 执行query_plan，按批取出元组，逐行输出每批中的有效行
+    DataChunk chunk;
+    executorTreeRoot->beginTuple();
+    while (executorTreeRoot->NextBatch(chunk)) {
+        for (size_t row = 0; row < chunk.count(); row++) {
+            std::vector<std::string> columns;
+            for (size_t c = 0; c < chunk.cols().size(); c++) {
+                auto &col = chunk.cols()[c];
+                std::string col_str;
+                const char *rec_buf = chunk.value(c, chunk.sel(row));
+                if (col.type == TYPE_INT) {
+                    col_str = std::to_string(*(const int *)rec_buf);
+                } else if (col.type == TYPE_FLOAT) {
+                    col_str = std::to_string(*(const float *)rec_buf);
+                } else if (col.type == TYPE_STRING) {
+                    col_str = std::string(rec_buf, col.len);
+                    col_str.resize(strlen(col_str.c_str()));
+                }
+                columns.push_back(col_str);
             }
-            columns.push_back(col_str);
-        }
-        // print record into buffer
-        rec_printer.print_record(columns, context);
-        // print record into file
-        outfile << "|";
-        for(int i = 0; i < columns.size(); ++i) {
-            outfile << " " << columns[i] << " |";
+            // print record into buffer
+            rec_printer.print_record(columns, context);
+            // print record into file
+            outfile << "|";
+            for(int i = 0; i < columns.size(); ++i) {
+                outfile << " " << columns[i] << " |";
+            }
+            outfile << "\n";
+            num_rec++;
         }
-        outfile << "\n";
-        num_rec++;
     }
     outfile.close();
     // Print footer into buffer
@@ -9,41 +9,302 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #pragma once
+
+#include <cstdio>
+
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
 #include "index/ix.h"
 #include "system/sm.h"
 
+// 排序键：多个字段拼接后规范化，降序的字段按位取反，整个排序键按memcmp比较
+class SortKey {
+   private:
+    std::vector<ColMeta> keys_;                 // 排序键在元组中的字段，按优先级排列
+    std::vector<bool> is_desc_;
+    std::vector<ColType> key_types_;
+    std::vector<int> key_lens_;
+    size_t key_len_ = 0;
+    std::vector<char> key_raw_;                 // 规范化之前拼接的排序键
+
+   public:
+    SortKey() = default;
+
+    SortKey(std::vector<ColMeta> keys, std::vector<bool> is_desc) {
+        keys_ = std::move(keys);
+        is_desc_ = std::move(is_desc);
+        for (auto &col : keys_) {
+            key_types_.push_back(col.type);
+            key_lens_.push_back(col.len);
+            key_len_ += col.len;
+        }
+        key_raw_.resize(key_len_);
+    }
+
+    size_t len() const { return key_len_; }
+
+    // 把元组rec的排序键写到dest
+    void make(const char *rec, char *dest) {
+        size_t offset = 0;
+        for (auto &col : keys_) {
+            memcpy(key_raw_.data() + offset, rec + col.offset, col.len);
+            offset += col.len;
+        }
+        ix_normalize_key(key_raw_.data(), dest, key_types_, key_lens_);
+        offset = 0;
+        for (size_t i = 0; i < keys_.size(); i++) {
+            if (is_desc_[i]) {
+                for (int b = 0; b < keys_[i].len; b++) {
+                    dest[offset + b] = static_cast<char>(~dest[offset + b]);
+                }
+            }
+            offset += keys_[i].len;
+        }
+    }
+};
+
+/* 外排序。每个元组连同排序键连续存放在arena中，排序时只移动由键的前8个字节和arena偏移组成的定长项。
+ * arena超出内存预算时把排好序的部分写入临时文件，全部读入后用败者树多路归并；键相同的元组保持输入的顺序 */
 class SortExecutor : public AbstractExecutor {
    private:
+    // 排序项，prefix是排序键前8个字节按大端序解释的整数，大多数比较不需要访问arena
+    struct SortItem {
+        uint64_t prefix;
+        size_t offset;
+    };
+
     std::unique_ptr<AbstractExecutor> prev_;
-    ColMeta cols_;                              // 框架中只支持一个键排序，需要自行修改数据结构支持多个键排序
-    size_t tuple_num;
-    bool is_desc_;
-    std::vector<size_t> used_tuple;
-    std::unique_ptr<RmRecord> current_tuple;
+    size_t len_;
+    SortKey sort_key_;
+    size_t key_len_;
+    size_t entry_len_;                          // arena和临时文件中每项的长度：排序键加上元组
+    size_t mem_budget_;
+
+    std::vector<char> arena_;
+    std::vector<SortItem> items_;
+    size_t pos_;                                // 全部在内存中时，下一个输出的项
+
+    std::vector<std::FILE *> runs_;             // 已排好序的临时文件
+    std::vector<std::vector<char>> heads_;      // heads_[i]是第i个临时文件当前的第一项
+    std::vector<bool> exhausted_;
+    std::vector<int> tree_;                     // 败者树，tree_[0]是胜者，其余是各内部结点上的败者
+    bool isend;
 
    public:
-    SortExecutor(std::unique_ptr<AbstractExecutor> prev, TabCol sel_cols, bool is_desc) {
+    SortExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &sel_cols, std::vector<bool> is_desc,
+                 size_t mem_budget = SORT_MEM) {
         prev_ = std::move(prev);
-        cols_ = prev_->get_col_offset(sel_cols);
-        is_desc_ = is_desc;
-        tuple_num = 0;
-        used_tuple.clear();
+        len_ = prev_->tupleLen();
+        std::vector<ColMeta> keys;
+        for (auto &sel_col : sel_cols) {
+            keys.push_back(*get_col(prev_->cols(), sel_col));
+        }
+        sort_key_ = SortKey(std::move(keys), std::move(is_desc));
+        key_len_ = sort_key_.len();
+        entry_len_ = key_len_ + len_;
+        mem_budget_ = mem_budget;
+        pos_ = 0;
+        isend = true;
     }
 
-    void beginTuple() override { 
-        
+    ~SortExecutor() override { close_runs(); }
+
+    size_t tupleLen() const override { return len_; };
+
+    const std::vector<ColMeta> &cols() const override { return prev_->cols(); };
+
+    std::string getType() override { return "SortExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        close_runs();
+        arena_.clear();
+        items_.clear();
+        // 按批读入，元组从DataChunk直接拼接到arena中
+        DataChunk chunk;
+        prev_->beginTuple();
+        while (prev_->NextBatch(chunk)) {
+            for (size_t i = 0; i < chunk.count(); i++) {
+                if (!items_.empty() && arena_.size() + entry_len_ + (items_.size() + 1) * sizeof(SortItem) > mem_budget_) {
+                    spill();
+                }
+                size_t offset = arena_.size();
+                arena_.resize(offset + entry_len_);
+                char *rec = arena_.data() + offset + key_len_;
+                chunk.gather(chunk.sel(i), rec);
+                sort_key_.make(rec, arena_.data() + offset);
+                items_.push_back(SortItem{prefix_of(arena_.data() + offset), offset});
+            }
+        }
+        if (runs_.empty()) {
+            sort_items();
+            pos_ = 0;
+            isend = items_.empty();
+            return;
+        }
+        if (!items_.empty()) {
+            spill();
+        }
+        std::vector<char>().swap(arena_);
+        std::vector<SortItem>().swap(items_);
+        start_merge();
     }
 
     void nextTuple() override {
-        
+        assert(!isend);
+        if (runs_.empty()) {
+            isend = ++pos_ == items_.size();
+            return;
+        }
+        int winner = tree_[0];
+        read_head(winner);
+        adjust(winner);
+        isend = exhausted_[tree_[0]];
     }
 
     std::unique_ptr<RmRecord> Next() override {
-        return nullptr;
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        assert(!isend);
+        if (runs_.empty()) {
+            return TupleView(arena_.data() + items_[pos_].offset + key_len_, len_);
+        }
+        return TupleView(heads_[tree_[0]].data() + key_len_, len_);
+    }
+
+    // 按批输出：直接从arena中排好序的项或败者树的胜者追加到chunk
+    bool NextBatch(DataChunk &chunk) override {
+        chunk.init(cols());
+        if (runs_.empty()) {
+            for (; !isend && !chunk.full(); isend = ++pos_ == items_.size()) {
+                chunk.append(arena_.data() + items_[pos_].offset + key_len_);
+            }
+            return chunk.count() > 0;
+        }
+        while (!isend && !chunk.full()) {
+            int winner = tree_[0];
+            chunk.append(heads_[winner].data() + key_len_);
+            read_head(winner);
+            adjust(winner);
+            isend = exhausted_[tree_[0]];
+        }
+        return chunk.count() > 0;
     }
 
     Rid &rid() override { return _abstract_rid; }
-};
\ No newline at end of file
+
+   private:
+    uint64_t prefix_of(const char *key) const {
+        uint64_t prefix = 0;
+        size_t n = std::min<size_t>(key_len_, sizeof(uint64_t));
+        for (size_t i = 0; i < n; i++) {
+            prefix |= static_cast<uint64_t>(static_cast<unsigned char>(key[i])) << (56 - 8 * i);
+        }
+        return prefix;
+    }
+
+    /**
+     * @description: 按排序键排序items_，键相同时按arena中的偏移即输入顺序
+     */
+    void sort_items() {
+        const char *base = arena_.data();
+        size_t rest = key_len_ > sizeof(uint64_t) ? key_len_ - sizeof(uint64_t) : 0;
+        std::sort(items_.begin(), items_.end(), [base, rest](const SortItem &a, const SortItem &b) {
+            if (a.prefix != b.prefix) {
+                return a.prefix < b.prefix;
+            }
+            if (rest > 0) {
+                int cmp = memcmp(base + a.offset + sizeof(uint64_t), base + b.offset + sizeof(uint64_t), rest);
+                if (cmp != 0) {
+                    return cmp < 0;
+                }
+            }
+            return a.offset < b.offset;
+        });
+    }
+
+    /**
+     * @description: 把arena中的元组排好序后顺序写入一个临时文件，并清空arena
+     */
+    void spill() {
+        sort_items();
+        std::FILE *run = std::tmpfile();
+        if (run == nullptr) {
+            throw UnixError();
+        }
+        runs_.push_back(run);
+        std::setvbuf(run, nullptr, _IOFBF, SORT_RUN_BUFFER);
+        for (auto &item : items_) {
+            if (std::fwrite(arena_.data() + item.offset, entry_len_, 1, run) != 1) {
+                throw UnixError();
+            }
+        }
+        if (std::fflush(run) != 0) {
+            throw UnixError();
+        }
+        arena_.clear();
+        items_.clear();
+    }
+
+    void close_runs() {
+        for (std::FILE *run : runs_) {
+            std::fclose(run);
+        }
+        runs_.clear();
+    }
+
+    void read_head(int i) {
+        if (std::fread(heads_[i].data(), entry_len_, 1, runs_[i]) == 1) {
+            return;
+        }
+        if (std::ferror(runs_[i])) {
+            throw UnixError();
+        }
+        exhausted_[i] = true;
+    }
+
+    // 第a个临时文件的当前项是否排在第b个之前；k表示初始化时使用的最小的虚拟项，读完的临时文件排在最后
+    bool run_less(int a, int b) const {
+        int k = runs_.size();
+        if (a == k || b == k) {
+            return a == k && b != k;
+        }
+        if (exhausted_[a] || exhausted_[b]) {
+            return !exhausted_[a] && exhausted_[b];
+        }
+        int cmp = memcmp(heads_[a].data(), heads_[b].data(), key_len_);
+        // 键相同时先输出较早写出的临时文件，其中是较早输入的元组
+        return cmp != 0 ? cmp < 0 : a < b;
+    }
+
+    // 第i个临时文件的当前项改变后，从它的叶子结点向上重新比赛
+    void adjust(int i) {
+        int k = runs_.size();
+        int winner = i;
+        for (int t = (i + k) / 2; t > 0; t /= 2) {
+            if (run_less(tree_[t], winner)) {
+                std::swap(winner, tree_[t]);
+            }
+        }
+        tree_[0] = winner;
+    }
+
+    void start_merge() {
+        int k = runs_.size();
+        heads_.assign(k, std::vector<char>(entry_len_));
+        exhausted_.assign(k, false);
+        for (int i = 0; i < k; i++) {
+            std::rewind(runs_[i]);
+            read_head(i);
+        }
+        tree_.assign(k, k);
+        for (int i = k - 1; i >= 0; i--) {
+            adjust(i);
+        }
+        isend = exhausted_[tree_[0]];
+    }
+};
@@ -0,0 +1,227 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "common/common.h"
+#include "system/sm_meta.h"
+
+/* 列式存储的一批元组，最多BATCH_SIZE行。每个字段的值按行号连续存放在各自的向量中，
+ * sel_中依次是有效的行号，过滤时只压缩sel_而不移动数据 */
+class DataChunk {
+   private:
+    std::vector<ColMeta> cols_;                 // 各字段，offset是字段在行格式元组中的偏移
+    std::vector<std::vector<char>> data_;       // data_[i]是第i个字段的向量
+    size_t size_ = 0;                           // 已写入的行数
+    std::vector<uint32_t> sel_;                 // 有效行的行号，升序
+    size_t count_ = 0;                          // 有效行数
+
+   public:
+    /**
+     * @description: 按字段设置列的布局并清空，布局不变时复用已分配的向量
+     */
+    void init(const std::vector<ColMeta> &cols) {
+        bool same = cols.size() == cols_.size();
+        for (size_t i = 0; same && i < cols.size(); i++) {
+            same = cols[i].len == cols_[i].len && cols[i].offset == cols_[i].offset;
+        }
+        cols_ = cols;
+        if (!same) {
+            data_.assign(cols_.size(), std::vector<char>());
+            for (size_t i = 0; i < cols_.size(); i++) {
+                data_[i].resize(BATCH_SIZE * cols_[i].len);
+            }
+            sel_.resize(BATCH_SIZE);
+        }
+        reset();
+    }
+
+    void reset() {
+        size_ = 0;
+        count_ = 0;
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    size_t size() const { return size_; }
+
+    size_t count() const { return count_; }
+
+    bool full() const { return size_ == BATCH_SIZE; }
+
+    // 第i个有效行的行号
+    uint32_t sel(size_t i) const { return sel_[i]; }
+
+    uint32_t *sel_data() { return sel_.data(); }
+
+    void set_count(size_t count) { count_ = count; }
+
+    const char *column(size_t col) const { return data_[col].data(); }
+
+    const char *value(size_t col, size_t row) const { return data_[col].data() + row * cols_[col].len; }
+
+    char *value(size_t col, size_t row) { return data_[col].data() + row * cols_[col].len; }
+
+    // 追加新的一行并标记为有效，返回其行号，各列的值由调用者按列写入
+    size_t add_row() {
+        sel_[count_++] = size_;
+        return size_++;
+    }
+
+    // 把行格式的元组rec追加为新的一行，并标记为有效
+    void append(const char *rec) {
+        for (size_t i = 0; i < cols_.size(); i++) {
+            memcpy(data_[i].data() + size_ * cols_[i].len, rec + cols_[i].offset, cols_[i].len);
+        }
+        sel_[count_++] = size_++;
+    }
+
+    // 把第row行按行格式写到dest
+    void gather(size_t row, char *dest) const {
+        for (size_t i = 0; i < cols_.size(); i++) {
+            memcpy(dest + cols_[i].offset, data_[i].data() + row * cols_[i].len, cols_[i].len);
+        }
+    }
+
+    // 依次取input中下标为idxs的字段作为本批的各列，行号和有效行与input相同；布局应已由init()设置
+    void project(const DataChunk &input, const std::vector<size_t> &idxs) {
+        for (size_t i = 0; i < idxs.size(); i++) {
+            memcpy(data_[i].data(), input.data_[idxs[i]].data(), input.size_ * cols_[i].len);
+        }
+        memcpy(sel_.data(), input.sel_.data(), input.count_ * sizeof(uint32_t));
+        size_ = input.size_;
+        count_ = input.count_;
+    }
+};
+
+/* 按批计算的过滤条件。条件在构造时解析为列的下标，每个条件对整批的有效行做一次紧凑的循环，
+ * 按类型和比较运算符选定的比较没有分支地写回sel_，不满足的行从sel_中去掉 */
+class BatchFilter {
+   private:
+    struct Pred {
+        size_t lhs;                             // 左边字段在DataChunk中的下标
+        bool is_rhs_val;
+        size_t rhs;                             // 右边字段的下标，is_rhs_val时不使用
+        const char *val;                        // 右边的常值，指向Condition中的raw
+        ColType type;
+        int len;
+        CompOp op;
+    };
+
+    std::vector<Pred> preds_;
+
+   public:
+    BatchFilter() = default;
+
+    // conds中常值的raw在BatchFilter的生命期内必须有效
+    BatchFilter(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds) {
+        auto index_of = [&](const TabCol &target) {
+            for (size_t i = 0; i < cols.size(); i++) {
+                if (cols[i].tab_name == target.tab_name && cols[i].name == target.col_name) {
+                    return i;
+                }
+            }
+            throw ColumnNotFoundError(target.tab_name + '.' + target.col_name);
+        };
+        for (auto &cond : conds) {
+            Pred pred;
+            pred.lhs = index_of(cond.lhs_col);
+            pred.is_rhs_val = cond.is_rhs_val;
+            pred.rhs = cond.is_rhs_val ? 0 : index_of(cond.rhs_col);
+            pred.val = cond.is_rhs_val ? cond.rhs_val.raw->data : nullptr;
+            pred.type = cond.is_rhs_val ? cond.rhs_val.type : cols[pred.rhs].type;
+            pred.len = cols[pred.lhs].len;
+            pred.op = cond.op;
+            preds_.push_back(pred);
+        }
+    }
+
+    bool empty() const { return preds_.empty(); }
+
+    // 从chunk的有效行中去掉不满足所有条件的行
+    void apply(DataChunk &chunk) const {
+        for (auto &pred : preds_) {
+            if (chunk.count() == 0) {
+                return;
+            }
+            chunk.set_count(select(chunk, pred));
+        }
+    }
+
+   private:
+    static size_t select(DataChunk &chunk, const Pred &pred) {
+        switch (pred.type) {
+            case TYPE_INT:
+                return select_op<int>(chunk, pred);
+            case TYPE_FLOAT:
+                return select_op<float>(chunk, pred);
+            case TYPE_STRING:
+                return select_op<const char *>(chunk, pred);
+            default:
+                throw InternalError("Unexpected data type");
+        }
+    }
+
+    template <typename T>
+    static size_t select_op(DataChunk &chunk, const Pred &pred) {
+        switch (pred.op) {
+            case OP_EQ: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp == 0; });
+            case OP_NE: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp != 0; });
+            case OP_LT: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp < 0; });
+            case OP_GT: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp > 0; });
+            case OP_LE: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp <= 0; });
+            case OP_GE: return select_cmp<T>(chunk, pred, [](int cmp) { return cmp >= 0; });
+            default:
+                throw InternalError("Unexpected comparison operator");
+        }
+    }
+
+    // 定长数值比较为-1/0/1，字符串按memcmp比较
+    template <typename T>
+    static int compare(const char *base, size_t row, const char *rhs, int len) {
+        if constexpr (std::is_same_v<T, const char *>) {
+            return memcmp(base + row * len, rhs, len);
+        } else {
+            T a = reinterpret_cast<const T *>(base)[row];
+            T b;
+            memcpy(&b, rhs, sizeof(T));
+            return (a > b) - (a < b);
+        }
+    }
+
+    template <typename T, typename Test>
+    static size_t select_cmp(DataChunk &chunk, const Pred &pred, Test test) {
+        const char *lhs = chunk.column(pred.lhs);
+        const char *rhs = pred.is_rhs_val ? nullptr : chunk.column(pred.rhs);
+        uint32_t *sel = chunk.sel_data();
+        size_t count = chunk.count();
+        size_t n = 0;
+        int len = pred.len;
+        if (pred.is_rhs_val) {
+            for (size_t i = 0; i < count; i++) {
+                uint32_t row = sel[i];
+                sel[n] = row;
+                n += test(compare<T>(lhs, row, pred.val, len));
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                uint32_t row = sel[i];
+                sel[n] = row;
+                n += test(compare<T>(lhs, row, rhs + row * len, len));
+            }
+        }
+        return n;
+    }
+};
@@ -11,6 +11,7 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "execution_defs.h"
+#include "execution_vector.h"
 #include "common/common.h"
 #include "index/ix.h"
 #include "system/sm.h"
@@ -42,6 +43,28 @@ class AbstractExecutor {
 
     virtual std::unique_ptr<RmRecord> Next() = 0;
 
+    /**
+     * @brief 返回当前元组的只读视图，不复制数据；视图在下一次beginTuple()/nextTuple()之前有效，
+     * 需要在此之后继续使用时调用Next()或TupleView::to_record()物化。默认实现通过Next()物化后返回
+     */
+    virtual TupleView view() {
+        materialized_ = Next();
+        return materialized_ == nullptr ? TupleView() : TupleView(*materialized_);
+    }
+
+    /**
+     * @brief 按批取元组：从当前元组开始取出至多BATCH_SIZE个元组按列写入chunk，没有更多元组时返回false。
+     * 在beginTuple()之后调用，同一次扫描中不与nextTuple()/view()混用。默认实现逐个取元组，
+     * 按批实现的算子覆盖它
+     */
+    virtual bool NextBatch(DataChunk &chunk) {
+        chunk.init(cols());
+        for (; !is_end() && !chunk.full(); nextTuple()) {
+            chunk.append(view().data);
+        }
+        return chunk.count() > 0;
+    }
+
     virtual ColMeta get_col_offset(const TabCol &target) { return ColMeta();};
 
     std::vector<ColMeta>::const_iterator get_col(const std::vector<ColMeta> &rec_cols, const TabCol &target) {
@@ -53,4 +76,7 @@ class AbstractExecutor {
         }
         return pos;
     }
+
+   private:
+    std::unique_ptr<RmRecord> materialized_;  // view()默认实现物化的当前元组
 };
\ No newline at end of file
@@ -0,0 +1,606 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdio>
+#include <limits>
+
+#include "execution_defs.h"
+#include "execution_hash.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/* 每组定长的聚合状态和聚合的输出元组。状态开头是int64的元组数，之后依次是各聚合函数的状态：
+ * SUM(int)为int64的和，SUM(float)和AVG为double的和，MIN/MAX为当前的值，COUNT直接使用元组数。
+ * 输出元组依次是各分组列和各聚合函数的值，COUNT和SUM(int)为int（超出int的范围时报错），SUM(float)和AVG为float，
+ * MIN/MAX与参数的类型相同 */
+class AggStates {
+   private:
+    struct Agg {
+        AggType type;
+        bool has_arg;                           // COUNT(*)没有参数
+        ColMeta arg;                            // 参数在输入元组中的字段
+        size_t arg_col;                         // 参数在输入元组的字段（也是DataChunk的列）中的下标
+        size_t offset;                          // 在状态中的偏移
+        ColMeta out;                            // 在输出元组中的字段
+        size_t out_col;                         // 在输出元组的字段（也是DataChunk的列）中的下标
+    };
+
+    std::vector<Agg> aggs_;
+    std::vector<ColMeta> cols_;                 // 输出元组的字段
+    size_t len_ = 0;                            // 输出元组的长度
+    size_t state_len_ = sizeof(int64_t);
+
+    template <typename T>
+    static T load(const char *src) {
+        T val;
+        memcpy(&val, src, sizeof(T));
+        return val;
+    }
+
+    template <typename T>
+    static void store(char *dest, T val) {
+        memcpy(dest, &val, sizeof(T));
+    }
+
+    // 输出列为int，超出范围时报错而不是截断
+    static int to_int(int64_t value, const Agg &agg) {
+        if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+            throw IntegerOverflowError(agg.out.name);
+        }
+        return static_cast<int>(value);
+    }
+
+    // 把输入元组累加到状态中，value(agg)返回聚合函数agg的参数的值
+    template <typename Value>
+    void update_with(char *state, Value value) const {
+        int64_t count = load<int64_t>(state);
+        for (auto &agg : aggs_) {
+            char *dest = state + agg.offset;
+            const char *src = agg.has_arg ? value(agg) : nullptr;
+            switch (agg.type) {
+                case AGG_COUNT:
+                    break;
+                case AGG_SUM:
+                case AGG_AVG:
+                    if (agg.type == AGG_SUM && agg.arg.type == TYPE_INT) {
+                        store<int64_t>(dest, load<int64_t>(dest) + load<int>(src));
+                    } else {
+                        double val = agg.arg.type == TYPE_INT ? load<int>(src) : load<float>(src);
+                        store<double>(dest, load<double>(dest) + val);
+                    }
+                    break;
+                case AGG_MIN:
+                case AGG_MAX: {
+                    int cmp = count == 0 ? 0 : ix_compare(src, dest, agg.arg.type, agg.arg.len);
+                    if (count == 0 || (agg.type == AGG_MIN ? cmp < 0 : cmp > 0)) {
+                        memcpy(dest, src, agg.arg.len);
+                    }
+                    break;
+                }
+            }
+        }
+        store<int64_t>(state, count + 1);
+    }
+
+    // 把状态转为各聚合函数的值，dest(agg)返回聚合函数agg的值写入的位置
+    template <typename Dest>
+    void finish_with(const char *state, Dest dest) const {
+        int64_t count = load<int64_t>(state);
+        for (auto &agg : aggs_) {
+            const char *src = state + agg.offset;
+            char *out = dest(agg);
+            switch (agg.type) {
+                case AGG_COUNT:
+                    store<int>(out, to_int(count, agg));
+                    break;
+                case AGG_SUM:
+                    if (agg.arg.type == TYPE_INT) {
+                        store<int>(out, to_int(load<int64_t>(src), agg));
+                    } else {
+                        store<float>(out, static_cast<float>(load<double>(src)));
+                    }
+                    break;
+                case AGG_AVG:
+                    store<float>(out, count == 0 ? 0.0f : static_cast<float>(load<double>(src) / count));
+                    break;
+                case AGG_MIN:
+                case AGG_MAX:
+                    memcpy(out, src, agg.arg.len);
+                    break;
+            }
+        }
+    }
+
+   public:
+    AggStates() = default;
+
+    /**
+     * @param group_keys 分组列在输入元组中的字段
+     * @param aggs 聚合函数
+     * @param input_cols 输入元组的字段
+     */
+    AggStates(const std::vector<ColMeta> &group_keys, const std::vector<AggExpr> &aggs,
+              const std::vector<ColMeta> &input_cols) {
+        for (auto col : group_keys) {
+            col.offset = len_;
+            len_ += col.len;
+            cols_.push_back(col);
+        }
+        for (size_t i = 0; i < aggs.size(); i++) {
+            Agg agg;
+            agg.type = aggs[i].type;
+            agg.has_arg = aggs[i].arg.col_name != "*";
+            agg.arg = ColMeta();
+            agg.arg_col = 0;
+            if (agg.has_arg) {
+                auto pos = std::find_if(input_cols.begin(), input_cols.end(), [&](const ColMeta &col) {
+                    return col.tab_name == aggs[i].arg.tab_name && col.name == aggs[i].arg.col_name;
+                });
+                if (pos == input_cols.end()) {
+                    throw ColumnNotFoundError(aggs[i].arg.tab_name + '.' + aggs[i].arg.col_name);
+                }
+                agg.arg = *pos;
+                agg.arg_col = pos - input_cols.begin();
+            }
+            agg.offset = state_len_;
+            switch (agg.type) {
+                case AGG_COUNT:
+                    agg.out = {.tab_name = "", .name = "", .type = TYPE_INT, .len = sizeof(int)};
+                    break;
+                case AGG_SUM:
+                    state_len_ += sizeof(int64_t);
+                    agg.out = {.tab_name = "", .name = "", .type = agg.arg.type, .len = agg.arg.len};
+                    break;
+                case AGG_AVG:
+                    state_len_ += sizeof(double);
+                    agg.out = {.tab_name = "", .name = "", .type = TYPE_FLOAT, .len = sizeof(float)};
+                    break;
+                case AGG_MIN:
+                case AGG_MAX:
+                    state_len_ += agg.arg.len;
+                    agg.out = {.tab_name = "", .name = "", .type = agg.arg.type, .len = agg.arg.len};
+                    break;
+            }
+            agg.out.name = aggs[i].output.col_name;
+            agg.out.offset = len_;
+            agg.out.index = false;
+            agg.out_col = cols_.size();
+            len_ += agg.out.len;
+            cols_.push_back(agg.out);
+            aggs_.push_back(agg);
+        }
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    size_t len() const { return len_; }
+
+    size_t state_len() const { return state_len_; }
+
+    void init(char *state) const { memset(state, 0, state_len_); }
+
+    // 把输入元组rec累加到状态中
+    void update(char *state, const char *rec) const {
+        update_with(state, [rec](const Agg &agg) { return rec + agg.arg.offset; });
+    }
+
+    // 把chunk的第row行累加到状态中，chunk的列是输入元组的各字段
+    void update(char *state, const DataChunk &chunk, size_t row) const {
+        update_with(state, [&chunk, row](const Agg &agg) { return chunk.value(agg.arg_col, row); });
+    }
+
+    // 把状态转为输出元组out中各聚合函数的值，分组列由调用者填写
+    void finish(const char *state, char *out) const {
+        finish_with(state, [out](const Agg &agg) { return out + agg.out.offset; });
+    }
+
+    // 把状态转为chunk第row行中各聚合函数的值，chunk的列是输出元组的各字段，分组列由调用者填写
+    void finish(const char *state, DataChunk &chunk, size_t row) const {
+        finish_with(state, [&chunk, row](const Agg &agg) { return chunk.value(agg.out_col, row); });
+    }
+};
+
+/* 哈希聚合。每组规范化的分组键和聚合状态连续存放在entries_中，按首次出现的顺序输出；
+ * 槽位中保存哈希值，探测时先比较哈希值再比较分组键。组数超出内存预算后不再建立新组，
+ * 其余组的输入元组按哈希值的高位写入临时文件分区，内存中的组输出完后再逐个分区聚合，分区内溢出时递归地再分区。
+ * 儿子节点的输入按批读取，分组键和聚合函数的参数直接从DataChunk的列中读出，只有写入溢出分区的元组拼接为行格式 */
+class HashAggregateExecutor : public AbstractExecutor {
+   private:
+    // 待处理的溢出分区，depth为写入时所在的层数
+    struct Part {
+        std::FILE *file;
+        int depth;
+    };
+
+    std::unique_ptr<AbstractExecutor> prev_;
+    size_t input_len_;
+    AggStates states_;
+    std::vector<ColMeta> group_keys_;           // 分组列在输入元组中的字段
+    std::vector<size_t> group_cols_;            // 分组列在输入元组的字段（也是DataChunk的列）中的下标
+    std::vector<ColType> key_types_;
+    std::vector<int> key_lens_;
+    size_t key_len_;
+    std::vector<char> key_raw_;                 // 规范化之前拼接的分组键
+    std::vector<char> key_;                     // 当前输入元组规范化的分组键
+    uint32_t hash_;                             // key_的哈希值
+    std::vector<char> rec_;                     // 写入溢出分区时拼接的行格式元组
+    size_t entry_len_;                          // 每组的长度：规范化的分组键加上聚合状态
+
+    size_t mem_budget_;
+    std::vector<char> entries_;
+    std::vector<HashSlot> slots_;               // 槽位中的index为组的下标加一
+    size_t mask_;
+    int depth_;                                 // 当前处理的层数，作为哈希的种子，0表示儿子节点的输入
+    std::vector<std::FILE *> spill_;            // 当前层组数超出预算后写入的分区
+    std::vector<Part> pending_;                 // 尚未处理的分区
+
+    size_t pos_;                                // 当前输出的组
+    std::vector<char> out_;                     // 当前输出的元组，view()指向这里
+    bool isend;
+
+   public:
+    HashAggregateExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &group_cols,
+                          const std::vector<AggExpr> &aggs, size_t mem_budget = HASH_AGG_MEM) {
+        prev_ = std::move(prev);
+        input_len_ = prev_->tupleLen();
+        key_len_ = 0;
+        for (auto &group_col : group_cols) {
+            auto pos = get_col(prev_->cols(), group_col);
+            ColMeta col = *pos;
+            group_keys_.push_back(col);
+            group_cols_.push_back(pos - prev_->cols().begin());
+            key_types_.push_back(col.type);
+            key_lens_.push_back(col.len);
+            key_len_ += col.len;
+        }
+        states_ = AggStates(group_keys_, aggs, prev_->cols());
+        key_raw_.resize(key_len_);
+        key_.resize(key_len_);
+        hash_ = 0;
+        rec_.resize(input_len_);
+        entry_len_ = key_len_ + states_.state_len();
+        mem_budget_ = mem_budget;
+        mask_ = 0;
+        depth_ = 0;
+        pos_ = 0;
+        out_.resize(states_.len());
+        isend = true;
+    }
+
+    ~HashAggregateExecutor() override { close_parts(); }
+
+    size_t tupleLen() const override { return states_.len(); };
+
+    const std::vector<ColMeta> &cols() const override { return states_.cols(); };
+
+    std::string getType() override { return "HashAggregateExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        close_parts();
+        reset_table(0);
+        DataChunk chunk;
+        prev_->beginTuple();
+        while (prev_->NextBatch(chunk)) {
+            for (size_t i = 0; i < chunk.count(); i++) {
+                consume(chunk, chunk.sel(i));
+            }
+        }
+        finish_level();
+        // 没有GROUP BY时即使没有输入元组也输出一组
+        if (group_keys_.empty() && entries_.empty()) {
+            entries_.resize(entry_len_);
+            states_.init(entries_.data());
+        }
+        pos_ = 0;
+        seek();
+    }
+
+    void nextTuple() override {
+        assert(!isend);
+        pos_++;
+        seek();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        assert(!isend);
+        return TupleView(out_.data(), out_.size());
+    }
+
+    // 按批输出：各组的分组键和聚合状态直接从entries_按列写入chunk，不经过out_
+    bool NextBatch(DataChunk &chunk) override {
+        chunk.init(cols());
+        while (!isend && !chunk.full()) {
+            const char *entry = entries_.data() + pos_ * entry_len_;
+            size_t row = chunk.add_row();
+            ix_denormalize_key(entry, key_raw_.data(), key_types_, key_lens_);
+            size_t offset = 0;
+            for (size_t i = 0; i < group_keys_.size(); i++) {
+                memcpy(chunk.value(i, row), key_raw_.data() + offset, key_lens_[i]);
+                offset += key_lens_[i];
+            }
+            states_.finish(entry + key_len_, chunk, row);
+            pos_++;
+            isend = !locate();
+        }
+        return chunk.count() > 0;
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    void close_parts() {
+        for (std::FILE *part : spill_) {
+            std::fclose(part);
+        }
+        for (auto &part : pending_) {
+            std::fclose(part.file);
+        }
+        spill_.clear();
+        pending_.clear();
+    }
+
+    void reset_table(int depth) {
+        entries_.clear();
+        slots_.assign(16, HashSlot{0, 0});
+        mask_ = slots_.size() - 1;
+        depth_ = depth;
+    }
+
+    // 从溢出分区读出的元组rec累加到所属的组
+    void consume(const char *rec) {
+        size_t offset = 0;
+        for (auto &col : group_keys_) {
+            memcpy(key_raw_.data() + offset, rec + col.offset, col.len);
+            offset += col.len;
+        }
+        char *state = find_group();
+        if (state == nullptr) {
+            spill(rec);
+            return;
+        }
+        states_.update(state, rec);
+    }
+
+    // 儿子节点输出的chunk的第row行累加到所属的组
+    void consume(const DataChunk &chunk, size_t row) {
+        size_t offset = 0;
+        for (size_t i = 0; i < group_cols_.size(); i++) {
+            memcpy(key_raw_.data() + offset, chunk.value(group_cols_[i], row), group_keys_[i].len);
+            offset += group_keys_[i].len;
+        }
+        char *state = find_group();
+        if (state == nullptr) {
+            chunk.gather(row, rec_.data());
+            spill(rec_.data());
+            return;
+        }
+        states_.update(state, chunk, row);
+    }
+
+    /**
+     * @description: 规范化key_raw_中的分组键，返回所属组的聚合状态，组不存在时新建；
+     * 组不在内存中且已超出预算时返回nullptr，由调用者把元组写入溢出分区
+     */
+    char *find_group() {
+        ix_normalize_key(key_raw_.data(), key_.data(), key_types_, key_lens_);
+        hash_ = hash_key(key_.data(), key_len_, depth_);
+        size_t pos = hash_ & mask_;
+        while (slots_[pos].index != 0) {
+            char *entry = entries_.data() + static_cast<size_t>(slots_[pos].index - 1) * entry_len_;
+            if (slots_[pos].hash == hash_ && memcmp(entry, key_.data(), key_len_) == 0) {
+                return entry + key_len_;
+            }
+            pos = (pos + 1) & mask_;
+        }
+        if (spill_.empty() && !entries_.empty() &&
+            entries_.size() + entry_len_ + slots_.size() * sizeof(HashSlot) > mem_budget_) {
+            for (int i = 0; i < HASH_AGG_PARTITIONS; i++) {
+                std::FILE *part = std::tmpfile();
+                if (part == nullptr) {
+                    throw UnixError();
+                }
+                spill_.push_back(part);
+            }
+        }
+        if (!spill_.empty()) {
+            return nullptr;
+        }
+        size_t num_entries = entries_.size() / entry_len_;
+        entries_.resize(entries_.size() + entry_len_);
+        char *entry = entries_.data() + num_entries * entry_len_;
+        memcpy(entry, key_.data(), key_len_);
+        states_.init(entry + key_len_);
+        slots_[pos] = HashSlot{hash_, static_cast<uint32_t>(num_entries + 1)};
+        if ((num_entries + 1) * 2 > slots_.size()) {
+            grow();
+        }
+        return entry + key_len_;
+    }
+
+    // 把元组rec写入分组键所属的溢出分区
+    void spill(const char *rec) {
+        if (std::fwrite(rec, input_len_, 1, spill_[part_of<HASH_AGG_PARTITIONS>(hash_)]) != 1) {
+            throw UnixError();
+        }
+    }
+
+    // 槽位数加倍，按保存的哈希值重新放置各组
+    void grow() {
+        std::vector<HashSlot> old(slots_.size() * 2, HashSlot{0, 0});
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (auto &slot : old) {
+            if (slot.index == 0) {
+                continue;
+            }
+            size_t pos = slot.hash & mask_;
+            while (slots_[pos].index != 0) {
+                pos = (pos + 1) & mask_;
+            }
+            slots_[pos] = slot;
+        }
+    }
+
+    // 当前层的输入处理完，把非空的溢出分区加入待处理的分区
+    void finish_level() {
+        for (std::FILE *part : spill_) {
+            std::fflush(part);
+            if (std::ftell(part) == 0) {
+                std::fclose(part);
+                continue;
+            }
+            pending_.push_back(Part{part, depth_ + 1});
+        }
+        spill_.clear();
+    }
+
+    /**
+     * @description: 定位到第pos_个组，内存中的组输出完时聚合下一个待处理的分区；没有更多的组时返回false
+     */
+    bool locate() {
+        while (pos_ * entry_len_ >= entries_.size()) {
+            if (pending_.empty()) {
+                return false;
+            }
+            Part part = pending_.back();
+            pending_.pop_back();
+            reset_table(part.depth);
+            std::rewind(part.file);
+            std::vector<char> rec(input_len_);
+            while (std::fread(rec.data(), input_len_, 1, part.file) == 1) {
+                consume(rec.data());
+            }
+            bool failed = std::ferror(part.file);
+            std::fclose(part.file);
+            if (failed) {
+                throw UnixError();
+            }
+            finish_level();
+            pos_ = 0;
+        }
+        return true;
+    }
+
+    // 定位到第pos_个组并构造输出元组；没有更多的组时设置isend
+    void seek() {
+        isend = !locate();
+        if (isend) {
+            return;
+        }
+        const char *entry = entries_.data() + pos_ * entry_len_;
+        ix_denormalize_key(entry, out_.data(), key_types_, key_lens_);
+        states_.finish(entry + key_len_, out_.data());
+    }
+};
+
+/* 流式聚合。儿子节点的输出已按分组列有序（例如按索引key的顺序扫描），分组键相同的元组相邻，
+ * 逐组累加，只需要一组的状态 */
+class SortAggregateExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> prev_;
+    AggStates states_;
+    std::vector<ColMeta> group_keys_;           // 分组列在输入元组中的字段
+    std::vector<char> state_;
+    std::vector<char> out_;                     // 当前输出的元组，开头是当前组的分组列，view()指向这里
+    bool emitted_;                              // 已输出过至少一组
+    bool isend;
+
+   public:
+    SortAggregateExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &group_cols,
+                          const std::vector<AggExpr> &aggs) {
+        prev_ = std::move(prev);
+        for (auto &group_col : group_cols) {
+            group_keys_.push_back(*get_col(prev_->cols(), group_col));
+        }
+        states_ = AggStates(group_keys_, aggs, prev_->cols());
+        state_.resize(states_.state_len());
+        out_.resize(states_.len());
+        emitted_ = false;
+        isend = true;
+    }
+
+    size_t tupleLen() const override { return states_.len(); };
+
+    const std::vector<ColMeta> &cols() const override { return states_.cols(); };
+
+    std::string getType() override { return "SortAggregateExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        emitted_ = false;
+        prev_->beginTuple();
+        advance();
+    }
+
+    void nextTuple() override {
+        assert(!isend);
+        advance();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        assert(!isend);
+        return TupleView(out_.data(), out_.size());
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    bool same_group(const char *rec) const {
+        for (size_t i = 0; i < group_keys_.size(); i++) {
+            auto &col = group_keys_[i];
+            if (memcmp(rec + col.offset, out_.data() + states_.cols()[i].offset, col.len) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @description: 累加下一组的所有元组，构造输出元组；没有更多的组时设置isend
+     */
+    void advance() {
+        states_.init(state_.data());
+        if (prev_->is_end()) {
+            // 没有GROUP BY时即使没有输入元组也输出一组
+            isend = emitted_ || !group_keys_.empty();
+            if (!isend) {
+                states_.finish(state_.data(), out_.data());
+                emitted_ = true;
+            }
+            return;
+        }
+        const char *rec = prev_->view().data;
+        for (size_t i = 0; i < group_keys_.size(); i++) {
+            memcpy(out_.data() + states_.cols()[i].offset, rec + group_keys_[i].offset, group_keys_[i].len);
+        }
+        do {
+            states_.update(state_.data(), rec);
+            prev_->nextTuple();
+        } while (!prev_->is_end() && same_group(rec = prev_->view().data));
+        states_.finish(state_.data(), out_.data());
+        emitted_ = true;
+        isend = false;
+    }
+};
@@ -0,0 +1,78 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+// 按批取儿子节点的元组，再逐个提供给只使用元组接口的上层算子；当前元组从DataChunk按行格式拼接到buf_中
+class BatchAdapterExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> prev_;
+    size_t len_;
+    DataChunk chunk_;
+    size_t pos_;                                // 当前元组在chunk_有效行中的序号
+    std::vector<char> buf_;                     // 当前元组，view()指向这里
+    bool isend;
+
+   public:
+    BatchAdapterExecutor(std::unique_ptr<AbstractExecutor> prev) {
+        prev_ = std::move(prev);
+        len_ = prev_->tupleLen();
+        buf_.resize(len_);
+        pos_ = 0;
+        isend = true;
+    }
+
+    size_t tupleLen() const override { return len_; };
+
+    const std::vector<ColMeta> &cols() const override { return prev_->cols(); };
+
+    std::string getType() override { return "BatchAdapterExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        prev_->beginTuple();
+        fetch();
+    }
+
+    void nextTuple() override {
+        assert(!isend);
+        if (++pos_ < chunk_.count()) {
+            chunk_.gather(chunk_.sel(pos_), buf_.data());
+            return;
+        }
+        fetch();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        assert(!isend);
+        return TupleView(buf_.data(), len_);
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    void fetch() {
+        pos_ = 0;
+        isend = !prev_->NextBatch(chunk_);
+        if (!isend) {
+            chunk_.gather(chunk_.sel(0), buf_.data());
+        }
+    }
+};
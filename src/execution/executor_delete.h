@@ -49,28 +49,43 @@ class DeleteExecutor : public AbstractExecutor {
 
         // insert和delete操作不需要返回record对应指针，返回nullptr即可
         // 参考exuctor_insert
-        // 0. 构建待删除record对象
-        RmRecord rec(fh_->get_file_hdr().record_size);
-
-        // 1. 将record对象通过RmFileHandles删除对应表的数据文件
+        // 1. 如果表上存在索引，用删除前的record拼出每个索引的key；B+树索引批量删除所有(key, rid)，每个叶结点只访问一次
+        if (!tab_.indexes.empty()) {
+            std::vector<std::vector<char>> keys(tab_.indexes.size());
+            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                keys[i].resize(rids_.size() * tab_.indexes[i].col_tot_len);
+            }
+            for (size_t r = 0; r < rids_.size(); ++r) {
+                auto rec = fh_->get_record(rids_[r], context_);
+                for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                    auto &index = tab_.indexes[i];
+                    char *key = keys[i].data() + r * index.col_tot_len;
+                    int offset = 0;
+                    for (auto &col : index.cols) {
+                        memcpy(key + offset, rec->data + col.offset, col.len);
+                        offset += col.len;
+                    }
+                }
+            }
+            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                auto &index = tab_.indexes[i];
+                std::string index_name = sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols);
+                if (index.type == INDEX_HASH) {
+                    auto ih = sm_manager_->hash_ihs_.at(index_name).get();
+                    for (size_t r = 0; r < rids_.size(); ++r) {
+                        ih->delete_entry(keys[i].data() + r * index.col_tot_len, rids_[r], context_->txn_);
+                    }
+                } else {
+                    sm_manager_->ihs_.at(index_name)->delete_entries(keys[i].data(), rids_.data(), rids_.size(),
+                                                                      context_->txn_);
+                }
+            }
+        }
+        // 2. 将record通过RmFileHandle从表的数据文件中删除
         for (const auto &rid : rids_) {
             fh_->delete_record(rid, context_);
         }
 
-        // 2. 如果表上存在索引，删除相关索引文件
-        for (size_t i = 0; i < tab_.indexes.size(); ++i) {
-            auto &index = tab_.indexes[i];
-            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
-            char *key = new char[index.col_tot_len];
-            int offset = 0;
-            for (size_t i = 0; i < index.col_num; ++i) {
-                memcpy(key + offset, rec.data + index.cols[i].offset, index.cols[i].len);
-                offset += index.cols[i].len;
-            }
-            ih->delete_entry(key, context_->txn_);
-            delete[] key;
-        }
-
         // lab4: 记录删除操作（for transaction rollback）
         for (const auto &rid : rids_) {
             WriteRecord *write_rec = new WriteRecord(WType::DELETE_TUPLE, tab_name_, rid);
@@ -0,0 +1,583 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "execution_defs.h"
+#include "execution_hash.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/* 等值连接。右儿子是build侧，整个读入内存建立开放定址的哈希表，左儿子是probe侧，逐条到哈希表中查找；
+ * 计划生成时把估计较小的输入放在右边。build侧超出内存预算时退化为grace hash join：
+ * 两侧都按哈希值的高位写入临时文件分区，再逐个分区建表、探测；分区的build侧仍超出预算时换一个哈希种子递归地再分区。
+ * 连接键规范化后按memcmp比较，类型相同的等值条件作为连接键，其余条件在连接后的元组上检查。
+ * 两侧都按批读取儿子节点，连接键直接从DataChunk的列中拼接：build侧的元组拼接为行格式存入rows_，
+ * probe侧只有找到匹配时才把元组拼接到连接结果中；按批输出时连接结果直接按列写入上层的DataChunk */
+class HashJoinExecutor : public AbstractExecutor {
+   private:
+    // 待处理的溢出分区，两侧的分区号相同。depth是分区内建表和再分区时哈希的种子，
+    // 再分区没有使build侧变小时（例如大量相同的key）splittable为false，之后不论大小都直接建表
+    struct Part {
+        std::FILE *build;                       // 每项是规范化的key加上右儿子的元组
+        std::FILE *probe;                       // 每项是规范化的key加上左儿子的元组
+        int depth;
+        bool splittable;
+    };
+
+    // 不能作为连接键的条件，两个字段都是连接后元组中的字段
+    struct Residual {
+        ColMeta lhs;
+        ColMeta rhs;
+        CompOp op;
+    };
+
+    std::unique_ptr<AbstractExecutor> left_;    // 左儿子节点，probe侧
+    std::unique_ptr<AbstractExecutor> right_;   // 右儿子节点，build侧
+    size_t len_;                                // join后获得的每条记录的长度
+    std::vector<ColMeta> cols_;                 // join后获得的记录的字段
+    size_t left_len_;
+    size_t right_len_;
+    bool isend;
+    std::vector<char> buf_;                     // 连接结果的缓冲区，每个元组复用，view()指向这里
+
+    std::vector<size_t> left_keys_;             // 连接键在左儿子的字段（也是DataChunk的列）中的下标
+    std::vector<size_t> right_keys_;            // 连接键在右儿子的字段中的下标，与left_keys_一一对应
+    std::vector<ColType> key_types_;
+    std::vector<int> key_lens_;
+    size_t key_len_;
+    std::vector<char> key_raw_;                 // 规范化之前拼接的连接键
+    std::vector<Residual> residuals_;
+
+    size_t mem_budget_;                         // build侧在内存中的字节数上限
+    size_t row_len_;                            // build侧每项的长度：规范化的key加上右儿子的元组
+    std::vector<char> rows_;                    // build侧的元组
+    std::vector<HashSlot> slots_;               // 槽位中的index为build侧元组的下标加一
+    size_t mask_;
+    bool built_;                                // 哈希表已经建好并且完整地在内存中，再次beginTuple()时直接复用
+    int depth_;                                 // 当前哈希表的种子，build侧完整地在内存中时为0
+
+    bool spilled_;                              // build侧超出了内存预算，按分区处理
+    std::vector<std::FILE *> build_parts_;      // 正在写入的build侧分区，build侧为空的分区为nullptr
+    std::vector<std::FILE *> probe_parts_;      // 正在写入的probe侧分区，对应的build侧分区为空时为nullptr
+    std::vector<Part> pending_;                 // 尚未处理的分区
+    Part part_;                                 // 正在处理的分区，part_.probe为nullptr表示还没有开始
+
+    bool probe_started_;
+    bool probing_;                              // 当前probe元组的匹配还没有找完
+    DataChunk probe_chunk_;                     // build侧在内存中时，左儿子的当前一批元组
+    size_t probe_pos_;                          // 当前probe元组在probe_chunk_有效行中的序号
+    std::vector<char> probe_key_;               // 当前probe元组规范化的key
+    std::vector<char> probe_buf_;               // 溢出时从分区中读出的probe项
+    uint32_t probe_hash_;
+    size_t slot_pos_;                           // 下一个要检查的槽位
+    const char *match_;                         // 当前元组对中build侧的元组，指向rows_
+
+   public:
+    HashJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right,
+                     std::vector<Condition> conds, size_t mem_budget = HASH_JOIN_MEM) {
+        left_ = std::move(left);
+        right_ = std::move(right);
+        left_len_ = left_->tupleLen();
+        right_len_ = right_->tupleLen();
+        len_ = left_len_ + right_len_;
+        cols_ = left_->cols();
+        auto right_cols = right_->cols();
+        for (auto &col : right_cols) {
+            col.offset += left_len_;
+        }
+        cols_.insert(cols_.end(), right_cols.begin(), right_cols.end());
+        isend = true;
+        buf_.resize(len_);
+
+        // 连接键和其余条件只在这里解析一次
+        key_len_ = 0;
+        for (auto &cond : conds) {
+            auto in = [](const std::vector<ColMeta> &cols, const TabCol &target) {
+                return std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+                    return col.tab_name == target.tab_name && col.name == target.col_name;
+                }) != cols.end();
+            };
+            if (cond.op == OP_EQ && !cond.is_rhs_val) {
+                const TabCol *left_col = nullptr, *right_col = nullptr;
+                if (in(left_->cols(), cond.lhs_col) && in(right_->cols(), cond.rhs_col)) {
+                    left_col = &cond.lhs_col;
+                    right_col = &cond.rhs_col;
+                } else if (in(left_->cols(), cond.rhs_col) && in(right_->cols(), cond.lhs_col)) {
+                    left_col = &cond.rhs_col;
+                    right_col = &cond.lhs_col;
+                }
+                if (left_col != nullptr) {
+                    auto lcol = get_col(left_->cols(), *left_col);
+                    auto rcol = get_col(right_->cols(), *right_col);
+                    if (lcol->type == rcol->type && lcol->len == rcol->len) {
+                        left_keys_.push_back(lcol - left_->cols().begin());
+                        right_keys_.push_back(rcol - right_->cols().begin());
+                        key_types_.push_back(lcol->type);
+                        key_lens_.push_back(lcol->len);
+                        key_len_ += lcol->len;
+                        continue;
+                    }
+                }
+            }
+            residuals_.push_back({*get_col(cols_, cond.lhs_col), *get_col(cols_, cond.rhs_col), cond.op});
+        }
+        if (left_keys_.empty()) {
+            throw InternalError("HashJoinExecutor: no equi-join condition");
+        }
+
+        mem_budget_ = mem_budget;
+        row_len_ = key_len_ + right_len_;
+        mask_ = 0;
+        built_ = false;
+        depth_ = 0;
+        spilled_ = false;
+        part_ = Part{nullptr, nullptr, 0, false};
+        key_raw_.resize(key_len_);
+        probe_started_ = false;
+        probing_ = false;
+        probe_pos_ = 0;
+        probe_key_.resize(key_len_);
+        probe_buf_.resize(key_len_ + left_len_);
+        probe_hash_ = 0;
+        slot_pos_ = 0;
+        match_ = nullptr;
+    }
+
+    ~HashJoinExecutor() override { close_parts(); }
+
+    size_t tupleLen() const override { return len_; };
+
+    const std::vector<ColMeta> &cols() const override { return cols_; };
+
+    std::string getType() override { return "HashJoinExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        probe_started_ = false;
+        probing_ = false;
+        isend = false;
+        if (!built_) {
+            close_parts();
+            rows_.clear();
+            slots_.clear();
+            build();
+        }
+        if (spilled_) {
+            partition_probe();
+        } else if (rows_.empty()) {
+            // build侧为空时不需要读probe侧
+            isend = true;
+            return;
+        }
+        advance();
+    }
+
+    void nextTuple() override {
+        assert(!isend);
+        advance();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        // advance()找到匹配时已经把连接结果拼接到buf_中
+        assert(!isend);
+        return TupleView(buf_.data(), len_);
+    }
+
+    // 按批输出：元组对直接从probe_chunk_（或溢出的probe项）和rows_按列写入chunk，不再拼接到buf_
+    bool NextBatch(DataChunk &chunk) override {
+        chunk.init(cols_);
+        size_t num_left = left_->cols().size();
+        while (!isend && !chunk.full()) {
+            append_match(chunk, num_left);
+            isend = !next_match();
+        }
+        return chunk.count() > 0;
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    // 把chunk第row行中下标为keys的各列拼接后规范化，写到dest
+    void make_key(const DataChunk &chunk, size_t row, const std::vector<size_t> &keys, char *dest) {
+        size_t offset = 0;
+        for (size_t key : keys) {
+            int len = chunk.cols()[key].len;
+            memcpy(key_raw_.data() + offset, chunk.value(key, row), len);
+            offset += len;
+        }
+        ix_normalize_key(key_raw_.data(), dest, key_types_, key_lens_);
+    }
+
+    static std::FILE *new_part() {
+        std::FILE *part = std::tmpfile();
+        if (part == nullptr) {
+            throw UnixError();
+        }
+        return part;
+    }
+
+    static void write_part(std::FILE *part, const char *data, size_t len) {
+        if (std::fwrite(data, len, 1, part) != 1) {
+            throw UnixError();
+        }
+    }
+
+    static bool read_part(std::FILE *part, char *data, size_t len) {
+        if (std::fread(data, len, 1, part) == 1) {
+            return true;
+        }
+        if (std::ferror(part)) {
+            throw UnixError();
+        }
+        return false;
+    }
+
+    static void close_part(std::FILE *&part) {
+        if (part != nullptr) {
+            std::fclose(part);
+            part = nullptr;
+        }
+    }
+
+    void close_parts() {
+        for (std::FILE *&part : build_parts_) {
+            close_part(part);
+        }
+        for (std::FILE *&part : probe_parts_) {
+            close_part(part);
+        }
+        for (auto &part : pending_) {
+            close_part(part.build);
+            close_part(part.probe);
+        }
+        close_part(part_.build);
+        close_part(part_.probe);
+        build_parts_.clear();
+        probe_parts_.clear();
+        pending_.clear();
+    }
+
+    /**
+     * @description: 读入整个build侧。超出内存预算时把已读入的部分和之后的元组都按分区写入build_parts_
+     */
+    void build() {
+        DataChunk chunk;
+        right_->beginTuple();
+        while (right_->NextBatch(chunk)) {
+            for (size_t i = 0; i < chunk.count(); i++) {
+                size_t offset = rows_.size();
+                rows_.resize(offset + row_len_);
+                make_key(chunk, chunk.sel(i), right_keys_, rows_.data() + offset);
+                chunk.gather(chunk.sel(i), rows_.data() + offset + key_len_);
+            }
+            if (build_parts_.empty() && rows_.size() + rows_.size() / row_len_ * 2 * sizeof(HashSlot) > mem_budget_) {
+                for (int i = 0; i < HASH_JOIN_PARTITIONS; i++) {
+                    build_parts_.push_back(new_part());
+                }
+            }
+            if (!build_parts_.empty()) {
+                for (size_t row = 0; row < rows_.size(); row += row_len_) {
+                    write_part(build_parts_[part_of<HASH_JOIN_PARTITIONS>(hash_key(rows_.data() + row, key_len_, 0))], rows_.data() + row, row_len_);
+                }
+                rows_.clear();
+            }
+        }
+        spilled_ = !build_parts_.empty();
+        if (!spilled_) {
+            depth_ = 0;
+            build_table();
+            built_ = true;
+        } else {
+            std::vector<char>().swap(rows_);
+        }
+    }
+
+    /**
+     * @description: 对rows_中的元组建立哈希表，槽位数是不小于元组数两倍的2的幂，冲突时线性探测
+     */
+    void build_table() {
+        size_t num_rows = rows_.size() / row_len_;
+        size_t num_slots = 16;
+        while (num_slots < num_rows * 2) {
+            num_slots <<= 1;
+        }
+        slots_.assign(num_slots, HashSlot{0, 0});
+        mask_ = num_slots - 1;
+        for (size_t i = 0; i < num_rows; i++) {
+            uint32_t h = hash_key(rows_.data() + i * row_len_, key_len_, depth_);
+            size_t pos = h & mask_;
+            while (slots_[pos].index != 0) {
+                pos = (pos + 1) & mask_;
+            }
+            slots_[pos] = HashSlot{h, static_cast<uint32_t>(i + 1)};
+        }
+    }
+
+    /**
+     * @description: 溢出时把整个probe侧按分区写入临时文件，build侧对应分区为空的元组直接丢弃
+     */
+    void partition_probe() {
+        open_probe_parts();
+        DataChunk chunk;
+        left_->beginTuple();
+        while (left_->NextBatch(chunk)) {
+            for (size_t i = 0; i < chunk.count(); i++) {
+                make_key(chunk, chunk.sel(i), left_keys_, probe_buf_.data());
+                std::FILE *part = probe_parts_[part_of<HASH_JOIN_PARTITIONS>(hash_key(probe_buf_.data(), key_len_, 0))];
+                if (part == nullptr) {
+                    continue;
+                }
+                chunk.gather(chunk.sel(i), probe_buf_.data() + key_len_);
+                write_part(part, probe_buf_.data(), probe_buf_.size());
+            }
+        }
+        push_parts(1, std::numeric_limits<long>::max());
+    }
+
+    // build_parts_写完后，为其中非空的分区建立probe侧的分区，空的分区关闭
+    void open_probe_parts() {
+        probe_parts_.assign(HASH_JOIN_PARTITIONS, nullptr);
+        for (int i = 0; i < HASH_JOIN_PARTITIONS; i++) {
+            std::fflush(build_parts_[i]);
+            if (std::ftell(build_parts_[i]) == 0) {
+                close_part(build_parts_[i]);
+            } else {
+                probe_parts_[i] = new_part();
+            }
+        }
+    }
+
+    // 把build_parts_和probe_parts_中成对的分区加入pending_；parent_size是再分区前build侧的字节数
+    void push_parts(int depth, long parent_size) {
+        for (int i = 0; i < HASH_JOIN_PARTITIONS; i++) {
+            if (build_parts_[i] != nullptr) {
+                bool splittable = std::ftell(build_parts_[i]) < parent_size;
+                pending_.push_back(Part{build_parts_[i], probe_parts_[i], depth, splittable});
+            }
+        }
+        build_parts_.clear();
+        probe_parts_.clear();
+    }
+
+    // 从头读出src中每项长为len的各项，按种子为depth的哈希值写入dest中对应的分区，返回读出的字节数
+    long scatter(std::FILE *src, size_t len, int depth, const std::vector<std::FILE *> &dest) {
+        std::rewind(src);
+        std::vector<char> entry(len);
+        long size = 0;
+        while (read_part(src, entry.data(), len)) {
+            std::FILE *part = dest[part_of<HASH_JOIN_PARTITIONS>(hash_key(entry.data(), key_len_, depth))];
+            if (part != nullptr) {
+                write_part(part, entry.data(), len);
+            }
+            size += len;
+        }
+        return size;
+    }
+
+    /**
+     * @description: 分区part_的build侧超出内存预算，两侧都按种子为part_.depth的哈希值的高位再分区，加入pending_
+     */
+    void split_part() {
+        for (int i = 0; i < HASH_JOIN_PARTITIONS; i++) {
+            build_parts_.push_back(new_part());
+        }
+        long size = scatter(part_.build, row_len_, part_.depth, build_parts_);
+        open_probe_parts();
+        scatter(part_.probe, probe_buf_.size(), part_.depth, probe_parts_);
+        push_parts(part_.depth + 1, size);
+    }
+
+    /**
+     * @description: 关闭当前分区，取出下一个待处理的分区，把build侧读入内存建立哈希表；
+     * 超出内存预算时再分区后继续取下一个。没有待处理的分区时返回false
+     */
+    bool load_part() {
+        while (true) {
+            close_part(part_.build);
+            close_part(part_.probe);
+            if (pending_.empty()) {
+                return false;
+            }
+            part_ = pending_.back();
+            pending_.pop_back();
+            std::rewind(part_.build);
+            rows_.clear();
+            bool fits = true;
+            while (true) {
+                size_t offset = rows_.size();
+                rows_.resize(offset + row_len_);
+                if (!read_part(part_.build, rows_.data() + offset, row_len_)) {
+                    rows_.resize(offset);
+                    break;
+                }
+                if (part_.splittable && rows_.size() + rows_.size() / row_len_ * 2 * sizeof(HashSlot) > mem_budget_) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) {
+                depth_ = part_.depth;
+                build_table();
+                std::rewind(part_.probe);
+                return true;
+            }
+            rows_.clear();
+            split_part();
+        }
+    }
+
+    /**
+     * @description: 取下一个probe元组，计算其key和哈希值；probe侧全部处理完时返回false
+     */
+    bool next_probe() {
+        if (!spilled_) {
+            if (!probe_started_) {
+                left_->beginTuple();
+                probe_started_ = true;
+                probe_chunk_.reset();
+                probe_pos_ = 0;
+            } else {
+                probe_pos_++;
+            }
+            while (probe_pos_ >= probe_chunk_.count()) {
+                if (!left_->NextBatch(probe_chunk_)) {
+                    return false;
+                }
+                probe_pos_ = 0;
+            }
+            make_key(probe_chunk_, probe_chunk_.sel(probe_pos_), left_keys_, probe_key_.data());
+        } else {
+            while (part_.probe == nullptr || !read_part(part_.probe, probe_buf_.data(), probe_buf_.size())) {
+                if (!load_part()) {
+                    return false;
+                }
+            }
+            memcpy(probe_key_.data(), probe_buf_.data(), key_len_);
+        }
+        probe_hash_ = hash_key(probe_key_.data(), key_len_, depth_);
+        slot_pos_ = probe_hash_ & mask_;
+        return true;
+    }
+
+    /**
+     * @description: 找到下一个满足所有连接条件的元组对，match_指向其中build侧的元组；有其余条件时连接结果已拼接到buf_中。
+     * 没有更多的元组对时返回false
+     */
+    bool next_match() {
+        while (true) {
+            if (!probing_) {
+                if (!next_probe()) {
+                    return false;
+                }
+                probing_ = true;
+            }
+            while (slots_[slot_pos_].index != 0) {
+                const HashSlot &slot = slots_[slot_pos_];
+                slot_pos_ = (slot_pos_ + 1) & mask_;
+                const char *row = rows_.data() + static_cast<size_t>(slot.index - 1) * row_len_;
+                if (slot.hash != probe_hash_ || memcmp(row, probe_key_.data(), key_len_) != 0) {
+                    continue;
+                }
+                match_ = row + key_len_;
+                if (residuals_.empty()) {
+                    return true;
+                }
+                compose(buf_.data());
+                if (check_residuals()) {
+                    return true;
+                }
+            }
+            probing_ = false;
+        }
+    }
+
+    // 把当前probe元组和match_按行格式拼接到dest
+    void compose(char *dest) const {
+        if (spilled_) {
+            memcpy(dest, probe_buf_.data() + key_len_, left_len_);
+        } else {
+            probe_chunk_.gather(probe_chunk_.sel(probe_pos_), dest);
+        }
+        memcpy(dest + left_len_, match_, right_len_);
+    }
+
+    // 找到下一个元组对并拼接到buf_中；没有时设置isend
+    void advance() {
+        isend = !next_match();
+        if (!isend && residuals_.empty()) {
+            compose(buf_.data());
+        }
+    }
+
+    // 把当前的元组对作为新的一行按列写入chunk，cols_的前num_left列来自左儿子
+    void append_match(DataChunk &chunk, size_t num_left) const {
+        size_t row = chunk.add_row();
+        for (size_t i = 0; i < cols_.size(); i++) {
+            const char *src;
+            if (i >= num_left) {
+                src = match_ + (cols_[i].offset - left_len_);
+            } else if (spilled_) {
+                src = probe_buf_.data() + key_len_ + cols_[i].offset;
+            } else {
+                src = probe_chunk_.value(i, probe_chunk_.sel(probe_pos_));
+            }
+            memcpy(chunk.value(i, row), src, cols_[i].len);
+        }
+    }
+
+    // 分析阶段已拒绝类型不同的条件。长度不同的字符串按较短的长度比较，相等时较长一边多出的部分不全为0则较大
+    static int compare(const char *lhs, const ColMeta &lcol, const char *rhs, const ColMeta &rcol) {
+        if (lcol.type != TYPE_STRING || lcol.len == rcol.len) {
+            return ix_compare(lhs, rhs, rcol.type, rcol.len);
+        }
+        int len = std::min(lcol.len, rcol.len);
+        int cmp = memcmp(lhs, rhs, len);
+        if (cmp != 0) {
+            return cmp;
+        }
+        const char *rest = lcol.len > len ? lhs + len : rhs + len;
+        int rest_len = std::max(lcol.len, rcol.len) - len;
+        bool zero = std::all_of(rest, rest + rest_len, [](char c) { return c == 0; });
+        return zero ? 0 : (lcol.len > len ? 1 : -1);
+    }
+
+    bool check_residuals() const {
+        for (auto &cond : residuals_) {
+            assert(cond.lhs.type == cond.rhs.type);
+            int cmp = compare(buf_.data() + cond.lhs.offset, cond.lhs, buf_.data() + cond.rhs.offset, cond.rhs);
+            bool found;
+            switch (cond.op) {
+                case OP_EQ: found = cmp == 0; break;
+                case OP_NE: found = cmp != 0; break;
+                case OP_LT: found = cmp < 0; break;
+                case OP_GT: found = cmp > 0; break;
+                case OP_LE: found = cmp <= 0; break;
+                case OP_GE: found = cmp >= 0; break;
+                default: found = false; break;
+            }
+            if (!found) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -10,12 +10,23 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
+#include <limits>
+
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
 #include "index/ix.h"
 #include "system/sm.h"
 
+// 索引扫描访问表数据的方式
+enum class IndexScanMode {
+    KEY_ORDER,   // 按key的顺序逐条访问表数据
+    INDEX_ONLY,  // 覆盖索引扫描：输出的字段都在索引中，直接从key构造元组，不访问表数据
+    RID_ORDER    // 先收集范围内所有的rid并按页号排序，每个表数据页面只访问一次（bitmap heap scan）；
+                 // 范围内不足BITMAP_SCAN_MIN_ROWS个rid时不排序，仍按key的顺序访问
+};
+
 class IndexScanExecutor : public AbstractExecutor {
    private:
     std::string tab_name_;                      // 表名称
@@ -29,14 +40,32 @@ class IndexScanExecutor : public AbstractExecutor {
     std::vector<std::string> index_col_names_;  // index scan涉及到的索引包含的字段
     IndexMeta index_meta_;                      // index scan涉及到的索引元数据
 
+    // 由fed_conds_推导出的扫描键范围，lower_key_为空时扫描整个叶结点链表
+    std::vector<char> lower_key_;               // 范围下界，未受约束的后缀字段填充为最小值或最大值
+    std::vector<char> upper_key_;               // 范围上界
+    bool lower_open_ = false;                   // 下界不包含lower_key_本身，用upper_bound定位
+    bool upper_open_ = false;                   // 上界不包含upper_key_本身，用lower_bound定位
+    bool empty_range_ = false;                  // 条件互相矛盾，范围为空
+
+    IndexScanMode mode_;                        // 访问表数据的方式
+    bool reverse_;                              // 按key的逆序扫描，RID_ORDER时不起作用
+    std::vector<char> key_buf_;                 // INDEX_ONLY时当前元组的缓冲区，view_指向这里
+    std::vector<Rid> sorted_rids_;              // RID_ORDER时范围内按(page_no,slot_no)排序的rid，范围较小时按key的顺序
+    size_t rid_pos_ = 0;                        // RID_ORDER时rid_在sorted_rids_中的下标
+    std::vector<page_id_t> heap_pages_;         // RID_ORDER时需要访问的表数据页面，升序且不重复
+    size_t page_pos_ = 0;                       // 已访问的页面个数，即当前页面之后的页面在heap_pages_中的下标
+    size_t prefetch_pos_ = 0;                   // heap_pages_中第一个尚未预读的页面的下标
+
     Rid rid_;
-    std::unique_ptr<RecScan> scan_;
+    std::unique_ptr<IxScan> scan_;
+    std::optional<RmPageHandle> page_handle_;   // rid_所在的页面，保持固定使view_有效
+    TupleView view_;                            // rid_对应记录在页面中的视图
 
     SmManager *sm_manager_;
 
    public:
     IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, std::vector<std::string> index_col_names,
-                    Context *context) {
+                    Context *context, IndexScanMode mode = IndexScanMode::KEY_ORDER, bool reverse = false) {
         sm_manager_ = sm_manager;
         context_ = context;
         tab_name_ = std::move(tab_name);
@@ -46,8 +75,23 @@ class IndexScanExecutor : public AbstractExecutor {
         index_col_names_ = index_col_names; 
         index_meta_ = *(tab_.get_index_meta(index_col_names_));
         fh_ = sm_manager_->fhs_.at(tab_name_).get();
-        cols_ = tab_.cols;
-        len_ = cols_.back().offset + cols_.back().len;
+        // 哈希索引只支持单点查询，查到的rid没有顺序，总是排序后按页号访问表数据
+        mode_ = index_meta_.type == INDEX_HASH ? IndexScanMode::RID_ORDER : mode;
+        reverse_ = reverse;
+        if (mode_ == IndexScanMode::INDEX_ONLY) {
+            // 输出元组的格式与key相同，即索引字段依次排列
+            cols_ = index_meta_.cols;
+            int offset = 0;
+            for (auto &col : cols_) {
+                col.offset = offset;
+                offset += col.len;
+            }
+            len_ = index_meta_.col_tot_len;
+            key_buf_.resize(len_);
+        } else {
+            cols_ = tab_.cols;
+            len_ = cols_.back().offset + cols_.back().len;
+        }
         std::map<CompOp, CompOp> swap_op = {
             {OP_EQ, OP_EQ}, {OP_NE, OP_NE}, {OP_LT, OP_GT}, {OP_GT, OP_LT}, {OP_LE, OP_GE}, {OP_GE, OP_LE},
         };
@@ -62,84 +106,332 @@ class IndexScanExecutor : public AbstractExecutor {
             }
         }
         fed_conds_ = conds_;
+        build_key_range();
+        if (index_meta_.type == INDEX_HASH && !empty_range_ &&
+            (lower_key_.empty() || lower_key_ != upper_key_ || lower_open_ || upper_open_)) {
+            throw InternalError("IndexScanExecutor: hash index requires equality conditions on all index columns");
+        }
+    }
+
+    /**
+     * @brief 根据fed_conds_推导扫描的键范围：索引最左前缀字段上的等值条件，加上随后一个字段上的范围条件；
+     * 被键范围完全蕴含的条件从fed_conds_中删去，不再对每条记录重复检查
+     */
+    void build_key_range() {
+        int col_num = index_meta_.cols.size();
+        std::vector<const char *> lower(col_num, nullptr), upper(col_num, nullptr);
+        std::vector<bool> lower_open(col_num, false), upper_open(col_num, false);
+        std::vector<std::vector<size_t>> used(col_num);  // 每个字段上参与推导的条件在fed_conds_中的下标
+        for (size_t i = 0; i < fed_conds_.size(); i++) {
+            const Condition &cond = fed_conds_[i];
+            if (!cond.is_rhs_val || cond.op == OP_NE) {
+                continue;
+            }
+            int k = 0;
+            while (k < col_num && index_meta_.cols[k].name != cond.lhs_col.col_name) {
+                k++;
+            }
+            // 常值类型与字段不一致时无法直接与索引中的key比较，留给check_conds处理
+            if (k == col_num || cond.rhs_val.type != index_meta_.cols[k].type) {
+                continue;
+            }
+            const ColMeta &col = index_meta_.cols[k];
+            const char *val = cond.rhs_val.raw->data;
+            // 同一字段上有多个条件时取交集：下界取较大者，上界取较小者，相等时开区间更紧
+            if (cond.op == OP_EQ || cond.op == OP_GT || cond.op == OP_GE) {
+                bool open = cond.op == OP_GT;
+                int cmp = lower[k] == nullptr ? 1 : ix_compare(val, lower[k], col.type, col.len);
+                if (cmp > 0 || (cmp == 0 && open)) {
+                    lower[k] = val;
+                    lower_open[k] = open;
+                }
+            }
+            if (cond.op == OP_EQ || cond.op == OP_LT || cond.op == OP_LE) {
+                bool open = cond.op == OP_LT;
+                int cmp = upper[k] == nullptr ? -1 : ix_compare(val, upper[k], col.type, col.len);
+                if (cmp < 0 || (cmp == 0 && open)) {
+                    upper[k] = val;
+                    upper_open[k] = open;
+                }
+            }
+            used[k].push_back(i);
+        }
+
+        // 等值前缀之后的第一个字段是范围字段，再往后的字段不能用于定位
+        int range_cols = 0;
+        while (range_cols < col_num && lower[range_cols] != nullptr && upper[range_cols] != nullptr &&
+               !lower_open[range_cols] && !upper_open[range_cols] &&
+               ix_compare(lower[range_cols], upper[range_cols], index_meta_.cols[range_cols].type,
+                          index_meta_.cols[range_cols].len) == 0) {
+            range_cols++;
+        }
+        if (range_cols < col_num && (lower[range_cols] != nullptr || upper[range_cols] != nullptr)) {
+            range_cols++;
+        }
+        if (range_cols == 0) {
+            return;
+        }
+        int last = range_cols - 1;
+        lower_open_ = lower_open[last];
+        upper_open_ = upper_open[last];
+        if (lower[last] != nullptr && upper[last] != nullptr) {
+            int cmp = ix_compare(lower[last], upper[last], index_meta_.cols[last].type, index_meta_.cols[last].len);
+            empty_range_ = cmp > 0 || (cmp == 0 && (lower_open_ || upper_open_));
+        }
+
+        // 下界为开区间时后缀字段取最大值，使等于下界的key全部落在范围之外；上界同理
+        lower_key_.resize(index_meta_.col_tot_len);
+        upper_key_.resize(index_meta_.col_tot_len);
+        int offset = 0;
+        for (int k = 0; k < col_num; k++) {
+            const ColMeta &col = index_meta_.cols[k];
+            if (k < range_cols && lower[k] != nullptr) {
+                memcpy(lower_key_.data() + offset, lower[k], col.len);
+            } else {
+                fill_key_col(lower_key_.data() + offset, col, lower_open_);
+            }
+            if (k < range_cols && upper[k] != nullptr) {
+                memcpy(upper_key_.data() + offset, upper[k], col.len);
+            } else {
+                fill_key_col(upper_key_.data() + offset, col, !upper_open_);
+            }
+            offset += col.len;
+        }
+
+        std::vector<bool> implied(fed_conds_.size(), false);
+        for (int k = 0; k < range_cols; k++) {
+            for (size_t i : used[k]) {
+                implied[i] = true;
+            }
+        }
+        std::vector<Condition> rest;
+        for (size_t i = 0; i < fed_conds_.size(); i++) {
+            if (!implied[i]) {
+                rest.push_back(std::move(fed_conds_[i]));
+            }
+        }
+        fed_conds_ = std::move(rest);
+    }
+
+    /**
+     * @brief 把key中的一个字段填充为该类型的最小值或最大值
+     */
+    static void fill_key_col(char *dest, const ColMeta &col, bool max) {
+        switch (col.type) {
+            case TYPE_INT: {
+                int val = max ? std::numeric_limits<int>::max() : std::numeric_limits<int>::min();
+                memcpy(dest, &val, sizeof(int));
+                break;
+            }
+            case TYPE_FLOAT: {
+                float val = max ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+                memcpy(dest, &val, sizeof(float));
+                break;
+            }
+            case TYPE_STRING:
+                // 字符串按memcmp比较，全0xff最大，全0最小
+                memset(dest, max ? 0xff : 0, col.len);
+                break;
+            default:
+                throw InternalError("Unexpected data type");
+        }
     }
     
     // index_scan和seq_scan在这里的逻辑应该是一样的
     // 二者的主要区别应该在ix_scan和rm_scan里next的实现上
     // 外部接口的差别在于scan_的初始化上
     void beginTuple() override {
-        auto ih_ = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_,index_col_names_)).get();
-        // find lower & upper for ixscan, using ix_manager's lower & upper
-        // lower iid指向第一个有效的rid
-        // upper end指向末尾
-        Iid lower = ih_->leaf_begin();
-        Iid upper = ih_->leaf_end();
-        scan_ = std::make_unique<IxScan>(ih_,lower,upper,sm_manager_->get_bpm());
-        if(scan_->is_end()){
+        if (index_meta_.type == INDEX_HASH) {
+            collect_rids();
+        } else {
+            begin_btree_scan();
+        }
+        if(at_end()){
             return ;
         }
-        for(;!scan_->is_end();scan_->next()){
-            rid_ = scan_->rid();
-            auto cur_record_ptr = fh_->get_record(rid_,context_);
-            if(check_conds(cur_record_ptr.get())){
+        for(;!at_end();advance()){
+            fetch_tuple();
+            if(check_conds(view_)){
                 break;
             }
         }
+        if(at_end()){
+            // 扫描结束，不再需要固定最后一个页面
+            page_handle_.reset();
+        }
         return;
     }
 
+    /**
+     * @brief 按键范围在B+树上构造scan_，RID_ORDER时随即收集范围内所有的rid
+     */
+    void begin_btree_scan() {
+        auto ih_ = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_,index_col_names_)).get();
+        // find lower & upper for ixscan, using ix_manager's lower & upper
+        // lower iid指向范围内第一个有效的rid
+        // upper指向范围内最后一个rid的后一个
+        Iid lower, upper;
+        if (empty_range_) {
+            lower = upper = ih_->leaf_end();
+        } else if (lower_key_.empty()) {
+            lower = ih_->leaf_begin();
+            upper = ih_->leaf_end();
+        } else {
+            lower = lower_open_ ? ih_->upper_bound(lower_key_.data()) : ih_->lower_bound(lower_key_.data());
+            upper = upper_open_ ? ih_->lower_bound(upper_key_.data()) : ih_->upper_bound(upper_key_.data());
+        }
+        scan_ = std::make_unique<IxScan>(ih_,lower,upper,sm_manager_->get_bpm(),reverse_ && mode_ != IndexScanMode::RID_ORDER);
+        if (mode_ == IndexScanMode::RID_ORDER) {
+            collect_rids();
+        }
+    }
+
     void nextTuple() override {
-        if(scan_->is_end()){
+        if(at_end()){
             return;
         }
-        for(scan_->next();!scan_->is_end();scan_->next()){
-            rid_ = scan_->rid();
-            auto cur_record_ptr = fh_->get_record(rid_,context_);
-            if(check_conds(cur_record_ptr.get())){
+        for(advance();!at_end();advance()){
+            fetch_tuple();
+            if(check_conds(view_)){
                 break;
             }
         }
+        if(at_end()){
+            // 扫描结束，不再需要固定最后一个页面
+            page_handle_.reset();
+        }
+    }
+
+    /**
+     * @brief 遍历索引范围（哈希索引则查找lower_key_），收集所有的rid并按页号排序，同时记录需要访问的表数据页面。
+     * B+树范围内的rid不足BITMAP_SCAN_MIN_ROWS个时，排序和预读节省不了多少页面访问，保留key的顺序
+     */
+    void collect_rids() {
+        sorted_rids_.clear();
+        if (index_meta_.type == INDEX_HASH) {
+            if (!empty_range_) {
+                auto ih = sm_manager_->hash_ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index_col_names_)).get();
+                ih->get_value(lower_key_.data(), &sorted_rids_, context_->txn_);
+            }
+        } else {
+            for (; !scan_->is_end(); scan_->next()) {
+                sorted_rids_.push_back(scan_->rid());
+            }
+            if (sorted_rids_.size() < BITMAP_SCAN_MIN_ROWS) {
+                heap_pages_.clear();
+                rid_pos_ = page_pos_ = prefetch_pos_ = 0;
+                return;
+            }
+        }
+        std::sort(sorted_rids_.begin(), sorted_rids_.end(), [](const Rid &a, const Rid &b) {
+            return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+        });
+        heap_pages_.clear();
+        for (auto &rid : sorted_rids_) {
+            if (heap_pages_.empty() || heap_pages_.back() != rid.page_no) {
+                heap_pages_.push_back(rid.page_no);
+            }
+        }
+        rid_pos_ = page_pos_ = prefetch_pos_ = 0;
+    }
+
+    /**
+     * @brief RID_ORDER时每进入一个新的表数据页面调用一次：已预读但尚未访问的页面不足PREFETCH_MIN_PAGES时，
+     * 预读heap_pages_中随后的PREFETCH_MAX_PAGES个页面，页号连续的页面合并为一次预读
+     */
+    void prefetch_heap_pages() {
+        page_pos_++;
+        if (prefetch_pos_ > page_pos_ + PREFETCH_MIN_PAGES || prefetch_pos_ == heap_pages_.size()) {
+            return;
+        }
+        prefetch_pos_ = std::max(prefetch_pos_, page_pos_);
+        size_t end = std::min(prefetch_pos_ + PREFETCH_MAX_PAGES, heap_pages_.size());
+        while (prefetch_pos_ < end) {
+            size_t run = prefetch_pos_ + 1;
+            while (run < end && heap_pages_[run] == heap_pages_[run - 1] + 1) {
+                run++;
+            }
+            sm_manager_->get_bpm()->prefetch(PageId{fh_->GetFd(), heap_pages_[prefetch_pos_]},
+                                             static_cast<int>(run - prefetch_pos_));
+            prefetch_pos_ = run;
+        }
+    }
+
+    // 当前位置是否已越过范围内的最后一个元组
+    bool at_end() const {
+        return mode_ == IndexScanMode::RID_ORDER ? rid_pos_ == sorted_rids_.size() : scan_->is_end();
+    }
+
+    // 移动到范围内的下一个元组
+    void advance() {
+        if (mode_ == IndexScanMode::RID_ORDER) {
+            rid_pos_++;
+        } else {
+            scan_->next();
+        }
+    }
+
+    /**
+     * @brief 读取当前位置的元组，设置rid_和view_；覆盖索引扫描只复制key，不固定表数据页面
+     */
+    void fetch_tuple() {
+        if (mode_ == IndexScanMode::INDEX_ONLY) {
+            rid_ = scan_->rid_and_key(key_buf_.data());
+            context_->lock_mgr_->lock_IS_on_table(context_->txn_, fh_->GetFd());
+            context_->lock_mgr_->lock_shared_on_record(context_->txn_, rid_, fh_->GetFd());
+            view_ = TupleView(key_buf_.data(), len_);
+        } else if (mode_ == IndexScanMode::RID_ORDER) {
+            rid_ = sorted_rids_[rid_pos_];
+            if (!page_handle_ || page_handle_->page->get_page_id().page_no != rid_.page_no) {
+                prefetch_heap_pages();
+            }
+            view_ = fh_->get_record_view(rid_, page_handle_, context_);
+        } else {
+            rid_ = scan_->rid();
+            view_ = fh_->get_record_view(rid_, page_handle_, context_);
+        }
     }
 
     std::unique_ptr<RmRecord> Next() override {
-        return fh_->get_record(rid_,context_);
+        return view_.to_record();
     }
 
+    TupleView view() override { return view_; }
+
     Rid &rid() override { return rid_; }
 
     size_t tupleLen() const {return len_;}
 
-    bool check_conds(RmRecord* record_ptr){
+    bool check_conds(const TupleView &record){
         int len = fed_conds_.size();
         if(len == 0)
             return true;
-        bool found = check_cond(fed_conds_[0],record_ptr);
+        bool found = check_cond(fed_conds_[0],record);
         for(int i=1;i<len;i++){
-            found &= check_cond(fed_conds_[i],record_ptr);
+            found &= check_cond(fed_conds_[i],record);
             if(!found)
                 return false;
         }
         return found;
     }
 
-    bool check_cond(Condition cond_, RmRecord* cur_record_ptr){
+    bool check_cond(const Condition &cond_, const TupleView &cur_record){
         // 1. 获取被比较的左列值
         auto left_col_it = get_col(cols_,cond_.lhs_col);
-        char* left_val = cur_record_ptr->data + left_col_it->offset;
+        const char* left_val = cur_record.data + left_col_it->offset;
         int len = left_col_it->len;
         // 2. 检查右列是否是常值，并获取相应的列值/常值
-        char* right_val;
+        const char* right_val;
         ColType col_type;
         if(cond_.is_rhs_val){
             // 常值
-            Value right_value = cond_.rhs_val;
-            right_val = right_value.raw->data;
-            col_type = right_value.type;
+            right_val = cond_.rhs_val.raw->data;
+            col_type = cond_.rhs_val.type;
         }
         else{
             // 同左值
             auto right_col_it = get_col(cols_,cond_.rhs_col);
-            right_val = cur_record_ptr->data + right_col_it->offset;
+            right_val = cur_record.data + right_col_it->offset;
             col_type = right_col_it->type;
         }
         // 3. 根据比较条件判断true false
@@ -158,19 +450,19 @@ class IndexScanExecutor : public AbstractExecutor {
                 break;
             }
             case OP_LT:{
-                found = (cmp==-1);
+                found = (cmp<0);
                 break;
             }
             case OP_GT:{
-                found = (cmp==1);
+                found = (cmp>0);
                 break;
             }
             case OP_LE:{
-                found = (cmp!=1);
+                found = (cmp<=0);
                 break;
             }
             case OP_GE:{
-                found = (cmp!=-1);
+                found = (cmp>=0);
                 break;
             }
         }
@@ -182,5 +474,5 @@ class IndexScanExecutor : public AbstractExecutor {
         return cols_;
     };
 
-    bool is_end() const { return scan_->is_end(); };
+    bool is_end() const { return at_end(); };
 };
\ No newline at end of file
@@ -57,14 +57,18 @@ class InsertExecutor : public AbstractExecutor {
         // 2. 如果表上存在索引，将record对象插入到相关索引文件中
         for(size_t i = 0; i < tab_.indexes.size(); ++i) {
             auto& index = tab_.indexes[i];
-            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
-            char* key = new char[index.col_tot_len];
+            std::string index_name = sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols);
+            std::vector<char> key(index.col_tot_len);
             int offset = 0;
             for(size_t i = 0; i < index.col_num; ++i) {
-                memcpy(key + offset, rec.data + index.cols[i].offset, index.cols[i].len);
+                memcpy(key.data() + offset, rec.data + index.cols[i].offset, index.cols[i].len);
                 offset += index.cols[i].len;
             }
-            ih->insert_entry(key, rid_, context_->txn_);
+            if (index.type == INDEX_HASH) {
+                sm_manager_->hash_ihs_.at(index_name)->insert_entry(key.data(), rid_, context_->txn_);
+            } else {
+                sm_manager_->ihs_.at(index_name)->insert_entry(key.data(), rid_, context_->txn_);
+            }
         }
 
         // lab4: 记录插入操作（for transaction rollback）
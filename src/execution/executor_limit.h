@@ -0,0 +1,67 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+// LIMIT ... OFFSET：跳过儿子节点的前offset个元组，之后最多输出limit个；输出够limit个后不再向儿子节点取元组
+class LimitExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> prev_;
+    size_t limit_;
+    size_t offset_;
+    size_t count_;                              // 已输出的元组数
+
+   public:
+    LimitExecutor(std::unique_ptr<AbstractExecutor> prev, size_t limit, size_t offset) {
+        prev_ = std::move(prev);
+        limit_ = limit;
+        offset_ = offset;
+        count_ = 0;
+    }
+
+    size_t tupleLen() const override { return prev_->tupleLen(); };
+
+    const std::vector<ColMeta> &cols() const override { return prev_->cols(); };
+
+    std::string getType() override { return "LimitExecutor"; };
+
+    bool is_end() const override { return count_ >= limit_ || prev_->is_end(); };
+
+    void beginTuple() override {
+        count_ = 0;
+        if (limit_ == 0) {
+            return;
+        }
+        prev_->beginTuple();
+        for (size_t i = 0; i < offset_ && !prev_->is_end(); i++) {
+            prev_->nextTuple();
+        }
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        if (++count_ < limit_) {
+            prev_->nextTuple();
+        }
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return prev_->Next();
+    }
+
+    TupleView view() override { return prev_->view(); }
+
+    Rid &rid() override { return prev_->rid(); }
+};
@@ -24,6 +24,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
 
     std::vector<Condition> fed_conds_;          // join条件 
     bool isend;
+    std::vector<char> buf_;                     // 连接结果的缓冲区，每个元组复用，view()指向这里
 
    public:
     NestedLoopJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right, 
@@ -40,9 +41,11 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
         cols_.insert(cols_.end(), right_cols.begin(), right_cols.end());
         isend = false;
         fed_conds_ = std::move(conds);
-
+        buf_.resize(len_);
     }
 
+    size_t tupleLen() const { return len_; };
+
     const std::vector<ColMeta> &cols() const {
         // std::vector<ColMeta> *_cols = nullptr;
         return cols_;
@@ -61,11 +64,12 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
         if(!right_->is_end())
             right_->nextTuple();
         while(!left_->is_end()){
-            auto left_rec = left_->Next();
+            // 左侧的视图在left_->nextTuple()之前一直有效，不需要物化
+            TupleView left_rec = left_->view();
             while(!right_->is_end() && !found_pair){
-                auto right_rec = right_->Next();
+                TupleView right_rec = right_->view();
                 // check conds
-                if(check_conds(left_rec.get(),right_rec.get())){
+                if(check_conds(left_rec,right_rec)){
                     found_pair = true;
                     return;
                 }
@@ -82,22 +86,22 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
     }
 
     std::unique_ptr<RmRecord> Next() override {
-        // 处理连接操作TODO
+        return view().to_record();
+    }
+
+    TupleView view() override {
         // 这时候left和right的next已经符合条件，直接进行连接
-        // check is_end
         assert(!isend);
-        // join
-        auto left_rec = left_->Next();
-        auto right_rec = right_->Next();
-        auto new_rec = std::make_unique<RmRecord>(len_);
-        memcpy(new_rec->data,left_rec->data,left_rec->size);
-        memcpy(new_rec->data+left_rec->size,right_rec->data,right_rec->size);
-        return new_rec;
+        TupleView left_rec = left_->view();
+        TupleView right_rec = right_->view();
+        memcpy(buf_.data(),left_rec.data,left_rec.size);
+        memcpy(buf_.data()+left_rec.size,right_rec.data,right_rec.size);
+        return TupleView(buf_.data(), len_);
     }
 
     Rid &rid() override { return _abstract_rid; }
 
-    bool check_conds(RmRecord* left_rec, RmRecord* right_rec){
+    bool check_conds(const TupleView &left_rec, const TupleView &right_rec){
         int len = fed_conds_.size();
         if(!len){
             return true;
@@ -112,12 +116,12 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
         return ret;
     }
 
-    bool check_cond(RmRecord* left_rec, RmRecord* right_rec, Condition cond_){
+    bool check_cond(const TupleView &left_rec, const TupleView &right_rec, const Condition &cond_){
         // TODO: 没处理类型转换
         auto left_col_it = left_->get_col(left_->cols(),cond_.lhs_col);
         auto right_col_it = right_->get_col(right_->cols(),cond_.rhs_col);
-        char* left_val = left_rec->data + left_col_it->offset;
-        char* right_val = right_rec->data + right_col_it->offset;
+        const char* left_val = left_rec.data + left_col_it->offset;
+        const char* right_val = right_rec.data + right_col_it->offset;
         assert(left_col_it->type == right_col_it->type);
         int cmp = ix_compare(left_val,right_val,right_col_it->type,right_col_it->len);
         bool found;
@@ -133,19 +137,19 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                 break;
             }
             case OP_LT:{
-                found = (cmp==-1);
+                found = (cmp<0);
                 break;
             }
             case OP_GT:{
-                found = (cmp==1);
+                found = (cmp>0);
                 break;
             }
             case OP_LE:{
-                found = (cmp!=1);
+                found = (cmp<=0);
                 break;
             }
             case OP_GE:{
-                found = (cmp!=-1);
+                found = (cmp>=0);
                 break;
             }
         }
@@ -21,6 +21,8 @@ class ProjectionExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;                     // 需要投影的字段 me:投影结束以后的colMeta串
     size_t len_;                                    // 字段总长度
     std::vector<size_t> sel_idxs_;                  // me: 被选择的列在提取前的index（第几列）
+    std::vector<char> buf_;                         // 投影结果的缓冲区，每个元组复用，view()指向这里
+    DataChunk input_;                               // NextBatch()时儿子节点的一批元组
 
    public:
     ProjectionExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &sel_cols) {
@@ -37,6 +39,7 @@ class ProjectionExecutor : public AbstractExecutor {
             cols_.push_back(col);
         }
         len_ = curr_offset;
+        buf_.resize(len_);
     }
 
     size_t tupleLen() const { return len_; };
@@ -52,22 +55,31 @@ class ProjectionExecutor : public AbstractExecutor {
     }
 
     std::unique_ptr<RmRecord> Next() override {
-        // 提取出对应列的数据，组装成一条新的记录，返回给上层
-        auto child_rec = prev_->Next();
-        auto ret_rec = std::make_unique<RmRecord>(len_);
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        // 提取出对应列的数据，组装到buf_中，返回给上层
+        TupleView child_rec = prev_->view();
         int sel_num = sel_idxs_.size();
-        auto prev_cols = prev_->cols();
+        auto &prev_cols = prev_->cols();
 
         for(int i=0;i<sel_num;i++){
-            // 对于cols_里的每一列，需要找到它在child_rec里的offset、len，以及它未来在ret_rec里的offset，并使用memcpy进行复制
-            ColMeta prev_col = prev_cols[sel_idxs_[i]];
-            ColMeta cur_col = cols_[i];
-            char* prev_val = child_rec->data+prev_col.offset;
-            char* cur_val = ret_rec->data + cur_col.offset;
-            int len = prev_col.len;
-            memcpy(cur_val,prev_val,len);
+            // 对于cols_里的每一列，需要找到它在child_rec里的offset、len，以及它在buf_里的offset，并使用memcpy进行复制
+            const ColMeta &prev_col = prev_cols[sel_idxs_[i]];
+            memcpy(buf_.data() + cols_[i].offset, child_rec.data + prev_col.offset, prev_col.len);
+        }
+        return TupleView(buf_.data(), len_);
+    }
+
+    // 按批投影：整列复制被选择的字段，有效行不变
+    bool NextBatch(DataChunk &chunk) override {
+        if (!prev_->NextBatch(input_)) {
+            return false;
         }
-        return ret_rec;
+        chunk.init(cols_);
+        chunk.project(input_, sel_idxs_);
+        return true;
     }
 
     Rid &rid() override { return _abstract_rid; }
@@ -24,9 +24,12 @@ class SeqScanExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;         // scan后生成的记录的字段
     size_t len_;                        // scan后生成的每条记录的长度
     std::vector<Condition> fed_conds_;  // 同conds_，两个字段相同
+    BatchFilter filter_;                // NextBatch()按批计算的fed_conds_
 
     Rid rid_;                           // me:当前指向的
     std::unique_ptr<RecScan> scan_;     // table_iterator
+    std::optional<RmPageHandle> page_handle_;  // rid_所在的页面，保持固定使view_有效
+    TupleView view_;                    // rid_对应记录在页面中的视图
 
     SmManager *sm_manager_;
 
@@ -43,6 +46,7 @@ class SeqScanExecutor : public AbstractExecutor {
         context_ = context;
 
         fed_conds_ = conds_;
+        filter_ = BatchFilter(cols_, fed_conds_);
     }
 
     size_t tupleLen() const { return len_; };
@@ -52,8 +56,8 @@ class SeqScanExecutor : public AbstractExecutor {
      *
      */
     void beginTuple() override {
-        // 初始化的时候scan会指向第一个有值的
-        scan_ = std::make_unique<RmScan>(fh_);
+        // 初始化的时候scan会指向第一个有值的；大表使用私有的ring buffer，避免冲掉缓冲池中的热点页面
+        scan_ = std::make_unique<RmScan>(fh_, BufferAccessType::BULK_READ);
         // 手动让scan指向第一个符合条件的
         if(scan_->is_end()){
             return;
@@ -61,11 +65,15 @@ class SeqScanExecutor : public AbstractExecutor {
         // TODO: 如果表是空着的，外层直接Next()可能会出事
         for(;!scan_->is_end();scan_->next()){
             rid_ = scan_->rid();
-            auto cur_record_ptr = fh_->get_record(rid_,context_);
-            if(check_conds(cur_record_ptr.get())){
+            view_ = fh_->get_record_view(rid_, page_handle_, context_);
+            if(check_conds(view_)){
                 break;
             }
         }
+        if(scan_->is_end()){
+            // 扫描结束，不再需要固定最后一个页面
+            page_handle_.reset();
+        }
         return;
     }
 
@@ -80,11 +88,15 @@ class SeqScanExecutor : public AbstractExecutor {
         for(scan_->next();!scan_->is_end();scan_->next()){
             rid_ = scan_->rid();
             // TODO: if table is empty, means rid_ = {0,-1};
-            auto cur_record_ptr = fh_->get_record(rid_,context_);
-            if(check_conds(cur_record_ptr.get())){
+            view_ = fh_->get_record_view(rid_, page_handle_, context_);
+            if(check_conds(view_)){
                 break;
             }
         }
+        if(scan_->is_end()){
+            // 扫描结束，不再需要固定最后一个页面
+            page_handle_.reset();
+        }
     }
 
     /**
@@ -97,45 +109,68 @@ class SeqScanExecutor : public AbstractExecutor {
         // 规定上一层通过nextTuple进行rid修改，再通过Next()获取rm
         // 因此在这个函数里不再调用nextTuple
         // nextTuple();
-        return fh_->get_record(rid_,context_);
+        return view_.to_record();
+    }
+
+    TupleView view() override { return view_; }
+
+    /**
+     * @brief 从scan_当前指向的记录开始，每批读入至多BATCH_SIZE条记录后一次计算所有谓词，直到得到有满足条件的元组的一批
+     */
+    bool NextBatch(DataChunk &chunk) override {
+        chunk.init(cols_);
+        while (!scan_->is_end()) {
+            chunk.reset();
+            for (; !scan_->is_end() && !chunk.full(); scan_->next()) {
+                rid_ = scan_->rid();
+                chunk.append(fh_->get_record_view(rid_, page_handle_, context_).data);
+            }
+            filter_.apply(chunk);
+            if (chunk.count() > 0) {
+                break;
+            }
+        }
+        if (scan_->is_end()) {
+            page_handle_.reset();
+        }
+        return chunk.count() > 0;
     }
 
     Rid &rid() override { return rid_; }
 
-    bool check_conds(RmRecord* record_ptr){
+    bool check_conds(const TupleView &record){
         int len = fed_conds_.size();
         if(len == 0)
             return true;
-        bool found = check_cond(fed_conds_[0],record_ptr);
+        bool found = check_cond(fed_conds_[0],record);
         for(int i=1;i<len;i++){
-            found &= check_cond(fed_conds_[i],record_ptr);
+            found &= check_cond(fed_conds_[i],record);
             if(!found)
                 return false;
         }
         return found;
     }
 
-    bool check_cond(Condition cond_, RmRecord* cur_record_ptr){
+    bool check_cond(const Condition &cond_, const TupleView &cur_record){
         // 1. 获取被比较的左列值
         auto left_col_it = get_col(cols_,cond_.lhs_col);
-        char* left_val = cur_record_ptr->data + left_col_it->offset;
+        const char* left_val = cur_record.data + left_col_it->offset;
         int len = left_col_it->len;
         // 2. 检查右列是否是常值，并获取相应的列值/常值
-        char* right_val;
+        const char* right_val;
         ColType col_type;
         if(cond_.is_rhs_val){
             // 常值
-            Value right_value = cond_.rhs_val;
-            right_val = right_value.raw->data;
-            col_type = right_value.type;
+            right_val = cond_.rhs_val.raw->data;
+            col_type = cond_.rhs_val.type;
         }
         else{
             // 同左值
             auto right_col_it = get_col(cols_,cond_.rhs_col);
-            right_val = cur_record_ptr->data + right_col_it->offset;
+            right_val = cur_record.data + right_col_it->offset;
             col_type = right_col_it->type;
         }
-        // 3. 根据比较条件判断true false
+        // 3. 根据比较条件判断true false，字符串的比较结果是memcmp的返回值，只看符号
         int cmp = ix_compare(left_val,right_val,col_type,len);
         bool found;
         switch(cond_.op){
@@ -151,19 +186,19 @@ class SeqScanExecutor : public AbstractExecutor {
                 break;
             }
             case OP_LT:{
-                found = (cmp==-1);
+                found = (cmp<0);
                 break;
             }
             case OP_GT:{
-                found = (cmp==1);
+                found = (cmp>0);
                 break;
             }
             case OP_LE:{
-                found = (cmp!=1);
+                found = (cmp<=0);
                 break;
             }
             case OP_GE:{
-                found = (cmp!=-1);
+                found = (cmp>=0);
                 break;
             }
         }
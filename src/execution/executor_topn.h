@@ -0,0 +1,120 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "execution_sort.h"
+
+/* ORDER BY ... LIMIT：只保留排在最前面的n个元组。最多n个槽位，用大顶堆维护当前的前n个，
+ * 新元组比堆顶小时替换堆顶，内存为O(n)，比较次数为O(输入元组数 * log n)；键相同的元组保持输入的顺序 */
+class TopNExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> prev_;
+    size_t len_;
+    SortKey sort_key_;
+    size_t key_len_;
+    size_t entry_len_;                          // 每个槽位的长度：排序键加上元组
+    size_t n_;
+
+    std::vector<char> slots_;                   // 最多n_个槽位
+    std::vector<size_t> seqs_;                  // 每个槽位中元组的输入序号，键相同时序号小的排在前面
+    std::vector<size_t> heap_;                  // 槽位下标组成的大顶堆，输入结束后排为升序
+    std::vector<char> entry_;                   // 当前输入元组的排序键和元组
+    size_t pos_;
+    bool isend;
+
+   public:
+    TopNExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &sel_cols, std::vector<bool> is_desc,
+                 size_t n) {
+        prev_ = std::move(prev);
+        len_ = prev_->tupleLen();
+        std::vector<ColMeta> keys;
+        for (auto &sel_col : sel_cols) {
+            keys.push_back(*get_col(prev_->cols(), sel_col));
+        }
+        sort_key_ = SortKey(std::move(keys), std::move(is_desc));
+        key_len_ = sort_key_.len();
+        entry_len_ = key_len_ + len_;
+        n_ = n;
+        entry_.resize(entry_len_);
+        pos_ = 0;
+        isend = true;
+    }
+
+    size_t tupleLen() const override { return len_; };
+
+    const std::vector<ColMeta> &cols() const override { return prev_->cols(); };
+
+    std::string getType() override { return "TopNExecutor"; };
+
+    bool is_end() const override { return isend; };
+
+    void beginTuple() override {
+        heap_.clear();
+        pos_ = 0;
+        if (n_ == 0) {
+            isend = true;
+            return;
+        }
+        // 槽位随输入增加，输入很少时不必一次分配n_个
+        slots_.clear();
+        seqs_.clear();
+        auto less = [this](size_t a, size_t b) { return slot_less(a, b); };
+        size_t seq = 0;
+        for (prev_->beginTuple(); !prev_->is_end(); prev_->nextTuple(), seq++) {
+            TupleView rec = prev_->view();
+            if (heap_.size() < n_) {
+                size_t slot = heap_.size();
+                slots_.resize(slots_.size() + entry_len_);
+                seqs_.push_back(seq);
+                sort_key_.make(rec.data, slots_.data() + slot * entry_len_);
+                memcpy(slots_.data() + slot * entry_len_ + key_len_, rec.data, len_);
+                heap_.push_back(slot);
+                std::push_heap(heap_.begin(), heap_.end(), less);
+                continue;
+            }
+            // 键与堆顶相同的新元组序号更大，排在堆顶之后，直接丢弃
+            sort_key_.make(rec.data, entry_.data());
+            size_t top = heap_.front();
+            if (memcmp(entry_.data(), slots_.data() + top * entry_len_, key_len_) >= 0) {
+                continue;
+            }
+            std::pop_heap(heap_.begin(), heap_.end(), less);
+            memcpy(entry_.data() + key_len_, rec.data, len_);
+            memcpy(slots_.data() + top * entry_len_, entry_.data(), entry_len_);
+            seqs_[top] = seq;
+            std::push_heap(heap_.begin(), heap_.end(), less);
+        }
+        std::sort_heap(heap_.begin(), heap_.end(), less);
+        isend = heap_.empty();
+    }
+
+    void nextTuple() override {
+        assert(!isend);
+        isend = ++pos_ == heap_.size();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        return view().to_record();
+    }
+
+    TupleView view() override {
+        assert(!isend);
+        return TupleView(slots_.data() + heap_[pos_] * entry_len_ + key_len_, len_);
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    bool slot_less(size_t a, size_t b) const {
+        int cmp = memcmp(slots_.data() + a * entry_len_, slots_.data() + b * entry_len_, key_len_);
+        return cmp != 0 ? cmp < 0 : seqs_[a] < seqs_[b];
+    }
+};
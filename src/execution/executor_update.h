@@ -9,6 +9,8 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #pragma once
+#include <algorithm>
+
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
@@ -38,58 +40,64 @@ class UpdateExecutor : public AbstractExecutor {
         context_ = context;
     }
     std::unique_ptr<RmRecord> Next() override {
-        // 类似于Delete，一方面更新fh_，update_record
-        // 另一方面从每个索引里(检查是否由setClause,)delete then insert
-        // 1. 从TabMeta tab_获取所有的索引列，从sm_manager_拿到所有的索引句柄
-        int ih_num = tab_.indexes.size();
-        std::vector<IxIndexHandle*> ihs(ih_num);
-        for(int i=0;i<ih_num;i++){
-            ihs[i] = (sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_,tab_.indexes[i].cols))).get();
-        }
-        // 2. 遍历rid
+        // 1. 读出所有记录，算出更新后的data
         int rid_num = rids_.size();
+        int rec_size = fh_->get_file_hdr().record_size;
+        std::vector<std::unique_ptr<RmRecord>> old_recs(rid_num);
+        std::vector<char> new_data(static_cast<size_t>(rid_num) * rec_size);
         for(int i=0;i<rid_num;i++){
-            auto rec = fh_->get_record(rids_[i],context_);
-            RmRecord updated_rec = RmRecord(rec->size);         // lab4
-            memcpy(updated_rec.data,rec->data,rec->size);       // lab4
-            // 2.1 算新的data
-            int set_num = set_clauses_.size();
-            char* new_data = new char[rec->size+1];
-            memset(new_data,0,rec->size+1);
-            memcpy(new_data,rec->data,rec->size+1);
-            for(int k=0;k<set_num;k++){
-                std::string cur_col = set_clauses_[k].lhs.col_name;
-                auto col_meta_ptr = tab_.get_col(cur_col);
-                memcpy(new_data+col_meta_ptr->offset,set_clauses_[k].rhs.raw->data,col_meta_ptr->len);
+            old_recs[i] = fh_->get_record(rids_[i],context_);
+            char *data = new_data.data() + static_cast<size_t>(i) * rec_size;
+            memcpy(data,old_recs[i]->data,rec_size);
+            for(auto &set_clause: set_clauses_){
+                auto col_meta_ptr = tab_.get_col(set_clause.lhs.col_name);
+                memcpy(data+col_meta_ptr->offset,set_clause.rhs.raw->data,col_meta_ptr->len);
+            }
+        }
+        // 2. 更新索引项：SET不涉及其字段的索引key不变，跳过；B+树索引批量删除旧的(key, rid)再批量插入新的，
+        // 每个叶结点只访问一次
+        for(auto &index: tab_.indexes){
+            bool touched = std::any_of(index.cols.begin(), index.cols.end(), [&](const ColMeta &col) {
+                return std::any_of(set_clauses_.begin(), set_clauses_.end(),
+                                   [&](const SetClause &set_clause) { return set_clause.lhs.col_name == col.name; });
+            });
+            if(!touched){
+                continue;
             }
-            // 2.2 更新索引项
-            for(int j=0;j<ih_num;j++){
-                IndexMeta index_meta = tab_.indexes[j];
-                // 按顺序拼接多级索引各个列的值，得到key
-                char* key = new char[index_meta.col_tot_len+1];
-                char* newkey = new char[index_meta.col_tot_len+1];
-                key[0] = '\0';
-                newkey[0] = '\0';
+            // 按顺序拼接多级索引各个列的值，得到key
+            std::vector<char> keys(static_cast<size_t>(rid_num) * index.col_tot_len);
+            std::vector<char> new_keys(keys.size());
+            for(int i=0;i<rid_num;i++){
+                char *key = keys.data() + static_cast<size_t>(i) * index.col_tot_len;
+                char *new_key = new_keys.data() + static_cast<size_t>(i) * index.col_tot_len;
+                const char *data = new_data.data() + static_cast<size_t>(i) * rec_size;
                 int curlen = 0;
-                for(int k=0;k<index_meta.col_num;k++){
-                    // strncat(key,rec->data+index_meta.cols[k].offset,index_meta.cols[k].len);
-                    memcpy(key+curlen,rec->data+index_meta.cols[k].offset,index_meta.cols[k].len);
-                    // strncat(newkey,new_data+index_meta.cols[k].offset,index_meta.cols[k].len);
-                    memcpy(newkey+curlen,new_data+index_meta.cols[k].offset,index_meta.cols[k].len);
-                    curlen += index_meta.cols[k].len;
-                    key[curlen] = '\0';
-                    newkey[curlen] = '\0';
+                for(auto &col: index.cols){
+                    memcpy(key+curlen,old_recs[i]->data+col.offset,col.len);
+                    memcpy(new_key+curlen,data+col.offset,col.len);
+                    curlen += col.len;
                 }
-                // 调用delete_entry删除该key
-                ihs[j]->delete_entry(key,context_->txn_);
-                ihs[j]->insert_entry(newkey,rids_[i],context_->txn_);
             }
-            // 2.3 写新data
+            std::string index_name = sm_manager_->get_ix_manager()->get_index_name(tab_name_,index.cols);
+            if(index.type == INDEX_HASH){
+                auto ih = sm_manager_->hash_ihs_.at(index_name).get();
+                for(int i=0;i<rid_num;i++){
+                    ih->delete_entry(keys.data() + static_cast<size_t>(i) * index.col_tot_len,rids_[i],context_->txn_);
+                    ih->insert_entry(new_keys.data() + static_cast<size_t>(i) * index.col_tot_len,rids_[i],context_->txn_);
+                }
+            } else {
+                auto ih = sm_manager_->ihs_.at(index_name).get();
+                ih->delete_entries(keys.data(),rids_.data(),rid_num,context_->txn_);
+                ih->insert_entries(new_keys.data(),rids_.data(),rid_num,context_->txn_);
+            }
+        }
+        // 3. 写新data
+        for(int i=0;i<rid_num;i++){
             // TODO 这里锁可能也有点问题
-            fh_->update_record(rids_[i],new_data,context_);
+            fh_->update_record(rids_[i],new_data.data() + static_cast<size_t>(i) * rec_size,context_);
 
             // lab4 modify write_set
-            WriteRecord* write_rec = new WriteRecord(WType::UPDATE_TUPLE,tab_name_,rids_[i],updated_rec);
+            WriteRecord* write_rec = new WriteRecord(WType::UPDATE_TUPLE,tab_name_,rids_[i],*old_recs[i]);
             context_->txn_->append_write_record(write_rec);
         }
         // TODO: return what
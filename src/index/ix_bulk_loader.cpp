@@ -0,0 +1,416 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ix_bulk_loader.h"
+
+#include <algorithm>
+#include <queue>
+
+static constexpr size_t IX_BULK_LOAD_MAX_LEVELS = 32;  // 每个结点至少两个孩子，32层足够
+
+IxBulkLoader::IxBulkLoader(IxIndexHandle *ih, double fill_factor, size_t sort_mem)
+    : ih_(ih), file_hdr_(ih->file_hdr_), sort_mem_(sort_mem) {
+    entry_len_ = file_hdr_->col_tot_len_ + static_cast<int>(sizeof(Rid));
+    int capacity = static_cast<int>(file_hdr_->btree_order_ * fill_factor);
+    leaf_capacity_ = std::clamp(capacity, 2, file_hdr_->btree_order_);
+    internal_capacity_ = leaf_capacity_;
+    byte_capacity_ = static_cast<int>(IxNodeHandle::max_bytes(file_hdr_) * std::min(fill_factor, 1.0));
+    {
+        IxNodeHandle root = ih_->fetch_node(file_hdr_->root_page_);
+        if (file_hdr_->root_page_ != IX_INIT_ROOT_PAGE || !root.is_leaf_page() || root.get_size() != 0) {
+            throw InternalError("IxBulkLoader: index is not empty");
+        }
+    }
+    levels_.reserve(IX_BULK_LOAD_MAX_LEVELS);
+    write_buf_.resize(static_cast<size_t>(IX_BULK_LOAD_WRITE_BATCH) * PAGE_SIZE);
+    pending_.reserve(IX_BULK_LOAD_WRITE_BATCH);
+}
+
+IxBulkLoader::~IxBulkLoader() {
+    for (std::FILE *run : runs_) {
+        std::fclose(run);
+    }
+}
+
+void IxBulkLoader::add(const char *key, const Rid &rid) {
+    size_t num_entries = sort_buf_.size() / entry_len_ + 1;
+    // 排序时每项还需要一个偏移量
+    if (!sort_buf_.empty() && num_entries * (entry_len_ + sizeof(size_t)) > sort_mem_) {
+        spill();
+    }
+    size_t offset = sort_buf_.size();
+    sort_buf_.resize(offset + entry_len_);
+    if (file_hdr_->is_normalized()) {
+        ix_normalize_key(key, sort_buf_.data() + offset, file_hdr_->col_types_, file_hdr_->col_lens_);
+    } else {
+        memcpy(sort_buf_.data() + offset, key, file_hdr_->col_tot_len_);
+    }
+    memcpy(sort_buf_.data() + offset + file_hdr_->col_tot_len_, &rid, sizeof(Rid));
+}
+
+/**
+ * @description: 先按key比较，key相同时按rid比较，使重复key中保留的是表扫描时最先遇到的那条记录
+ */
+bool IxBulkLoader::entry_less(const char *a, const char *b) const {
+    int cmp = ix_compare(a, b, *file_hdr_);
+    if (cmp != 0) {
+        return cmp < 0;
+    }
+    Rid ra, rb;
+    memcpy(&ra, a + file_hdr_->col_tot_len_, sizeof(Rid));
+    memcpy(&rb, b + file_hdr_->col_tot_len_, sizeof(Rid));
+    return ra.page_no != rb.page_no ? ra.page_no < rb.page_no : ra.slot_no < rb.slot_no;
+}
+
+/**
+ * @description: 把排序缓冲区排好序后写入一个临时文件，并清空缓冲区
+ */
+void IxBulkLoader::spill() {
+    std::vector<size_t> offsets(sort_buf_.size() / entry_len_);
+    for (size_t i = 0; i < offsets.size(); i++) {
+        offsets[i] = i * entry_len_;
+    }
+    const char *base = sort_buf_.data();
+    std::sort(offsets.begin(), offsets.end(),
+              [this, base](size_t a, size_t b) { return entry_less(base + a, base + b); });
+    std::FILE *run = std::tmpfile();
+    if (run == nullptr) {
+        throw UnixError();
+    }
+    runs_.push_back(run);
+    for (size_t offset : offsets) {
+        if (std::fwrite(base + offset, entry_len_, 1, run) != 1) {
+            throw UnixError();
+        }
+    }
+    if (std::fflush(run) != 0) {
+        throw UnixError();
+    }
+    sort_buf_.clear();
+}
+
+/**
+ * @description: 按顺序对每一项调用emit；没有写过临时文件时直接在内存中排序，否则把剩余部分也写出后多路归并
+ */
+void IxBulkLoader::merge(const std::function<void(const char *)> &emit) {
+    if (runs_.empty()) {
+        std::vector<size_t> offsets(sort_buf_.size() / entry_len_);
+        for (size_t i = 0; i < offsets.size(); i++) {
+            offsets[i] = i * entry_len_;
+        }
+        const char *base = sort_buf_.data();
+        std::sort(offsets.begin(), offsets.end(),
+                  [this, base](size_t a, size_t b) { return entry_less(base + a, base + b); });
+        for (size_t offset : offsets) {
+            emit(base + offset);
+        }
+        return;
+    }
+    if (!sort_buf_.empty()) {
+        spill();
+    }
+    std::vector<char>().swap(sort_buf_);
+
+    // heads[i]是第i个临时文件当前的第一项
+    std::vector<std::vector<char>> heads(runs_.size(), std::vector<char>(entry_len_));
+    auto read_head = [&](size_t i) {
+        if (std::fread(heads[i].data(), entry_len_, 1, runs_[i]) == 1) {
+            return true;
+        }
+        if (std::ferror(runs_[i])) {
+            throw UnixError();
+        }
+        return false;
+    };
+    auto greater = [&](size_t a, size_t b) { return entry_less(heads[b].data(), heads[a].data()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> queue(greater);
+    for (size_t i = 0; i < runs_.size(); i++) {
+        std::rewind(runs_[i]);
+        if (read_head(i)) {
+            queue.push(i);
+        }
+    }
+    while (!queue.empty()) {
+        size_t i = queue.top();
+        queue.pop();
+        emit(heads[i].data());
+        if (read_head(i)) {
+            queue.push(i);
+        }
+    }
+}
+
+/**
+ * @description: 排序后自底向上构建B+树，写完所有结点后更新file_hdr_；表为空时保留create_index写入的空根结点
+ */
+void IxBulkLoader::finish() {
+    // 建索引时持有表锁，树中没有其他操作；持有root_latch_排他锁，之后的下降从新的根结点开始
+    std::unique_lock lock{ih_->root_latch_};
+    int key_len = file_hdr_->col_tot_len_;
+    std::vector<char> prev_key(key_len);
+    std::vector<Rid> postings;  // prev_key的所有rid，唯一索引中只保留第一个
+    merge([&](const char *entry) {
+        Rid rid;
+        memcpy(&rid, entry + key_len, sizeof(Rid));
+        if (!postings.empty() && ix_compare(entry, prev_key.data(), *file_hdr_) == 0) {
+            if (!file_hdr_->unique_) {
+                postings.push_back(rid);
+            }
+            return;
+        }
+        if (!postings.empty()) {
+            append(0, prev_key.data(), write_postings(postings));
+        }
+        memcpy(prev_key.data(), entry, key_len);
+        postings.assign(1, rid);
+    });
+    if (!postings.empty()) {
+        append(0, prev_key.data(), write_postings(postings));
+    }
+    if (levels_.empty()) {
+        return;
+    }
+
+    // 从叶结点层开始放入每层最后的一项并写完最右边的结点，它在上一层的项在下一轮放入结点；
+    // 放入最后一项时可能再打开一个结点，使上一层出现，最高层只有一个结点，它是根结点
+    for (size_t level = 0; level < levels_.size(); level++) {
+        commit(level, nullptr);
+        close_node(level, nullptr, IX_LEAF_HEADER_PAGE);
+        if (level + 1 == levels_.size()) {
+            write_closed(level, IX_NO_PAGE);
+        }
+    }
+    // leaf header的前一个/后一个叶子分别指向最后一个/第一个叶结点
+    std::vector<char> header(PAGE_SIZE, 0);
+    *reinterpret_cast<IxPageHdr *>(header.data()) = {
+        .next_free_page_no = IX_NO_PAGE,
+        .parent = IX_NO_PAGE,
+        .num_key = 0,
+        .is_leaf = true,
+        .prev_leaf = last_leaf_,
+        .next_leaf = IX_INIT_ROOT_PAGE,
+    };
+    write_page(IX_LEAF_HEADER_PAGE, header.data());
+    flush_pages();
+
+    std::lock_guard hdr_lock{ih_->file_hdr_latch_};
+    ih_->file_hdr_->root_page_ = levels_.back().page_no;
+    ih_->file_hdr_->first_leaf_ = IX_INIT_ROOT_PAGE;
+    ih_->file_hdr_->last_leaf_ = last_leaf_;
+    ih_->file_hdr_->num_pages_ += num_new_pages_;
+}
+
+/**
+ * @description: 在第level层加入一个键值对，它先作为这一层的pending，上一项此时放入结点：结点放不下时先写出它并打开
+ * 一个新结点，新结点的分隔key加入上一层；某一层的第一个结点写满时才创建上一层，因此最高层始终只有一个结点，即根结点
+ */
+void IxBulkLoader::append(size_t level, const char *key, const Rid &rid) {
+    if (level == levels_.size()) {
+        if (levels_.size() == levels_.capacity()) {
+            throw InternalError("IxBulkLoader: too many levels");
+        }
+        levels_.emplace_back();
+        // 第一个叶结点重用create_index写入的初始根结点
+        open_node(level, level == 0 ? IX_INIT_ROOT_PAGE : allocate_page(), nullptr);
+    }
+    if (!levels_[level].pending.empty()) {
+        commit(level, key);
+    }
+    Level &node = levels_[level];
+    node.pending.assign(key, key + file_hdr_->col_tot_len_);
+    node.pending_rid = rid;
+}
+
+/**
+ * @description: 把第level层的pending放入最右边的结点，放入后结点的上界至少为pending与next_key之间的分隔key
+ * （next_key为nullptr时没有上界），按这个上界放不下时先写出结点，pending放入新结点。
+ * 放入的是孩子结点的项时，孩子结点由此得到parent并写出
+ * @note 每次放入时都按上界检查过，结点在下一次放不下时以它与pending之间的分隔key为上界写出，仍然放得下
+ */
+void IxBulkLoader::commit(size_t level, const char *next_key) {
+    int len = file_hdr_->col_tot_len_;
+    char high[IX_MAX_COL_LEN];
+    if (next_key != nullptr) {
+        separator(level, levels_[level].pending.data(), next_key, high);
+    }
+    if (!levels_[level].rids.empty() && !fits(level, next_key != nullptr ? high : nullptr)) {
+        Level &node = levels_[level];
+        char sep[IX_MAX_COL_LEN];
+        separator(level, node.keys.data() + node.keys.size() - len, node.pending.data(), sep);
+        page_id_t next = allocate_page();
+        if (level + 1 == levels_.size()) {
+            char first[IX_MAX_COL_LEN];
+            if (file_hdr_->key_format_ == IX_KEY_COMPRESSED) {
+                memset(first, 0, len);
+            } else {
+                memcpy(first, node.keys.data(), len);
+            }
+            append(level + 1, first, {.page_no = node.page_no, .slot_no = -1});
+        }
+        close_node(level, sep, next);
+        open_node(level, next, sep);
+        append(level + 1, sep, {.page_no = next, .slot_no = -1});
+    }
+    Level &node = levels_[level];
+    int key_len = ix_significant_len(node.pending.data(), len);
+    node.keys.insert(node.keys.end(), node.pending.begin(), node.pending.end());
+    node.rids.push_back(node.pending_rid);
+    node.key_lens.push_back(key_len);
+    node.suffix_bytes += std::max(0, key_len - node.prefix);
+    node.pending.clear();
+    if (level > 0) {
+        write_closed(level - 1, node.page_no);
+    }
+}
+
+/**
+ * @description: 第level层最右边的结点以high为上界时能否再放入pending：定长格式按键值对数量判断，
+ * 压缩格式按编码后的字节数判断，公共前缀随上界变化时重新计算后缀的总字节数
+ */
+bool IxBulkLoader::fits(size_t level, const char *high) {
+    Level &node = levels_[level];
+    if (file_hdr_->key_format_ != IX_KEY_COMPRESSED) {
+        int capacity = level == 0 ? leaf_capacity_ : internal_capacity_;
+        return static_cast<int>(node.rids.size()) < capacity;
+    }
+    int len = file_hdr_->col_tot_len_;
+    const char *low = node.low.empty() ? nullptr : node.low.data();
+    int prefix = low != nullptr && high != nullptr ? ix_common_prefix(low, high, len) : 0;
+    if (prefix != node.prefix) {
+        node.prefix = prefix;
+        node.suffix_bytes = 0;
+        for (int key_len : node.key_lens) {
+            node.suffix_bytes += std::max(0, key_len - prefix);
+        }
+    }
+    int low_len = low != nullptr ? ix_significant_len(low, len) : 0;
+    int high_len = high != nullptr ? ix_significant_len(high, len) : 0;
+    int size = ix_slots_offset(low_len, high_len) + static_cast<int>((node.rids.size() + 1) * sizeof(IxSlot)) +
+               node.suffix_bytes + std::max(0, ix_significant_len(node.pending.data(), len) - prefix);
+    return size <= byte_capacity_;
+}
+
+/**
+ * @description: 第level层相邻的两个key left < right之间的分隔key：压缩格式的叶结点层取最短的前缀，
+ * 内部结点层的key本身就是孩子的下界，定长格式与逐条插入一致取right
+ */
+void IxBulkLoader::separator(size_t level, const char *left, const char *right, char *dest) const {
+    if (file_hdr_->key_format_ == IX_KEY_COMPRESSED && level == 0) {
+        ix_separator(left, right, dest, file_hdr_->col_tot_len_);
+    } else {
+        memcpy(dest, right, file_hdr_->col_tot_len_);
+    }
+}
+
+/**
+ * @description: 只有一个rid时直接返回它；否则把rids写入新分配的posting list页面，返回叶结点中指向它的rid
+ */
+Rid IxBulkLoader::write_postings(const std::vector<Rid> &rids) {
+    if (rids.size() == 1) {
+        return rids[0];
+    }
+    std::vector<char> buf(PAGE_SIZE);
+    page_id_t next_page = IX_NO_PAGE;
+    // 从最后一页开始写，每页都能得到下一页的页号
+    for (size_t end = rids.size(); end > 0;) {
+        size_t begin = (end - 1) / IX_POSTING_CAPACITY * IX_POSTING_CAPACITY;
+        std::fill(buf.begin(), buf.end(), 0);
+        *reinterpret_cast<IxPostingHdr *>(buf.data()) = {.next_page = next_page,
+                                                          .num_rids = static_cast<int>(end - begin)};
+        memcpy(buf.data() + sizeof(IxPostingHdr), rids.data() + begin, (end - begin) * sizeof(Rid));
+        next_page = allocate_page();
+        write_page(next_page, buf.data());
+        end = begin;
+    }
+    return {.page_no = IX_POSTING_LIST, .slot_no = next_page};
+}
+
+void IxBulkLoader::open_node(size_t level, page_id_t page_no, const char *low) {
+    Level &node = levels_[level];
+    node.keys.clear();
+    node.rids.clear();
+    node.key_lens.clear();
+    node.low.clear();
+    if (low != nullptr && file_hdr_->key_format_ == IX_KEY_COMPRESSED) {
+        node.low.assign(low, low + file_hdr_->col_tot_len_);
+    }
+    node.prefix = 0;
+    node.suffix_bytes = 0;
+    node.page_no = page_no;
+}
+
+/**
+ * @description: 按文件的key格式生成第level层最右边的结点页面，等它在上一层的项放入结点后再写出
+ * @param high 压缩格式结点的上界，最右边的结点为nullptr
+ * @param next_leaf 叶结点的下一个叶结点，最后一个叶结点为IX_LEAF_HEADER_PAGE
+ */
+void IxBulkLoader::close_node(size_t level, const char *high, page_id_t next_leaf) {
+    Level &node = levels_[level];
+    node.closed.assign(PAGE_SIZE, 0);
+    node.closed_page_no = node.page_no;
+    page_id_t prev_leaf = last_leaf_ == IX_NO_PAGE ? IX_LEAF_HEADER_PAGE : last_leaf_;
+    *reinterpret_cast<IxPageHdr *>(node.closed.data()) = {
+        .next_free_page_no = IX_NO_PAGE,
+        .parent = IX_NO_PAGE,
+        .num_key = 0,
+        .is_leaf = level == 0,
+        .prev_leaf = level == 0 ? prev_leaf : IX_NO_PAGE,
+        .next_leaf = level == 0 ? next_leaf : IX_NO_PAGE,
+    };
+    IxNodeHandle::encode(node.closed.data(), file_hdr_, node.low.empty() ? nullptr : node.low.data(), high,
+                         node.keys.data(), node.rids.data(), node.rids.size());
+    if (level == 0) {
+        last_leaf_ = node.page_no;
+    }
+}
+
+/**
+ * @description: 写出第level层等待parent的结点页面
+ */
+void IxBulkLoader::write_closed(size_t level, page_id_t parent) {
+    Level &node = levels_[level];
+    assert(!node.closed.empty());
+    reinterpret_cast<IxPageHdr *>(node.closed.data())->parent = parent;
+    write_page(node.closed_page_no, node.closed.data());
+    node.closed.clear();
+}
+
+/**
+ * @description: 把页面加入待写入的批次，批次满时写入磁盘；缓冲池中该页面的旧内容先被删除
+ */
+void IxBulkLoader::write_page(page_id_t page_no, const char *data) {
+    if (!ih_->buffer_pool_manager_->delete_page({.fd = ih_->fd_, .page_no = page_no})) {
+        throw InternalError("IxBulkLoader: page " + std::to_string(page_no) + " is pinned");
+    }
+    char *buf = write_buf_.data() + pending_.size() * PAGE_SIZE;
+    memcpy(buf, data, PAGE_SIZE);
+    pending_.push_back({.fd = ih_->fd_, .page_no = page_no, .buf = buf});
+    if (pending_.size() == static_cast<size_t>(IX_BULK_LOAD_WRITE_BATCH)) {
+        flush_pages();
+    }
+}
+
+void IxBulkLoader::flush_pages() {
+    // 按页号排序，使页号连续的页面合并为一次写入
+    std::sort(pending_.begin(), pending_.end(),
+              [](const PageIoRequest &a, const PageIoRequest &b) { return a.page_no < b.page_no; });
+    ih_->disk_manager_->write_pages_batch(pending_);
+    for (auto &request : pending_) {
+        if (!request.ok()) {
+            throw InternalError("IxBulkLoader: failed to write page " + std::to_string(request.page_no));
+        }
+    }
+    pending_.clear();
+}
+
+page_id_t IxBulkLoader::allocate_page() {
+    num_new_pages_++;
+    return ih_->disk_manager_->allocate_page(ih_->fd_);
+}
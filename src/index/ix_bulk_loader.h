@@ -0,0 +1,110 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "ix_defs.h"
+#include "ix_index_handle.h"
+
+/* 自底向上批量构建B+树，用于CREATE INDEX。
+ * 先把所有键值对收集到排序缓冲区，超过内存上限时把排好序的一段写入临时文件，最后多路归并得到有序序列；
+ * 再按顺序从左到右填满叶结点（每个结点填到btree_order * fill_factor，压缩格式填到最大字节数 * fill_factor），
+ * 每层只保留一个未写完的结点，结点写满后直接写入磁盘并把它的分隔key加入上一层，每个页面只写一次，
+ * 不经过逐条插入时的查找和分裂。压缩格式结点的公共前缀取决于上界，即下一个结点的分隔key，
+ * 因此每层最后加入的一项要等到下一项到来才放入结点 */
+class IxBulkLoader {
+   public:
+    /**
+     * @param ih 刚由IxManager::create_index创建并打开的空索引
+     * @param fill_factor 每个结点填充的比例
+     * @param sort_mem 排序缓冲区的字节数上限
+     */
+    IxBulkLoader(IxIndexHandle *ih, double fill_factor = IX_BULK_LOAD_FILL_FACTOR,
+                 size_t sort_mem = IX_BULK_LOAD_SORT_MEM);
+
+    ~IxBulkLoader();
+
+    IxBulkLoader(const IxBulkLoader &) = delete;
+    IxBulkLoader &operator=(const IxBulkLoader &) = delete;
+
+    // 加入一个键值对，key的长度为索引的col_tot_len_
+    void add(const char *key, const Rid &rid);
+
+    // 排序并构建B+树：唯一索引中重复的key只保留rid最小的一个，与逐条插入时忽略重复key的结果一致；
+    // 非唯一索引中重复key的所有rid按顺序写入posting list
+    void finish();
+
+    // 已写入的临时文件个数
+    size_t num_runs() const { return runs_.size(); }
+
+   private:
+    // 正在构建的一层中最右边的结点
+    struct Level {
+        std::vector<char> keys;     // 结点中的key，完整长度连续存放
+        std::vector<Rid> rids;
+        std::vector<int> key_lens;  // 每个key去掉末尾0字节后的长度
+        std::vector<char> low;      // 压缩格式结点的下界，为空时没有下界
+        int prefix = 0;             // 压缩格式结点的公共前缀长度，suffix_bytes按它计算
+        int suffix_bytes = 0;       // 压缩格式结点中后缀的总字节数
+        page_id_t page_no;          // 结点打开时就分配页号，孩子结点在这里得到它们的parent
+        std::vector<char> pending;  // 最后加入的key，还没有放入结点，为空时没有
+        Rid pending_rid;
+        std::vector<char> closed;   // 已写完的结点页面，等它在上一层的项放入结点、得到parent后再写出
+        page_id_t closed_page_no;
+    };
+
+    IxIndexHandle *ih_;
+    const IxFileHdr *file_hdr_;
+    int entry_len_;                 // 排序缓冲区中每项的长度，key之后紧跟rid
+    size_t sort_mem_;
+    std::vector<char> sort_buf_;
+    std::vector<std::FILE *> runs_; // 已排好序的临时文件
+    int leaf_capacity_;             // 按fill_factor计算出的每个结点的键值对数量
+    int internal_capacity_;
+    int byte_capacity_;             // 按fill_factor计算出的压缩格式结点的字节数
+
+    std::vector<Level> levels_;     // levels_[0]是叶结点层
+    page_id_t last_leaf_ = IX_NO_PAGE;
+    int num_new_pages_ = 0;         // 除重用的初始根结点外新分配的页面数
+    std::vector<char> write_buf_;   // 待批量写入的页面
+    std::vector<PageIoRequest> pending_;
+
+    bool entry_less(const char *a, const char *b) const;
+
+    void spill();
+
+    void merge(const std::function<void(const char *)> &emit);
+
+    void append(size_t level, const char *key, const Rid &rid);
+
+    void commit(size_t level, const char *next_key);
+
+    bool fits(size_t level, const char *high);
+
+    void separator(size_t level, const char *left, const char *right, char *dest) const;
+
+    Rid write_postings(const std::vector<Rid> &rids);
+
+    void open_node(size_t level, page_id_t page_no, const char *low);
+
+    void close_node(size_t level, const char *high, page_id_t next_leaf);
+
+    void write_closed(size_t level, page_id_t parent);
+
+    void write_page(page_id_t page_no, const char *data);
+
+    void flush_pages();
+
+    page_id_t allocate_page();
+};
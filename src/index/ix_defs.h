@@ -22,8 +22,21 @@ constexpr int IX_INIT_ROOT_PAGE = 2;
 constexpr int IX_INIT_NUM_PAGES = 3;
 constexpr int IX_MAX_COL_LEN = 512;
 
+constexpr uint32_t IX_FILE_MAGIC = 0x49584442;  // B+树索引文件的标识"IXDB"
+constexpr uint32_t IX_FILE_VERSION = 3;         // 文件格式版本，3加入了IX_KEY_COMPRESSED结点；格式不兼容地变化时递增
+
+// 索引中key的存储格式。前两种格式的key占满col_tot_len_字节的定长槽位，btree_order只由col_tot_len_决定
+constexpr int IX_KEY_RAW = 0;           // 按字段原样存储，逐字段调用ix_compare比较
+constexpr int IX_KEY_NORMALIZED = 1;    // 规范化为可以直接用memcmp比较的字节串，见ix_normalize_key
+constexpr int IX_KEY_COMPRESSED = 2;    // 规范化的key存放在前缀压缩的结点中，见IxCompressedHdr；结点的容量按实际占用的字节数计算
+
+// 非唯一索引中同一个key的多个rid存放在posting list中，叶结点里该key的rid为{IX_POSTING_LIST, posting list首页的页号}
+constexpr int IX_POSTING_LIST = -2;
+
 class IxFileHdr {
 public: 
+    uint32_t magic_;                    // 固定为IX_FILE_MAGIC
+    uint32_t version_;                  // 创建文件时的IX_FILE_VERSION，打开时不一致则拒绝
     page_id_t first_free_page_no_;      // 文件中第一个空闲的磁盘页面的页面号
     int num_pages_;                     // 磁盘文件中页面的数量
     page_id_t root_page_;               // B+树根节点对应的页面号
@@ -37,26 +50,41 @@ public:
     page_id_t first_leaf_;              // 首叶节点对应的页号，在上层IxManager的open函数进行初始化，初始化为root page_no
     page_id_t last_leaf_;               // 尾叶节点对应的页号
     int tot_len_;                       // 记录结构体的整体长度
+    int key_format_;                    // key的存储格式，IX_KEY_RAW、IX_KEY_NORMALIZED或IX_KEY_COMPRESSED
+    int unique_;                        // 是否为唯一索引，非唯一索引中重复key的rid存放在posting list中
 
     IxFileHdr() {
+        magic_ = IX_FILE_MAGIC;
+        version_ = IX_FILE_VERSION;
         tot_len_ = col_num_ = 0;
+        key_format_ = IX_KEY_RAW;
+        unique_ = true;
     }
 
     IxFileHdr(page_id_t first_free_page_no, int num_pages, page_id_t root_page, int col_num,
                 int col_tot_len, int btree_order, int keys_size, page_id_t first_leaf, page_id_t last_leaf)
-                : first_free_page_no_(first_free_page_no), num_pages_(num_pages), root_page_(root_page), col_num_(col_num),
+                : magic_(IX_FILE_MAGIC), version_(IX_FILE_VERSION), first_free_page_no_(first_free_page_no), num_pages_(num_pages), root_page_(root_page), col_num_(col_num),
                 col_tot_len_(col_tot_len), btree_order_(btree_order), keys_size_(keys_size), first_leaf_(first_leaf), last_leaf_(last_leaf) {
                     tot_len_ = 0;
+                    key_format_ = IX_KEY_RAW;
+                    unique_ = true;
                 } 
 
+    // key是否以规范化的形式存储
+    bool is_normalized() const { return key_format_ != IX_KEY_RAW; }
+
     void update_tot_len() {
         tot_len_ = 0;
-        tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 6;
+        tot_len_ += sizeof(uint32_t) * 2 + sizeof(page_id_t) * 4 + sizeof(int) * 8;
         tot_len_ += sizeof(ColType) * col_num_ + sizeof(int) * col_num_;
     }
 
     void serialize(char* dest) {
         int offset = 0;
+        memcpy(dest + offset, &magic_, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        memcpy(dest + offset, &version_, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
         memcpy(dest + offset, &tot_len_, sizeof(int));
         offset += sizeof(int);
         memcpy(dest + offset, &first_free_page_no_, sizeof(page_id_t));
@@ -85,11 +113,23 @@ public:
         offset += sizeof(page_id_t);
         memcpy(dest + offset, &last_leaf_, sizeof(page_id_t));
         offset += sizeof(page_id_t);
+        memcpy(dest + offset, &key_format_, sizeof(int));
+        offset += sizeof(int);
+        memcpy(dest + offset, &unique_, sizeof(int));
+        offset += sizeof(int);
         assert(offset == tot_len_);
     }
 
+    // 标识或版本不一致时只读出magic_和version_，由调用者检查后拒绝打开
     void deserialize(char* src) {
         int offset = 0;
+        magic_ = *reinterpret_cast<const uint32_t*>(src + offset);
+        offset += sizeof(uint32_t);
+        version_ = *reinterpret_cast<const uint32_t*>(src + offset);
+        offset += sizeof(uint32_t);
+        if (magic_ != IX_FILE_MAGIC || version_ != IX_FILE_VERSION) {
+            return;
+        }
         tot_len_ = *reinterpret_cast<const int*>(src + offset);
         offset += sizeof(int);
         first_free_page_no_ = *reinterpret_cast<const page_id_t*>(src + offset);
@@ -123,6 +163,10 @@ public:
         offset += sizeof(page_id_t);
         last_leaf_ = *reinterpret_cast<const page_id_t*>(src + offset);
         offset += sizeof(page_id_t);
+        key_format_ = *reinterpret_cast<const int*>(src + offset);
+        offset += sizeof(int);
+        unique_ = *reinterpret_cast<const int*>(src + offset);
+        offset += sizeof(int);
         assert(offset == tot_len_);
     }
 };
@@ -137,6 +181,39 @@ public:
     page_id_t next_leaf;            // next leaf node's page_no, effective only when is_leaf is true
 };
 
+/* IX_KEY_COMPRESSED格式的结点在IxPageHdr之后依次存放IxCompressedHdr、下界、上界和IxSlot数组，key的后缀从页尾向前存放。
+ * 结点中的key都在[下界, 上界)中，它们共有下界和上界的公共前缀，这部分只存一次（即下界的前prefix_len字节）；
+ * 每个key只存去掉公共前缀和末尾0字节后的后缀。下界和上界就是父结点中指向本结点和右兄弟的分隔key，同样去掉末尾的0字节；
+ * 叶结点分裂时分隔key取能区分左右两边的最短前缀（后缀截断），因此内部结点中的key通常比完整的key短。
+ * 内部结点的第0个key等于它的下界，没有下界时为全0 */
+class IxCompressedHdr {
+public:
+    uint16_t prefix_len;            // 公共前缀的长度，下界和上界都存在时为二者补齐到col_tot_len_后的公共前缀长度，否则为0
+    uint16_t low_len;               // 下界的长度
+    uint16_t high_len;              // 上界的长度
+    uint8_t has_low;                // 是否有下界，最左边的结点没有下界
+    uint8_t has_high;               // 是否有上界，最右边的结点没有上界
+    uint16_t heap_size;             // 页尾后缀区占用的字节数，包括删除后留下的空洞
+    uint16_t garbage;               // 后缀区中空洞的字节数，插入时连续空间不足就整理后缀区
+};
+
+class IxSlot {
+public:
+    uint16_t offset;                // key的后缀在页面中的偏移
+    uint16_t len;                   // 后缀的长度
+    Rid rid;
+};
+
+/* posting list由一个或多个页面组成的链表，每页以IxPostingHdr开头，之后紧跟num_rids个Rid；
+ * 新的rid加入第一页，第一页写满时在链表头部加入新页面；页面为空时从链表中摘下，放入file_hdr_的空闲页链表 */
+class IxPostingHdr {
+public:
+    page_id_t next_page;            // 链表中的下一页，最后一页为IX_NO_PAGE；空闲页链表中为下一个空闲页
+    int num_rids;                   // 本页中rid的数量
+};
+
+constexpr int IX_POSTING_CAPACITY = (PAGE_SIZE - sizeof(IxPostingHdr)) / sizeof(Rid);
+
 class Iid {
 public:
     int page_no;
@@ -0,0 +1,333 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ix_hash_index.h"
+
+#include <algorithm>
+
+#include "execution/execution_hash.h"
+
+static IxHashBucketHdr *bucket_hdr(PageGuard &guard) {
+    return reinterpret_cast<IxHashBucketHdr *>(guard.get_page()->get_data());
+}
+
+static char *bucket_entries(PageGuard &guard) { return guard.get_page()->get_data() + sizeof(IxHashBucketHdr); }
+
+IxHashIndexHandle::IxHashIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
+    : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
+    std::vector<char> buf(PAGE_SIZE);
+    disk_manager_->read_page(fd, IX_FILE_HDR_PAGE, buf.data(), PAGE_SIZE);
+    file_hdr_.deserialize(buf.data());
+    if (file_hdr_.magic_ != IX_HASH_FILE_MAGIC || file_hdr_.version_ != IX_HASH_FILE_VERSION) {
+        throw FileFormatError(disk_manager_->get_file_name(fd));
+    }
+    buf.resize(file_hdr_.dir_num_pages_ * PAGE_SIZE);
+    disk_manager_->read_page(fd, file_hdr_.dir_first_page_, buf.data(), buf.size());
+    dir_.resize(1u << file_hdr_.global_depth_);
+    memcpy(dir_.data(), buf.data(), dir_.size() * sizeof(page_id_t));
+    // 新页面从文件末尾开始分配
+    disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages_);
+}
+
+/**
+ * @brief 对规范化的key计算哈希值，与哈希连接和哈希聚合使用同一个哈希函数
+ */
+uint32_t IxHashIndexHandle::hash(const char *key) const { return hash_key(key, file_hdr_.col_tot_len_); }
+
+/**
+ * @brief 查找key对应的所有rid，持有目录的共享锁和桶的读锁
+ */
+bool IxHashIndexHandle::get_value(const char *key, std::vector<Rid> *result, Transaction *transaction) const {
+    char key_buf[IX_MAX_COL_LEN];
+    ix_normalize_key(key, key_buf, file_hdr_.col_types_, file_hdr_.col_lens_);
+    uint32_t h = hash(key_buf);
+    std::shared_lock lock{dir_latch_};
+    WritePageGuard bucket = fetch_page(bucket_of(h));
+    std::shared_lock latch{bucket.get_page()->latch()};
+    bool found = false;
+    WritePageGuard overflow;
+    for (PageGuard *page = &bucket;; page = &overflow) {
+        IxHashBucketHdr *hdr = bucket_hdr(*page);
+        char *entries = bucket_entries(*page);
+        for (int i = 0; i < hdr->num_entries; i++) {
+            char *entry = entries + i * entry_len();
+            if (memcmp(entry, key_buf, file_hdr_.col_tot_len_) == 0) {
+                Rid rid;
+                memcpy(&rid, entry + file_hdr_.col_tot_len_, sizeof(Rid));
+                result->push_back(rid);
+                found = true;
+            }
+        }
+        if (hdr->next_overflow == IX_NO_PAGE) {
+            break;
+        }
+        overflow = fetch_page(hdr->next_overflow);
+    }
+    return found;
+}
+
+/**
+ * @brief 插入键值对，同一个key可以插入多个rid
+ * @note 先持有目录的共享锁，只对桶加写锁：桶中有空位时直接完成；否则持有目录的排他锁，
+ * 反复分裂key所在的桶直到有空位，无法通过分裂腾出空位时加入溢出页
+ */
+bool IxHashIndexHandle::insert_entry(const char *key, const Rid &value, Transaction *transaction) {
+    char key_buf[IX_MAX_COL_LEN];
+    ix_normalize_key(key, key_buf, file_hdr_.col_types_, file_hdr_.col_lens_);
+    uint32_t h = hash(key_buf);
+    {
+        std::shared_lock lock{dir_latch_};
+        WritePageGuard bucket = fetch_page(bucket_of(h));
+        std::unique_lock latch{bucket.get_page()->latch()};
+        if (try_insert(&bucket, key_buf, value)) {
+            return true;
+        }
+    }
+    std::unique_lock lock{dir_latch_};
+    while (true) {
+        WritePageGuard bucket = fetch_page(bucket_of(h));
+        if (try_insert(&bucket, key_buf, value)) {
+            return true;
+        }
+        if (!can_split(&bucket, h)) {
+            append_overflow(&bucket, key_buf, value);
+            return true;
+        }
+        split(&bucket);
+    }
+}
+
+/**
+ * @brief 删除键值对(key, value)，用所在页面的最后一个键值对填补空位，溢出页为空时从链表中摘下并回收；
+ * 桶不合并，目录也不收缩
+ * @return (key, value)是否存在
+ */
+bool IxHashIndexHandle::delete_entry(const char *key, const Rid &value, Transaction *transaction) {
+    char key_buf[IX_MAX_COL_LEN];
+    ix_normalize_key(key, key_buf, file_hdr_.col_types_, file_hdr_.col_lens_);
+    int key_len = file_hdr_.col_tot_len_;
+    std::shared_lock lock{dir_latch_};
+    WritePageGuard bucket = fetch_page(bucket_of(hash(key_buf)));
+    std::unique_lock latch{bucket.get_page()->latch()};
+    WritePageGuard prev_overflow, overflow;
+    PageGuard *prev = nullptr;
+    for (PageGuard *page = &bucket;;) {
+        IxHashBucketHdr *hdr = bucket_hdr(*page);
+        char *entries = bucket_entries(*page);
+        for (int i = 0; i < hdr->num_entries; i++) {
+            char *entry = entries + i * entry_len();
+            if (memcmp(entry, key_buf, key_len) != 0 || memcmp(entry + key_len, &value, sizeof(Rid)) != 0) {
+                continue;
+            }
+            page->mark_dirty();
+            hdr->num_entries--;
+            memmove(entry, entries + hdr->num_entries * entry_len(), entry_len());
+            if (hdr->num_entries == 0 && page != &bucket) {
+                prev->mark_dirty();
+                bucket_hdr(*prev)->next_overflow = hdr->next_overflow;
+                free_page(&overflow);
+            }
+            return true;
+        }
+        if (hdr->next_overflow == IX_NO_PAGE) {
+            return false;
+        }
+        page_id_t next = hdr->next_overflow;
+        if (page == &overflow) {
+            prev_overflow = std::move(overflow);
+            prev = &prev_overflow;
+        } else {
+            prev = &bucket;
+        }
+        overflow = fetch_page(next);
+        page = &overflow;
+    }
+}
+
+/**
+ * @brief 把键值对放入桶中第一个有空位的页面
+ * @return 桶的所有页面都已满时返回false
+ */
+bool IxHashIndexHandle::try_insert(WritePageGuard *bucket, const char *key, const Rid &value) {
+    WritePageGuard overflow;
+    for (WritePageGuard *page = bucket;; page = &overflow) {
+        IxHashBucketHdr *hdr = bucket_hdr(*page);
+        if (hdr->num_entries < file_hdr_.bucket_capacity_) {
+            page->mark_dirty();
+            char *entry = bucket_entries(*page) + hdr->num_entries * entry_len();
+            memcpy(entry, key, file_hdr_.col_tot_len_);
+            memcpy(entry + file_hdr_.col_tot_len_, &value, sizeof(Rid));
+            hdr->num_entries++;
+            return true;
+        }
+        if (hdr->next_overflow == IX_NO_PAGE) {
+            return false;
+        }
+        overflow = fetch_page(hdr->next_overflow);
+    }
+}
+
+/**
+ * @brief 在桶的第一个页面之后加入一个溢出页并放入键值对，调用者持有目录的排他锁
+ */
+void IxHashIndexHandle::append_overflow(WritePageGuard *bucket, const char *key, const Rid &value) {
+    WritePageGuard page = new_page();
+    IxHashBucketHdr *hdr = bucket_hdr(page);
+    hdr->local_depth = bucket_hdr(*bucket)->local_depth;
+    hdr->next_overflow = bucket_hdr(*bucket)->next_overflow;
+    bucket->mark_dirty();
+    bucket_hdr(*bucket)->next_overflow = page.get_page_id().page_no;
+    bool inserted = try_insert(&page, key, value);
+    assert(inserted);
+}
+
+/**
+ * @brief 分裂能否把哈希值为hash的key与桶中已有的键值对分开：存在某个键值对的哈希值与hash
+ * 在第local_depth到IX_HASH_MAX_DEPTH - 1位之间不同
+ */
+bool IxHashIndexHandle::can_split(WritePageGuard *bucket, uint32_t hash) {
+    int local_depth = bucket_hdr(*bucket)->local_depth;
+    if (local_depth >= IX_HASH_MAX_DEPTH) {
+        return false;
+    }
+    uint32_t mask = ((1u << IX_HASH_MAX_DEPTH) - 1) & ~((1u << local_depth) - 1);
+    WritePageGuard overflow;
+    for (WritePageGuard *page = bucket;; page = &overflow) {
+        IxHashBucketHdr *hdr = bucket_hdr(*page);
+        char *entries = bucket_entries(*page);
+        for (int i = 0; i < hdr->num_entries; i++) {
+            if (((this->hash(entries + i * entry_len()) ^ hash) & mask) != 0) {
+                return true;
+            }
+        }
+        if (hdr->next_overflow == IX_NO_PAGE) {
+            return false;
+        }
+        overflow = fetch_page(hdr->next_overflow);
+    }
+}
+
+/**
+ * @brief 把桶分裂为两个局部深度加1的桶，局部深度等于全局深度时先把目录加倍；
+ * 桶的溢出页被回收，其中的键值对按哈希值的第local_depth位重新分配，调用者持有目录的排他锁
+ */
+void IxHashIndexHandle::split(WritePageGuard *bucket) {
+    int local_depth = bucket_hdr(*bucket)->local_depth;
+    if (local_depth == file_hdr_.global_depth_) {
+        size_t size = dir_.size();
+        dir_.resize(size * 2);
+        std::copy_n(dir_.begin(), size, dir_.begin() + size);
+        file_hdr_.global_depth_++;
+    }
+
+    // 取出桶中所有的键值对
+    std::vector<char> entries;
+    {
+        IxHashBucketHdr *hdr = bucket_hdr(*bucket);
+        entries.assign(bucket_entries(*bucket), bucket_entries(*bucket) + hdr->num_entries * entry_len());
+        for (page_id_t page_no = hdr->next_overflow; page_no != IX_NO_PAGE;) {
+            WritePageGuard page = fetch_page(page_no);
+            IxHashBucketHdr *overflow_hdr = bucket_hdr(page);
+            entries.insert(entries.end(), bucket_entries(page),
+                           bucket_entries(page) + overflow_hdr->num_entries * entry_len());
+            page_no = overflow_hdr->next_overflow;
+            free_page(&page);
+        }
+    }
+    WritePageGuard sibling = new_page();
+    bucket->mark_dirty();
+    *bucket_hdr(*bucket) = {.local_depth = local_depth + 1, .num_entries = 0, .next_overflow = IX_NO_PAGE};
+    bucket_hdr(sibling)->local_depth = local_depth + 1;
+
+    page_id_t bucket_no = bucket->get_page_id().page_no;
+    page_id_t sibling_no = sibling.get_page_id().page_no;
+    for (size_t i = 0; i < dir_.size(); i++) {
+        if (dir_[i] == bucket_no && ((i >> local_depth) & 1)) {
+            dir_[i] = sibling_no;
+        }
+    }
+    for (size_t offset = 0; offset < entries.size(); offset += entry_len()) {
+        const char *key = entries.data() + offset;
+        Rid rid;
+        memcpy(&rid, key + file_hdr_.col_tot_len_, sizeof(Rid));
+        WritePageGuard *target = ((hash(key) >> local_depth) & 1) ? &sibling : bucket;
+        if (!try_insert(target, key, rid)) {
+            append_overflow(target, key, rid);
+        }
+    }
+}
+
+/**
+ * @brief 固定一个页面，只读访问时不会成为脏页，修改前调用mark_dirty()
+ */
+WritePageGuard IxHashIndexHandle::fetch_page(page_id_t page_no) const {
+    WritePageGuard guard = buffer_pool_manager_->fetch_page_write(PageId{fd_, page_no});
+    if (!guard) {
+        throw InternalError("IxHashIndexHandle::fetch_page: no free frame in buffer pool");
+    }
+    return guard;
+}
+
+/**
+ * @brief 分配一个空的桶页面，优先重用空闲页链表中的页面
+ */
+WritePageGuard IxHashIndexHandle::new_page() {
+    std::lock_guard lock{free_latch_};
+    WritePageGuard guard;
+    if (file_hdr_.first_free_page_no_ != IX_NO_PAGE) {
+        guard = fetch_page(file_hdr_.first_free_page_no_);
+        file_hdr_.first_free_page_no_ = bucket_hdr(guard)->next_overflow;
+    } else {
+        PageId page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
+        guard = buffer_pool_manager_->new_page_guarded(&page_id);
+        if (!guard) {
+            throw InternalError("IxHashIndexHandle::new_page: no free frame in buffer pool");
+        }
+    }
+    guard.mark_dirty();
+    *bucket_hdr(guard) = {.local_depth = 0, .num_entries = 0, .next_overflow = IX_NO_PAGE};
+    return guard;
+}
+
+/**
+ * @brief 把已从桶中摘下的页面放入空闲页链表，并取消固定
+ */
+void IxHashIndexHandle::free_page(WritePageGuard *guard) {
+    std::lock_guard lock{free_latch_};
+    guard->mark_dirty();
+    *bucket_hdr(*guard) = {.local_depth = 0, .num_entries = 0, .next_overflow = file_hdr_.first_free_page_no_};
+    file_hdr_.first_free_page_no_ = guard->get_page_id().page_no;
+    guard->release();
+}
+
+/**
+ * @brief 把目录写入文件，由IxManager::close_hash_index调用；保留的页面不够时把旧的目录页面放入空闲页链表，
+ * 在文件末尾分配新的连续页面
+ */
+void IxHashIndexHandle::write_dir() {
+    int num_pages = static_cast<int>((dir_.size() + IX_HASH_DIR_PER_PAGE - 1) / IX_HASH_DIR_PER_PAGE);
+    std::vector<char> buf(num_pages * PAGE_SIZE, 0);
+    if (num_pages > file_hdr_.dir_num_pages_) {
+        for (int i = 0; i < file_hdr_.dir_num_pages_; i++) {
+            *reinterpret_cast<IxHashBucketHdr *>(buf.data()) = {
+                .local_depth = 0, .num_entries = 0, .next_overflow = file_hdr_.first_free_page_no_};
+            file_hdr_.first_free_page_no_ = file_hdr_.dir_first_page_ + i;
+            disk_manager_->write_page(fd_, file_hdr_.first_free_page_no_, buf.data(), PAGE_SIZE);
+        }
+        file_hdr_.dir_first_page_ = disk_manager_->allocate_page(fd_);
+        for (int i = 1; i < num_pages; i++) {
+            disk_manager_->allocate_page(fd_);
+        }
+        file_hdr_.dir_num_pages_ = num_pages;
+    }
+    memcpy(buf.data(), dir_.data(), dir_.size() * sizeof(page_id_t));
+    disk_manager_->write_page(fd_, file_hdr_.dir_first_page_, buf.data(), buf.size());
+    file_hdr_.num_pages_ = disk_manager_->get_fd2pageno(fd_);
+}
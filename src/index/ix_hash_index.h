@@ -0,0 +1,156 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+
+#include "ix_defs.h"
+#include "ix_index_handle.h"
+#include "transaction/transaction.h"
+
+constexpr int IX_HASH_BUCKET_PAGE = 1;      // 初始时唯一的桶
+constexpr int IX_HASH_INIT_DIR_PAGE = 2;    // 初始的目录页面
+constexpr int IX_HASH_INIT_NUM_PAGES = 3;
+constexpr int IX_HASH_MAX_DEPTH = 20;       // 目录最多有2^20项，哈希值的更高位不再用于分裂
+constexpr int IX_HASH_DIR_PER_PAGE = PAGE_SIZE / sizeof(page_id_t);
+
+constexpr uint32_t IX_HASH_FILE_MAGIC = 0x49584853;  // 哈希索引文件的标识"IXHS"
+constexpr uint32_t IX_HASH_FILE_VERSION = 1;         // 文件格式版本，格式不兼容地变化时递增
+
+// 哈希索引的文件头，存放在第0页，打开时读入内存，关闭时写回
+class IxHashFileHdr {
+public:
+    uint32_t magic_ = IX_HASH_FILE_MAGIC;       // 固定为IX_HASH_FILE_MAGIC
+    uint32_t version_ = IX_HASH_FILE_VERSION;   // 创建文件时的IX_HASH_FILE_VERSION，打开时不一致则拒绝
+    int col_num_;                       // 索引包含的字段数量
+    std::vector<ColType> col_types_;    // 字段的类型
+    std::vector<int> col_lens_;         // 字段的长度
+    int col_tot_len_;                   // 索引包含的字段的总长度
+    int bucket_capacity_;               // 每个桶页面最多存放的键值对数量
+    int global_depth_;                  // 目录的全局深度，目录有2^global_depth项
+    int num_pages_;                     // 文件中已分配的页面数，打开时从这里继续分配页号
+    page_id_t first_free_page_no_;      // 空闲页链表，释放的溢出页和旧的目录页面在这里重用
+    page_id_t dir_first_page_;          // 目录存放在从这一页开始的连续页面中
+    int dir_num_pages_;                 // 为目录保留的页面数
+
+    int size() const { return sizeof(uint32_t) * 2 + sizeof(int) * 8 + (sizeof(ColType) + sizeof(int)) * col_num_; }
+
+    void serialize(char *dest) const {
+        int offset = 0;
+        auto put = [&](const void *src, size_t len) {
+            memcpy(dest + offset, src, len);
+            offset += len;
+        };
+        put(&magic_, sizeof(uint32_t));
+        put(&version_, sizeof(uint32_t));
+        put(&col_num_, sizeof(int));
+        put(col_types_.data(), sizeof(ColType) * col_num_);
+        put(col_lens_.data(), sizeof(int) * col_num_);
+        put(&col_tot_len_, sizeof(int));
+        put(&bucket_capacity_, sizeof(int));
+        put(&global_depth_, sizeof(int));
+        put(&num_pages_, sizeof(int));
+        put(&first_free_page_no_, sizeof(page_id_t));
+        put(&dir_first_page_, sizeof(page_id_t));
+        put(&dir_num_pages_, sizeof(int));
+        assert(offset == size());
+    }
+
+    // 标识或版本不一致时只读出magic_和version_，由调用者检查后拒绝打开
+    void deserialize(const char *src) {
+        int offset = 0;
+        auto get = [&](void *dest, size_t len) {
+            memcpy(dest, src + offset, len);
+            offset += len;
+        };
+        get(&magic_, sizeof(uint32_t));
+        get(&version_, sizeof(uint32_t));
+        if (magic_ != IX_HASH_FILE_MAGIC || version_ != IX_HASH_FILE_VERSION) {
+            return;
+        }
+        get(&col_num_, sizeof(int));
+        col_types_.resize(col_num_);
+        col_lens_.resize(col_num_);
+        get(col_types_.data(), sizeof(ColType) * col_num_);
+        get(col_lens_.data(), sizeof(int) * col_num_);
+        get(&col_tot_len_, sizeof(int));
+        get(&bucket_capacity_, sizeof(int));
+        get(&global_depth_, sizeof(int));
+        get(&num_pages_, sizeof(int));
+        get(&first_free_page_no_, sizeof(page_id_t));
+        get(&dir_first_page_, sizeof(page_id_t));
+        get(&dir_num_pages_, sizeof(int));
+    }
+};
+
+// 桶页面的头部，之后紧跟bucket_capacity_个键值对，每个键值对是规范化的key加上Rid
+class IxHashBucketHdr {
+public:
+    int local_depth;                // 桶的局部深度，目录中哈希值低local_depth位相同的项都指向这个桶
+    int num_entries;                // 本页中键值对的数量
+    page_id_t next_overflow;        // 溢出页链表，哈希值相同的键值对超出一页时使用；空闲页链表中为下一个空闲页
+};
+
+/* 可扩展哈希索引，只支持等值查找。目录常驻内存，桶是缓冲池中的页面；
+ * 同一个key可以有多个rid。桶满时分裂，局部深度等于全局深度时目录加倍；
+ * 桶中所有键值对的哈希值都相同（重复key）时分裂无济于事，改为加入溢出页 */
+class IxHashIndexHandle {
+    friend class IxManager;
+
+   private:
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    int fd_;
+    IxHashFileHdr file_hdr_;
+    std::vector<page_id_t> dir_;        // 目录，第i项是哈希值低global_depth位为i的key所在的桶
+    // 目录锁：查找以及不引起分裂的插入删除持共享锁，只在桶的第一个页面上加读写锁，同一个桶的溢出页也由它保护；
+    // 分裂、目录加倍和加入溢出页持排他锁
+    mutable std::shared_mutex dir_latch_;
+    std::mutex free_latch_;             // 保护空闲页链表，持有共享锁的删除也会释放溢出页
+
+   public:
+    IxHashIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
+
+    bool get_value(const char *key, std::vector<Rid> *result, Transaction *transaction) const;
+
+    bool insert_entry(const char *key, const Rid &value, Transaction *transaction);
+
+    bool delete_entry(const char *key, const Rid &value, Transaction *transaction);
+
+    int get_global_depth() const {
+        std::shared_lock lock{dir_latch_};
+        return file_hdr_.global_depth_;
+    }
+
+   private:
+    uint32_t hash(const char *key) const;
+
+    page_id_t bucket_of(uint32_t hash) const { return dir_[hash & ((1u << file_hdr_.global_depth_) - 1)]; }
+
+    int entry_len() const { return file_hdr_.col_tot_len_ + sizeof(Rid); }
+
+    bool try_insert(WritePageGuard *bucket, const char *key, const Rid &value);
+
+    void append_overflow(WritePageGuard *bucket, const char *key, const Rid &value);
+
+    bool can_split(WritePageGuard *bucket, uint32_t hash);
+
+    void split(WritePageGuard *bucket);
+
+    WritePageGuard fetch_page(page_id_t page_no) const;
+
+    WritePageGuard new_page();
+
+    void free_page(WritePageGuard *guard);
+
+    void write_dir();
+};
@@ -10,8 +10,344 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_index_handle.h"
 
+#include <algorithm>
+
 #include "ix_scan.h"
 
+/**
+ * @brief 在当前node的[lo,num_key)中查找第一个>=target（upper为false）或>target（upper为true）的key_idx
+ *
+ * @note 单列INT/FLOAT键使用按类型特化的无分支二分查找；规范化的key跳过结点内的公共前缀后用memcmp二分查找，
+ * 压缩格式的结点中公共前缀只存一次，target与它比较一次后只比较后缀；其余键用ix_compare二分查找
+ */
+template <bool upper>
+int IxNodeHandle::search(const char *target, int lo) const {
+    int hi = page_hdr->num_key;
+    if (hi <= lo) {
+        // upper_bound从1开始，结点为空时与顺序查找一样返回num_key
+        return hi;
+    }
+    if (!binary_search) {
+        for (int i = lo; i < hi; i++) {
+            int cmp = compare_key(i, target);
+            if (upper ? cmp > 0 : cmp >= 0) {
+                return i;
+            }
+        }
+        return hi;
+    }
+    if (is_compressed()) {
+        int cmp = compare_prefix(target);
+        if (cmp != 0) {
+            return cmp < 0 ? lo : hi;
+        }
+        int target_len = ix_significant_len(target, file_hdr->col_tot_len_);
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            cmp = compare_suffix(mid, target, target_len);
+            if (upper ? cmp <= 0 : cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+    if (file_hdr->key_format_ == IX_KEY_NORMALIZED) {
+        // 结点中的key有序，[lo,hi)中第一个和最后一个key的公共前缀就是所有key的公共前缀，target只需和它比较一次
+        int len = file_hdr->col_tot_len_;
+        const char *first = get_key(lo);
+        const char *last = get_key(hi - 1);
+        int prefix = 0;
+        while (prefix < len && first[prefix] == last[prefix]) {
+            prefix++;
+        }
+        int cmp = memcmp(target, first, prefix);
+        if (cmp != 0) {
+            return cmp < 0 ? lo : hi;
+        }
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            cmp = memcmp(get_key(mid) + prefix, target + prefix, len - prefix);
+            if (upper ? cmp <= 0 : cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+    if (file_hdr->col_types_.size() == 1) {
+        switch (file_hdr->col_types_[0]) {
+            case TYPE_INT:
+                return ix_search_typed<int, upper>(keys, lo, hi, target);
+            case TYPE_FLOAT:
+                return ix_search_typed<float, upper>(keys, lo, hi, target);
+            default:
+                break;
+        }
+    }
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = ix_compare(get_key(mid), target, *file_hdr);
+        if (upper ? cmp <= 0 : cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief target的前prefix_len字节与结点的公共前缀比较，返回值的符号与memcmp(target, prefix)相同
+ * @note 公共前缀是下界的前prefix_len字节，下界在末尾去掉的0字节也属于前缀
+ */
+int IxNodeHandle::compare_prefix(const char *target) const {
+    auto hdr = compressed_hdr();
+    int stored = std::min(hdr->prefix_len, hdr->low_len);
+    int cmp = memcmp(target, fences(), stored);
+    if (cmp != 0) {
+        return cmp;
+    }
+    for (int i = stored; i < hdr->prefix_len; i++) {
+        if (target[i] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 已知target与公共前缀相同时比较第key_idx个key和target，key的后缀之后都是0字节
+ * @param target_len target去掉末尾0字节后的长度
+ */
+int IxNodeHandle::compare_suffix(int key_idx, const char *target, int target_len) const {
+    const IxSlot &slot = slots()[key_idx];
+    int prefix = compressed_hdr()->prefix_len;
+    int cmp = memcmp(page->get_data() + slot.offset, target + prefix, slot.len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return prefix + slot.len < target_len ? -1 : 0;
+}
+
+void IxNodeHandle::read_key(int key_idx, char *dest) const {
+    int len = file_hdr->col_tot_len_;
+    if (!is_compressed()) {
+        memcpy(dest, get_key(key_idx), len);
+        return;
+    }
+    auto hdr = compressed_hdr();
+    const IxSlot &slot = slots()[key_idx];
+    memset(dest, 0, len);
+    memcpy(dest, fences(), std::min(hdr->prefix_len, hdr->low_len));
+    memcpy(dest + hdr->prefix_len, page->get_data() + slot.offset, slot.len);
+}
+
+int IxNodeHandle::compare_key(int key_idx, const char *target) const {
+    if (!is_compressed()) {
+        return ix_compare(get_key(key_idx), target, *file_hdr);
+    }
+    int cmp = compare_prefix(target);
+    if (cmp != 0) {
+        return -cmp;
+    }
+    return compare_suffix(key_idx, target, ix_significant_len(target, file_hdr->col_tot_len_));
+}
+
+void IxNodeHandle::read_separator(char *dest) const {
+    if (is_compressed()) {
+        read_low(dest);
+    } else {
+        read_key(0, dest);
+    }
+}
+
+bool IxNodeHandle::read_low(char *dest) const {
+    auto hdr = compressed_hdr();
+    memset(dest, 0, file_hdr->col_tot_len_);
+    memcpy(dest, fences(), hdr->low_len);
+    return hdr->has_low;
+}
+
+bool IxNodeHandle::read_high(char *dest) const {
+    auto hdr = compressed_hdr();
+    memset(dest, 0, file_hdr->col_tot_len_);
+    memcpy(dest, fences() + hdr->low_len, hdr->high_len);
+    return hdr->has_high;
+}
+
+void IxNodeHandle::read_entries(int begin, int end, std::vector<char> *keys, std::vector<Rid> *rids) const {
+    int len = file_hdr->col_tot_len_;
+    size_t offset = keys->size();
+    keys->resize(offset + static_cast<size_t>(end - begin) * len);
+    for (int i = begin; i < end; i++, offset += len) {
+        read_key(i, keys->data() + offset);
+        rids->push_back(*get_rid(i));
+    }
+}
+
+void IxNodeHandle::rebuild(const char *low, const char *high, const char *keys, const Rid *rids, int n) {
+    guard.mark_dirty();
+    encode(page->get_data(), file_hdr, low, high, keys, rids, n);
+}
+
+/**
+ * @note 压缩格式：公共前缀为上下界补齐后的公共前缀，上下界中有一个不存在时为空；后缀按key的顺序从页尾向前存放
+ */
+void IxNodeHandle::encode(char *data, const IxFileHdr *file_hdr, const char *low, const char *high,
+                          const char *keys, const Rid *rids, int n) {
+    int len = file_hdr->col_tot_len_;
+    reinterpret_cast<IxPageHdr *>(data)->num_key = n;
+    if (file_hdr->key_format_ != IX_KEY_COMPRESSED) {
+        if (n > 0) {
+            memcpy(data + sizeof(IxPageHdr), keys, static_cast<size_t>(n) * len);
+            memcpy(data + sizeof(IxPageHdr) + file_hdr->keys_size_, rids, n * sizeof(Rid));
+        }
+        return;
+    }
+    IxCompressedHdr hdr{};
+    hdr.has_low = low != nullptr;
+    hdr.has_high = high != nullptr;
+    hdr.low_len = low != nullptr ? ix_significant_len(low, len) : 0;
+    hdr.high_len = high != nullptr ? ix_significant_len(high, len) : 0;
+    hdr.prefix_len = low != nullptr && high != nullptr ? ix_common_prefix(low, high, len) : 0;
+    if (hdr.low_len > 0) {
+        memcpy(data + IX_FENCE_OFFSET, low, hdr.low_len);
+    }
+    if (hdr.high_len > 0) {
+        memcpy(data + IX_FENCE_OFFSET + hdr.low_len, high, hdr.high_len);
+    }
+    auto slots = reinterpret_cast<IxSlot *>(data + ix_slots_offset(hdr.low_len, hdr.high_len));
+    int top = PAGE_SIZE;
+    for (int i = 0; i < n; i++) {
+        const char *key = keys + static_cast<size_t>(i) * len;
+        int suffix_len = std::max(0, ix_significant_len(key, len) - hdr.prefix_len);
+        top -= suffix_len;
+        memcpy(data + top, key + hdr.prefix_len, suffix_len);
+        slots[i] = {.offset = static_cast<uint16_t>(top), .len = static_cast<uint16_t>(suffix_len), .rid = rids[i]};
+    }
+    assert(reinterpret_cast<char *>(slots + n) <= data + top);
+    hdr.heap_size = PAGE_SIZE - top;
+    *reinterpret_cast<IxCompressedHdr *>(data + sizeof(IxPageHdr)) = hdr;
+}
+
+int IxNodeHandle::encoded_size(const IxFileHdr *file_hdr, const char *low, const char *high, const char *keys,
+                               int n) {
+    int len = file_hdr->col_tot_len_;
+    int low_len = low != nullptr ? ix_significant_len(low, len) : 0;
+    int high_len = high != nullptr ? ix_significant_len(high, len) : 0;
+    int prefix = low != nullptr && high != nullptr ? ix_common_prefix(low, high, len) : 0;
+    int size = ix_slots_offset(low_len, high_len) + n * static_cast<int>(sizeof(IxSlot));
+    for (int i = 0; i < n; i++) {
+        size += std::max(0, ix_significant_len(keys + static_cast<size_t>(i) * len, len) - prefix);
+    }
+    return size;
+}
+
+int IxNodeHandle::used_bytes() const {
+    auto hdr = compressed_hdr();
+    return ix_slots_offset(hdr->low_len, hdr->high_len) + page_hdr->num_key * static_cast<int>(sizeof(IxSlot)) +
+           hdr->heap_size - hdr->garbage;
+}
+
+// 压缩格式的结点中key占用的字节数，key为nullptr时为结点中可能的最大值
+int IxNodeHandle::entry_bytes(const char *key) const {
+    int len = file_hdr->col_tot_len_;
+    int prefix = compressed_hdr()->prefix_len;
+    int suffix_len = key != nullptr ? std::max(0, ix_significant_len(key, len) - prefix) : len - prefix;
+    return static_cast<int>(sizeof(IxSlot)) + suffix_len;
+}
+
+bool IxNodeHandle::is_overfull() const {
+    if (!is_compressed()) {
+        return page_hdr->num_key >= file_hdr->btree_order_ + 1;
+    }
+    return used_bytes() > max_bytes(file_hdr);
+}
+
+bool IxNodeHandle::is_underfull() const {
+    if (!is_compressed()) {
+        return page_hdr->num_key < (file_hdr->btree_order_ + 1) / 2;
+    }
+    return used_bytes() < max_bytes(file_hdr) / 2;
+}
+
+bool IxNodeHandle::can_insert(const char *key) const {
+    if (!is_compressed()) {
+        return page_hdr->num_key + 1 < file_hdr->btree_order_ + 1;
+    }
+    return used_bytes() + entry_bytes(key) <= max_bytes(file_hdr);
+}
+
+bool IxNodeHandle::can_erase(const char *key) const {
+    if (!is_compressed()) {
+        return page_hdr->num_key - 1 >= (file_hdr->btree_order_ + 1) / 2;
+    }
+    return used_bytes() - entry_bytes(key) >= max_bytes(file_hdr) / 2;
+}
+
+bool IxNodeHandle::can_set_key(int i, const char *key) const {
+    if (!is_compressed()) {
+        return true;
+    }
+    int old_bytes = static_cast<int>(sizeof(IxSlot)) + slots()[i].len;
+    return used_bytes() - old_bytes + entry_bytes(key) <= max_bytes(file_hdr);
+}
+
+void IxNodeHandle::set_key(int key_idx, const char *key) {
+    if (!is_compressed()) {
+        guard.mark_dirty();
+        memcpy(keys + key_idx * file_hdr->col_tot_len_, key, file_hdr->col_tot_len_);
+        return;
+    }
+    Rid rid = *get_rid(key_idx);
+    erase_pair(key_idx);
+    insert_pair(key_idx, key, rid);
+}
+
+/**
+ * @brief 在压缩格式的结点中插入一个键值对，后缀区的连续空间不足时先整理；key必须在结点的上下界之间
+ */
+void IxNodeHandle::insert_compressed(int pos, const char *key, const Rid &rid) {
+    assert(compare_prefix(key) == 0);
+    auto hdr = compressed_hdr();
+    int suffix_len = std::max(0, ix_significant_len(key, file_hdr->col_tot_len_) - hdr->prefix_len);
+    int slots_end = ix_slots_offset(hdr->low_len, hdr->high_len) +
+                    (page_hdr->num_key + 1) * static_cast<int>(sizeof(IxSlot));
+    if (slots_end + hdr->heap_size + suffix_len > PAGE_SIZE) {
+        compact();
+    }
+    assert(slots_end + hdr->heap_size + suffix_len <= PAGE_SIZE);
+    hdr->heap_size += suffix_len;
+    int offset = PAGE_SIZE - hdr->heap_size;
+    memcpy(page->get_data() + offset, key + hdr->prefix_len, suffix_len);
+    IxSlot *slot = slots();
+    memmove(slot + pos + 1, slot + pos, (page_hdr->num_key - pos) * sizeof(IxSlot));
+    slot[pos] = {.offset = static_cast<uint16_t>(offset), .len = static_cast<uint16_t>(suffix_len), .rid = rid};
+    page_hdr->num_key++;
+}
+
+/**
+ * @brief 按槽位的顺序把后缀重新紧密地存放到页尾，去掉删除留下的空洞
+ */
+void IxNodeHandle::compact() {
+    char buf[PAGE_SIZE];
+    char *data = page->get_data();
+    memcpy(buf, data, PAGE_SIZE);
+    IxSlot *slot = slots();
+    int top = PAGE_SIZE;
+    for (int i = 0; i < page_hdr->num_key; i++) {
+        top -= slot[i].len;
+        memcpy(data + top, buf + slot[i].offset, slot[i].len);
+        slot[i].offset = static_cast<uint16_t>(top);
+    }
+    auto hdr = compressed_hdr();
+    hdr->heap_size = PAGE_SIZE - top;
+    hdr->garbage = 0;
+}
+
 /**
  * @brief 在当前node中查找第一个>=target的key_idx
  *
@@ -19,15 +355,7 @@ See the Mulan PSL v2 for more details. */
  * @note 返回key index（同时也是rid index），作为slot no
  */
 int IxNodeHandle::lower_bound(const char *target) const {
-    // Todo:
-    // 查找当前节点中第一个大于等于target的key，并返回key的位置给上层
-    // 提示: 可以采用多种查找方式，如顺序遍历、二分查找等；使用ix_compare()函数进行比较
-    for(int i = 0;i < page_hdr->num_key;i++){
-        if(ix_compare(target,get_key(i),file_hdr->col_types_,file_hdr->col_lens_)!=1){
-            return i;
-        }
-    }
-    return page_hdr->num_key;
+    return search<false>(target, 0);
 }
 
 /**
@@ -37,15 +365,7 @@ int IxNodeHandle::lower_bound(const char *target) const {
  * @note 注意此处的范围从1开始
  */
 int IxNodeHandle::upper_bound(const char *target) const {
-    // Todo:
-    // 查找当前节点中第一个大于target的key，并返回key的位置给上层
-    // 提示: 可以采用多种查找方式：顺序遍历、二分查找等；使用ix_compare()函数进行比较
-    for(int i = 1;i < page_hdr->num_key;i++){
-        if(ix_compare(get_key(i),target,file_hdr->col_types_,file_hdr->col_lens_)==1){
-            return i;
-        }
-    }
-    return page_hdr->num_key;
+    return search<true>(target, 1);
 }
 
 /**
@@ -65,8 +385,7 @@ bool IxNodeHandle::leaf_lookup(const char *key, Rid **value) {
     
     // expectation = the index of key
     int expectation = lower_bound(key);
-    if(expectation == page_hdr->num_key || 
-        ix_compare(key,get_key(expectation),file_hdr->col_types_,file_hdr->col_lens_)){
+    if(expectation == page_hdr->num_key || compare_key(expectation,key)){
         return false;
     }
     *value = get_rid(expectation);
@@ -108,6 +427,13 @@ void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n)
     if((pos < 0) || (pos > get_size()) )
         return;
     // 2. 通过key获取n个连续键值对的key值，并把n个key值插入到pos位置
+    guard.mark_dirty();
+    if (is_compressed()) {
+        for (int i = 0; i < n; i++) {
+            insert_compressed(pos + i, key + static_cast<size_t>(i) * file_hdr->col_tot_len_, rid[i]);
+        }
+        return;
+    }
     int mv_num = get_size()-pos;
 
     char* new_key_dest = get_key(pos);
@@ -137,7 +463,7 @@ int IxNodeHandle::insert(const char *key, const Rid &value) {
     // 2. 如果key重复则不插入
     // 3. 如果key不重复则插入键值对
     if( index == page_hdr->num_key
-        || ix_compare(get_key(index),key,file_hdr->col_types_,file_hdr->col_lens_))
+        || compare_key(index,key))
     {
         insert_pairs(index,key,&value,1);
     }
@@ -160,6 +486,17 @@ void IxNodeHandle::erase_pair(int pos) {
     }
     
     // 将pos之后（不含pos）的键值对整体往前移动1个
+    guard.mark_dirty();
+    if (is_compressed()) {
+        auto hdr = compressed_hdr();
+        IxSlot *slot = slots();
+        hdr->garbage += slot[pos].len;
+        memmove(slot + pos, slot + pos + 1, (page_hdr->num_key - pos - 1) * sizeof(IxSlot));
+        if (--page_hdr->num_key == 0) {
+            hdr->heap_size = hdr->garbage = 0;
+        }
+        return;
+    }
     int move_pair_num = page_hdr->num_key - pos - 1;
     char* erased_key = get_key(pos);
     char* next_key = get_key(pos+1);
@@ -184,8 +521,7 @@ int IxNodeHandle::remove(const char *key) {
     // 2. 如果要删除的键值对存在，删除键值对
     // 3. 返回完成删除操作后的键值对数量
     int index = lower_bound(key);
-    if(index != page_hdr->num_key &&
-        !ix_compare(key,get_key(index),file_hdr->col_types_,file_hdr->col_lens_)){
+    if(index != page_hdr->num_key && !compare_key(index,key)){
             erase_pair(index);
         }
     return page_hdr->num_key;
@@ -200,35 +536,121 @@ IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffe
     disk_manager_->read_page(fd, IX_FILE_HDR_PAGE, buf, PAGE_SIZE);
     file_hdr_ = new IxFileHdr();
     file_hdr_->deserialize(buf);
+    delete[] buf;
+    if (file_hdr_->magic_ != IX_FILE_MAGIC || file_hdr_->version_ != IX_FILE_VERSION) {
+        delete file_hdr_;
+        throw FileFormatError(disk_manager_->get_file_name(fd));
+    }
     
     // disk_manager管理的fd对应的文件中，设置从file_hdr_->num_pages开始分配page_no
-    int now_page_no = disk_manager_->get_fd2pageno(fd);
-    disk_manager_->set_fd2pageno(fd, now_page_no + 1);
+    disk_manager_->set_fd2pageno(fd, file_hdr_->num_pages_);
 }
 
 /**
- * @brief 用于查找指定键所在的叶子结点
+ * @brief 用于查找指定键所在的叶子结点，从根结点开始按latch crabbing向下加锁：对孩子结点加锁后再释放父结点的锁
  * @param key 要查找的目标key值
- * @param operation 查找到目标键值对后要进行的操作类型
+ * @param operation 查找到目标键值对后要进行的操作类型，FIND对叶结点加读锁，INSERT和DELETE对叶结点加写锁
  * @param transaction 事务参数，如果不需要则默认传入nullptr
- * @return [leaf node] and [root_is_latched] 返回目标叶子结点以及根结点是否加锁
- * @note need to Unlatch and unpin the leaf node outside!
- * 注意：用了FindLeafPage之后一定要unlatch叶结点，否则下次latch该结点会堵塞！
+ * @return [leaf node] and [is_root] 返回加锁的目标叶子结点以及它是否为根结点，叶子结点的句柄析构时先解锁再取消固定
+ * @note 内部结点只加读锁，只在叶结点上修改的插入删除用这种方式乐观地下降；结点是否为叶结点在创建后不再改变，
+ * 可以在加锁之前判断
  */
-std::pair<IxNodeHandle *, bool> IxIndexHandle::find_leaf_page(const char *key, Operation operation,
-                                                            Transaction *transaction, bool find_first) {
-    // 1. 获取根节点
-    page_id_t cur_page_no = file_hdr_->root_page_;
-    IxNodeHandle* node_hdr = fetch_node(cur_page_no);
-    // 2. 从根节点开始不断向下查找目标key
-    while(!node_hdr->is_leaf_page()){
-        cur_page_no = node_hdr->internal_lookup(key);
-        buffer_pool_manager_->unpin_page(node_hdr->get_page_id(),false);
-        node_hdr = fetch_node(cur_page_no);
+std::pair<IxNodeHandle, bool> IxIndexHandle::find_leaf_page(const char *key, Operation operation,
+                                                           Transaction *transaction, bool find_first) const {
+    auto latch = [operation](IxNodeHandle &node) {
+        if (node.is_leaf_page() && operation != Operation::FIND) {
+            node.latch_exclusive();
+        } else {
+            node.latch_shared();
+        }
+    };
+    // 1. 持有root_latch_共享锁获取根节点并加锁，之后根结点不会被替换
+    IxNodeHandle node_hdr;
+    {
+        std::shared_lock lock{root_latch_};
+        node_hdr = fetch_node(file_hdr_->root_page_);
+        latch(node_hdr);
+    }
+    bool is_root = node_hdr.is_leaf_page();
+    // 2. 从根节点开始不断向下查找目标key，先对孩子结点加锁再释放当前结点
+    while(!node_hdr.is_leaf_page()){
+        IxNodeHandle child = fetch_node(node_hdr.internal_lookup(key));
+        latch(child);
+        node_hdr = std::move(child);
     }
-    // 3. 找到包含该key值的叶子结点停止查找，并返回叶子节点
-    return std::make_pair(node_hdr, false);
-    //TODO : latch?
+    // 3. 找到包含该key值的叶子结点停止查找，返回加锁的叶子节点
+    return std::make_pair(std::move(node_hdr), is_root);
+}
+
+/**
+ * @brief 持有写锁从根结点下降到key所在的叶结点，用于可能分裂或合并的插入删除
+ * @param fence 不为空时求出叶结点的上界：下降路径上每层右侧的分隔key中最深的一个，叶结点中只会有小于它的key；
+ * 最右侧的叶结点没有上界，fence为空
+ * @return 从最上面一个可能被修改的结点到叶结点的路径
+ * @note 先持有root_latch_共享锁对根结点加写锁，根结点不安全时释放，改为持有root_latch_排他锁重新获取根结点；
+ * 向下每对一个孩子结点加锁后，如果孩子结点安全就释放它上面的所有结点
+ */
+IxWritePath IxIndexHandle::find_write_path(const char *key, Operation operation, std::vector<char> *fence) {
+    IxWritePath path;
+    {
+        std::shared_lock lock{root_latch_};
+        IxNodeHandle root = fetch_node(file_hdr_->root_page_);
+        root.latch_exclusive();
+        if (is_safe(root, key, operation, true)) {
+            path.nodes.push_back(std::move(root));
+        }
+    }
+    if (path.nodes.empty()) {
+        path.root_lock = std::unique_lock(root_latch_);
+        path.nodes.push_back(fetch_node(file_hdr_->root_page_));
+        path.nodes.back().latch_exclusive();
+    }
+    path.top_is_root = true;
+    if (fence != nullptr) {
+        fence->clear();
+    }
+    while (!path.nodes.back().is_leaf_page()) {
+        IxNodeHandle &node = path.nodes.back();
+        int index = node.upper_bound(key);
+        if (fence != nullptr && index < node.get_size()) {
+            fence->resize(file_hdr_->col_tot_len_);
+            node.read_key(index, fence->data());
+        }
+        IxNodeHandle child = fetch_node(node.value_at(index - 1));
+        child.latch_exclusive();
+        if (is_safe(child, key, operation, false)) {
+            path.release();
+            path.top_is_root = false;
+        }
+        path.nodes.push_back(std::move(child));
+    }
+    return path;
+}
+
+/**
+ * @brief 判断持有写锁的node在这次插入或删除后是否不会影响它的父结点：插入时不会分裂；
+ * 删除时不会合并或重分配，并且第一个key不变（否则maintain_parent要修改父结点）
+ * @param is_root node是否为根结点，根结点的父结点是root_latch_
+ * @note 内部结点中插入或删除的是孩子的分隔key，压缩格式时按最长的key判断；压缩格式的父结点中存的是孩子的下界，
+ * 不随第一个key改变
+ */
+bool IxIndexHandle::is_safe(IxNodeHandle &node, const char *key, Operation operation, bool is_root) const {
+    const char *entry = node.is_leaf_page() ? key : nullptr;
+    if (operation == Operation::INSERT) {
+        return node.can_insert(entry);
+    }
+    if (is_root) {
+        // 叶结点作为根结点时大小不限；内部结点只剩一个孩子时要由adjust_root删除
+        return node.is_leaf_page() || node.get_size() > 2;
+    }
+    if (!node.can_erase(entry)) {
+        return false;
+    }
+    if (node.is_compressed()) {
+        return true;
+    }
+    // 叶结点删除的不是第一个key，内部结点向下经过的不是第一个孩子
+    return node.is_leaf_page() ? node.compare_key(0, key) < 0 : node.upper_bound(key) > 1;
 }
 
 /**
@@ -240,69 +662,109 @@ std::pair<IxNodeHandle *, bool> IxIndexHandle::find_leaf_page(const char *key, O
  * @return bool 返回目标键值对是否存在
  */
 bool IxIndexHandle::get_value(const char *key, std::vector<Rid> *result, Transaction *transaction) {
-    // Todo:
-    // 1. 获取目标key值所在的叶子结点
-    // simple latch
-    std::scoped_lock lock{root_latch_};
+    char key_buf[IX_MAX_COL_LEN];
+    key = to_stored_key(key, key_buf);
+    // 1. 获取目标key值所在的叶子结点，下降时只持有读锁，不同线程的查找可以并发进行
     auto leaf_pair = find_leaf_page(key,Operation::FIND,transaction,false);
-    IxNodeHandle* leaf_hdr = leaf_pair.first;
+    IxNodeHandle &leaf_hdr = leaf_pair.first;
     // 2. 在叶子节点中查找目标key值的位置，并读取key对应的rid
     Rid* obj_rid = nullptr;
-    bool found = leaf_hdr->leaf_lookup(key,&obj_rid);
-    // 3. 把rid存入result参数中
+    bool found = leaf_hdr.leaf_lookup(key,&obj_rid);
+    // 3. 把rid存入result参数中，posting list中的rid全部读出
     if(found){
-        result->push_back(*obj_rid);
+        read_postings(*obj_rid, result);
     }
-    buffer_pool_manager_->unpin_page(leaf_hdr->get_page_id(),false);
     return found;
-    // TODO: latch
-    // 提示：使用完buffer_pool提供的page之后，记得unpin page；记得处理并发的上锁
 }
 
 /**
  * @brief  将传入的一个node拆分(Split)成两个结点，在node的右边生成一个新结点new node
- * @param node 需要拆分的结点
- * @return 拆分得到的new_node
- * @note need to unpin the new node outside
- * 注意：本函数执行完毕后，原node和new node都需要在函数外面进行unpin
+ * @param node 需要拆分的结点，调用者持有它和它的父结点的写锁
+ * @return 拆分得到的new_node，其句柄析构时取消固定
+ * @note 新结点在插入父结点之前不会被其他线程访问，不需要加锁；叶结点的后继结点按从左到右的顺序加写锁后修改prev_leaf，
+ * 内部结点的孩子只修改父结点编号，该字段由持有父结点写锁的线程维护
  */
-IxNodeHandle *IxIndexHandle::split(IxNodeHandle *node) {
+IxNodeHandle IxIndexHandle::split(IxNodeHandle *node) {
     // Todo:
     // 1. 将原结点的键值对平均分配，右半部分分裂为新的右兄弟结点
     //    需要初始化新节点的page_hdr内容
-    IxNodeHandle* new_node = create_node();
-    int old_keys_size = node->get_size()/2;                 // size of the old node
-    int new_keys_size = node->get_size() - old_keys_size;
-    
-    new_node->page_hdr->parent = node->page_hdr->parent;
-    new_node->page_hdr->num_key = 0;
-    new_node->page_hdr->is_leaf = node->page_hdr->is_leaf;
+    IxNodeHandle new_node = create_node();
+    new_node.set_parent_page_no(node->get_parent_page_no());
+    new_node.set_size(0);
+    new_node.set_leaf(node->is_leaf_page());
 
-    node->page_hdr->num_key = old_keys_size;
+    if(node->is_compressed()){
+        split_compressed(node,&new_node);
+    } else {
+        int old_keys_size = node->get_size()/2;                 // size of the old node
+        int new_keys_size = node->get_size() - old_keys_size;
 
-    char* new_keys_src = node->get_key(old_keys_size);
-    Rid*  new_rids_src = node->get_rid(old_keys_size);
-    
-    new_node->insert_pairs(0,new_keys_src,new_rids_src,new_keys_size);
+        node->set_size(old_keys_size);
+
+        char* new_keys_src = node->get_key(old_keys_size);
+        Rid*  new_rids_src = node->get_rid(old_keys_size);
+
+        new_node.insert_pairs(0,new_keys_src,new_rids_src,new_keys_size);
+    }
     // 2. 如果新的右兄弟结点是叶子结点，更新新旧节点的prev_leaf和next_leaf指针
-    //    为新节点分配键值对，更新旧节点的键值对数记录
-    if(new_node->page_hdr->is_leaf){
-        new_node->page_hdr->next_leaf = node->page_hdr->next_leaf;
-        new_node->page_hdr->prev_leaf = node->get_page_no();
-        IxNodeHandle* origin_next_leaf = fetch_node(node->page_hdr->next_leaf);
-        origin_next_leaf->page_hdr->prev_leaf = new_node->get_page_no();
-        node->page_hdr->next_leaf = new_node->get_page_no();
-        buffer_pool_manager_->unpin_page(origin_next_leaf->get_page_id(),true);
+    //    为新节点分配键值对，更新旧节点的键值对数记录；原结点是最右叶子节点时更新file_hdr_.last_leaf
+    if(new_node.is_leaf_page()){
+        new_node.set_next_leaf(node->get_next_leaf());
+        new_node.set_prev_leaf(node->get_page_no());
+        IxNodeHandle origin_next_leaf = fetch_node(node->get_next_leaf());
+        origin_next_leaf.latch_exclusive();
+        origin_next_leaf.set_prev_leaf(new_node.get_page_no());
+        node->set_next_leaf(new_node.get_page_no());
+        if (new_node.get_next_leaf() == IX_LEAF_HEADER_PAGE) {
+            std::lock_guard lock{file_hdr_latch_};
+            file_hdr_->last_leaf_ = new_node.get_page_no();
+        }
     }
     // 3. 如果新的右兄弟结点不是叶子结点，更新该结点的所有孩子结点的父节点信息(使用IxIndexHandle::maintain_child())
     else{
-        for(int i=0;i<new_node->page_hdr->num_key;i++){
-            maintain_child(new_node,i);
+        for(int i=0;i<new_node.get_size();i++){
+            maintain_child(&new_node,i);
         }
     }
     return new_node;
 }
 
+/**
+ * @brief 分裂压缩格式的结点：按占用的字节数把键值对分成大小相近的两半，两边各自按新的上下界重新编码
+ * @note 叶结点的分隔key取左边最后一个key和右边第一个key之间的最短前缀；内部结点的分隔key就是右边第一个孩子的下界。
+ * 分隔key成为左边的上界和右边的下界，右边的公共前缀不会比原结点短，重新编码后不会变大
+ */
+void IxIndexHandle::split_compressed(IxNodeHandle *node, IxNodeHandle *new_node) {
+    int len = file_hdr_->col_tot_len_;
+    int n = node->get_size();
+    std::vector<int> bytes(n);
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        bytes[i] = static_cast<int>(sizeof(IxSlot)) + node->slots()[i].len;
+        total += bytes[i];
+    }
+    // 左边取前k个键值对，使左边的字节数最接近一半，两边至少各有一个
+    int k = 1;
+    for (int left = bytes[0]; k + 1 < n && left + bytes[k] / 2 <= total / 2; k++) {
+        left += bytes[k];
+    }
+    std::vector<char> keys;
+    std::vector<Rid> rids;
+    node->read_entries(0, n, &keys, &rids);
+    char low[IX_MAX_COL_LEN], high[IX_MAX_COL_LEN], sep[IX_MAX_COL_LEN];
+    bool has_low = node->read_low(low);
+    bool has_high = node->read_high(high);
+    const char *first = keys.data() + static_cast<size_t>(k) * len;
+    if (node->is_leaf_page()) {
+        ix_separator(first - len, first, sep, len);
+    } else {
+        memcpy(sep, first, len);
+    }
+    new_node->rebuild(sep, has_high ? high : nullptr, first, rids.data() + k, n - k);
+    node->rebuild(has_low ? low : nullptr, sep, keys.data(), rids.data(), k);
+    assert(!node->is_overfull() && !new_node->is_overfull());
+}
+
 /**
  * @brief Insert key & value pair into internal page after split
  * 拆分(Split)后，向上找到old_node的父结点
@@ -310,167 +772,364 @@ IxNodeHandle *IxIndexHandle::split(IxNodeHandle *node) {
  * 如果插入后>=maxsize，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
  * 直到找到的old_node为根结点时，结束递归（此时将会新建一个根R，关键字为key，old_node和new_node为其孩子）
  *
- * @param (old_node, new_node) 原结点为old_node，old_node被分裂之后产生了新的右兄弟结点new_node
- * @param key 要插入parent的key
+ * @param path old_node为path->nodes[level]，它的父结点是path->nodes[level - 1]
+ * @note 插入parent的key是new_node的分隔key，见IxNodeHandle::read_separator
  * @note 一个结点插入了键值对之后需要分裂，分裂后左半部分的键值对保留在原结点，在参数中称为old_node，
  * 右半部分的键值对分裂为新的右兄弟节点，在参数中称为new_node（参考Split函数来理解old_node和new_node）
- * @note 本函数执行完毕后，new node和old node都需要在函数外面进行unpin
+ * @note 分裂的结点不安全，下降时保留了它的父结点；level为0时old_node是根结点，此时持有root_latch_排他锁
  */
-void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node,
+void IxIndexHandle::insert_into_parent(IxWritePath *path, size_t level, IxNodeHandle *new_node,
                                      Transaction *transaction) {
+    IxNodeHandle *old_node = &path->nodes[level];
+    char key[IX_MAX_COL_LEN];
+    new_node->read_separator(key);
     // Todo:
     // 1. 分裂前的结点（原结点, old_node）是否为根结点，如果为根结点需要分配新的root
-    if(old_node->is_root_page()){
-        IxNodeHandle* new_root = create_node();    
-        new_root->page_hdr->parent = IX_NO_PAGE;
-        new_root->page_hdr->num_key = 0;
-        new_root->page_hdr->is_leaf = false;
-        new_root->page_hdr->prev_leaf = IX_NO_PAGE;
-        new_root->page_hdr->next_leaf = IX_NO_PAGE;
-
-        new_root->insert_pair(0,old_node->get_key(0),{old_node->get_page_no(),-1});
-        new_root->insert_pair(1,new_node->get_key(0),{new_node->get_page_no(),-1});
-        
-        old_node->page_hdr->parent = new_root->get_page_no();
-        new_node->page_hdr->parent = new_root->get_page_no();
-
-        update_root_page_no(new_root->get_page_no());
-
-        buffer_pool_manager_->unpin_page(new_root->get_page_id(),true);
+    if(level == 0){
+        assert(path->root_lock.owns_lock() && old_node->is_root_page());
+        IxNodeHandle new_root = create_node();
+        new_root.set_parent_page_no(IX_NO_PAGE);
+        new_root.set_size(0);
+        new_root.set_leaf(false);
+        new_root.set_prev_leaf(IX_NO_PAGE);
+        new_root.set_next_leaf(IX_NO_PAGE);
+
+        char old_key[IX_MAX_COL_LEN];
+        old_node->read_separator(old_key);
+        new_root.insert_pair(0,old_key,{old_node->get_page_no(),-1});
+        new_root.insert_pair(1,key,{new_node->get_page_no(),-1});
+
+        old_node->set_parent_page_no(new_root.get_page_no());
+        new_node->set_parent_page_no(new_root.get_page_no());
+
+        update_root_page_no(new_root.get_page_no());
         return;
     }
     // 2. 获取原结点（old_node）的父亲结点
-    IxNodeHandle* parent = fetch_node(old_node->page_hdr->parent);
+    IxNodeHandle &parent = path->nodes[level - 1];
     // 3. 获取key对应的rid，并将(key, rid)插入到父亲结点
-    int index = parent->find_child(old_node);
-    parent->insert_pair(index+1,key,{new_node->get_page_no(),-1});
+    int index = parent.find_child(old_node);
+    parent.insert_pair(index+1,key,{new_node->get_page_no(),-1});
     // 4. 如果父亲结点仍需要继续分裂，则进行递归插入
-    if(parent->get_size() >= parent->get_max_size()){
-        IxNodeHandle* right_bro = split(parent);
-        insert_into_parent(parent,right_bro->get_key(0),right_bro,transaction);
-        // buffer_pool_manager_->unpin_page(parent->get_page_id(),true);
-        buffer_pool_manager_->unpin_page(right_bro->get_page_id(),true);
+    if(parent.is_overfull()){
+        IxNodeHandle right_bro = split(&parent);
+        insert_into_parent(path,level - 1,&right_bro,transaction);
     }
-    buffer_pool_manager_->unpin_page(parent->get_page_id(),true);
-    // 提示：记得unpin page
 }
 
 /**
  * @brief 将指定键值对插入到B+树中
  * @param (key, value) 要插入的键值对
  * @param transaction 事务指针
- * @return page_id_t 插入到的叶结点的page_no
+ * @return page_id_t 是否插入成功，唯一索引中key已存在时不插入
+ * @note 先乐观地下降，内部结点只加读锁，叶子结点加写锁：key已存在（只修改posting list）或叶子结点插入后
+ * 不需要分裂时直接完成；否则释放叶子结点，重新持有写锁下降，只保留会被分裂影响的祖先结点
  */
 page_id_t IxIndexHandle::insert_entry(const char *key, const Rid &value, Transaction *transaction) {
-    // Todo:
-    // 1. 查找key值应该插入到哪个叶子节点
-    std::scoped_lock lock{root_latch_};
-    auto leaf_page = find_leaf_page(key,Operation::INSERT,transaction);
-    IxNodeHandle* leaf_node = leaf_page.first;
+    char key_buf[IX_MAX_COL_LEN];
+    key = to_stored_key(key, key_buf);
+    {
+        auto [leaf_node, is_root] = find_leaf_page(key,Operation::INSERT,transaction);
+        int pos = leaf_node.lower_bound(key);
+        if(pos < leaf_node.get_size() && leaf_node.compare_key(pos,key) == 0){
+            if(file_hdr_->unique_){
+                return false;
+            }
+            append_posting(&leaf_node,pos,value);
+            return true;
+        }
+        if(is_safe(leaf_node,key,Operation::INSERT,is_root)){
+            leaf_node.insert_pair(pos,key,value);
+            return true;
+        }
+    }
+    // 1. 查找key值应该插入到哪个叶子节点，释放叶子结点期间key可能已被其他线程插入，需要重新检查
+    IxWritePath path = find_write_path(key,Operation::INSERT);
+    size_t level = path.nodes.size() - 1;
+    IxNodeHandle &leaf_node = path.nodes[level];
+    int pos = leaf_node.lower_bound(key);
+    if(pos < leaf_node.get_size() && leaf_node.compare_key(pos,key) == 0){
+        if(file_hdr_->unique_){
+            return false;
+        }
+        append_posting(&leaf_node,pos,value);
+        return true;
+    }
     // 2. 在该叶子节点中插入键值对
-    int prev_num_key = leaf_node->get_size();
-    int cur_num_key = leaf_node->insert(key,value);
+    leaf_node.insert_pair(pos,key,value);
     // 3. 如果结点已满，分裂结点，并把新结点的相关信息插入父节点
-    IxNodeHandle* right_bro;
-    bool is_full = (cur_num_key == leaf_node->get_max_size());
-    bool insert_succ = (prev_num_key != cur_num_key);
-    if(insert_succ && is_full){
-        right_bro = split(leaf_node);
-        insert_into_parent(leaf_node,right_bro->get_key(0),right_bro,transaction);
-        if(file_hdr_->last_leaf_ == leaf_node->get_page_no()){
-            file_hdr_->last_leaf_ = right_bro->get_page_no();
-        }
-        buffer_pool_manager_->unpin_page(right_bro->get_page_id(),true);
-    }
-    buffer_pool_manager_->unpin_page(leaf_node->get_page_id(),true);
-    // 提示：记得unpin page；若当前叶子节点是最右叶子节点，则需要更新file_hdr_.last_leaf；记得处理并发的上锁
-    // if(is_full && (leaf_node->lower_bound(key) == leaf_node->page_hdr->num_key)){
-    //     return right_bro->get_page_no();
-    // }
-    // else{
-    //     return leaf_node->get_page_no();
-    // }
-    return insert_succ;
-    // MAYBE
+    if(leaf_node.is_overfull()){
+        IxNodeHandle right_bro = split(&leaf_node);
+        insert_into_parent(&path,level,&right_bro,transaction);
+    }
+    return true;
 }
 
 /**
  * @brief 用于删除B+树中含有指定key的键值对
  * @param key 要删除的key值
+ * @param value 为nullptr时删除key及其所有rid；否则只删除(key, *value)，posting list中还有其他rid时保留key
  * @param transaction 事务指针
+ * @note 与插入相同，先乐观地删除：只从posting list中删除rid，或者要删除的不是叶子结点的第一个key
+ * （不需要更新祖先结点的key）且删除后不需要合并或重分配时直接完成；否则持有写锁重新下降并删除
  */
-bool IxIndexHandle::delete_entry(const char *key, Transaction *transaction) {
-    // Todo:
-    // 1. 获取该键值对所在的叶子结点
-    std::scoped_lock lock{root_latch_};
-    auto leaf_page = find_leaf_page(key,Operation::DELETE,transaction);
-    IxNodeHandle* leaf_node = leaf_page.first;
+bool IxIndexHandle::erase_entry(const char *key, const Rid *value, Transaction *transaction) {
+    char key_buf[IX_MAX_COL_LEN];
+    key = to_stored_key(key, key_buf);
+    {
+        auto [leaf_node, is_root] = find_leaf_page(key,Operation::DELETE,transaction);
+        int pos = leaf_node.lower_bound(key);
+        if(pos == leaf_node.get_size() || leaf_node.compare_key(pos,key)){
+            return false;
+        }
+        Rid entry = *leaf_node.get_rid(pos);
+        if(value != nullptr && entry.page_no == IX_POSTING_LIST){
+            return remove_posting(&leaf_node,pos,*value);
+        }
+        if(value != nullptr && entry != *value){
+            return false;
+        }
+        if(is_safe(leaf_node,key,Operation::DELETE,is_root)){
+            free_postings(entry);
+            leaf_node.erase_pair(pos);
+            return true;
+        }
+    }
+    // 1. 获取该键值对所在的叶子结点，释放叶子结点期间posting list可能已被其他线程修改，需要重新检查
+    IxWritePath path = find_write_path(key,Operation::DELETE);
+    size_t level = path.nodes.size() - 1;
+    IxNodeHandle &leaf_node = path.nodes[level];
+    int pos = leaf_node.lower_bound(key);
+    if(pos == leaf_node.get_size() || leaf_node.compare_key(pos,key)){
+        return false;
+    }
+    Rid entry = *leaf_node.get_rid(pos);
+    if(value != nullptr && entry.page_no == IX_POSTING_LIST){
+        return remove_posting(&leaf_node,pos,*value);
+    }
+    if(value != nullptr && entry != *value){
+        return false;
+    }
     // 2. 在该叶子结点中删除键值对
-    int prev_num_key = leaf_node->get_size();
-    int cur_num_key = leaf_node->remove(key);
-    bool changed = (cur_num_key == (prev_num_key-1));
-    // 3. 如果删除成功需要调用CoalesceOrRedistribute来进行合并或重分配操作，并根据函数返回结果判断是否有结点需要删除
-    if(changed){
-        // bool delete_node = coalesce_or_redistribute(leaf_node);
-        coalesce_or_redistribute(leaf_node);
-        // 在coalesce、redistribute、adjust_root内部 返回前就做好删除
-        // 否则好像找不到要删的节点
+    free_postings(entry);
+    leaf_node.erase_pair(pos);
+    // 3. 删除成功后调用CoalesceOrRedistribute来进行合并或重分配操作，被删除的结点在其内部处理
+    coalesce_or_redistribute(&path,level,transaction);
+    return true;
+}
+
+/**
+ * @brief 批量插入键值对，用于多行DML：按key排序后依次插入，同一个叶结点上的key只下降一次
+ * @param keys 依次存放n个上层格式的key
+ * @param rids 与keys一一对应的rid
+ * @return 插入的项数，唯一索引中已存在的key不插入
+ * @note 持有写锁下降，同时记下叶结点的上界fence，之后小于上界的key直接插入当前叶结点。下降时只按一次插入判断
+ * 结点是否安全，因此叶结点将要分裂而没有持有父结点时重新下降，分裂后也重新下降
+ */
+int IxIndexHandle::insert_entries(const char *keys, const Rid *rids, int n, Transaction *transaction) {
+    std::vector<char> stored;
+    std::vector<int> order = sort_batch(keys, rids, n, &stored);
+    int len = file_hdr_->col_tot_len_;
+    std::vector<char> fence;  // 当前叶结点的上界，为空时没有上界
+    IxWritePath path;
+    int inserted = 0;
+    for (int i : order) {
+        const char *key = stored.data() + static_cast<size_t>(i) * len;
+        if (!path.nodes.empty() && !fence.empty() && ix_compare(key, fence.data(), *file_hdr_) >= 0) {
+            path.release();
+        }
+        for (;;) {
+            if (path.nodes.empty()) {
+                path = find_write_path(key, Operation::INSERT, &fence);
+            }
+            size_t level = path.nodes.size() - 1;
+            IxNodeHandle &leaf = path.nodes[level];
+            int pos = leaf.lower_bound(key);
+            if (pos < leaf.get_size() && leaf.compare_key(pos, key) == 0) {
+                if (!file_hdr_->unique_) {
+                    append_posting(&leaf, pos, rids[i]);
+                    inserted++;
+                }
+                break;
+            }
+            if (!path.can_restructure(level) && !is_safe(leaf, key, Operation::INSERT, path.top_is_root)) {
+                // 先释放当前叶结点的锁，重新下降可能回到同一个页面
+                path.release();
+                continue;
+            }
+            leaf.insert_pair(pos, key, rids[i]);
+            inserted++;
+            if (leaf.is_overfull()) {
+                IxNodeHandle right_bro = split(&leaf);
+                insert_into_parent(&path, level, &right_bro, transaction);
+                path.release();
+            }
+            break;
+        }
+    }
+    return inserted;
+}
+
+/**
+ * @brief 批量删除键值对(key, rid)，用于多行DML：按key排序后依次删除，同一个叶结点上的key只下降一次
+ * @return 删除的项数，不存在的(key, rid)跳过
+ * @note 与insert_entries相同，叶结点将要低于下限或者第一个key将被删除而没有持有父结点时重新下降。
+ * 离开一个叶结点时，如果它需要调整，再统一合并或重分配，之后树结构可能改变，下一个key重新下降
+ */
+int IxIndexHandle::delete_entries(const char *keys, const Rid *rids, int n, Transaction *transaction) {
+    std::vector<char> stored;
+    std::vector<int> order = sort_batch(keys, rids, n, &stored);
+    int len = file_hdr_->col_tot_len_;
+    std::vector<char> fence;
+    IxWritePath path;
+    bool need_rebalance = false;  // 当前叶结点离开时是否需要合并或重分配
+    int deleted = 0;
+    auto leave_leaf = [&]() {
+        if (need_rebalance) {
+            coalesce_or_redistribute(&path, path.nodes.size() - 1, transaction);
+            need_rebalance = false;
+        }
+        path.release();
+    };
+    for (int i : order) {
+        const char *key = stored.data() + static_cast<size_t>(i) * len;
+        if (!path.nodes.empty() && !fence.empty() && ix_compare(key, fence.data(), *file_hdr_) >= 0) {
+            leave_leaf();
+        }
+        for (;;) {
+            if (path.nodes.empty()) {
+                path = find_write_path(key, Operation::DELETE, &fence);
+            }
+            size_t level = path.nodes.size() - 1;
+            IxNodeHandle &leaf = path.nodes[level];
+            int pos = leaf.lower_bound(key);
+            if (pos == leaf.get_size() || leaf.compare_key(pos, key) != 0) {
+                break;
+            }
+            Rid entry = *leaf.get_rid(pos);
+            if (entry.page_no == IX_POSTING_LIST) {
+                deleted += remove_posting(&leaf, pos, rids[i]);
+                break;
+            }
+            if (entry != rids[i]) {
+                break;
+            }
+            if (!path.can_restructure(level) && !is_safe(leaf, key, Operation::DELETE, path.top_is_root)) {
+                leave_leaf();
+                continue;
+            }
+            leaf.erase_pair(pos);
+            deleted++;
+            // 定长格式的父结点中存的是第一个key，它被删除时也要更新父结点
+            if ((pos == 0 && !leaf.is_compressed()) || leaf.is_underfull()) {
+                need_rebalance = true;
+            }
+            break;
+        }
+    }
+    if (!path.nodes.empty()) {
+        leave_leaf();
     }
-    buffer_pool_manager_->unpin_page(leaf_node->get_page_id(),changed);
-    // 4. 如果需要并发，并且需要删除叶子结点，则需要在事务的delete_page_set中添加删除结点的对应页面；记得处理并发的上锁
-    return changed;
-    // TODO: latch
+    return deleted;
 }
 
+/**
+ * @brief 把一批key转换为存储格式写入stored，返回按(key, rid)排序后的下标
+ */
+std::vector<int> IxIndexHandle::sort_batch(const char *keys, const Rid *rids, int n,
+                                           std::vector<char> *stored) const {
+    int len = file_hdr_->col_tot_len_;
+    stored->resize(static_cast<size_t>(n) * len);
+    for (int i = 0; i < n; i++) {
+        size_t offset = static_cast<size_t>(i) * len;
+        const char *key = to_stored_key(keys + offset, stored->data() + offset);
+        if (key != stored->data() + offset) {
+            memcpy(stored->data() + offset, key, len);
+        }
+    }
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        int cmp = ix_compare(stored->data() + static_cast<size_t>(a) * len,
+                             stored->data() + static_cast<size_t>(b) * len, *file_hdr_);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        return rids[a].page_no != rids[b].page_no ? rids[a].page_no < rids[b].page_no
+                                                  : rids[a].slot_no < rids[b].slot_no;
+    });
+    return order;
+}
+
+
 /**
  * @brief 用于处理合并和重分配的逻辑，用于删除键值对后调用
  *
- * @param node 执行完删除操作的结点
+ * @param path 删除时持有写锁的路径，node为path->nodes[level]
  * @param transaction 事务指针
- * @param root_is_latched 传出参数：根节点是否上锁，用于并发操作
  * @return 是否需要删除结点
  * @note User needs to first find the sibling of input page.
  * If sibling's size + input page's size >= 2 * page's minsize, then redistribute.
  * Otherwise, merge(Coalesce).
+ * @note 压缩格式的结点按字节数判断：合并后放得下就合并，否则尝试重分配，重分配后也放不下时保留不满的结点
+ * @note 同一层的结点按从左到右的顺序加锁：兄弟结点在左边时先释放node的锁。此时持有父结点的写锁，
+ * 其他线程只可能在node为叶结点时乐观地插入，重新加锁后要再次判断是否需要合并或重分配
  */
-bool IxIndexHandle::coalesce_or_redistribute(IxNodeHandle *node, Transaction *transaction, bool *root_is_latched) {
+bool IxIndexHandle::coalesce_or_redistribute(IxWritePath *path, size_t level, Transaction *transaction) {
+    IxNodeHandle &node = path->nodes[level];
     // Todo:
     // 1. 判断node结点是否为根节点
     //    1.1 如果是根节点，需要调用AdjustRoot() 函数来进行处理，返回根节点是否需要被删除
     //    1.2 如果不是根节点，并且不需要执行合并或重分配操作，则直接返回false，否则执行2
-    if(node->is_root_page()){
-        return adjust_root(node);
+    //    level为0而node不是根结点时node是安全结点，不需要调整
+    if(level == 0){
+        return path->top_is_root && adjust_root(&node);
+    }
+    //    node的第一个key可能已被删除，合并或重分配之前先更新祖先结点中的key，否则它作为第0个孩子
+    //    合并到左边或重分配后，父结点中过时的key会出现在非0的位置上
+    if(node.get_size()>0){
+        maintain_parent(&node,path,level);
     }
-    if(node->get_size()>=node->get_min_size()){
-        maintain_parent(node);   // MAYBE
+    if(!node.is_underfull()){
         return false;
     }
     // 2. 获取node结点的父亲结点
-    IxNodeHandle* parent = fetch_node(node->get_parent_page_no());
-    // 3. 寻找node结点的兄弟结点（优先选取前驱结点）
-    IxNodeHandle* sibling;
-    int node_index = parent->find_child(node);
-    if(node_index > 0){
-        sibling = fetch_node(parent->value_at(node_index-1));
+    IxNodeHandle &parent = path->nodes[level - 1];
+    // 3. 寻找node结点的兄弟结点（优先选取前驱结点）；压缩格式的父结点可能因为没有合并而只剩一个孩子
+    int node_index = parent.find_child(&node);
+    if(parent.get_size() == 1){
+        return false;
     }
-    else{
-        sibling = fetch_node(parent->value_at(node_index+1));
+    IxNodeHandle sibling = fetch_node(parent.value_at(node_index > 0 ? node_index - 1 : node_index + 1));
+    if(node_index > 0){
+        node.unlatch();
+        sibling.latch_exclusive();
+        node.latch_exclusive();
+        if(!node.is_underfull()){
+            maintain_parent(&node,path,level);
+            return false;
+        }
+    } else {
+        sibling.latch_exclusive();
     }
     // 4. 如果node结点和兄弟结点的键值对数量之和，能够支撑两个B+树结点（即node.size+neighbor.size >=
     // NodeMinSize*2)，则只需要重新分配键值对（调用Redistribute函数）
-    if((node->get_size()+sibling->get_size()) >= 2*(node->get_min_size())){
-        redistribute(sibling,node,parent,node_index);
-        buffer_pool_manager_->unpin_page(parent->get_page_id(),true);   // need maintain parent
-        buffer_pool_manager_->unpin_page(sibling->get_page_id(),true);
+    bool merge = node.is_compressed()
+                     ? (node_index > 0 ? can_coalesce(&sibling, &node) : can_coalesce(&node, &sibling))
+                     : node.get_size() + sibling.get_size() < 2 * node.get_min_size();
+    if(!merge){
+        redistribute(&sibling,&node,path,level,node_index);
         return false;
     }
-    // 5. 如果不满足上述条件，则需要合并两个结点，将右边的结点合并到左边的结点（调用Coalesce函数）
-    else{
-        coalesce(&sibling,&node,&parent,node_index,transaction,root_is_latched);
-        buffer_pool_manager_->unpin_page(parent->get_page_id(),true);
-        buffer_pool_manager_->unpin_page(sibling->get_page_id(),true);
-        return true;
-    }
+    // 5. 如果不满足上述条件，则需要合并两个结点，将右边的结点合并到左边的结点（调用Coalesce函数），
+    // 释放这一层的结点后再处理父结点
+    coalesce(&sibling,&node,&parent,node_index,transaction);
+    sibling.unlatch();
+    path->nodes.resize(level);
+    coalesce_or_redistribute(path,level - 1,transaction);
+    return true;
 }
 
 /**
@@ -478,26 +1137,21 @@ bool IxIndexHandle::coalesce_or_redistribute(IxNodeHandle *node, Transaction *tr
  * @param old_root_node 原根节点
  * @return bool 根结点是否需要被删除
  * @note size of root page can be less than min size and this method is only called within coalesce_or_redistribute()
+ * @note 根结点只剩一个孩子时下降过程中它不安全，此时持有root_latch_排他锁，可以替换根结点
  */
 bool IxIndexHandle::adjust_root(IxNodeHandle *old_root_node) {
     // Todo:
     // 1. 如果old_root_node是内部结点，并且大小为1，则直接把它的孩子更新成新的根结点
     if(!old_root_node->is_leaf_page() && old_root_node->get_size()==1){
-        IxNodeHandle* child = fetch_node(old_root_node->value_at(0));
-        child->set_parent_page_no(IX_NO_PAGE);
-        update_root_page_no(child->get_page_no());
-        buffer_pool_manager_->unpin_page(child->get_page_id(),true);
-        file_hdr_->num_pages_-=1;
+        IxNodeHandle child = fetch_node(old_root_node->value_at(0));
+        child.set_parent_page_no(IX_NO_PAGE);
+        update_root_page_no(child.get_page_no());
+        release_node_handle(*old_root_node);
         return true;
     }
-    // 2. 如果old_root_node是叶结点，且大小为0，则直接更新root page
-    else if(old_root_node->is_leaf_page() && !old_root_node->get_size()){
-        // TODO: didn't understand
-        file_hdr_->root_page_ = IX_NO_PAGE;
-        file_hdr_->num_pages_-=1;
-        return true;
-    }
-    // 3. 除了上述两种情况，不需要进行操作
+    // 2. 如果old_root_node是叶结点，且大小为0，保留它作为空树的根结点，与create_index创建的初始状态一致，
+    // 之后的查找和插入仍然从它开始
+    // 3. 除了上述情况，不需要进行操作
     return false;
 }
 
@@ -507,26 +1161,31 @@ bool IxIndexHandle::adjust_root(IxNodeHandle *old_root_node) {
  * & value pair into end of input "node", otherwise move sibling page's last key & value pair into head of input "node".
  *
  * @param neighbor_node sibling page of input "node"
- * @param node input from method coalesceOrRedistribute()
- * @param parent the parent of "node" and "neighbor_node"
+ * @param node input from method coalesceOrRedistribute()，即path->nodes[level]
+ * @param path the parent of "node" and "neighbor_node" is path->nodes[level - 1]
  * @param index node在parent中的rid_idx
  * @note node是之前刚被删除过一个key的结点
  * index=0，则neighbor是node后继结点，表示：node(left)      neighbor(right)
  * index>0，则neighbor是node前驱结点，表示：neighbor(left)  node(right)
  * 注意更新parent结点的相关kv对
  */
-void IxIndexHandle::redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index) {
+void IxIndexHandle::redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxWritePath *path, size_t level,
+                                 int index) {
     // Todo:
     // 1. 通过index判断neighbor_node是否为node的前驱结点
     // 2. 从neighbor_node中移动一个键值对到node结点中
     // 3. 更新父节点中的相关信息，并且修改移动键值对对应孩字结点的父结点信息（maintain_child函数）
     // 注意：neighbor_node的位置不同，需要移动的键值对不同，需要分类讨论
+    if(node->is_compressed()){
+        redistribute_compressed(neighbor_node,node,&path->nodes[level - 1],index);
+        return;
+    }
     if(index){
         // neighbor->node
         int neighbor_pos = neighbor_node->get_size()-1;
         node->insert_pair(0,neighbor_node->get_key(neighbor_pos),*(neighbor_node->get_rid(neighbor_pos)));
         neighbor_node->erase_pair(neighbor_pos);
-        maintain_parent(node);
+        maintain_parent(node,path,level);
         maintain_child(node,0);
     }
     else{
@@ -534,52 +1193,116 @@ void IxIndexHandle::redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node
         int node_pos = node->get_size();
         node->insert_pair(node_pos,neighbor_node->get_key(0),*(neighbor_node->get_rid(0)));
         neighbor_node->erase_pair(0);
-        maintain_parent(neighbor_node);
+        maintain_parent(neighbor_node,path,level);
         maintain_child(node,node_pos);
     }
 
 }
 
+/**
+ * @brief 重分配压缩格式的结点：移动一个键值对后两边按新的分隔key重新编码，并替换父结点中右边结点的key
+ * @note 叶结点的分隔key重新截断，内部结点的分隔key是右边第一个孩子的下界，两边的孩子的上下界都不变；
+ * 重新编码后有一边超出容量，或者父结点放不下新的分隔key时不做重分配
+ */
+void IxIndexHandle::redistribute_compressed(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent,
+                                            int index) {
+    IxNodeHandle *left = index ? neighbor_node : node;
+    IxNodeHandle *right = index ? node : neighbor_node;
+    int len = file_hdr_->col_tot_len_;
+    int left_size = left->get_size();
+    int n = left_size + right->get_size();
+    // 移动后左边的键值对数量，提供键值对的一边至少保留一个
+    int mid = index ? left_size - 1 : left_size + 1;
+    if (mid < 1 || mid >= n) {
+        return;
+    }
+    std::vector<char> keys;
+    std::vector<Rid> rids;
+    left->read_entries(0, left_size, &keys, &rids);
+    right->read_entries(0, right->get_size(), &keys, &rids);
+    char low[IX_MAX_COL_LEN], high[IX_MAX_COL_LEN], sep[IX_MAX_COL_LEN];
+    const char *left_low = left->read_low(low) ? low : nullptr;
+    const char *right_high = right->read_high(high) ? high : nullptr;
+    const char *first = keys.data() + static_cast<size_t>(mid) * len;
+    if (node->is_leaf_page()) {
+        ix_separator(first - len, first, sep, len);
+    } else {
+        memcpy(sep, first, len);
+    }
+    int right_index = index ? index : 1;
+    int limit = IxNodeHandle::max_bytes(file_hdr_);
+    if (IxNodeHandle::encoded_size(file_hdr_, left_low, sep, keys.data(), mid) > limit ||
+        IxNodeHandle::encoded_size(file_hdr_, sep, right_high, first, n - mid) > limit ||
+        !parent->can_set_key(right_index, sep)) {
+        return;
+    }
+    left->rebuild(left_low, sep, keys.data(), rids.data(), mid);
+    right->rebuild(sep, right_high, first, rids.data() + mid, n - mid);
+    parent->set_key(right_index, sep);
+    maintain_child(node, index ? 0 : node->get_size() - 1);
+}
+
+/**
+ * @brief 合并后的压缩格式结点是否放得下：合并后的上下界为左边的下界和右边的上界，公共前缀可能变短
+ */
+bool IxIndexHandle::can_coalesce(IxNodeHandle *left, IxNodeHandle *right) const {
+    std::vector<char> keys;
+    std::vector<Rid> rids;
+    left->read_entries(0, left->get_size(), &keys, &rids);
+    right->read_entries(0, right->get_size(), &keys, &rids);
+    char low[IX_MAX_COL_LEN], high[IX_MAX_COL_LEN];
+    const char *left_low = left->read_low(low) ? low : nullptr;
+    const char *right_high = right->read_high(high) ? high : nullptr;
+    return IxNodeHandle::encoded_size(file_hdr_, left_low, right_high, keys.data(), rids.size()) <=
+           IxNodeHandle::max_bytes(file_hdr_);
+}
+
 /**
  * @brief 合并(Coalesce)函数是将node和其直接前驱进行合并，也就是和它左边的neighbor_node进行合并；
  * 假设node一定在右边。如果上层传入的index=0，说明node在左边，那么交换node和neighbor_node，保证node在右边；合并到左结点，实际上就是删除了右结点；
  * Move all the key & value pairs from one page to its sibling page, and notify buffer pool manager to delete this page.
- * Parent page must be adjusted to take info of deletion into account. Remember to deal with coalesce or redistribute
- * recursively if necessary.
+ * Parent page must be adjusted to take info of deletion into account.
  *
  * @param neighbor_node sibling page of input "node" (neighbor_node是node的前结点)
  * @param node input from method coalesceOrRedistribute() (node结点是需要被删除的)
  * @param parent parent page of input "node"
  * @param index node在parent中的rid_idx
- * @return true means parent node should be deleted, false means no deletion happend
  * @note Assume that *neighbor_node is the left sibling of *node (neighbor -> node)
+ * @note 调用者持有三个结点的写锁；parent是否需要继续合并或重分配由调用者在释放这一层的结点后处理
  */
-bool IxIndexHandle::coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
-                             Transaction *transaction, bool *root_is_latched) {
+void IxIndexHandle::coalesce(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                             Transaction *transaction) {
     // Todo:
     // 1. 用index判断neighbor_node是否为node的前驱结点，若不是则交换两个结点，让neighbor_node作为左结点，node作为右结点
     if(!index){
-        IxNodeHandle** tmp = neighbor_node;
-        neighbor_node = node;
-        node = tmp;
+        std::swap(neighbor_node,node);
         index++;
     }
     // 2. 把node结点的键值对移动到neighbor_node中，并更新node结点孩子结点的父节点信息（调用maintain_child函数）
-    int neigh_pos = (*neighbor_node)->get_size();
-    int insert_num = (*node)->get_size();
-    (*neighbor_node)->insert_pairs(neigh_pos,(*node)->get_key(0),(*node)->get_rid(0),insert_num);
-    for(int i=0;i<insert_num;i++){
-        maintain_child(*neighbor_node,neigh_pos+i);
+    int neigh_pos = neighbor_node->get_size();
+    int insert_num = node->get_size();
+    if(node->is_compressed()){
+        std::vector<char> keys;
+        std::vector<Rid> rids;
+        neighbor_node->read_entries(0,neigh_pos,&keys,&rids);
+        node->read_entries(0,insert_num,&keys,&rids);
+        char low[IX_MAX_COL_LEN], high[IX_MAX_COL_LEN];
+        const char *merged_low = neighbor_node->read_low(low) ? low : nullptr;
+        const char *merged_high = node->read_high(high) ? high : nullptr;
+        neighbor_node->rebuild(merged_low,merged_high,keys.data(),rids.data(),rids.size());
+    } else {
+        neighbor_node->insert_pairs(neigh_pos,node->get_key(0),node->get_rid(0),insert_num);
     }
-    if((*node)->is_leaf_page() && file_hdr_->last_leaf_ == (*node)->get_page_no() ){
-        file_hdr_->last_leaf_ = (*neighbor_node)->get_page_no();
+    for(int i=0;i<insert_num;i++){
+        maintain_child(neighbor_node,neigh_pos+i);
     }
-    // 3. 释放和删除node结点，并删除parent中node结点的信息，返回parent是否需要被删除
-    erase_leaf(*node);
-    (*parent)->erase_pair(index);
-    release_node_handle(**node);
+    // 3. 释放和删除node结点，并删除parent中node结点的信息
     // 提示：如果是叶子结点且为最右叶子结点，需要更新file_hdr_.last_leaf
-    return coalesce_or_redistribute(*parent,transaction);
+    if(node->is_leaf_page()){
+        erase_leaf(node,neighbor_node);
+    }
+    parent->erase_pair(index);
+    release_node_handle(*node);
 }
 
 /**
@@ -592,13 +1315,12 @@ bool IxIndexHandle::coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
  * @note iid和rid存的不是一个东西，rid是上层传过来的记录位置，iid是索引内部生成的索引槽位置
  */
 Rid IxIndexHandle::get_rid(const Iid &iid) const {
-    // 这个函数有参考
-    IxNodeHandle *node = fetch_node(iid.page_no);
-    if (iid.slot_no >= node->get_size()) {
+    IxNodeHandle node = fetch_node(iid.page_no);
+    node.latch_shared();
+    if (iid.slot_no >= node.get_size()) {
         throw IndexEntryNotFoundError();
     }
-    buffer_pool_manager_->unpin_page(node->get_page_id(), false);
-    return *node->get_rid(iid.slot_no);
+    return *node.get_rid(iid.slot_no);
 }
 
 /**
@@ -610,12 +1332,11 @@ Rid IxIndexHandle::get_rid(const Iid &iid) const {
  * 可用*(int *)key转换回去
  */
 Iid IxIndexHandle::lower_bound(const char *key) {
+    char key_buf[IX_MAX_COL_LEN];
+    key = to_stored_key(key, key_buf);
     auto node_pair = find_leaf_page(key,Operation::FIND,nullptr);
-    auto node = node_pair.first;
-    int index = node->lower_bound(key);
-    int page_no = node->get_page_no();
-    buffer_pool_manager_->unpin_page(node->get_page_id(),false);
-    return Iid{page_no, index};
+    IxNodeHandle &node = node_pair.first;
+    return leaf_position(node, node.lower_bound(key));
 }
 
 /**
@@ -623,23 +1344,26 @@ Iid IxIndexHandle::lower_bound(const char *key) {
  *
  * @param key
  * @return Iid
+ * @note 叶结点中的第0个key不是分隔键，所以从0开始查找，而不是像内部结点一样从1开始
  */
 Iid IxIndexHandle::upper_bound(const char *key) {
-    //TODO: didn't understand
+    char key_buf[IX_MAX_COL_LEN];
+    key = to_stored_key(key, key_buf);
     auto node_pair = find_leaf_page(key,Operation::FIND,nullptr);
-    auto node = node_pair.first;
-    int index = node->upper_bound(key);
-    Iid iid;
-    if(index >= node->get_size()){
-        // 分类讨论，实际上应该是取到==的时候，应该返回最末尾的那一个
-        iid = leaf_end();
-    }
-    else{
-        int page_no = node->get_page_no();
-        iid = {.page_no = page_no,.slot_no = index};
+    IxNodeHandle &node = node_pair.first;
+    return leaf_position(node, node.search<true>(key, 0));
+}
+
+/**
+ * @brief 把叶结点node中的位置index转换为Iid，调用者已持有node的读锁
+ * index等于结点大小时指向下一个叶结点的第一个键值对，node是最后一个叶结点时即为leaf_end()，
+ * 这样lower_bound/upper_bound的结果都能直接作为IxScan的起止位置
+ */
+Iid IxIndexHandle::leaf_position(IxNodeHandle &node, int index) const {
+    if (index < node.get_size() || node.get_next_leaf() == IX_LEAF_HEADER_PAGE) {
+        return Iid{.page_no = node.get_page_no(), .slot_no = index};
     }
-    buffer_pool_manager_->unpin_page(node->get_page_id(),false);
-    return iid;
+    return Iid{.page_no = node.get_next_leaf(), .slot_no = 0};
 }
 
 /**
@@ -647,12 +1371,17 @@ Iid IxIndexHandle::upper_bound(const char *key) {
  * 用处在于可以作为IxScan的最后一个
  *
  * @return Iid
+ * @note last_leaf_只在持有原来最后一个叶结点的写锁时改变，对读到的叶结点加读锁后last_leaf_不变，它就仍是最后一个叶结点
  */
 Iid IxIndexHandle::leaf_end() const {
-    IxNodeHandle *node = fetch_node(file_hdr_->last_leaf_);
-    Iid iid = {.page_no = file_hdr_->last_leaf_, .slot_no = node->get_size()};
-    buffer_pool_manager_->unpin_page(node->get_page_id(), false);
-    return iid;
+    for (;;) {
+        page_id_t last = last_leaf();
+        IxNodeHandle node = fetch_node(last);
+        node.latch_shared();
+        if (last_leaf() == last) {
+            return Iid{.page_no = last, .slot_no = node.get_size()};
+        }
+    }
 }
 
 /**
@@ -660,6 +1389,7 @@ Iid IxIndexHandle::leaf_end() const {
  * 用处在于可以作为IxScan的第一个
  *
  * @return Iid
+ * @note 分裂和合并都保留左边的结点，第一个叶结点不会改变
  */
 Iid IxIndexHandle::leaf_begin() const {
     Iid iid = {.page_no = file_hdr_->first_leaf_, .slot_no = 0};
@@ -670,95 +1400,239 @@ Iid IxIndexHandle::leaf_begin() const {
  * @brief 获取一个指定结点
  *
  * @param page_no
- * @return IxNodeHandle*
- * @note pin the page, remember to unpin it outside!
+ * @return IxNodeHandle 结点句柄，析构时取消固定；结点以读写方式获取，只有被修改过的结点才成为脏页
  */
-IxNodeHandle *IxIndexHandle::fetch_node(int page_no) const {
-    Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
-    IxNodeHandle *node = new IxNodeHandle(file_hdr_, page);
-    return node;
+IxNodeHandle IxIndexHandle::fetch_node(int page_no) const {
+    WritePageGuard guard = buffer_pool_manager_->fetch_page_write(PageId{fd_, page_no});
+    if (!guard) {
+        throw InternalError("IxIndexHandle::fetch_node: no free frame in buffer pool");
+    }
+    return IxNodeHandle(file_hdr_, std::move(guard));
 }
 
 /**
  * @brief 创建一个新结点
  *
- * @return IxNodeHandle*
- * @note pin the page, remember to unpin it outside!
+ * @return IxNodeHandle 新结点的句柄，析构时取消固定
  * 注意：对于Index的处理是，删除某个页面后，认为该被删除的页面是free_page
  * 而first_free_page实际上就是最新被删除的页面，初始为IX_NO_PAGE
  * 在最开始插入时，一直是create node，那么first_page_no一直没变，一直是IX_NO_PAGE
  * 与Record的处理不同，Record将未插入满的记录页认为是free_page
  */
-IxNodeHandle *IxIndexHandle::create_node() {
-    IxNodeHandle *node;
-    file_hdr_->num_pages_++;
-
+IxNodeHandle IxIndexHandle::create_node() {
     PageId new_page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
     // 从3开始分配page_no，第一次分配之后，new_page_id.page_no=3，file_hdr_.num_pages=4
-    Page *page = buffer_pool_manager_->new_page(&new_page_id);
-    node = new IxNodeHandle(file_hdr_, page);
-    return node;
+    WritePageGuard guard = buffer_pool_manager_->new_page_guarded(&new_page_id);
+    if (!guard) {
+        throw InternalError("IxIndexHandle::create_node: no free frame in buffer pool");
+    }
+    std::lock_guard lock{file_hdr_latch_};
+    file_hdr_->num_pages_++;
+    return IxNodeHandle(file_hdr_, std::move(guard));
 }
 
 /**
- * @brief 从node开始更新其父节点的第一个key，一直向上更新直到根节点
+ * @brief node的第一个key改变后更新父节点中对应的key，父结点的第一个key也改变时继续向上更新
  *
- * @param node
+ * @param node path->nodes[level]，或者它的兄弟结点
+ * @note 只需要更新path中的祖先结点：path中最上面的结点不是根结点时它是安全结点，第一个key不会改变
+ * @note 压缩格式的父结点中存的是孩子的下界，不随孩子的第一个key改变，不需要更新
  */
-void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
+void IxIndexHandle::maintain_parent(IxNodeHandle *node, IxWritePath *path, size_t level) {
+    if (node->is_compressed()) {
+        return;
+    }
     IxNodeHandle *curr = node;
-    while (curr->get_parent_page_no() != IX_NO_PAGE) {
-        // Load its parent
-        IxNodeHandle *parent = fetch_node(curr->get_parent_page_no());
-        int rank = parent->find_child(curr);
-        char *parent_key = parent->get_key(rank);
+    for (size_t i = level; i > 0; i--) {
+        IxNodeHandle &parent = path->nodes[i - 1];
+        int rank = parent.find_child(curr);
+        char *parent_key = parent.get_key(rank);
         char *child_first_key = curr->get_key(0);
         if (memcmp(parent_key, child_first_key, file_hdr_->col_tot_len_) == 0) {
-            assert(buffer_pool_manager_->unpin_page(parent->get_page_id(), true));
             break;
         }
-        memcpy(parent_key, child_first_key, file_hdr_->col_tot_len_);  // 修改了parent node
-        curr = parent;
-
-        assert(buffer_pool_manager_->unpin_page(parent->get_page_id(), true));
+        parent.set_key(rank, child_first_key);  // 修改了parent node
+        curr = &parent;
     }
 }
 
 /**
- * @brief 要删除leaf之前调用此函数，更新leaf前驱结点的next指针和后继结点的prev指针
+ * @brief 要删除leaf之前调用此函数，更新leaf前驱结点的next指针和后继结点的prev指针；leaf是最后一个叶结点时更新last_leaf_
  *
  * @param leaf 要删除的leaf
+ * @param prev leaf的前驱结点，即合并时的左结点，调用者已持有它的写锁
  */
-void IxIndexHandle::erase_leaf(IxNodeHandle *leaf) {
-    assert(leaf->is_leaf_page());
+void IxIndexHandle::erase_leaf(IxNodeHandle *leaf, IxNodeHandle *prev) {
+    assert(leaf->is_leaf_page() && prev->get_page_no() == leaf->get_prev_leaf());
 
-    IxNodeHandle *prev = fetch_node(leaf->get_prev_leaf());
     prev->set_next_leaf(leaf->get_next_leaf());
-    buffer_pool_manager_->unpin_page(prev->get_page_id(), true);
 
-    IxNodeHandle *next = fetch_node(leaf->get_next_leaf());
-    next->set_prev_leaf(leaf->get_prev_leaf());  // 注意此处是SetPrevLeaf()
-    buffer_pool_manager_->unpin_page(next->get_page_id(), true);
+    IxNodeHandle next = fetch_node(leaf->get_next_leaf());
+    next.latch_exclusive();
+    next.set_prev_leaf(leaf->get_prev_leaf());  // 注意此处是SetPrevLeaf()
+    if (next.get_page_no() == IX_LEAF_HEADER_PAGE) {
+        std::lock_guard lock{file_hdr_latch_};
+        file_hdr_->last_leaf_ = prev->get_page_no();
+    }
 }
 
 /**
- * @brief 删除node时，更新file_hdr_.num_pages
+ * @brief 删除node时调用
  *
  * @param node
+ * @note 删除的结点的页号不再重用，file_hdr_.num_pages不减少，打开文件时从num_pages开始分配页号
  */
-void IxIndexHandle::release_node_handle(IxNodeHandle &node) {
-    file_hdr_->num_pages_--;
-}
+void IxIndexHandle::release_node_handle(IxNodeHandle &node) {}
 
 /**
  * @brief 将node的第child_idx个孩子结点的父节点置为node
+ * @note 不对孩子结点加锁：父结点编号只由持有父结点写锁的线程修改，其他线程在下降时不读取它
  */
 void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx) {
     if (!node->is_leaf_page()) {
         //  Current node is inner node, load its child and set its parent to current node
         int child_page_no = node->value_at(child_idx);
-        IxNodeHandle *child = fetch_node(child_page_no);
-        child->set_parent_page_no(node->get_page_no());
-        buffer_pool_manager_->unpin_page(child->get_page_id(), true);
+        IxNodeHandle child = fetch_node(child_page_no);
+        child.set_parent_page_no(node->get_page_no());
+    }
+}
+
+
+/**
+ * @brief 把叶结点中的rid展开为key对应的所有rid追加到result中：普通rid直接加入，posting list依次读出每一页
+ */
+void IxIndexHandle::read_postings(const Rid &entry, std::vector<Rid> *result) const {
+    if (entry.page_no != IX_POSTING_LIST) {
+        result->push_back(entry);
+        return;
+    }
+    for (page_id_t page_no = entry.slot_no; page_no != IX_NO_PAGE;) {
+        ReadPageGuard guard = buffer_pool_manager_->fetch_page_read(PageId{fd_, page_no});
+        if (!guard) {
+            throw InternalError("IxIndexHandle::read_postings: no free frame in buffer pool");
+        }
+        auto hdr = reinterpret_cast<const IxPostingHdr *>(guard.get_data());
+        auto rids = reinterpret_cast<const Rid *>(guard.get_data() + sizeof(IxPostingHdr));
+        result->insert(result->end(), rids, rids + hdr->num_rids);
+        page_no = hdr->next_page;
     }
 }
+
+/**
+ * @brief 把value加入leaf中第pos个key的rid：key原来只有一个rid时改为posting list，
+ * 第一页已满时在链表头部加入新页面，因此每次插入只访问一个posting list页面
+ */
+void IxIndexHandle::append_posting(IxNodeHandle *leaf, int pos, const Rid &value) {
+    Rid entry = *leaf->get_rid(pos);
+    if (entry.page_no == IX_POSTING_LIST) {
+        WritePageGuard head = fetch_posting_page(entry.slot_no);
+        auto hdr = reinterpret_cast<IxPostingHdr *>(head.get_page()->get_data());
+        if (hdr->num_rids < IX_POSTING_CAPACITY) {
+            reinterpret_cast<Rid *>(head.get_data() + sizeof(IxPostingHdr))[hdr->num_rids++] = value;
+            return;
+        }
+    }
+    WritePageGuard page = new_posting_page();
+    auto hdr = reinterpret_cast<IxPostingHdr *>(page.get_data());
+    auto rids = reinterpret_cast<Rid *>(page.get_data() + sizeof(IxPostingHdr));
+    if (entry.page_no == IX_POSTING_LIST) {
+        hdr->next_page = entry.slot_no;
+    } else {
+        rids[hdr->num_rids++] = entry;
+    }
+    rids[hdr->num_rids++] = value;
+    leaf->set_rid(pos, Rid{.page_no = IX_POSTING_LIST, .slot_no = page.get_page_id().page_no});
+}
+
+/**
+ * @brief 从leaf中第pos个key的posting list中删除value，用所在页面的最后一个rid填补空位；
+ * 页面为空时从链表中摘下并回收，只剩一个rid时改回直接存放在叶结点中
+ * @return value是否在posting list中
+ */
+bool IxIndexHandle::remove_posting(IxNodeHandle *leaf, int pos, const Rid &value) {
+    WritePageGuard prev;  // 链表中的前一页
+    for (page_id_t page_no = leaf->get_rid(pos)->slot_no; page_no != IX_NO_PAGE;) {
+        WritePageGuard guard = fetch_posting_page(page_no);
+        auto hdr = reinterpret_cast<IxPostingHdr *>(guard.get_page()->get_data());
+        auto rids = reinterpret_cast<Rid *>(guard.get_page()->get_data() + sizeof(IxPostingHdr));
+        Rid *found = std::find(rids, rids + hdr->num_rids, value);
+        page_no = hdr->next_page;
+        if (found == rids + hdr->num_rids) {
+            prev = std::move(guard);
+            continue;
+        }
+        guard.mark_dirty();
+        *found = rids[--hdr->num_rids];
+        if (hdr->num_rids == 0) {
+            if (prev) {
+                reinterpret_cast<IxPostingHdr *>(prev.get_data())->next_page = page_no;
+            } else {
+                leaf->set_rid(pos, Rid{.page_no = IX_POSTING_LIST, .slot_no = page_no});
+            }
+            free_posting_page(&guard);
+        }
+        // posting list至少有两个rid，删除后第一页不为空
+        guard = fetch_posting_page(leaf->get_rid(pos)->slot_no);
+        hdr = reinterpret_cast<IxPostingHdr *>(guard.get_page()->get_data());
+        if (hdr->next_page == IX_NO_PAGE && hdr->num_rids == 1) {
+            leaf->set_rid(pos, *reinterpret_cast<Rid *>(guard.get_page()->get_data() + sizeof(IxPostingHdr)));
+            free_posting_page(&guard);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 删除整个key时回收它的posting list的所有页面，entry为普通rid时不做任何事
+ */
+void IxIndexHandle::free_postings(const Rid &entry) {
+    if (entry.page_no != IX_POSTING_LIST) {
+        return;
+    }
+    for (page_id_t page_no = entry.slot_no; page_no != IX_NO_PAGE;) {
+        WritePageGuard guard = fetch_posting_page(page_no);
+        page_no = reinterpret_cast<IxPostingHdr *>(guard.get_page()->get_data())->next_page;
+        free_posting_page(&guard);
+    }
+}
+
+WritePageGuard IxIndexHandle::fetch_posting_page(page_id_t page_no) const {
+    WritePageGuard guard = buffer_pool_manager_->fetch_page_write(PageId{fd_, page_no});
+    if (!guard) {
+        throw InternalError("IxIndexHandle::fetch_posting_page: no free frame in buffer pool");
+    }
+    return guard;
+}
+
+/**
+ * @brief 分配一个空的posting list页面，优先重用file_hdr_空闲页链表中的页面
+ */
+WritePageGuard IxIndexHandle::new_posting_page() {
+    std::lock_guard lock{file_hdr_latch_};
+    WritePageGuard guard;
+    if (file_hdr_->first_free_page_no_ != IX_NO_PAGE) {
+        guard = fetch_posting_page(file_hdr_->first_free_page_no_);
+        file_hdr_->first_free_page_no_ = reinterpret_cast<IxPostingHdr *>(guard.get_page()->get_data())->next_page;
+    } else {
+        PageId page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
+        guard = buffer_pool_manager_->new_page_guarded(&page_id);
+        if (!guard) {
+            throw InternalError("IxIndexHandle::new_posting_page: no free frame in buffer pool");
+        }
+        file_hdr_->num_pages_++;
+    }
+    *reinterpret_cast<IxPostingHdr *>(guard.get_data()) = {.next_page = IX_NO_PAGE, .num_rids = 0};
+    return guard;
+}
+
+/**
+ * @brief 把已从posting list中摘下的页面放入file_hdr_的空闲页链表，并取消固定
+ */
+void IxIndexHandle::free_posting_page(WritePageGuard *guard) {
+    std::lock_guard lock{file_hdr_latch_};
+    *reinterpret_cast<IxPostingHdr *>(guard->get_data()) = {.next_page = file_hdr_->first_free_page_no_,
+                                                            .num_rids = 0};
+    file_hdr_->first_free_page_no_ = guard->get_page_id().page_no;
+    guard->release();
+}
@@ -10,12 +10,15 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <mutex>
+#include <shared_mutex>
+
 #include "ix_defs.h"
 #include "transaction/transaction.h"
 
 enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、插入、删除
 
-static const bool binary_search = false;
+static const bool binary_search = true;   // 结点内用二分查找定位key，为false时顺序查找
 
 inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
     switch (type) {
@@ -46,35 +49,229 @@ inline int ix_compare(const char* a, const char* b, const std::vector<ColType>&
     return 0;
 }
 
-/* 管理B+树中的每个节点 */
+/**
+ * @brief 把上层传入的key规范化为可以直接用memcmp比较的字节串，长度不变：
+ * INT翻转符号位，FLOAT为正时翻转符号位、为负时按位取反，二者都按大端序存放；STRING本身按memcmp比较，原样复制
+ */
+inline void ix_normalize_key(const char *src, char *dest, const std::vector<ColType> &col_types,
+                             const std::vector<int> &col_lens) {
+    int offset = 0;
+    for (size_t i = 0; i < col_types.size(); ++i) {
+        if (col_types[i] == TYPE_STRING) {
+            memcpy(dest + offset, src + offset, col_lens[i]);
+        } else {
+            uint32_t bits;
+            memcpy(&bits, src + offset, sizeof(bits));
+            if (col_types[i] == TYPE_INT) {
+                bits ^= 0x80000000u;
+            } else {
+                // -0.0与0.0相等
+                if (bits == 0x80000000u) {
+                    bits = 0;
+                }
+                bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+            }
+            for (int b = 0; b < 4; ++b) {
+                dest[offset + b] = static_cast<char>(bits >> (24 - 8 * b));
+            }
+        }
+        offset += col_lens[i];
+    }
+}
+
+/**
+ * @brief ix_normalize_key的逆变换，把索引中存储的key还原为上层的格式
+ */
+inline void ix_denormalize_key(const char *src, char *dest, const std::vector<ColType> &col_types,
+                               const std::vector<int> &col_lens) {
+    int offset = 0;
+    for (size_t i = 0; i < col_types.size(); ++i) {
+        if (col_types[i] == TYPE_STRING) {
+            memcpy(dest + offset, src + offset, col_lens[i]);
+        } else {
+            uint32_t bits = 0;
+            for (int b = 0; b < 4; ++b) {
+                bits = (bits << 8) | static_cast<unsigned char>(src[offset + b]);
+            }
+            if (col_types[i] == TYPE_INT) {
+                bits ^= 0x80000000u;
+            } else {
+                bits = (bits & 0x80000000u) ? (bits & ~0x80000000u) : ~bits;
+            }
+            memcpy(dest + offset, &bits, sizeof(bits));
+        }
+        offset += col_lens[i];
+    }
+}
+
+// 比较两个索引中存储格式的key，规范化的key只需一次memcmp
+inline int ix_compare(const char *a, const char *b, const IxFileHdr &file_hdr) {
+    if (file_hdr.is_normalized()) {
+        return memcmp(a, b, file_hdr.col_tot_len_);
+    }
+    return ix_compare(a, b, file_hdr.col_types_, file_hdr.col_lens_);
+}
+
+// 规范化的key去掉末尾0字节后的长度，压缩格式的结点只存这一部分
+inline int ix_significant_len(const char *key, int len) {
+    while (len > 0 && key[len - 1] == 0) {
+        len--;
+    }
+    return len;
+}
+
+// 两个key的公共前缀长度
+inline int ix_common_prefix(const char *a, const char *b, int len) {
+    int prefix = 0;
+    while (prefix < len && a[prefix] == b[prefix]) {
+        prefix++;
+    }
+    return prefix;
+}
+
+/**
+ * @brief 求叶结点left和right之间的分隔key，满足left < dest <= right：取right中能与left区分开的最短前缀，其余字节补0，
+ * 压缩格式的内部结点因此只需存放这个前缀
+ */
+inline void ix_separator(const char *left, const char *right, char *dest, int len) {
+    int prefix = ix_common_prefix(left, right, len);
+    assert(prefix < len);
+    memcpy(dest, right, prefix + 1);
+    memset(dest + prefix + 1, 0, len - prefix - 1);
+}
+
+// 压缩格式的结点中下界的偏移，上界紧跟在下界之后
+constexpr int IX_FENCE_OFFSET = sizeof(IxPageHdr) + sizeof(IxCompressedHdr);
+
+// 压缩格式的结点中IxSlot数组的偏移，在上下界之后按IxSlot对齐
+inline int ix_slots_offset(int low_len, int high_len) {
+    int offset = IX_FENCE_OFFSET + low_len + high_len;
+    return (offset + alignof(IxSlot) - 1) / alignof(IxSlot) * alignof(IxSlot);
+}
+
+/**
+ * @brief 单列INT/FLOAT键的无分支二分查找，键的类型在编译期确定，不经过ix_compare中按ColType的分支
+ * @tparam T 键的类型，int或float
+ * @tparam upper 为false时查找[lo,hi)中第一个>=target的位置，为true时查找第一个>target的位置
+ * @param keys 键数组的首地址，第i个键位于keys + i * sizeof(T)
+ * @return 找到的位置，不存在时返回hi；要求lo < hi
+ */
+template <typename T, bool upper>
+inline int ix_search_typed(const char *keys, int lo, int hi, const char *target) {
+    T t;
+    memcpy(&t, target, sizeof(T));
+    auto key_at = [keys](int i) {
+        T k;
+        memcpy(&k, keys + i * sizeof(T), sizeof(T));
+        return k;
+    };
+    // 目标位置之前的键都满足before，之后的都不满足
+    auto before = [&t](T k) { return upper ? !(t < k) : k < t; };
+    // 每轮把区间缩小一半，只根据比较结果选择下一轮的起点，循环次数只和区间长度有关，编译为条件传送而不是分支
+    int base = lo;
+    int n = hi - lo;
+    while (n > 1) {
+        int half = n / 2;
+        base = before(key_at(base + half - 1)) ? base + half : base;
+        n -= half;
+    }
+    return base + before(key_at(base));
+}
+
+/* 管理B+树中的每个节点，句柄持有结点页面的固定，只能移动不能拷贝，析构时取消固定；修改结点的方法会把页面标记为脏页。
+ * 句柄还可以持有结点页面的读锁或写锁，析构或被移动赋值时先释放锁再取消固定。
+ * IX_KEY_COMPRESSED格式的结点没有定长的keys和rids数组，只能通过read_key、compare_key和get_rid访问，
+ * 结点是否已满、是否需要合并都按实际占用的字节数判断 */
 class IxNodeHandle {
     friend class IxIndexHandle;
     friend class IxScan;
 
    private:
     const IxFileHdr *file_hdr;      // 节点所在文件的头部信息
+    PageGuard guard;                // 结点页面的固定句柄
     Page *page;                     // 存储节点的页面
     IxPageHdr *page_hdr;            // page->data的第一部分，指针指向首地址，长度为sizeof(IxPageHdr)
     char *keys;                     // page->data的第二部分，指针指向首地址，长度为file_hdr->keys_size，每个key的长度为file_hdr->col_len
     Rid *rids;                      // page->data的第三部分，指针指向首地址
+    std::shared_lock<std::shared_mutex> read_latch_;    // 持有的结点读锁，声明在guard之后，先于取消固定释放
+    std::unique_lock<std::shared_mutex> write_latch_;   // 持有的结点写锁
 
    public:
     IxNodeHandle() = default;
 
-    IxNodeHandle(const IxFileHdr *file_hdr_, Page *page_) : file_hdr(file_hdr_), page(page_) {
+    IxNodeHandle(const IxFileHdr *file_hdr_, PageGuard &&guard_) : file_hdr(file_hdr_), guard(std::move(guard_)) {
+        page = guard.get_page();
         page_hdr = reinterpret_cast<IxPageHdr *>(page->get_data());
         keys = page->get_data() + sizeof(IxPageHdr);
         rids = reinterpret_cast<Rid *>(keys + file_hdr->keys_size_);
     }
 
+    IxNodeHandle(IxNodeHandle &&that) = default;
+
+    IxNodeHandle &operator=(IxNodeHandle &&that) noexcept {
+        if (this != &that) {
+            // 先释放原结点的锁，再取消固定原结点
+            unlatch();
+            file_hdr = that.file_hdr;
+            guard = std::move(that.guard);
+            page = that.page;
+            page_hdr = that.page_hdr;
+            keys = that.keys;
+            rids = that.rids;
+            read_latch_ = std::move(that.read_latch_);
+            write_latch_ = std::move(that.write_latch_);
+        }
+        return *this;
+    }
+
+    // 对结点加读锁
+    void latch_shared() { read_latch_ = std::shared_lock<std::shared_mutex>(page->latch()); }
+
+    // 对结点加写锁
+    void latch_exclusive() { write_latch_ = std::unique_lock<std::shared_mutex>(page->latch()); }
+
+    // 释放持有的锁，页面仍保持固定
+    void unlatch() {
+        read_latch_ = std::shared_lock<std::shared_mutex>();
+        write_latch_ = std::unique_lock<std::shared_mutex>();
+    }
+
     int get_size() { return page_hdr->num_key; }
 
-    void set_size(int size) { page_hdr->num_key = size; }
+    void set_size(int size) {
+        guard.mark_dirty();
+        page_hdr->num_key = size;
+    }
 
     int get_max_size() { return file_hdr->btree_order_ + 1; }
 
     int get_min_size() { return get_max_size() / 2; }
 
+    bool is_compressed() const { return file_hdr->key_format_ == IX_KEY_COMPRESSED; }
+
+    // 压缩格式的结点最多占用的字节数，留出一个最长的键值对的空间，使插入之后再分裂
+    static int max_bytes(const IxFileHdr *file_hdr) {
+        return PAGE_SIZE - file_hdr->col_tot_len_ - static_cast<int>(sizeof(IxSlot));
+    }
+
+    // 压缩格式的结点已占用的字节数，不包括后缀区中的空洞
+    int used_bytes() const;
+
+    // 插入后需要分裂
+    bool is_overfull() const;
+
+    // 删除后需要合并或重分配
+    bool is_underfull() const;
+
+    // 再插入key后不需要分裂；key为nullptr时按结点中最长的key计算，用于内部结点
+    bool can_insert(const char *key) const;
+
+    // 删除key后不需要合并或重分配；key为nullptr时按结点中最长的key计算，用于内部结点
+    bool can_erase(const char *key) const;
+
+    // 把第i个key替换为key后不会超出结点的容量
+    bool can_set_key(int i, const char *key) const;
+
     int key_at(int i) { return *(int *)get_key(i); }
 
     /* 得到第i个孩子结点的page_no */
@@ -94,24 +291,75 @@ class IxNodeHandle {
 
     bool is_root_page() { return get_parent_page_no() == INVALID_PAGE_ID; }
 
-    void set_next_leaf(page_id_t page_no) { page_hdr->next_leaf = page_no; }
+    void set_next_leaf(page_id_t page_no) {
+        guard.mark_dirty();
+        page_hdr->next_leaf = page_no;
+    }
 
-    void set_prev_leaf(page_id_t page_no) { page_hdr->prev_leaf = page_no; }
+    void set_prev_leaf(page_id_t page_no) {
+        guard.mark_dirty();
+        page_hdr->prev_leaf = page_no;
+    }
 
-    void set_parent_page_no(page_id_t parent) { page_hdr->parent = parent; }
+    void set_parent_page_no(page_id_t parent) {
+        guard.mark_dirty();
+        page_hdr->parent = parent;
+    }
 
-    char *get_key(int key_idx) const { return keys + key_idx * file_hdr->col_tot_len_; }
+    void set_leaf(bool is_leaf) {
+        guard.mark_dirty();
+        page_hdr->is_leaf = is_leaf;
+    }
 
-    Rid *get_rid(int rid_idx) const { return &rids[rid_idx]; }
+    // 定长格式的结点中第key_idx个key的地址，压缩格式的结点用read_key
+    char *get_key(int key_idx) const {
+        assert(!is_compressed());
+        return keys + key_idx * file_hdr->col_tot_len_;
+    }
 
-    void set_key(int key_idx, const char *key) { memcpy(keys + key_idx * file_hdr->col_tot_len_, key, file_hdr->col_tot_len_); }
+    Rid *get_rid(int rid_idx) const { return is_compressed() ? &slots()[rid_idx].rid : &rids[rid_idx]; }
 
-    void set_rid(int rid_idx, const Rid &rid) { rids[rid_idx] = rid; }
+    void set_key(int key_idx, const char *key);
+
+    void set_rid(int rid_idx, const Rid &rid) {
+        guard.mark_dirty();
+        *get_rid(rid_idx) = rid;
+    }
+
+    // 把第key_idx个key补齐到col_tot_len_字节写入dest
+    void read_key(int key_idx, char *dest) const;
+
+    // 比较第key_idx个key和target，结果的符号与ix_compare相同
+    int compare_key(int key_idx, const char *target) const;
+
+    // 父结点中指向本结点的key：压缩格式的结点为它的下界，没有下界时为全0；否则为第一个key
+    void read_separator(char *dest) const;
+
+    // 压缩格式的结点的下界和上界，补齐到col_tot_len_字节写入dest，返回是否存在
+    bool read_low(char *dest) const;
+
+    bool read_high(char *dest) const;
+
+    // 把[begin,end)中的key和rid追加到keys和rids中
+    void read_entries(int begin, int end, std::vector<char> *keys, std::vector<Rid> *rids) const;
+
+    // 用n个键值对重写结点，压缩格式的结点同时设置新的上下界（nullptr表示没有），用于分裂、合并和重分配
+    void rebuild(const char *low, const char *high, const char *keys, const Rid *rids, int n);
+
+    // 按文件的key格式把n个键值对写入页面data，不修改IxPageHdr中num_key以外的字段；批量构建时直接生成页面
+    static void encode(char *data, const IxFileHdr *file_hdr, const char *low, const char *high, const char *keys,
+                       const Rid *rids, int n);
+
+    // encode写出的压缩格式结点占用的字节数
+    static int encoded_size(const IxFileHdr *file_hdr, const char *low, const char *high, const char *keys, int n);
 
     int lower_bound(const char *target) const;
 
     int upper_bound(const char *target) const;
 
+    template <bool upper>
+    int search(const char *target, int lo) const;
+
     void insert_pairs(int pos, const char *key, const Rid *rid, int n);
 
     page_id_t internal_lookup(const char *key);
@@ -127,6 +375,29 @@ class IxNodeHandle {
 
     int remove(const char *key);
 
+   private:
+    IxCompressedHdr *compressed_hdr() const {
+        return reinterpret_cast<IxCompressedHdr *>(page->get_data() + sizeof(IxPageHdr));
+    }
+
+    const char *fences() const { return page->get_data() + IX_FENCE_OFFSET; }
+
+    IxSlot *slots() const {
+        auto hdr = compressed_hdr();
+        return reinterpret_cast<IxSlot *>(page->get_data() + ix_slots_offset(hdr->low_len, hdr->high_len));
+    }
+
+    int compare_prefix(const char *target) const;
+
+    int compare_suffix(int key_idx, const char *target, int target_len) const;
+
+    int entry_bytes(const char *key) const;
+
+    void insert_compressed(int pos, const char *key, const Rid &rid);
+
+    void compact();
+
+   public:
     /**
      * @brief used in internal node to remove the last key in root node, and return the last child
      *
@@ -157,45 +428,91 @@ class IxNodeHandle {
     }
 };
 
+/* 插入删除时自上而下持有写锁的结点。下降时孩子结点安全（这次操作后不会分裂、合并或重分配，并且第一个key不变）
+ * 就释放它上面的所有结点，之后的修改不会超出nodes；根结点可能被分裂或删除时还持有root_latch_排他锁 */
+struct IxWritePath {
+    std::unique_lock<std::shared_mutex> root_lock;
+    std::vector<IxNodeHandle> nodes;  // nodes[i]是nodes[i+1]的父结点，最后一个是叶结点
+    bool top_is_root = false;         // nodes[0]是根结点
+
+    // nodes[level]分裂或合并时要修改的上层结点都已持有：持有它的父结点，或者它是根结点并且持有root_latch_
+    bool can_restructure(size_t level) const { return level > 0 || root_lock.owns_lock(); }
+
+    void release() {
+        nodes.clear();
+        if (root_lock.owns_lock()) {
+            root_lock.unlock();
+        }
+    }
+};
+
 /* B+树 */
 class IxIndexHandle {
     friend class IxScan;
     friend class IxManager;
+    friend class IxBulkLoader;
 
    private:
     DiskManager *disk_manager_;
     BufferPoolManager *buffer_pool_manager_;
     int fd_;                                    // 存储B+树的文件
     IxFileHdr* file_hdr_;                       // 存了root_page，但其初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
-    std::mutex root_latch_;
+    // 根结点锁，相当于根结点之上的结点，保护file_hdr_->root_page_：下降时持有共享锁直到对根结点加锁；
+    // 只有分裂或合并可能到达根结点时才持有排他锁，直到根结点的修改完成。其余结点使用页面上的读写锁，按latch crabbing自上而下加锁
+    mutable std::shared_mutex root_latch_;
+    // 保护file_hdr_中会被不同子树上的操作并发修改的字段：空闲页链表、num_pages_和last_leaf_
+    mutable std::mutex file_hdr_latch_;
 
    public:
     IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
-    // for search
+    // 把上层传入的key转换为索引中存储的格式，规范化时写入buf并返回buf，否则直接返回key
+    const char *to_stored_key(const char *key, char *buf) const {
+        if (!file_hdr_->is_normalized()) {
+            return key;
+        }
+        ix_normalize_key(key, buf, file_hdr_->col_types_, file_hdr_->col_lens_);
+        return buf;
+    }
+
+    // for search，非唯一索引中返回key对应的所有rid
     bool get_value(const char *key, std::vector<Rid> *result, Transaction *transaction);
 
-    std::pair<IxNodeHandle *, bool> find_leaf_page(const char *key, Operation operation, Transaction *transaction,
-                                                 bool find_first = false);
+    std::pair<IxNodeHandle, bool> find_leaf_page(const char *key, Operation operation, Transaction *transaction,
+                                                bool find_first = false) const;
 
-    // for insert
+    // for insert，非唯一索引中key已存在时把value加入它的posting list
     page_id_t insert_entry(const char *key, const Rid &value, Transaction *transaction);
 
-    IxNodeHandle *split(IxNodeHandle *node);
+    IxNodeHandle split(IxNodeHandle *node);
+
+    void split_compressed(IxNodeHandle *node, IxNodeHandle *new_node);
+
+    void insert_into_parent(IxWritePath *path, size_t level, IxNodeHandle *new_node, Transaction *transaction);
+
+    // for delete，删除key及其所有rid
+    bool delete_entry(const char *key, Transaction *transaction) { return erase_entry(key, nullptr, transaction); }
 
-    void insert_into_parent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node, Transaction *transaction);
+    // 只删除(key, value)这一项，key的其他rid保留
+    bool delete_entry(const char *key, const Rid &value, Transaction *transaction) {
+        return erase_entry(key, &value, transaction);
+    }
+
+    // 批量维护索引：keys中依次存放n个上层格式的key，与rids一一对应，顺序任意；返回实际插入/删除的项数
+    int insert_entries(const char *keys, const Rid *rids, int n, Transaction *transaction);
 
-    // for delete
-    bool delete_entry(const char *key, Transaction *transaction);
+    int delete_entries(const char *keys, const Rid *rids, int n, Transaction *transaction);
+
+    bool coalesce_or_redistribute(IxWritePath *path, size_t level, Transaction *transaction = nullptr);
 
-    bool coalesce_or_redistribute(IxNodeHandle *node, Transaction *transaction = nullptr,
-                                bool *root_is_latched = nullptr);
     bool adjust_root(IxNodeHandle *old_root_node);
 
-    void redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
+    void redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxWritePath *path, size_t level, int index);
+
+    void redistribute_compressed(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
 
-    bool coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
-                  Transaction *transaction, bool *root_is_latched);
+    void coalesce(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                  Transaction *transaction);
 
     Iid lower_bound(const char *key);
 
@@ -211,15 +528,54 @@ class IxIndexHandle {
 
     bool is_empty() const { return file_hdr_->root_page_ == IX_NO_PAGE; }
 
+    int num_pages() const {
+        std::lock_guard lock{file_hdr_latch_};
+        return file_hdr_->num_pages_;
+    }
+
+    page_id_t last_leaf() const {
+        std::lock_guard lock{file_hdr_latch_};
+        return file_hdr_->last_leaf_;
+    }
+
+    Iid leaf_position(IxNodeHandle &node, int index) const;
+
+    bool erase_entry(const char *key, const Rid *value, Transaction *transaction);
+
+    // for latch crabbing
+    IxWritePath find_write_path(const char *key, Operation operation, std::vector<char> *fence = nullptr);
+
+    bool is_safe(IxNodeHandle &node, const char *key, Operation operation, bool is_root) const;
+
+    // for batch
+    std::vector<int> sort_batch(const char *keys, const Rid *rids, int n, std::vector<char> *stored) const;
+
+    // for posting list，调用者持有posting list所属叶结点的写锁（只读时为读锁）
+    void read_postings(const Rid &entry, std::vector<Rid> *result) const;
+
+    void append_posting(IxNodeHandle *leaf, int pos, const Rid &value);
+
+    bool remove_posting(IxNodeHandle *leaf, int pos, const Rid &value);
+
+    void free_postings(const Rid &entry);
+
+    WritePageGuard fetch_posting_page(page_id_t page_no) const;
+
+    WritePageGuard new_posting_page();
+
+    void free_posting_page(WritePageGuard *guard);
+
     // for get/create node
-    IxNodeHandle *fetch_node(int page_no) const;
+    IxNodeHandle fetch_node(int page_no) const;
 
-    IxNodeHandle *create_node();
+    IxNodeHandle create_node();
 
     // for maintain data structure
-    void maintain_parent(IxNodeHandle *node);
+    void maintain_parent(IxNodeHandle *node, IxWritePath *path, size_t level);
+
+    bool can_coalesce(IxNodeHandle *left, IxNodeHandle *right) const;
 
-    void erase_leaf(IxNodeHandle *leaf);
+    void erase_leaf(IxNodeHandle *leaf, IxNodeHandle *prev);
 
     void release_node_handle(IxNodeHandle &node);
 
@@ -10,11 +10,13 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
 #include "system/sm_meta.h"
 #include "ix_defs.h"
+#include "ix_hash_index.h"
 #include "ix_index_handle.h"
 
 class IxManager {
@@ -54,7 +56,10 @@ class IxManager {
         return disk_manager_->is_file(ix_name);
     }
 
-    void create_index(const std::string &filename, const std::vector<ColMeta>& index_cols) {
+    // unique为false时创建非唯一索引，重复key的所有rid都保留在posting list中；
+    // compress为false时规范化的key也存放在定长的结点中
+    void create_index(const std::string &filename, const std::vector<ColMeta>& index_cols, bool unique = true,
+                      bool compress = IX_PREFIX_COMPRESSION) {
         std::string ix_name = get_index_name(filename, index_cols);
         // Create index file
         disk_manager_->create_file(ix_name);
@@ -73,19 +78,33 @@ class IxManager {
         if (col_tot_len > IX_MAX_COL_LEN) {
             throw InvalidColLengthError(col_tot_len);
         }
+        // 多列和字符串key规范化后只需一次memcmp，compress时存放在前缀压缩的结点中；
+        // 单列INT/FLOAT key保持原样，使用按类型特化的二分查找
+        bool normalize = col_num > 1 || std::any_of(index_cols.begin(), index_cols.end(),
+                                                    [](const ColMeta &col) { return col.type == TYPE_STRING; });
+        int key_format = !normalize ? IX_KEY_RAW : compress ? IX_KEY_COMPRESSED : IX_KEY_NORMALIZED;
         // 根据 |page_hdr| + (|attr| + |rid|) * (n + 1) <= PAGE_SIZE 求得n的最大值btree_order
         // 即 n <= btree_order，那么btree_order就是每个结点最多可插入的键值对数量（实际还多留了一个空位，但其不可插入）
         int btree_order = static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr)) / (col_tot_len + sizeof(Rid)) - 1);
+        int keys_size = (btree_order + 1) * col_tot_len;
+        if (key_format == IX_KEY_COMPRESSED) {
+            // 压缩格式的结点按实际占用的字节数分裂，btree_order只记录所有后缀都为空时的最大扇出，没有定长的keys数组
+            btree_order = static_cast<int>((PAGE_SIZE - col_tot_len - sizeof(IxSlot) - ix_slots_offset(0, 0)) /
+                                           sizeof(IxSlot));
+            keys_size = 0;
+        }
         assert(btree_order > 2);
 
         // Create file header and write to file
         IxFileHdr* fhdr = new IxFileHdr(IX_NO_PAGE, IX_INIT_NUM_PAGES, IX_INIT_ROOT_PAGE,
-                                col_num, col_tot_len, btree_order, (btree_order + 1) * col_tot_len,
+                                col_num, col_tot_len, btree_order, keys_size,
                                 IX_INIT_ROOT_PAGE, IX_INIT_ROOT_PAGE);
         for(int i = 0; i < col_num; ++i) {
             fhdr->col_types_.push_back(index_cols[i].type);
             fhdr->col_lens_.push_back(index_cols[i].len);
         }
+        fhdr->key_format_ = key_format;
+        fhdr->unique_ = unique;
         fhdr->update_tot_len();
         
         char* data = new char[fhdr->tot_len_];
@@ -133,6 +152,49 @@ class IxManager {
         disk_manager_->close_file(fd);
     }
 
+    // 创建可扩展哈希索引，文件名与B+树索引相同：第0页为文件头，初始时只有一个局部深度为0的桶，目录只有一项
+    void create_hash_index(const std::string &filename, const std::vector<ColMeta>& index_cols) {
+        std::string ix_name = get_index_name(filename, index_cols);
+        disk_manager_->create_file(ix_name);
+        int fd = disk_manager_->open_file(ix_name);
+
+        IxHashFileHdr fhdr;
+        fhdr.col_num_ = index_cols.size();
+        fhdr.col_tot_len_ = 0;
+        for (auto &col : index_cols) {
+            fhdr.col_types_.push_back(col.type);
+            fhdr.col_lens_.push_back(col.len);
+            fhdr.col_tot_len_ += col.len;
+        }
+        if (fhdr.col_tot_len_ > IX_MAX_COL_LEN) {
+            throw InvalidColLengthError(fhdr.col_tot_len_);
+        }
+        fhdr.bucket_capacity_ =
+            static_cast<int>((PAGE_SIZE - sizeof(IxHashBucketHdr)) / (fhdr.col_tot_len_ + sizeof(Rid)));
+        fhdr.global_depth_ = 0;
+        fhdr.num_pages_ = IX_HASH_INIT_NUM_PAGES;
+        fhdr.first_free_page_no_ = IX_NO_PAGE;
+        fhdr.dir_first_page_ = IX_HASH_INIT_DIR_PAGE;
+        fhdr.dir_num_pages_ = 1;
+
+        char page_buf[PAGE_SIZE];
+        memset(page_buf, 0, PAGE_SIZE);
+        fhdr.serialize(page_buf);
+        disk_manager_->write_page(fd, IX_FILE_HDR_PAGE, page_buf, PAGE_SIZE);
+        {
+            memset(page_buf, 0, PAGE_SIZE);
+            auto bhdr = reinterpret_cast<IxHashBucketHdr *>(page_buf);
+            *bhdr = {.local_depth = 0, .num_entries = 0, .next_overflow = IX_NO_PAGE};
+            disk_manager_->write_page(fd, IX_HASH_BUCKET_PAGE, page_buf, PAGE_SIZE);
+        }
+        {
+            memset(page_buf, 0, PAGE_SIZE);
+            *reinterpret_cast<page_id_t *>(page_buf) = IX_HASH_BUCKET_PAGE;
+            disk_manager_->write_page(fd, IX_HASH_INIT_DIR_PAGE, page_buf, PAGE_SIZE);
+        }
+        disk_manager_->close_file(fd);
+    }
+
     void destroy_index(const std::string &filename, const std::vector<ColMeta>& index_cols) {
         std::string ix_name = get_index_name(filename, index_cols);
         disk_manager_->destroy_file(ix_name);
@@ -147,13 +209,58 @@ class IxManager {
     std::unique_ptr<IxIndexHandle> open_index(const std::string &filename, const std::vector<ColMeta>& index_cols) {
         std::string ix_name = get_index_name(filename, index_cols);
         int fd = disk_manager_->open_file(ix_name);
-        return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        try {
+            return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        } catch (RMDBError &) {
+            disk_manager_->close_file(fd);
+            throw;
+        }
     }
 
     std::unique_ptr<IxIndexHandle> open_index(const std::string &filename, const std::vector<std::string>& index_cols) {
         std::string ix_name = get_index_name(filename, index_cols);
         int fd = disk_manager_->open_file(ix_name);
-        return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        try {
+            return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        } catch (RMDBError &) {
+            disk_manager_->close_file(fd);
+            throw;
+        }
+    }
+
+    std::unique_ptr<IxHashIndexHandle> open_hash_index(const std::string &filename,
+                                                       const std::vector<ColMeta>& index_cols) {
+        std::string ix_name = get_index_name(filename, index_cols);
+        int fd = disk_manager_->open_file(ix_name);
+        try {
+            return std::make_unique<IxHashIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        } catch (RMDBError &) {
+            disk_manager_->close_file(fd);
+            throw;
+        }
+    }
+
+    std::unique_ptr<IxHashIndexHandle> open_hash_index(const std::string &filename,
+                                                       const std::vector<std::string>& index_cols) {
+        std::string ix_name = get_index_name(filename, index_cols);
+        int fd = disk_manager_->open_file(ix_name);
+        try {
+            return std::make_unique<IxHashIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
+        } catch (RMDBError &) {
+            disk_manager_->close_file(fd);
+            throw;
+        }
+    }
+
+    // 目录和文件头只在关闭时写回
+    void close_hash_index(IxHashIndexHandle *ih) {
+        ih->write_dir();
+        char page_buf[PAGE_SIZE];
+        memset(page_buf, 0, PAGE_SIZE);
+        ih->file_hdr_.serialize(page_buf);
+        disk_manager_->write_page(ih->fd_, IX_FILE_HDR_PAGE, page_buf, PAGE_SIZE);
+        buffer_pool_manager_->flush_all_pages(ih->fd_);
+        disk_manager_->close_file(ih->fd_);
     }
 
     void close_index(const IxIndexHandle *ih) {
@@ -10,24 +10,117 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_scan.h"
 
+IxScan::IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm, bool reverse)
+    : ih_(ih),
+      iid_(reverse ? upper : lower),
+      end_(upper),
+      begin_(lower),
+      reverse_(reverse),
+      bpm_(bpm),
+      read_ahead_(bpm, ih->fd_),
+      key_(ih->file_hdr_->col_tot_len_) {
+    if (reverse_) {
+        done_ = lower == upper;
+        if (!done_) {
+            prev();
+        }
+        return;
+    }
+    if (!is_end()) {
+        IxNodeHandle node = ih_->fetch_node(iid_.page_no);
+        node.latch_shared();
+        load_entry(node);
+    }
+}
+
 /**
- * @brief 
- * @todo 加上读锁（需要使用缓冲池得到page）
+ * @brief 移动到下一个rid，当前key的rid都已返回时移动到下一个键值对，读取叶结点时持有它的读锁
+ * @note 移动到下一个叶结点时先对它加读锁再释放当前叶结点，与分裂、合并一样按从左到右的顺序加锁
  */
 void IxScan::next() {
     assert(!is_end());
-    IxNodeHandle *node = ih_->fetch_node(iid_.page_no);
-    assert(node->is_leaf_page());
-    assert(iid_.slot_no < node->get_size());
+    if (++rid_idx_ < rids_.size()) {
+        return;
+    }
+    if (reverse_) {
+        if (iid_ == begin_) {
+            done_ = true;
+        } else {
+            prev();
+        }
+        return;
+    }
+    IxNodeHandle node = ih_->fetch_node(iid_.page_no);
+    node.latch_shared();
+    assert(node.is_leaf_page());
+    assert(iid_.slot_no < node.get_size());
     // increment slot no
     iid_.slot_no++;
-    if (iid_.page_no != ih_->file_hdr_->last_leaf_ && iid_.slot_no == node->get_size()) {
+    if (node.get_next_leaf() != IX_LEAF_HEADER_PAGE && iid_.slot_no == node.get_size()) {
         // go to next leaf
         iid_.slot_no = 0;
-        iid_.page_no = node->get_next_leaf();
+        iid_.page_no = node.get_next_leaf();
+        read_ahead_.access(iid_.page_no, ih_->num_pages());
+        if (!is_end()) {
+            IxNodeHandle next_node = ih_->fetch_node(iid_.page_no);
+            next_node.latch_shared();
+            node = std::move(next_node);
+        }
+    }
+    if (!is_end()) {
+        load_entry(node);
+    }
+}
+
+/**
+ * @brief reverse时移动到前一个键值对，当前位置是叶结点的第一个时移动到前一个叶结点的最后一个
+ * @note 不能持有右边的叶结点等待左边叶结点的锁，否则会与从左向右加锁的分裂、合并死锁，因此先释放当前叶结点；
+ * 释放期间前一个叶结点可能分裂或被合并，它的next_leaf不再是当前叶结点时按当前key重新查找位置
+ */
+void IxScan::prev() {
+    IxNodeHandle node = ih_->fetch_node(iid_.page_no);
+    node.latch_shared();
+    assert(node.is_leaf_page());
+    if (iid_.slot_no < node.get_size()) {
+        // 构造时iid_为upper，这里记下它的key用于重新查找
+        node.read_key(iid_.slot_no, key_.data());
+    }
+    while (iid_.slot_no == 0) {
+        page_id_t page_no = iid_.page_no;
+        page_id_t prev_page_no = node.get_prev_leaf();
+        node.unlatch();
+        node = ih_->fetch_node(prev_page_no);
+        node.latch_shared();
+        if (node.get_next_leaf() == page_no) {
+            iid_ = Iid{.page_no = prev_page_no, .slot_no = node.get_size()};
+        } else {
+            node.unlatch();
+            node = ih_->find_leaf_page(key_.data(), Operation::FIND, nullptr).first;
+            iid_ = Iid{.page_no = node.get_page_no(), .slot_no = node.lower_bound(key_.data())};
+        }
+    }
+    iid_.slot_no--;
+    load_entry(node);
+}
+
+Rid IxScan::rid_and_key(char *key) const {
+    if (ih_->file_hdr_->is_normalized()) {
+        ix_denormalize_key(key_.data(), key, ih_->file_hdr_->col_types_, ih_->file_hdr_->col_lens_);
+    } else {
+        memcpy(key, key_.data(), key_.size());
     }
+    return rid();
 }
 
-Rid IxScan::rid() const {
-    return ih_->get_rid(iid_);
-}
\ No newline at end of file
+/**
+ * @brief 读出iid_处的key和它的所有rid，调用者持有node的读锁
+ */
+void IxScan::load_entry(IxNodeHandle &node) {
+    if (iid_.slot_no >= node.get_size()) {
+        throw IndexEntryNotFoundError();
+    }
+    node.read_key(iid_.slot_no, key_.data());
+    rids_.clear();
+    rid_idx_ = 0;
+    ih_->read_postings(*node.get_rid(iid_.slot_no), &rids_);
+}
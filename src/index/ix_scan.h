@@ -12,27 +12,44 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_defs.h"
 #include "ix_index_handle.h"
+#include "storage/read_ahead.h"
 
 // class IxIndexHandle;
 
 // 用于遍历叶子结点
 // 用于直接遍历叶子结点，而不用findleafpage来得到叶子结点
-// TODO：对page遍历时，要加上读锁
+// 每次读取叶子结点时加读锁，两次调用之间不持有锁
+// 移动到一个key时把它的所有rid（重复key的posting list）和key一起读出，之后逐个返回其中的rid
+// reverse时从upper的前一个位置沿prev_leaf向前遍历到lower，用于按索引逆序输出的ORDER BY ... DESC LIMIT
 class IxScan : public RecScan {
     const IxIndexHandle *ih_;
-    Iid iid_;  // 初始为lower（用于遍历的指针）
+    Iid iid_;  // 初始为lower（用于遍历的指针），reverse时初始为upper的前一个位置
     Iid end_;  // 初始为upper
+    Iid begin_;             // lower，reverse时遍历到这里结束
+    bool reverse_;
+    bool done_ = false;     // reverse时已经越过begin_
     BufferPoolManager *bpm_;
+    ReadAhead read_ahead_;  // 叶结点链表的顺序预读，分裂产生的叶结点页号递增时生效
+    std::vector<Rid> rids_; // 当前key的所有rid
+    size_t rid_idx_ = 0;    // 当前rid在rids_中的下标
+    std::vector<char> key_; // 当前key，保持索引中的存储格式
 
    public:
-    IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm)
-        : ih_(ih), iid_(lower), end_(upper), bpm_(bpm) {}
+    IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm, bool reverse = false);
 
     void next() override;
 
-    bool is_end() const override { return iid_ == end_; }
+    bool is_end() const override { return reverse_ ? done_ : iid_ == end_; }
 
-    Rid rid() const override;
+    Rid rid() const override { return rids_[rid_idx_]; }
+
+    // 返回当前位置的rid，并把对应的key还原为上层的格式复制到key中
+    Rid rid_and_key(char *key) const;
 
     const Iid &iid() const { return iid_; }
+
+   private:
+    void load_entry(IxNodeHandle &node);
+
+    void prev();
 };
\ No newline at end of file
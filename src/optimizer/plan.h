@@ -27,6 +27,7 @@ typedef enum PlanTag{
     T_CreateTable,
     T_DropTable,
     T_CreateIndex,
+    T_CreateHashIndex,
     T_DropIndex,
     T_Insert,
     T_Update,
@@ -38,8 +39,15 @@ typedef enum PlanTag{
     T_Transaction_rollback,
     T_SeqScan,
     T_IndexScan,
+    T_IndexOnlyScan,
+    T_BitmapHeapScan,
     T_NestLoop,
+    T_HashJoin,
+    T_HashAggregate,
+    T_SortAggregate,
     T_Sort,
+    T_TopN,
+    T_Limit,
     T_Projection
 } PlanTag;
 
@@ -74,6 +82,8 @@ class ScanPlan : public Plan
         size_t len_;                               
         std::vector<Condition> fed_conds_;
         std::vector<std::string> index_col_names_;
+        bool ordered_ = false;      // 为了ORDER BY ... LIMIT按索引key的顺序输出，不能再改用其他索引
+        bool reverse_ = false;      // 按索引key的逆序扫描
     
 };
 
@@ -118,20 +128,53 @@ class ProjectionPlan : public Plan
 class SortPlan : public Plan
 {
     public:
-        SortPlan(PlanTag tag, std::shared_ptr<Plan> subplan, TabCol sel_col, bool is_desc)
+        SortPlan(PlanTag tag, std::shared_ptr<Plan> subplan, std::vector<TabCol> sel_cols, std::vector<bool> is_desc)
         {
             Plan::tag = tag;
             subplan_ = std::move(subplan);
-            sel_col_ = sel_col;
-            is_desc_ = is_desc;
+            sel_cols_ = std::move(sel_cols);
+            is_desc_ = std::move(is_desc);
         }
         ~SortPlan(){}
         std::shared_ptr<Plan> subplan_;
-        TabCol sel_col_;
-        bool is_desc_;
+        std::vector<TabCol> sel_cols_;      // 排序键，按优先级排列
+        std::vector<bool> is_desc_;         // 每个排序键是否降序
+        size_t limit_ = 0;                  // T_TopN时只需要排在最前面的limit_个元组
         
 };
 
+class AggregatePlan : public Plan
+{
+    public:
+        AggregatePlan(PlanTag tag, std::shared_ptr<Plan> subplan, std::vector<TabCol> group_cols, std::vector<AggExpr> aggs)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            group_cols_ = std::move(group_cols);
+            aggs_ = std::move(aggs);
+        }
+        ~AggregatePlan(){}
+        std::shared_ptr<Plan> subplan_;
+        std::vector<TabCol> group_cols_;    // GROUP BY的各列
+        std::vector<AggExpr> aggs_;         // 聚合函数，输出元组中依次是各分组列和各聚合函数的值
+};
+
+class LimitPlan : public Plan
+{
+    public:
+        LimitPlan(PlanTag tag, std::shared_ptr<Plan> subplan, int limit, int offset)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            limit_ = limit;
+            offset_ = offset;
+        }
+        ~LimitPlan(){}
+        std::shared_ptr<Plan> subplan_;
+        int limit_;
+        int offset_;
+};
+
 // dml语句，包括insert; delete; update; select语句　
 class DMLPlan : public Plan
 {
@@ -22,22 +22,102 @@ See the Mulan PSL v2 for more details. */
 #include "index/ix.h"
 #include "record_printer.h"
 
-// 目前的索引匹配规则为：完全匹配索引字段，且全部为单点查询，不会自动调整where条件的顺序
-// 修改成多点查询，且对index_col_names进行查重
+// 索引匹配规则为：索引的最左前缀字段上有常值等值条件，随后最多一个字段上有常值范围条件；
+// 哈希索引只能用于所有字段上都有类型相同的常值等值条件的单点查询。
+// 有多个索引可用时选择能匹配的字段最多的，匹配字段数相同时优先选择哈希索引，IndexScanExecutor据此推导扫描的键范围
 bool Planner::get_index_cols(std::string tab_name, std::vector<Condition> curr_conds, std::vector<std::string>& index_col_names) {
     index_col_names.clear();
-    std::unordered_set<std::string> inserted_cols;
+    std::unordered_set<std::string> eq_cols;
+    std::unordered_set<std::string> range_cols;
+    std::unordered_set<std::string> typed_eq_cols;  // 常值类型与字段类型相同的等值条件，可以直接计算哈希值
+    TabMeta& tab = sm_manager_->db_.get_table(tab_name);
     for(auto& cond: curr_conds) {
-        // if(cond.is_rhs_val && cond.op == OP_EQ && cond.lhs_col.tab_name.compare(tab_name) == 0)
-        if(cond.is_rhs_val && cond.lhs_col.tab_name.compare(tab_name) == 0
-            && inserted_cols.count(cond.lhs_col.col_name)==0){
-            index_col_names.push_back(cond.lhs_col.col_name);
-            inserted_cols.insert(cond.lhs_col.col_name);
+        if(!cond.is_rhs_val || cond.lhs_col.tab_name.compare(tab_name) != 0 || cond.op == OP_NE) continue;
+        if(cond.op == OP_EQ) {
+            eq_cols.insert(cond.lhs_col.col_name);
+            if(cond.rhs_val.type == tab.get_col(cond.lhs_col.col_name)->type) {
+                typed_eq_cols.insert(cond.lhs_col.col_name);
+            }
+        } else {
+            range_cols.insert(cond.lhs_col.col_name);
         }
     }
-    TabMeta& tab = sm_manager_->db_.get_table(tab_name);
-    if(tab.is_index(index_col_names)) return true;
-    return false;
+    size_t best_matched = 0;
+    for(auto& index: tab.indexes) {
+        size_t matched = 0;
+        if(index.type == INDEX_HASH) {
+            bool all_eq = std::all_of(index.cols.begin(), index.cols.end(),
+                                      [&](const ColMeta& col) { return typed_eq_cols.count(col.name) > 0; });
+            matched = all_eq ? index.cols.size() : 0;
+        } else {
+            while(matched < index.cols.size() && eq_cols.count(index.cols[matched].name)) {
+                matched++;
+            }
+            if(matched < index.cols.size() && range_cols.count(index.cols[matched].name)) {
+                matched++;
+            }
+        }
+        if(matched > best_matched || (matched > 0 && matched == best_matched && index.type == INDEX_HASH)) {
+            best_matched = matched;
+            index_col_names.clear();
+            for(auto& col: index.cols) {
+                index_col_names.push_back(col.name);
+            }
+        }
+    }
+    return best_matched > 0;
+}
+
+// 索引的每个字段上都有常值等值条件时是单点查询，按key的顺序访问表数据；
+// 否则是范围查询，先收集rid再按页号顺序访问表数据，每个页面只读取一次（范围内的rid较少时执行器仍按key的顺序访问）
+PlanTag Planner::index_scan_tag(const std::vector<Condition>& curr_conds, const std::vector<std::string>& index_col_names) {
+    for(auto& col_name: index_col_names) {
+        bool has_eq = std::any_of(curr_conds.begin(), curr_conds.end(), [&](const Condition& cond) {
+            return cond.is_rhs_val && cond.op == OP_EQ && cond.lhs_col.col_name == col_name;
+        });
+        if(!has_eq) {
+            return T_BitmapHeapScan;
+        }
+    }
+    return T_IndexScan;
+}
+
+// 连接条件两边都是字段、类型相同的等值条件可以作为hash join的连接键
+bool Planner::is_equi_join(const Condition& cond) {
+    if(cond.is_rhs_val || cond.op != OP_EQ) {
+        return false;
+    }
+    auto lhs = sm_manager_->db_.get_table(cond.lhs_col.tab_name).get_col(cond.lhs_col.col_name);
+    auto rhs = sm_manager_->db_.get_table(cond.rhs_col.tab_name).get_col(cond.rhs_col.col_name);
+    return lhs->type == rhs->type && lhs->len == rhs->len;
+}
+
+// 自底向上估计每个算子输出的行数，返回plan的估计值。表的行数取记录文件能容纳的记录数，
+// 每个常值等值条件的选择率按1/10、其他条件按1/3估计；有等值连接条件的连接改为hash join，
+// 并把估计较小的儿子换到右边作为build侧
+size_t Planner::choose_join_method(std::shared_ptr<Plan> plan) {
+    if(auto x = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+        RmFileHdr file_hdr = sm_manager_->fhs_.at(x->tab_name_)->get_file_hdr();
+        size_t rows = static_cast<size_t>(std::max(file_hdr.num_pages - 1, 0)) * file_hdr.num_records_per_page;
+        for(auto& cond: x->conds_) {
+            rows /= cond.op == OP_EQ ? 10 : 3;
+        }
+        return std::max<size_t>(rows, 1);
+    }
+    if(auto x = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+        size_t left_rows = choose_join_method(x->left_);
+        size_t right_rows = choose_join_method(x->right_);
+        bool equi = std::any_of(x->conds_.begin(), x->conds_.end(), [&](const Condition& cond) { return is_equi_join(cond); });
+        if(!equi) {
+            return left_rows > SIZE_MAX / right_rows ? SIZE_MAX : left_rows * right_rows;
+        }
+        x->tag = T_HashJoin;
+        if(left_rows < right_rows) {
+            std::swap(x->left_, x->right_);
+        }
+        return std::max(left_rows, right_rows);
+    }
+    return 1;
 }
 
 /**
@@ -136,10 +216,17 @@ std::shared_ptr<Plan> Planner::physical_optimization(std::shared_ptr<Query> quer
     std::shared_ptr<Plan> plan = make_one_rel(query);
     
     // 其他物理优化
+    choose_join_method(plan);
+
+    // 处理聚合和group by
+    plan = generate_agg_plan(query, std::move(plan));
 
     // 处理orderby
     plan = generate_sort_plan(query, std::move(plan)); 
 
+    // 处理limit
+    plan = generate_limit_plan(query, std::move(plan));
+
     return plan;
 }
 
@@ -162,7 +249,7 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query)
                 std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
         } else {  // 存在索引
             table_scan_executors[i] =
-                std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+                std::make_shared<ScanPlan>(index_scan_tag(curr_conds, index_col_names), sm_manager_, tables[i], curr_conds, index_col_names);
         }
     }
     // 只有一个表，不需要join。
@@ -268,13 +355,151 @@ std::shared_ptr<Plan> Planner::generate_sort_plan(std::shared_ptr<Query> query,
         const auto &sel_tab_cols = sm_manager_->db_.get_table(sel_tab_name).cols;
         all_cols.insert(all_cols.end(), sel_tab_cols.begin(), sel_tab_cols.end());
     }
-    TabCol sel_col;
-    for (auto &col : all_cols) {
-        if(col.name.compare(x->order->cols->col_name) == 0 )
-        sel_col = {.tab_name = col.tab_name, .col_name = col.name};
+    std::vector<TabCol> sel_cols;
+    std::vector<bool> is_desc;
+    for (auto &order : x->orders) {
+        // 没有指定表名时按字段名在所有表中查找
+        auto pos = std::find_if(all_cols.begin(), all_cols.end(), [&](const ColMeta &col) {
+            return col.name == order->cols->col_name && (order->cols->tab_name.empty() || col.tab_name == order->cols->tab_name);
+        });
+        if (pos == all_cols.end()) {
+            throw ColumnNotFoundError(order->cols->col_name);
+        }
+        TabCol sel_col = {.tab_name = pos->tab_name, .col_name = pos->name};
+        // 聚合之后只剩下分组列
+        if ((!query->aggs.empty() || !query->group_cols.empty()) &&
+            std::find(query->group_cols.begin(), query->group_cols.end(), sel_col) == query->group_cols.end()) {
+            throw RMDBError("ORDER BY column " + sel_col.col_name + " must appear in the GROUP BY clause");
+        }
+        sel_cols.push_back(sel_col);
+        is_desc.push_back(order->orderby_dir == ast::OrderBy_DESC);
+    }
+    return std::make_shared<SortPlan>(T_Sort, std::move(plan), std::move(sel_cols), std::move(is_desc));
+}
+
+/**
+ * @brief 有聚合函数或GROUP BY时加入AggregatePlan。输入按分组列有序时用流式的T_SortAggregate，否则用T_HashAggregate
+ */
+std::shared_ptr<Plan> Planner::generate_agg_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan)
+{
+    if(query->aggs.empty() && query->group_cols.empty()) {
+        return plan;
+    }
+    PlanTag tag = use_grouped_index(query, plan) ? T_SortAggregate : T_HashAggregate;
+    return std::make_shared<AggregatePlan>(tag, std::move(plan), query->group_cols, query->aggs);
+}
+
+/**
+ * @brief 单表查询中，某个B+树索引的前几列恰好是分组列（顺序不限）时，按索引key的顺序扫描，分组键相同的元组相邻。
+ * 扫描已经选用该索引时改为按key的顺序输出；顺序扫描时只在该索引能覆盖用到的所有字段时改为覆盖索引扫描
+ */
+bool Planner::use_grouped_index(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan)
+{
+    auto scan = std::dynamic_pointer_cast<ScanPlan>(plan);
+    if(scan == nullptr || query->group_cols.empty()) {
+        return false;
+    }
+    std::vector<TabCol> used_cols = query->group_cols;
+    for(auto& agg: query->aggs) {
+        if(agg.arg.col_name != "*") {
+            used_cols.push_back(agg.arg);
+        }
+    }
+    for(auto& cond: scan->conds_) {
+        used_cols.push_back(cond.lhs_col);
+        if(!cond.is_rhs_val) {
+            used_cols.push_back(cond.rhs_col);
+        }
+    }
+    TabMeta& tab = sm_manager_->db_.get_table(scan->tab_name_);
+    for(auto& index: tab.indexes) {
+        if(index.type != INDEX_BTREE || index.cols.size() < query->group_cols.size()) {
+            continue;
+        }
+        std::vector<std::string> index_col_names;
+        for(auto& col: index.cols) {
+            index_col_names.push_back(col.name);
+        }
+        bool grouped = std::all_of(query->group_cols.begin(), query->group_cols.end(), [&](const TabCol& col) {
+            auto end = index_col_names.begin() + query->group_cols.size();
+            return std::find(index_col_names.begin(), end, col.col_name) != end;
+        });
+        if(!grouped) {
+            continue;
+        }
+        if(scan->tag != T_SeqScan && scan->index_col_names_ == index_col_names) {
+            scan->tag = T_IndexScan;
+            scan->ordered_ = true;
+            return true;
+        }
+        bool covers = std::all_of(used_cols.begin(), used_cols.end(), [&](const TabCol& col) {
+            return std::find(index_col_names.begin(), index_col_names.end(), col.col_name) != index_col_names.end();
+        });
+        if(scan->tag == T_SeqScan && covers) {
+            scan->tag = T_IndexOnlyScan;
+            scan->index_col_names_ = std::move(index_col_names);
+            scan->ordered_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 有LIMIT时在最上层加入LimitPlan。同时有ORDER BY时，单表查询的排序键是某个B+树索引的最左前缀且方向一致的，
+ * 去掉排序改为按索引key的顺序（或逆序）扫描，取到足够的元组后即停止；否则排序改为只保留前offset+limit个元组的T_TopN。
+ * 没有排序时LIMIT直接作用于索引范围扫描的，按key的顺序访问表数据，不再先收集整个范围内的rid
+ */
+std::shared_ptr<Plan> Planner::generate_limit_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan)
+{
+    if(query->limit < 0) {
+        return plan;
+    }
+    if(auto x = std::dynamic_pointer_cast<SortPlan>(plan)) {
+        if(use_ordered_index(x)) {
+            plan = x->subplan_;
+        } else {
+            x->tag = T_TopN;
+            x->limit_ = static_cast<size_t>(query->limit) + query->offset;
+        }
+    }
+    if(auto x = std::dynamic_pointer_cast<ScanPlan>(plan); x && x->tag == T_BitmapHeapScan) {
+        x->tag = T_IndexScan;
+    }
+    return std::make_shared<LimitPlan>(T_Limit, std::move(plan), query->limit, query->offset);
+}
+
+bool Planner::use_ordered_index(std::shared_ptr<SortPlan> sort)
+{
+    auto scan = std::dynamic_pointer_cast<ScanPlan>(sort->subplan_);
+    if(scan == nullptr || std::any_of(sort->is_desc_.begin(), sort->is_desc_.end(),
+                                      [&](bool desc) { return desc != sort->is_desc_[0]; })) {
+        return false;
+    }
+    TabMeta& tab = sm_manager_->db_.get_table(scan->tab_name_);
+    for(auto& index: tab.indexes) {
+        if(index.type != INDEX_BTREE || index.cols.size() < sort->sel_cols_.size()) {
+            continue;
+        }
+        std::vector<std::string> index_col_names;
+        for(auto& col: index.cols) {
+            index_col_names.push_back(col.name);
+        }
+        bool prefix = true;
+        for(size_t i = 0; i < sort->sel_cols_.size(); i++) {
+            prefix = prefix && sort->sel_cols_[i].col_name == index_col_names[i];
+        }
+        // 已经按条件选用了其他索引时保留原来的选择
+        if(!prefix || (scan->tag != T_SeqScan && scan->index_col_names_ != index_col_names)) {
+            continue;
+        }
+        scan->tag = T_IndexScan;
+        scan->index_col_names_ = std::move(index_col_names);
+        scan->ordered_ = true;
+        scan->reverse_ = sort->is_desc_[0];
+        return true;
     }
-    return std::make_shared<SortPlan>(T_Sort, std::move(plan), sel_col, 
-                                    x->order->orderby_dir == ast::OrderBy_DESC);
+    return false;
 }
 
 
@@ -292,12 +517,76 @@ std::shared_ptr<Plan> Planner::generate_select_plan(std::shared_ptr<Query> query
     //物理优化
     auto sel_cols = query->cols;
     std::shared_ptr<Plan> plannerRoot = physical_optimization(query, context);
+    use_index_only_scan(plannerRoot, sel_cols);
     plannerRoot = std::make_shared<ProjectionPlan>(T_Projection, std::move(plannerRoot), 
                                                         std::move(sel_cols));
 
     return plannerRoot;
 }
 
+/**
+ * @brief 单表查询中，输出字段、排序字段和谓词涉及的字段都包含在某个索引中时，把扫描改为覆盖索引扫描，
+ * 直接从索引的key构造元组而不访问表数据；已选用的索引不能覆盖时，再尝试表上的其他索引。
+ * 哈希索引不能按顺序扫描key，不用于覆盖索引扫描
+ *
+ * @param plan 投影算子的子计划
+ * @param sel_cols 投影的字段
+ */
+void Planner::use_index_only_scan(std::shared_ptr<Plan> plan, const std::vector<TabCol> &sel_cols) {
+    std::vector<TabCol> used_cols = sel_cols;
+    if(auto x = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+        plan = x->subplan_;
+    }
+    if(auto x = std::dynamic_pointer_cast<SortPlan>(plan)) {
+        used_cols.insert(used_cols.end(), x->sel_cols_.begin(), x->sel_cols_.end());
+        plan = x->subplan_;
+    }
+    if(auto x = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+        // 聚合之上的字段都来自分组列，扫描只需要提供分组列和聚合函数的参数
+        used_cols = x->group_cols_;
+        for(auto& agg: x->aggs_) {
+            if(agg.arg.col_name != "*") {
+                used_cols.push_back(agg.arg);
+            }
+        }
+        plan = x->subplan_;
+    }
+    auto scan = std::dynamic_pointer_cast<ScanPlan>(plan);
+    if(scan == nullptr) {
+        return;
+    }
+    for(auto& cond: scan->conds_) {
+        used_cols.push_back(cond.lhs_col);
+        if(!cond.is_rhs_val) {
+            used_cols.push_back(cond.rhs_col);
+        }
+    }
+    auto covers = [&](const IndexMeta& index) {
+        return index.type != INDEX_HASH && std::all_of(used_cols.begin(), used_cols.end(), [&](const TabCol& col) {
+            return std::any_of(index.cols.begin(), index.cols.end(),
+                               [&](const ColMeta& index_col) { return index_col.name == col.col_name; });
+        });
+    };
+    TabMeta& tab = sm_manager_->db_.get_table(scan->tab_name_);
+    if((scan->tag == T_IndexScan || scan->tag == T_BitmapHeapScan) && covers(*tab.get_index_meta(scan->index_col_names_))) {
+        scan->tag = T_IndexOnlyScan;
+        return;
+    }
+    if(scan->tag != T_SeqScan || scan->ordered_) {
+        return;
+    }
+    for(auto& index: tab.indexes) {
+        if(covers(index)) {
+            scan->index_col_names_.clear();
+            for(auto& col: index.cols) {
+                scan->index_col_names_.push_back(col.name);
+            }
+            scan->tag = T_IndexOnlyScan;
+            return;
+        }
+    }
+}
+
 // 生成DDL语句和DML语句的查询执行计划
 std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context *context)
 {
@@ -321,7 +610,8 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
         plannerRoot = std::make_shared<DDLPlan>(T_DropTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(query->parse)) {
         // create index;
-        plannerRoot = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+        plannerRoot = std::make_shared<DDLPlan>(x->hash ? T_CreateHashIndex : T_CreateIndex, x->tab_name, x->col_names,
+                                                std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(query->parse)) {
         // drop index
         plannerRoot = std::make_shared<DDLPlan>(T_DropIndex, x->tab_name, x->col_names, std::vector<ColDef>());
@@ -344,7 +634,7 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
                 std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
         } else {  // 存在索引
             table_scan_executors =
-                std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+                std::make_shared<ScanPlan>(index_scan_tag(query->conds, index_col_names), sm_manager_, x->tab_name, query->conds, index_col_names);
         }
 
         plannerRoot = std::make_shared<DMLPlan>(T_Delete, table_scan_executors, x->tab_name,  
@@ -364,7 +654,7 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
                 std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
         } else {  // 存在索引
             table_scan_executors =
-                std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+                std::make_shared<ScanPlan>(index_scan_tag(query->conds, index_col_names), sm_manager_, x->tab_name, query->conds, index_col_names);
         }
         plannerRoot = std::make_shared<DMLPlan>(T_Update, table_scan_executors, x->tab_name,
                                                      std::vector<Value>(), query->conds, 
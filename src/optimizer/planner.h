@@ -42,14 +42,30 @@ class Planner {
 
     std::shared_ptr<Plan> make_one_rel(std::shared_ptr<Query> query);
 
+    std::shared_ptr<Plan> generate_agg_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
+
+    bool use_grouped_index(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
+
     std::shared_ptr<Plan> generate_sort_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
+
+    std::shared_ptr<Plan> generate_limit_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
+
+    bool use_ordered_index(std::shared_ptr<SortPlan> sort);
     
     std::shared_ptr<Plan> generate_select_plan(std::shared_ptr<Query> query, Context *context);
 
+    void use_index_only_scan(std::shared_ptr<Plan> plan, const std::vector<TabCol> &sel_cols);
+
 
     // int get_indexNo(std::string tab_name, std::vector<Condition> curr_conds);
     bool get_index_cols(std::string tab_name, std::vector<Condition> curr_conds, std::vector<std::string>& index_col_names);
 
+    PlanTag index_scan_tag(const std::vector<Condition>& curr_conds, const std::vector<std::string>& index_col_names);
+
+    size_t choose_join_method(std::shared_ptr<Plan> plan);
+
+    bool is_equi_join(const Condition& cond);
+
     ColType interp_sv_type(ast::SvType sv_type) {
         std::map<ast::SvType, ColType> m = {
             {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_STRING}};
@@ -26,6 +26,10 @@ enum SvCompOp {
     SV_OP_EQ, SV_OP_NE, SV_OP_LT, SV_OP_GT, SV_OP_LE, SV_OP_GE
 };
 
+enum SvAggFunc {
+    SV_AGG_COUNT, SV_AGG_SUM, SV_AGG_MIN, SV_AGG_MAX, SV_AGG_AVG
+};
+
 enum OrderByDir {
     OrderBy_DEFAULT,
     OrderBy_ASC,
@@ -96,9 +100,10 @@ struct DescTable : public TreeNode {
 struct CreateIndex : public TreeNode {
     std::string tab_name;
     std::vector<std::string> col_names;
+    bool hash;      // USING HASH，创建只支持等值查找的哈希索引
 
-    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_) :
-            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
+    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_, bool hash_ = false) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)), hash(hash_) {}
 };
 
 struct DropIndex : public TreeNode {
@@ -141,6 +146,14 @@ struct Col : public Expr {
             tab_name(std::move(tab_name_)), col_name(std::move(col_name_)) {}
 };
 
+// 选择列表中的聚合函数，COUNT(*)的col_name为"*"
+struct AggCol : public Col {
+    SvAggFunc func;
+
+    AggCol(SvAggFunc func_, std::string tab_name_, std::string col_name_) :
+            Col(std::move(tab_name_), std::move(col_name_)), func(func_) {}
+};
+
 struct SetClause : public TreeNode {
     std::string col_name;
     std::shared_ptr<Value> val;
@@ -166,6 +179,13 @@ struct OrderBy : public TreeNode
        cols(std::move(cols_)), orderby_dir(std::move(orderby_dir_)) {}
 };
 
+struct Limit : public TreeNode
+{
+    int limit;      // 最多输出的元组数
+    int offset;     // 输出之前跳过的元组数
+    Limit(int limit_, int offset_) : limit(limit_), offset(offset_) {}
+};
+
 struct InsertStmt : public TreeNode {
     std::string tab_name;
     std::vector<std::shared_ptr<Value>> vals;
@@ -209,19 +229,23 @@ struct SelectStmt : public TreeNode {
     std::vector<std::string> tabs;
     std::vector<std::shared_ptr<BinaryExpr>> conds;
     std::vector<std::shared_ptr<JoinExpr>> jointree;
+    std::vector<std::shared_ptr<Col>> group_cols;   // GROUP BY的各列
 
     
     bool has_sort;
-    std::shared_ptr<OrderBy> order;
+    std::vector<std::shared_ptr<OrderBy>> orders;   // ORDER BY的各个键，按优先级排列
+    std::shared_ptr<Limit> limit;                   // 没有LIMIT时为空
 
 
     SelectStmt(std::vector<std::shared_ptr<Col>> cols_,
                std::vector<std::string> tabs_,
                std::vector<std::shared_ptr<BinaryExpr>> conds_,
-               std::shared_ptr<OrderBy> order_) :
+               std::vector<std::shared_ptr<Col>> group_cols_,
+               std::vector<std::shared_ptr<OrderBy>> orders_,
+               std::shared_ptr<Limit> limit_) :
             cols(std::move(cols_)), tabs(std::move(tabs_)), conds(std::move(conds_)), 
-            order(std::move(order_)) {
-                has_sort = (bool)order;
+            group_cols(std::move(group_cols_)), orders(std::move(orders_)), limit(std::move(limit_)) {
+                has_sort = !orders.empty();
             }
 };
 
@@ -257,6 +281,9 @@ struct SemValue {
     std::vector<std::shared_ptr<BinaryExpr>> sv_conds;
 
     std::shared_ptr<OrderBy> sv_orderby;
+    std::vector<std::shared_ptr<OrderBy>> sv_orderbys;
+
+    std::shared_ptr<Limit> sv_limit;
 };
 
 extern std::shared_ptr<ast::TreeNode> parse_tree;
@@ -90,7 +90,7 @@ private:
             std::cout << "DESC_TABLE\n";
             print_val(x->tab_name, offset);
         } else if (auto x = std::dynamic_pointer_cast<CreateIndex>(node)) {
-            std::cout << "CREATE_INDEX\n";
+            std::cout << (x->hash ? "CREATE_HASH_INDEX\n" : "CREATE_INDEX\n");
             print_val(x->tab_name, offset);
             // print_val(x->col_name, offset);
             for(auto col_name: x->col_names)
@@ -3,6 +3,7 @@
 #include "yacc.tab.h"
 #include <iostream>
 #include <memory>
+#include <strings.h>
 
 int yylex(YYSTYPE *yylval, YYLTYPE *yylloc);
 
@@ -11,6 +12,20 @@ void yyerror(YYLTYPE *locp, const char* s) {
 }
 
 using namespace ast;
+
+// 按名字识别聚合函数，不区分大小写
+static bool get_agg_func(const std::string &name, SvAggFunc *func) {
+    static const std::pair<const char *, SvAggFunc> funcs[] = {
+        {"COUNT", SV_AGG_COUNT}, {"SUM", SV_AGG_SUM}, {"MIN", SV_AGG_MIN}, {"MAX", SV_AGG_MAX}, {"AVG", SV_AGG_AVG},
+    };
+    for (auto &f : funcs) {
+        if (strcasecmp(name.c_str(), f.first) == 0) {
+            *func = f.second;
+            return true;
+        }
+    }
+    return false;
+}
 %}
 
 // request a pure (reentrant) parser
@@ -22,7 +37,7 @@ using namespace ast;
 
 // keywords
 %token SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY
-WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY
+WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY USING HASH LIMIT OFFSET GROUP
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
@@ -42,13 +57,15 @@ WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_CO
 %type <sv_vals> valueList
 %type <sv_str> tbName colName
 %type <sv_strs> tableList colNameList
-%type <sv_col> col
-%type <sv_cols> colList selector
+%type <sv_col> col selItem
+%type <sv_cols> colList selector selList opt_group_clause
 %type <sv_set_clause> setClause
 %type <sv_set_clauses> setClauses
 %type <sv_cond> condition
 %type <sv_conds> whereClause optWhereClause
-%type <sv_orderby>  order_clause opt_order_clause
+%type <sv_orderby>  order_item
+%type <sv_limit> opt_limit_clause
+%type <sv_orderbys> order_clause opt_order_clause
 %type <sv_orderby_dir> opt_asc_desc
 
 %%
@@ -125,6 +142,10 @@ ddl:
     {
         $$ = std::make_shared<CreateIndex>($3, $5);
     }
+    |   CREATE INDEX tbName '(' colNameList ')' USING HASH
+    {
+        $$ = std::make_shared<CreateIndex>($3, $5, true);
+    }
     |   DROP INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<DropIndex>($3, $5);
@@ -144,9 +165,9 @@ dml:
     {
         $$ = std::make_shared<UpdateStmt>($2, $4, $5);
     }
-    |   SELECT selector FROM tableList optWhereClause opt_order_clause
+    |   SELECT selector FROM tableList optWhereClause opt_group_clause opt_order_clause opt_limit_clause
     {
-        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6);
+        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6, $7, $8);
     }
     ;
 
@@ -329,7 +350,40 @@ selector:
     {
         $$ = {};
     }
-    |   colList
+    |   selList
+    ;
+
+selList:
+        selItem
+    {
+        $$ = std::vector<std::shared_ptr<Col>>{$1};
+    }
+    |   selList ',' selItem
+    {
+        $$.push_back($3);
+    }
+    ;
+
+selItem:
+        col
+    |   IDENTIFIER '(' col ')'
+    {
+        SvAggFunc func;
+        if (!get_agg_func($1, &func)) {
+            yyerror(&@1, "unknown aggregate function");
+            YYERROR;
+        }
+        $$ = std::make_shared<AggCol>(func, $3->tab_name, $3->col_name);
+    }
+    |   IDENTIFIER '(' '*' ')'
+    {
+        SvAggFunc func;
+        if (!get_agg_func($1, &func) || func != SV_AGG_COUNT) {
+            yyerror(&@1, "only COUNT accepts *");
+            YYERROR;
+        }
+        $$ = std::make_shared<AggCol>(SV_AGG_COUNT, "", "*");
+    }
     ;
 
 tableList:
@@ -347,6 +401,14 @@ tableList:
     }
     ;
 
+opt_group_clause:
+    GROUP BY colList
+    {
+        $$ = $3;
+    }
+    |   /* epsilon */ { /* ignore*/ }
+    ;
+
 opt_order_clause:
     ORDER BY order_clause      
     { 
@@ -356,12 +418,35 @@ opt_order_clause:
     ;
 
 order_clause:
+      order_item
+    {
+        $$ = std::vector<std::shared_ptr<OrderBy>>{$1};
+    }
+    |   order_clause ',' order_item
+    {
+        $$.push_back($3);
+    }
+    ;
+
+order_item:
       col  opt_asc_desc 
     { 
         $$ = std::make_shared<OrderBy>($1, $2);
     }
     ;   
 
+opt_limit_clause:
+    LIMIT VALUE_INT
+    {
+        $$ = std::make_shared<Limit>($2, 0);
+    }
+    |   LIMIT VALUE_INT OFFSET VALUE_INT
+    {
+        $$ = std::make_shared<Limit>($2, $4);
+    }
+    |   /* epsilon */ { /* ignore*/ }
+    ;
+
 opt_asc_desc:
     ASC          { $$ = OrderBy_ASC;     }
     |  DESC      { $$ = OrderBy_DESC;    }
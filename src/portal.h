@@ -15,6 +15,8 @@ See the Mulan PSL v2 for more details. */
 #include <string>
 #include "optimizer/plan.h"
 #include "execution/executor_abstract.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_hash_join.h"
 #include "execution/executor_nestedloop_join.h"
 #include "execution/executor_projection.h"
 #include "execution/executor_seq_scan.h"
@@ -23,6 +25,8 @@ See the Mulan PSL v2 for more details. */
 #include "execution/executor_insert.h"
 #include "execution/executor_delete.h"
 #include "execution/execution_sort.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_topn.h"
 #include "common/common.h"
 
 typedef enum portalTag{
@@ -161,18 +165,38 @@ class Portal
                 return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context);
             }
             else {
-                return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context);
+                IndexScanMode mode = x->tag == T_IndexOnlyScan    ? IndexScanMode::INDEX_ONLY
+                                     : x->tag == T_BitmapHeapScan ? IndexScanMode::RID_ORDER
+                                                                  : IndexScanMode::KEY_ORDER;
+                return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context,
+                                                           mode, x->reverse_);
             } 
         } else if(auto x = std::dynamic_pointer_cast<JoinPlan>(plan)) {
             std::unique_ptr<AbstractExecutor> left = convert_plan_executor(x->left_, context);
             std::unique_ptr<AbstractExecutor> right = convert_plan_executor(x->right_, context);
+            if(x->tag == T_HashJoin) {
+                return std::make_unique<HashJoinExecutor>(std::move(left), std::move(right), std::move(x->conds_));
+            }
             std::unique_ptr<AbstractExecutor> join = std::make_unique<NestedLoopJoinExecutor>(
                                 std::move(left), 
                                 std::move(right), std::move(x->conds_));
             return join;
         } else if(auto x = std::dynamic_pointer_cast<SortPlan>(plan)) {
+            if(x->tag == T_TopN) {
+                return std::make_unique<TopNExecutor>(convert_plan_executor(x->subplan_, context), 
+                                                x->sel_cols_, x->is_desc_, x->limit_);
+            }
             return std::make_unique<SortExecutor>(convert_plan_executor(x->subplan_, context), 
-                                            x->sel_col_, x->is_desc_);
+                                            x->sel_cols_, x->is_desc_);
+        } else if(auto x = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+            if(x->tag == T_SortAggregate) {
+                return std::make_unique<SortAggregateExecutor>(convert_plan_executor(x->subplan_, context), 
+                                                        x->group_cols_, x->aggs_);
+            }
+            return std::make_unique<HashAggregateExecutor>(convert_plan_executor(x->subplan_, context), 
+                                                    x->group_cols_, x->aggs_);
+        } else if(auto x = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+            return std::make_unique<LimitExecutor>(convert_plan_executor(x->subplan_, context), x->limit_, x->offset_);
         }
         return nullptr;
     }
@@ -13,9 +13,18 @@ See the Mulan PSL v2 for more details. */
 #include <cinttypes>
 #include <cstring>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RMDB_BITMAP_AVX2
+#include <immintrin.h>
+#endif
+
 static constexpr int BITMAP_WIDTH = 8;
 static constexpr unsigned BITMAP_HIGHEST_BIT = 0x80u;  // 128 (2^7)
+static constexpr int BITMAP_WORD_BYTES = 8;            // 按64位字扫描
+static constexpr int BITMAP_AVX2_BYTES = 32;           // AVX2一次处理256位，整页的bitmap才使用
 
+/* 位图，第pos位存放在第pos/8个字节中，字节内从最高位开始编号。
+ * 查找和计数按64位字进行：字节按顺序装入64位整数后第0位恰好是最高位，用clz找到最靠前的位 */
 class Bitmap {
    public:
     // 从地址bm开始的size个字节全部置0
@@ -39,17 +48,72 @@ class Bitmap {
      * @return 找到了就返回偏移位置，没找到就返回max_n
      */
     static int next_bit(bool bit, const char *bm, int max_n, int curr) {
-        for (int i = curr + 1; i < max_n; i++) {
-            if (is_set(bm, i) == bit) {
-                return i;
-            }
+        int pos = curr + 1;
+        if (pos >= max_n) {
+            return max_n;
+        }
+        // 稠密的位图中下一位往往就是目标位，单独判断可以让分支预测越过对位图内容的依赖
+        if (is_set(bm, pos) == bit) {
+            return pos;
         }
-        return max_n;
+        // 其次检查当前字节剩余的位
+        int byte = get_bucket(pos);
+        unsigned rest = static_cast<unsigned char>(bit ? bm[byte] : ~bm[byte]) & (0xFFu >> (pos % BITMAP_WIDTH));
+        if (rest != 0) {
+            int i = byte * BITMAP_WIDTH + __builtin_clz(rest) - (32 - BITMAP_WIDTH);
+            return i < max_n ? i : max_n;
+        }
+        return next_bit_in_words(bit, bm, max_n, byte + 1);
     }
 
     // 找第一个为0 or 1的位
     static int first_bit(bool bit, const char *bm, int max_n) { return next_bit(bit, bm, max_n, -1); }
 
+    // 统计[0,max_n)中为1的位的个数
+    static int count(const char *bm, int max_n) {
+        int num_bytes = max_n / BITMAP_WIDTH;
+        int total = 0;
+        int byte = 0;
+#ifdef RMDB_BITMAP_AVX2
+        if (num_bytes >= BITMAP_AVX2_BYTES && has_avx2()) {
+            byte = num_bytes / BITMAP_AVX2_BYTES * BITMAP_AVX2_BYTES;
+            total = count_blocks_avx2(bm, byte);
+        }
+#endif
+        for (; byte + BITMAP_WORD_BYTES <= num_bytes; byte += BITMAP_WORD_BYTES) {
+            total += __builtin_popcountll(load_word(bm, byte, num_bytes, true));
+        }
+        for (; byte < num_bytes; byte++) {
+            total += __builtin_popcount(static_cast<unsigned char>(bm[byte]));
+        }
+        // 最后不满一个字节的部分
+        int rest = max_n % BITMAP_WIDTH;
+        if (rest != 0) {
+            total += __builtin_popcount(static_cast<unsigned char>(bm[num_bytes]) & (0xFFu << (BITMAP_WIDTH - rest)));
+        }
+        return total;
+    }
+
+    /**
+     * @brief 按从小到大的顺序对[0,max_n)中每个为1的位调用f(pos)
+     */
+    template <typename F>
+    static void for_each_set_bit(const char *bm, int max_n, F &&f) {
+        int num_bytes = (max_n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        for (int byte = 0; byte < num_bytes; byte += BITMAP_WORD_BYTES) {
+            uint64_t word = load_word(bm, byte, num_bytes, true);
+            while (word != 0) {
+                int i = __builtin_clzll(word);
+                int pos = byte * BITMAP_WIDTH + i;
+                if (pos >= max_n) {
+                    return;
+                }
+                f(pos);
+                word ^= (1ULL << 63) >> i;
+            }
+        }
+    }
+
     // for example:
     // rid_.slot_no = Bitmap::next_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page,
     // rid_.slot_no); int slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
@@ -58,4 +122,91 @@ class Bitmap {
     static int get_bucket(int pos) { return pos / BITMAP_WIDTH; }
 
     static char get_bit(int pos) { return BITMAP_HIGHEST_BIT >> static_cast<char>(pos % BITMAP_WIDTH); }
+
+    /**
+     * @brief 从第byte个字节开始按64位字查找，next_bit在当前字节内找不到时调用
+     */
+    static int next_bit_in_words(bool bit, const char *bm, int max_n, int byte) {
+        int num_bytes = (max_n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        if (byte >= num_bytes) {
+            return max_n;
+        }
+        uint64_t word = load_word(bm, byte, num_bytes, bit);
+        while (word == 0) {
+            byte += BITMAP_WORD_BYTES;
+            if (byte >= num_bytes) {
+                return max_n;
+            }
+#ifdef RMDB_BITMAP_AVX2
+            if (num_bytes - byte >= BITMAP_AVX2_BYTES && has_avx2()) {
+                byte = skip_blocks_avx2(bm, byte, num_bytes, bit);
+                if (byte >= num_bytes) {
+                    return max_n;
+                }
+            }
+#endif
+            word = load_word(bm, byte, num_bytes, bit);
+        }
+        int i = byte * BITMAP_WIDTH + __builtin_clzll(word);
+        return i < max_n ? i : max_n;
+    }
+
+    /**
+     * @brief 从第byte个字节开始读入至多8个字节，第一个字节放在最高位；超出num_bytes的字节补0
+     * @param bit 为false时返回取反后的结果，便于用同样的方式查找为0的位（补的字节取反后为1，由调用者按max_n截断）
+     */
+    static uint64_t load_word(const char *bm, int byte, int num_bytes, bool bit) {
+        uint64_t word = 0;
+        if (num_bytes - byte >= BITMAP_WORD_BYTES) {
+            memcpy(&word, bm + byte, BITMAP_WORD_BYTES);
+            word = __builtin_bswap64(word);
+        } else {
+            for (int i = byte; i < num_bytes; i++) {
+                word = word << BITMAP_WIDTH | static_cast<unsigned char>(bm[i]);
+            }
+            word <<= (BITMAP_WORD_BYTES - (num_bytes - byte)) * BITMAP_WIDTH;
+        }
+        return bit ? word : ~word;
+    }
+
+#ifdef RMDB_BITMAP_AVX2
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    /**
+     * @brief 从第byte个字节开始，每次跳过32个全0（查找1时）或全1（查找0时）的字节，
+     * 返回第一个可能包含目标位的块的起始字节，剩余不足32个字节时返回剩余部分的起始字节
+     */
+    __attribute__((target("avx2"))) static int skip_blocks_avx2(const char *bm, int byte, int num_bytes, bool bit) {
+        const __m256i skip = bit ? _mm256_setzero_si256() : _mm256_set1_epi8(-1);
+        for (; byte + BITMAP_AVX2_BYTES <= num_bytes; byte += BITMAP_AVX2_BYTES) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bm + byte));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, skip)) != -1) {
+                break;
+            }
+        }
+        return byte;
+    }
+
+    /**
+     * @brief 统计前num_bytes个字节中为1的位数，num_bytes为32的倍数；每个字节拆成两个4位查表求和，再用sad累加
+     */
+    __attribute__((target("avx2"))) static int count_blocks_avx2(const char *bm, int num_bytes) {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2,
+                                                3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        __m256i acc = _mm256_setzero_si256();
+        for (int byte = 0; byte < num_bytes; byte += BITMAP_AVX2_BYTES) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bm + byte));
+            __m256i lo = _mm256_and_si256(block, low_mask);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(block, 4), low_mask);
+            __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+        }
+        return static_cast<int>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+    }
+#endif
 };
@@ -10,6 +10,9 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
 #include "defs.h"
 #include "storage/buffer_pool_manager.h"
 
@@ -18,18 +21,30 @@ constexpr int RM_FILE_HDR_PAGE = 0;
 constexpr int RM_FIRST_RECORD_PAGE = 1;
 constexpr int RM_MAX_RECORD_SIZE = 512;
 
+/* 空闲空间映射(free space map, FSM)：记录页面从RM_FIRST_RECORD_PAGE开始，每隔RM_FSM_PAGE_SPAN个数据页面放置一个FSM页面，
+ * FSM页面用一个字节记录其后RM_FSM_PAGE_SPAN个数据页面的空闲程度，即第k个FSM页面的页号为
+ * RM_FIRST_RECORD_PAGE + k * (RM_FSM_PAGE_SPAN + 1) */
+constexpr int RM_FSM_PAGE_SPAN = PAGE_SIZE - Page::OFFSET_PAGE_HDR;  // 每个FSM页面管理的数据页面个数
+constexpr uint8_t RM_FSM_FULL = 0;           // 页面没有空闲slot，尚未分配的页面也记为0
+constexpr uint8_t RM_FSM_EMPTY = UINT8_MAX;  // 页面中没有记录，可以被回收；其余取值越大空闲slot越多
+
+constexpr uint32_t RM_FILE_MAGIC = 0x524d4442;  // 表数据文件的标识"RMDB"
+constexpr uint32_t RM_FILE_VERSION = 2;         // 文件格式版本，2为带FSM页面的布局；格式不兼容地变化时递增
+
 /* 文件头，记录表数据文件的元信息，写入磁盘中文件的第0号页面 */
 struct RmFileHdr {
+    uint32_t magic;             // 固定为RM_FILE_MAGIC
+    uint32_t version;           // 创建文件时的RM_FILE_VERSION，打开时不一致则拒绝
     int record_size;            // 表中每条记录的大小，由于不包含变长字段，因此当前字段初始化后保持不变
     int num_pages;              // 文件中分配的页面个数（初始化为1）
     int num_records_per_page;   // 每个页面最多能存储的元组个数
-    int first_free_page_no;     // 文件中当前第一个包含空闲空间的页面号（初始化为-1）
+    int first_free_page_no;     // FSM的搜索起点，之前的数据页面都已满；为-1时表示没有已知的空闲页面（初始化为-1）
     int bitmap_size;            // 每个页面bitmap大小
 };
 
 /* 表数据文件中每个页面的页头，记录每个页面的元信息 */
 struct RmPageHdr {
-    int next_free_page_no;  // 当前页面满了之后，下一个包含空闲空间的页面号（初始化为-1）
+    int next_free_page_no;  // unused，空闲页面由FSM管理
     int num_records;        // 当前页面中当前已经存储的记录个数（初始化为0）
 };
 
@@ -62,7 +77,7 @@ struct RmRecord {
         allocated_ = true;
     }
 
-    RmRecord(int size_, char* data_) {
+    RmRecord(int size_, const char* data_) {
         size = size_;
         data = new char[size_];
         memcpy(data, data_, size_);
@@ -90,3 +105,19 @@ struct RmRecord {
         data = nullptr;
     }
 };
+
+/* 记录的只读视图，data指向被固定的页面（或执行器内部的缓冲区）中的记录，不拥有数据。
+ * 视图只在持有者取消固定页面或改写缓冲区之前有效，需要更长的生命周期时用to_record()物化 */
+struct TupleView {
+    const char* data = nullptr;  // 记录的数据
+    int size = 0;                // 记录的大小
+
+    TupleView() = default;
+
+    TupleView(const char* data_, int size_) : data(data_), size(size_) {}
+
+    explicit TupleView(const RmRecord& record) : data(record.data), size(record.size) {}
+
+    // 复制一份数据，得到可以脱离页面固定独立存在的记录
+    std::unique_ptr<RmRecord> to_record() const { return std::make_unique<RmRecord>(size, data); }
+};
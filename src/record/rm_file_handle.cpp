@@ -10,6 +10,8 @@ See the Mulan PSL v2 for more details. */
 
 #include "rm_file_handle.h"
 
+#include <algorithm>
+
 /**
  * @description: 获取当前表中记录号为rid的记录
  * @param {Rid&} rid 记录号，指定记录的位置
@@ -24,10 +26,29 @@ std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid& rid, Context* cont
     context->lock_mgr_->lock_shared_on_record(context->txn_, rid, fd_);
     // 1. 获取指定记录所在的page handle
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
-    // 2. 初始化一个指向RmRecord的指针（赋值其内部的data和size）
+    // 2. 初始化一个指向RmRecord的指针（赋值其内部的data和size），page_handle析构时取消固定页面
     return std::make_unique<RmRecord>(file_hdr_.record_size, page_handle.get_slot(rid.slot_no));
 }
 
+/**
+ * @description: 获取当前表中记录号为rid的记录的只读视图，不复制记录
+ * @param {Rid&} rid 记录号，指定记录的位置
+ * @param {optional<RmPageHandle>&} page_handle 调用者持有的页面句柄，不是rid所在的页面时替换为rid所在的页面，
+ *                                              连续访问同一页面上的记录时只固定一次
+ * @param {Context*} context
+ * @return {TupleView} 指向页面中记录的视图，在page_handle被替换或析构之前有效
+ */
+TupleView RmFileHandle::get_record_view(const Rid& rid, std::optional<RmPageHandle>& page_handle,
+                                        Context* context) const {
+    context->lock_mgr_->lock_IS_on_table(context->txn_, fd_);
+    context->lock_mgr_->lock_shared_on_record(context->txn_, rid, fd_);
+    if (!page_handle || page_handle->page->get_page_id().page_no != rid.page_no) {
+        page_handle.reset();
+        page_handle.emplace(fetch_page_handle(rid.page_no));
+    }
+    return TupleView(page_handle->get_slot(rid.slot_no), file_hdr_.record_size);
+}
+
 /**
  * @description: 在当前表中插入一条记录，不指定插入位置
  * @param {char*} buf 要插入的记录的数据
@@ -47,13 +68,11 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
     // 3. 将buf复制到空闲slot位置
     memcpy(first_free_slot, buf, file_hdr_.record_size);
     Bitmap::set(page_handle.bitmap, first_free_slot_no);
-    // 4. 更新page_handle.page_hdr中的数据结构
-    page_handle.page_hdr->num_records++;
-    // 注意考虑插入一条记录后页面已满的情况，需要更新file_hdr_.first_free_page_no
-    if (page_handle.page_hdr->num_records >= file_hdr_.num_records_per_page) {
-        file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
-    }
-    return Rid{page_handle.page->get_page_id().page_no, first_free_slot_no};
+    // 4. 更新page_handle.page_hdr中的数据结构，页面的空闲程度变化时更新FSM
+    int page_no = page_handle.page->get_page_id().page_no;
+    int num_records = page_handle.page_hdr->num_records++;
+    update_free_space(page_no, num_records, num_records + 1);
+    return Rid{page_no, first_free_slot_no};
 }
 
 /**
@@ -64,15 +83,12 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
 void RmFileHandle::insert_record(const Rid& rid, char* buf, Context* context) {
     // NEED REVISIT
     //  这个函数是不是从来没被调用过
-    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    RmPageHandle page_handle = fetch_page_handle_for_write(rid.page_no);
     char* obj_slot = page_handle.get_slot(rid.slot_no);
     memcpy(obj_slot, buf, file_hdr_.record_size);
     Bitmap::set(page_handle.bitmap, rid.slot_no);
-    page_handle.page_hdr->num_records++;
-    if (page_handle.page_hdr->num_records >= file_hdr_.num_records_per_page) {
-        file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
-    }
-    return;
+    int num_records = page_handle.page_hdr->num_records++;
+    update_free_space(rid.page_no, num_records, num_records + 1);
 }
 
 /**
@@ -86,14 +102,11 @@ void RmFileHandle::delete_record(const Rid& rid, Context* context) {
     context->lock_mgr_->lock_IX_on_table(context->txn_, fd_);
     context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_);
     // 1. 获取指定记录所在的page handle
-    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    RmPageHandle page_handle = fetch_page_handle_for_write(rid.page_no);
     Bitmap::reset(page_handle.bitmap, rid.slot_no);
-    // 2. 更新page_handle.page_hdr中的数据结构
-    if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
-        release_page_handle(page_handle);
-    }
-    page_handle.page_hdr->num_records--;
-    // 注意考虑删除一条记录后页面未满的情况，需要调用release_page_handle()
+    // 2. 更新page_handle.page_hdr中的数据结构，页面的空闲程度变化时更新FSM，变空的页面之后可以被回收
+    int num_records = page_handle.page_hdr->num_records--;
+    update_free_space(rid.page_no, num_records, num_records - 1);
 }
 
 /**
@@ -108,7 +121,7 @@ void RmFileHandle::update_record(const Rid& rid, char* buf, Context* context) {
     context->lock_mgr_->lock_IX_on_table(context->txn_, fd_);
     context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_);
     // 1. 获取指定记录所在的page handle
-    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    RmPageHandle page_handle = fetch_page_handle_for_write(rid.page_no);
     // 2. 更新记录
     char* obj_slot = page_handle.get_slot(rid.slot_no);
     memcpy(obj_slot, buf, file_hdr_.record_size);
@@ -120,9 +133,10 @@ void RmFileHandle::update_record(const Rid& rid, char* buf, Context* context) {
 /**
  * @description: 获取指定页面的页面句柄
  * @param {int} page_no 页面号
+ * @param {BufferAccessStrategy*} strategy 缓冲池访问策略，为nullptr时使用默认策略
  * @return {RmPageHandle} 指定页面的句柄
  */
-RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
+RmPageHandle RmFileHandle::fetch_page_handle(int page_no, BufferAccessStrategy* strategy) const {
     // Todo:
     // 使用缓冲池获取指定页面，并生成page_handle返回给上层
     // if page_no is invalid, throw PageNotExistError exception
@@ -132,8 +146,27 @@ RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
     if (page_no == INVALID_PAGE_ID) {
         throw PageNotExistError("PageNameTODO", page_no);
     }
-    Page* obj_page = buffer_pool_manager_->fetch_page(page_id);
-    return RmPageHandle(&file_hdr_, obj_page);
+    ReadPageGuard guard = buffer_pool_manager_->fetch_page_read(page_id, strategy);
+    if (!guard) {
+        throw InternalError("RmFileHandle::fetch_page_handle: no free frame in buffer pool");
+    }
+    return RmPageHandle(&file_hdr_, std::move(guard));
+}
+
+/**
+ * @description: 以读写方式获取指定页面的页面句柄，句柄析构时页面成为脏页
+ * @param {int} page_no 页面号
+ * @return {RmPageHandle} 指定页面的句柄
+ */
+RmPageHandle RmFileHandle::fetch_page_handle_for_write(int page_no) {
+    if (page_no == INVALID_PAGE_ID) {
+        throw PageNotExistError("PageNameTODO", page_no);
+    }
+    WritePageGuard guard = buffer_pool_manager_->fetch_page_write(PageId{fd_, page_no});
+    if (!guard) {
+        throw InternalError("RmFileHandle::fetch_page_handle_for_write: no free frame in buffer pool");
+    }
+    return RmPageHandle(&file_hdr_, std::move(guard));
 }
 
 /**
@@ -142,48 +175,161 @@ RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
  */
 RmPageHandle RmFileHandle::create_new_page_handle() {
     // Todo:
-    // 1.使用缓冲池来创建一个新page
+    // 1.使用缓冲池来创建一个新page，新页面落在FSM页面的位置上时，先把它初始化为FSM页面再分配下一个页面
     PageId page_id;
     page_id.fd = fd_;
-    Page* newPage = buffer_pool_manager_->new_page(&page_id);
-    RmPageHandle new_page_handle = RmPageHandle(&file_hdr_, newPage);
+    WritePageGuard guard = buffer_pool_manager_->new_page_guarded(&page_id);
+    if (guard && is_fsm_page(page_id.page_no)) {
+        memset(guard.get_data(), 0, PAGE_SIZE);
+        file_hdr_.num_pages++;
+        guard = buffer_pool_manager_->new_page_guarded(&page_id);
+    }
+    if (!guard) {
+        throw InternalError("RmFileHandle::create_new_page_handle: no free frame in buffer pool");
+    }
+    RmPageHandle new_page_handle = RmPageHandle(&file_hdr_, std::move(guard));
     // 2.更新page handle中的相关信息
-    new_page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
+    new_page_handle.page_hdr->next_free_page_no = RM_NO_PAGE;
     new_page_handle.page_hdr->num_records = 0;
     Bitmap::init(new_page_handle.bitmap, file_hdr_.bitmap_size);
-    // 3.更新file_hdr_
+    // 3.更新file_hdr_和FSM
     file_hdr_.num_pages++;
-    file_hdr_.first_free_page_no = newPage->get_page_id().page_no;
+    set_free_space(page_id.page_no, RM_FSM_EMPTY);
     return new_page_handle;
 }
 
 /**
  * @brief 创建或获取一个空闲的page handle
  *
- * @return RmPageHandle 返回生成的空闲page handle
- * @note pin the page, remember to unpin it outside!
+ * @return RmPageHandle 返回生成的空闲page handle，析构时取消固定
  */
 RmPageHandle RmFileHandle::create_page_handle() {
-    // Todo:
-    // 1. 判断file_hdr_中是否还有空闲页
-    //     1.1 没有空闲页：使用缓冲池来创建一个新page；可直接调用create_new_page_handle()
-    //     1.2 有空闲页：直接获取第一个空闲页
-    if (file_hdr_.first_free_page_no < 0) {
-        return create_new_page_handle();
-    } else {
-        return fetch_page_handle(file_hdr_.first_free_page_no);
-    }
-    // 2. 生成page handle并返回给上层
+    // 1. 通过FSM查找有空闲slot的页面；FSM只是提示，页面实际已满时修正FSM后继续查找
+    for (int page_no = find_free_page(); page_no != RM_NO_PAGE; page_no = find_free_page()) {
+        RmPageHandle page_handle = fetch_page_handle_for_write(page_no);
+        if (page_handle.page_hdr->num_records < file_hdr_.num_records_per_page) {
+            return page_handle;
+        }
+        set_free_space(page_no, RM_FSM_FULL);
+    }
+    // 2. 没有空闲页：使用缓冲池来创建一个新page
+    return create_new_page_handle();
 }
 
 /**
- * @description: 当一个页面从没有空闲空间的状态变为有空闲空间状态时，更新文件头和页头中空闲页面相关的元数据
+ * @description: 从file_hdr_.first_free_page_no开始在FSM中查找第一个有空闲slot的数据页面，并把搜索起点移到该页面
+ * 搜索起点之前的页面都已满，页面有了空闲slot时搜索起点才会后退，因此插入查找空闲页面的均摊代价为O(1)
+ * @return {int} 有空闲slot的页号，没有时返回RM_NO_PAGE
  */
-void RmFileHandle::release_page_handle(RmPageHandle& page_handle) {
-    // Todo:
-    // 当page从已满变成未满，考虑如何更新：
-    // 1. page_handle.page_hdr->next_free_page_no
-    // 2. file_hdr_.first_free_page_no
-    page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
-    file_hdr_.first_free_page_no = page_handle.page->get_page_id().page_no;
+int RmFileHandle::find_free_page() {
+    int page_no = file_hdr_.first_free_page_no;
+    while (page_no != RM_NO_PAGE && page_no < file_hdr_.num_pages) {
+        if (is_fsm_page(page_no)) {
+            page_no++;
+            continue;
+        }
+        int fsm_no = fsm_page_no(page_no);
+        int end = std::min(fsm_no + RM_FSM_PAGE_SPAN + 1, file_hdr_.num_pages);
+        ReadPageGuard guard = buffer_pool_manager_->fetch_page_read(PageId{fd_, fsm_no});
+        if (!guard) {
+            throw InternalError("RmFileHandle::find_free_page: no free frame in buffer pool");
+        }
+        auto categories = reinterpret_cast<const uint8_t *>(guard.get_data() + Page::OFFSET_PAGE_HDR);
+        for (; page_no < end; page_no++) {
+            if (categories[page_no - fsm_no - 1] != RM_FSM_FULL) {
+                file_hdr_.first_free_page_no = page_no;
+                return page_no;
+            }
+        }
+    }
+    file_hdr_.first_free_page_no = RM_NO_PAGE;
+    return RM_NO_PAGE;
+}
+
+/**
+ * @description: 页面中有num_records条记录时在FSM中记录的空闲程度，空页面为RM_FSM_EMPTY，满页面为RM_FSM_FULL，
+ * 其余按空闲slot的比例映射到[1, RM_FSM_EMPTY-1)
+ */
+uint8_t RmFileHandle::free_space_category(int num_records) const {
+    int num_free = file_hdr_.num_records_per_page - num_records;
+    if (num_records == 0) {
+        return RM_FSM_EMPTY;
+    }
+    if (num_free <= 0) {
+        return RM_FSM_FULL;
+    }
+    return static_cast<uint8_t>(1 + (num_free - 1) * (RM_FSM_EMPTY - 2) / file_hdr_.num_records_per_page);
+}
+
+/**
+ * @description: 页面的记录数从old_num_records变为num_records后，空闲程度变化时更新FSM
+ */
+void RmFileHandle::update_free_space(int page_no, int old_num_records, int num_records) {
+    uint8_t category = free_space_category(num_records);
+    if (category != free_space_category(old_num_records)) {
+        set_free_space(page_no, category);
+    }
+}
+
+/**
+ * @description: 在FSM中记录数据页面page_no的空闲程度，页面有空闲slot时把FSM的搜索起点移到该页面之前
+ */
+void RmFileHandle::set_free_space(int page_no, uint8_t category) {
+    int fsm_no = fsm_page_no(page_no);
+    WritePageGuard guard = buffer_pool_manager_->fetch_page_write(PageId{fd_, fsm_no});
+    if (!guard) {
+        throw InternalError("RmFileHandle::set_free_space: no free frame in buffer pool");
+    }
+    guard.get_data()[Page::OFFSET_PAGE_HDR + page_no - fsm_no - 1] = static_cast<char>(category);
+    if (category != RM_FSM_FULL &&
+        (file_hdr_.first_free_page_no == RM_NO_PAGE || page_no < file_hdr_.first_free_page_no)) {
+        file_hdr_.first_free_page_no = page_no;
+    }
+}
+
+/**
+ * @description: 回收FSM中记为空的数据页面：把页面移出缓冲池并释放其磁盘空间，文件末尾的空页面直接截断。
+ * 释放了磁盘空间的页面读回时全为0，仍是合法的空页面，之后可以继续被插入复用
+ * @note 调用时不能有其他线程访问该表，SmManager在关闭数据库时调用
+ */
+void RmFileHandle::reclaim_empty_pages() {
+    // 1. 释放空页面的磁盘空间，记录最后一个仍在使用的页面
+    int last_used_page_no = RM_FILE_HDR_PAGE;
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr_.num_pages; page_no++) {
+        if (is_fsm_page(page_no)) {
+            continue;
+        }
+        uint8_t category;
+        {
+            int fsm_no = fsm_page_no(page_no);
+            ReadPageGuard guard = buffer_pool_manager_->fetch_page_read(PageId{fd_, fsm_no});
+            if (!guard) {
+                throw InternalError("RmFileHandle::reclaim_empty_pages: no free frame in buffer pool");
+            }
+            category = static_cast<uint8_t>(guard.get_data()[Page::OFFSET_PAGE_HDR + page_no - fsm_no - 1]);
+        }
+        // FSM只是提示，页面确实没有记录并且能够移出缓冲池时才释放
+        bool is_empty = category == RM_FSM_EMPTY && fetch_page_handle(page_no).page_hdr->num_records == 0;
+        if (is_empty && buffer_pool_manager_->delete_page(PageId{fd_, page_no})) {
+            disk_manager_->deallocate_page(fd_, page_no);
+            continue;
+        }
+        last_used_page_no = page_no;
+    }
+    // 2. 截断最后一个仍在使用的页面之后的所有页面，被截断的数据页面在FSM中记为未分配
+    int num_pages = last_used_page_no + 1;
+    for (int page_no = num_pages; page_no < file_hdr_.num_pages; page_no++) {
+        if (is_fsm_page(page_no)) {
+            buffer_pool_manager_->delete_page(PageId{fd_, page_no});
+        } else if (fsm_page_no(page_no) < num_pages) {
+            set_free_space(page_no, RM_FSM_FULL);
+        }
+    }
+    if (num_pages < file_hdr_.num_pages) {
+        disk_manager_->truncate_file(fd_, num_pages);
+        file_hdr_.num_pages = num_pages;
+    }
+    if (file_hdr_.first_free_page_no >= num_pages) {
+        file_hdr_.first_free_page_no = RM_NO_PAGE;
+    }
 }
\ No newline at end of file
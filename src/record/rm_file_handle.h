@@ -13,6 +13,8 @@ See the Mulan PSL v2 for more details. */
 #include <assert.h>
 
 #include <memory>
+#include <optional>
+#include <utility>
 
 #include "bitmap.h"
 #include "common/context.h"
@@ -20,24 +22,33 @@ See the Mulan PSL v2 for more details. */
 
 class RmManager;
 
-/* 对表数据文件中的页面进行封装 */
+/* 对表数据文件中的页面进行封装，page_handle持有页面的固定句柄，析构时取消固定 */
 struct RmPageHandle {
     const RmFileHdr *file_hdr;  // 当前页面所在文件的文件头指针
+    PageGuard guard;            // 页面的固定句柄，以读写方式获取的页面在取消固定时成为脏页
     Page *page;                 // 页面的实际数据，包括页面存储的数据、元信息等
     RmPageHdr *page_hdr;        // page->data的第一部分，存储页面元信息，指针指向首地址，长度为sizeof(RmPageHdr)
     char *bitmap;               // page->data的第二部分，存储页面的bitmap，指针指向首地址，长度为file_hdr->bitmap_size
     char *slots;                // page->data的第三部分，存储表的记录，指针指向首地址，每个slot的长度为file_hdr->record_size
 
-    RmPageHandle(const RmFileHdr *fhdr_, Page *page_) : file_hdr(fhdr_), page(page_) {
-        page_hdr = reinterpret_cast<RmPageHdr *>(page->get_data() + page->OFFSET_PAGE_HDR);
-        bitmap = page->get_data() + sizeof(RmPageHdr) + page->OFFSET_PAGE_HDR;
-        slots = bitmap + file_hdr->bitmap_size;
+    RmPageHandle(const RmFileHdr *fhdr_, ReadPageGuard &&guard_) : RmPageHandle(fhdr_, static_cast<PageGuard &&>(guard_)) {}
+
+    RmPageHandle(const RmFileHdr *fhdr_, WritePageGuard &&guard_) : RmPageHandle(fhdr_, static_cast<PageGuard &&>(guard_)) {
+        guard.mark_dirty();
     }
 
     // 返回指定slot_no的slot存储收地址
     char* get_slot(int slot_no) const {
         return slots + slot_no * file_hdr->record_size;  // slots的首地址 + slot个数 * 每个slot的大小(每个record的大小)
     }
+
+   private:
+    RmPageHandle(const RmFileHdr *fhdr_, PageGuard &&guard_) : file_hdr(fhdr_), guard(std::move(guard_)) {
+        page = guard.get_page();
+        page_hdr = reinterpret_cast<RmPageHdr *>(page->get_data() + page->OFFSET_PAGE_HDR);
+        bitmap = page->get_data() + sizeof(RmPageHdr) + page->OFFSET_PAGE_HDR;
+        slots = bitmap + file_hdr->bitmap_size;
+    }
 };
 
 /* 每个RmFileHandle对应一个表的数据文件，里面有多个page，每个page的数据封装在RmPageHandle中 */
@@ -58,6 +69,9 @@ class RmFileHandle {
         // 这里实际就是初始化file_hdr，只不过是从磁盘中读出进行初始化
         // init file_hdr_
         disk_manager_->read_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+        if (file_hdr_.magic != RM_FILE_MAGIC || file_hdr_.version != RM_FILE_VERSION) {
+            throw FileFormatError(disk_manager_->get_file_name(fd));
+        }
         // disk_manager管理的fd对应的文件中，设置从file_hdr_.num_pages开始分配page_no
         disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages);
     }
@@ -67,12 +81,17 @@ class RmFileHandle {
 
     /* 判断指定位置上是否已经存在一条记录，通过Bitmap来判断 */
     bool is_record(const Rid &rid) const {
+        if (is_fsm_page(rid.page_no)) {
+            return false;
+        }
         RmPageHandle page_handle = fetch_page_handle(rid.page_no);
         return Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
     }
 
     std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
 
+    TupleView get_record_view(const Rid &rid, std::optional<RmPageHandle> &page_handle, Context *context) const;
+
     Rid insert_record(char *buf, Context *context);
 
     // void insert_record(const Rid &rid, char *buf);
@@ -84,10 +103,30 @@ class RmFileHandle {
 
     RmPageHandle create_new_page_handle();
 
-    RmPageHandle fetch_page_handle(int page_no) const;
+    RmPageHandle fetch_page_handle(int page_no, BufferAccessStrategy *strategy = nullptr) const;
+
+    RmPageHandle fetch_page_handle_for_write(int page_no);
+
+    void reclaim_empty_pages();
+
+    /* 判断页面是否为FSM页面，FSM页面不存放记录 */
+    static bool is_fsm_page(int page_no) {
+        return page_no >= RM_FIRST_RECORD_PAGE && (page_no - RM_FIRST_RECORD_PAGE) % (RM_FSM_PAGE_SPAN + 1) == 0;
+    }
+
+    /* 管理数据页面page_no的FSM页面的页号 */
+    static int fsm_page_no(int page_no) {
+        return RM_FIRST_RECORD_PAGE + (page_no - RM_FIRST_RECORD_PAGE) / (RM_FSM_PAGE_SPAN + 1) * (RM_FSM_PAGE_SPAN + 1);
+    }
 
    private:
     RmPageHandle create_page_handle();
 
-    void release_page_handle(RmPageHandle &page_handle);
+    int find_free_page();
+
+    uint8_t free_space_category(int num_records) const;
+
+    void update_free_space(int page_no, int old_num_records, int num_records);
+
+    void set_free_space(int page_no, uint8_t category);
 };
\ No newline at end of file
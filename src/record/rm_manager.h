@@ -40,6 +40,8 @@ class RmManager {
 
         // 初始化file header
         RmFileHdr file_hdr{};
+        file_hdr.magic = RM_FILE_MAGIC;
+        file_hdr.version = RM_FILE_VERSION;
         file_hdr.record_size = record_size;
         file_hdr.num_pages = 1;
         file_hdr.first_free_page_no = RM_NO_PAGE;
@@ -68,7 +70,12 @@ class RmManager {
      */
     std::unique_ptr<RmFileHandle> open_file(const std::string& filename) {
         int fd = disk_manager_->open_file(filename);
-        return std::make_unique<RmFileHandle>(disk_manager_, buffer_pool_manager_, fd);
+        try {
+            return std::make_unique<RmFileHandle>(disk_manager_, buffer_pool_manager_, fd);
+        } catch (RMDBError &) {
+            disk_manager_->close_file(fd);
+            throw;
+        }
     }
     /**
      * @description: 关闭表的数据文件
@@ -12,62 +12,65 @@ See the Mulan PSL v2 for more details. */
 #include "rm_file_handle.h"
 
 /**
- * @brief 初始化file_handle和rid
- * @param file_handle
+ * @description: 初始化file_handle和rid（指向第一个存放了记录的位置）
+ * @param {RmFileHandle*} file_handle 扫描的表文件
+ * @param {BufferAccessType} access_type 缓冲池访问策略，BULK_READ时只有超过缓冲池1/4的大表才使用私有的ring buffer，
+ *                                       小表仍使用默认策略，以便被其他查询复用
  */
-RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
-    // Todo:
-    // 初始化file_handle和rid（指向第一个存放了记录的位置）
-    if (file_handle->file_hdr_.num_pages > 1){
-        // 存了记录
-        RmPageHandle first_page_handle = file_handle_->fetch_page_handle(1);
-        rid_.page_no = 1;
-        rid_.slot_no = Bitmap::first_bit(1,first_page_handle.bitmap,file_handle->file_hdr_.num_records_per_page);
-    }
-    else{
-        // 没有记录
-        rid_.page_no = 0;
-        rid_.slot_no = -1; // TODO
+RmScan::RmScan(const RmFileHandle *file_handle, BufferAccessType access_type)
+    : file_handle_(file_handle),
+      strategy_(make_strategy(file_handle, access_type)),
+      read_ahead_(file_handle->buffer_pool_manager_, file_handle->fd_, strategy_.get()) {
+    rid_.page_no = RM_FIRST_RECORD_PAGE;
+    rid_.slot_no = -1;
+    next();
+}
+
+/**
+ * @description: 根据访问类型和表的大小选择扫描使用的访问策略
+ */
+std::unique_ptr<BufferAccessStrategy> RmScan::make_strategy(const RmFileHandle *file_handle,
+                                                            BufferAccessType access_type) {
+    BufferPoolManager *buffer_pool_manager = file_handle->buffer_pool_manager_;
+    if (access_type != BufferAccessType::NORMAL &&
+        static_cast<size_t>(file_handle->file_hdr_.num_pages) > buffer_pool_manager->get_pool_size() / 4) {
+        return buffer_pool_manager->get_access_strategy(access_type);
     }
+    return nullptr;
 }
 
 /**
- * @brief 找到文件中下一个存放了记录的位置
+ * @description: 找到文件中下一个存放了记录的非空闲位置，用rid_来指向这个位置；没有更多记录时rid_.page_no等于num_pages
  */
 void RmScan::next() {
-    // Todo:
-    // 找到文件中下一个存放了记录的非空闲位置，用rid_来指向这个位置
     int max_records = file_handle_->file_hdr_.num_records_per_page;
     int page_max = file_handle_->file_hdr_.num_pages;
-    RmPageHandle page_handle = file_handle_->fetch_page_handle(rid_.page_no);
-    rid_.slot_no = Bitmap::next_bit(1,page_handle.bitmap,max_records,rid_.slot_no);
-    
-    while(rid_.slot_no == max_records){
-        rid_.page_no++;
-        if(rid_.page_no >= page_max){
+    while (rid_.page_no < page_max) {
+        if (!page_handle_) {
+            read_ahead_.access(rid_.page_no, page_max);
+            // FSM页面不存放记录
+            if (RmFileHandle::is_fsm_page(rid_.page_no)) {
+                rid_.page_no++;
+                continue;
+            }
+            page_handle_.emplace(file_handle_->fetch_page_handle(rid_.page_no, strategy_.get()));
+        }
+        rid_.slot_no = Bitmap::next_bit(1, page_handle_->bitmap, max_records, rid_.slot_no);
+        if (rid_.slot_no < max_records) {
             return;
         }
-        page_handle = file_handle_->fetch_page_handle(rid_.page_no);
-        rid_.slot_no = Bitmap::first_bit(1,page_handle.bitmap,max_records);
+        // 当前页面已经扫描完，取消固定后进入下一页
+        page_handle_.reset();
+        rid_.page_no++;
+        rid_.slot_no = -1;
     }
-    // 考虑store page_handle，省去fetch开销
+    rid_.slot_no = max_records;
 }
 
-/**
- * @brief ​ 判断是否到达文件末尾
- */
 bool RmScan::is_end() const {
-    // Todo: 修改返回值
-    if(rid_.slot_no == file_handle_->file_hdr_.num_records_per_page \
-        && (rid_.page_no >= (file_handle_->file_hdr_.num_pages))){
-            return true;
-        }
-    return false;
+    return rid_.page_no >= file_handle_->file_hdr_.num_pages;
 }
 
-/**
- * @brief RmScan内部存放的rid
- */
 Rid RmScan::rid() const {
     return rid_;
-}
\ No newline at end of file
+}
@@ -10,19 +10,32 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
-#include "rm_defs.h"
+#include <memory>
+#include <optional>
 
-class RmFileHandle;
+#include "rm_file_handle.h"
+#include "storage/buffer_access_strategy.h"
+#include "storage/read_ahead.h"
 
 class RmScan : public RecScan {
     const RmFileHandle *file_handle_;
     Rid rid_;
+    std::optional<RmPageHandle> page_handle_;           // 当前rid_所在的页面，扫描期间保持固定，离开该页面时取消固定
+    std::unique_ptr<BufferAccessStrategy> strategy_;    // 扫描使用的缓冲池访问策略，为nullptr时使用默认策略
+    ReadAhead read_ahead_;                              // 顺序预读状态，扫描在其窗口之前异步读入后续页面
 public:
-    RmScan(const RmFileHandle *file_handle);
+    RmScan(const RmFileHandle *file_handle, BufferAccessType access_type = BufferAccessType::NORMAL);
+
+    RmScan(const RmScan &) = delete;
+    RmScan &operator=(const RmScan &) = delete;
 
     void next() override;
 
     bool is_end() const override;
 
     Rid rid() const override;
+
+private:
+    static std::unique_ptr<BufferAccessStrategy> make_strategy(const RmFileHandle *file_handle,
+                                                               BufferAccessType access_type);
 };
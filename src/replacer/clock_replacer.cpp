@@ -0,0 +1,71 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "clock_replacer.h"
+
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : ref_bits_(num_pages, 0), evictable_(num_pages, 0), max_size_(num_pages) {}
+
+/**
+ * @description: 使用CLOCK策略选择一个victim frame：时钟指针循环扫描可淘汰帧，
+ *               引用位为1的帧获得第二次机会(引用位清0)，遇到引用位为0的帧即将其淘汰
+ * @param {frame_id_t*} frame_id 被移除的frame的id
+ * @return {bool} 如果成功淘汰了一个页面则返回true，否则返回false
+ */
+bool ClockReplacer::victim(frame_id_t* frame_id) {
+    if (size_ == 0) {
+        return false;
+    }
+    // 最多扫描两圈：第一圈清除所有引用位，第二圈必然找到引用位为0的可淘汰帧
+    for (size_t step = 0; step < 2 * max_size_; ++step) {
+        size_t cur = hand_;
+        hand_ = (hand_ + 1 == max_size_) ? 0 : hand_ + 1;
+        if (!evictable_[cur]) {
+            continue;
+        }
+        if (ref_bits_[cur]) {
+            ref_bits_[cur] = 0;
+            continue;
+        }
+        evictable_[cur] = 0;
+        size_--;
+        *frame_id = static_cast<frame_id_t>(cur);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @description: 固定指定的frame，即该页面无法被淘汰
+ * @param {frame_id_t} frame_id 需要固定的frame的id
+ */
+void ClockReplacer::pin(frame_id_t frame_id) {
+    if (evictable_[frame_id]) {
+        evictable_[frame_id] = 0;
+        size_--;
+    }
+}
+
+/**
+ * @description: 取消固定一个frame，代表该页面可以被淘汰，同时设置其引用位
+ * @param {frame_id_t} frame_id 取消固定的frame的id
+ */
+void ClockReplacer::unpin(frame_id_t frame_id) {
+    ref_bits_[frame_id] = 1;
+    if (!evictable_[frame_id]) {
+        evictable_[frame_id] = 1;
+        size_++;
+    }
+}
+
+/**
+ * @description: 获取当前replacer中可以被淘汰的页面数量
+ */
+size_t ClockReplacer::Size() { return size_; }
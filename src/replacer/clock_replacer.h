@@ -0,0 +1,47 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/*
+ClockReplacer实现了CLOCK(second chance)替换策略。
+每个帧对应一个引用位和一个可淘汰标记，均在构造时一次性分配，victim/pin/unpin过程中不再申请内存。
+ClockReplacer本身不加锁，由调用者(缓冲池分区的latch)保证互斥访问。
+*/
+class ClockReplacer : public Replacer {
+   public:
+    /**
+     * @description: 创建一个新的ClockReplacer
+     * @param {size_t} num_pages ClockReplacer最多需要管理的帧数量，帧号范围为[0, num_pages)
+     */
+    explicit ClockReplacer(size_t num_pages);
+
+    ~ClockReplacer() = default;
+
+    bool victim(frame_id_t *frame_id);
+
+    void pin(frame_id_t frame_id);
+
+    void unpin(frame_id_t frame_id);
+
+    size_t Size();
+
+   private:
+    std::vector<uint8_t> ref_bits_;     // 每个帧的引用位，被访问后置1，时钟指针经过时清0
+    std::vector<uint8_t> evictable_;    // 每个帧是否处于unpinned状态（可被淘汰）
+    size_t hand_ = 0;                   // 时钟指针
+    size_t size_ = 0;                   // 当前可被淘汰的帧数量
+    size_t max_size_;                   // 最大容量（与缓冲池分区的帧数相同）
+};
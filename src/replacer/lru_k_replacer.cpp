@@ -0,0 +1,103 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : k_(k), history_(num_pages * k, 0), access_count_(num_pages, 0), pinned_(num_pages, 0), evictable_(num_pages, 0) {}
+
+/**
+ * @description: 记录一次对frame的访问
+ * @param {frame_id_t} frame_id 被访问的frame的id
+ */
+void LRUKReplacer::record_access(frame_id_t frame_id) {
+    history_[frame_id * k_ + access_count_[frame_id] % k_] = ++current_ts_;
+    access_count_[frame_id]++;
+}
+
+/**
+ * @description: 计算frame在cold_或hot_中的排序键
+ * @return {Entry} 访问次数不足K次时为最早一次访问时间，否则为第K近一次访问时间
+ * @param {frame_id_t} frame_id 目标frame的id
+ */
+LRUKReplacer::Entry LRUKReplacer::get_entry(frame_id_t frame_id) const {
+    uint64_t count = access_count_[frame_id];
+    // 访问次数达到K次时，下一个待写入的槽位恰好保存着第K近一次访问
+    size_t slot = count < k_ ? 0 : count % k_;
+    return {history_[frame_id * k_ + slot], frame_id};
+}
+
+/**
+ * @description: 使用LRU-K策略删除一个victim frame，并返回该frame的id
+ * @param {frame_id_t*} frame_id 被移除的frame的id
+ * @return {bool} 如果成功淘汰了一个页面则返回true，否则返回false
+ */
+bool LRUKReplacer::victim(frame_id_t* frame_id) {
+    std::set<Entry> &candidates = cold_.empty() ? hot_ : cold_;
+    if (candidates.empty()) {
+        return false;
+    }
+    *frame_id = candidates.begin()->second;
+    candidates.erase(candidates.begin());
+    // 帧将装入新的页面，清空其访问历史
+    evictable_[*frame_id] = 0;
+    access_count_[*frame_id] = 0;
+    return true;
+}
+
+/**
+ * @description: 固定指定的frame并记录一次访问；已处于固定状态的frame上的重复访问不再记录
+ * @param {frame_id_t} frame_id 需要固定的frame的id
+ */
+void LRUKReplacer::pin(frame_id_t frame_id) {
+    if (evictable_[frame_id]) {
+        (access_count_[frame_id] < k_ ? cold_ : hot_).erase(get_entry(frame_id));
+        evictable_[frame_id] = 0;
+    }
+    if (!pinned_[frame_id]) {
+        pinned_[frame_id] = 1;
+        record_access(frame_id);
+    }
+}
+
+/**
+ * @description: 取消固定一个frame，代表该页面可以被淘汰
+ * @param {frame_id_t} frame_id 取消固定的frame的id
+ */
+void LRUKReplacer::unpin(frame_id_t frame_id) {
+    pinned_[frame_id] = 0;
+    if (evictable_[frame_id]) {
+        return;
+    }
+    // 未经pin直接加入的frame没有访问历史，将本次unpin视为一次访问
+    if (access_count_[frame_id] == 0) {
+        record_access(frame_id);
+    }
+    evictable_[frame_id] = 1;
+    (access_count_[frame_id] < k_ ? cold_ : hot_).insert(get_entry(frame_id));
+}
+
+/**
+ * @description: 移除一个frame并清空其访问历史，用于页面被删除时
+ * @param {frame_id_t} frame_id 需要移除的frame的id
+ */
+void LRUKReplacer::remove(frame_id_t frame_id) {
+    if (evictable_[frame_id]) {
+        (access_count_[frame_id] < k_ ? cold_ : hot_).erase(get_entry(frame_id));
+        evictable_[frame_id] = 0;
+    }
+    pinned_[frame_id] = 0;
+    access_count_[frame_id] = 0;
+}
+
+/**
+ * @description: 获取当前replacer中可以被淘汰的页面数量
+ */
+size_t LRUKReplacer::Size() { return cold_.size() + hot_.size(); }
@@ -0,0 +1,63 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/*
+LRUKReplacer实现了LRU-K替换策略。
+淘汰时优先选择历史访问次数不足K次的帧(向后K距离为+inf)，它们之间按最早一次访问的时间淘汰；
+否则选择第K近一次访问时间最早的帧。只被顺序扫描访问一次的页面因此会先于热点页面被淘汰。
+帧被固定期间的重复访问视为相关访问(correlated reference)，只记录一次。
+LRUKReplacer本身不加锁，由调用者(缓冲池分区的latch)保证互斥访问。
+*/
+class LRUKReplacer : public Replacer {
+   public:
+    /**
+     * @description: 创建一个新的LRUKReplacer
+     * @param {size_t} num_pages LRUKReplacer最多需要管理的帧数量，帧号范围为[0, num_pages)
+     * @param {size_t} k 计算向后K距离使用的访问次数
+     */
+    explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+    ~LRUKReplacer() = default;
+
+    bool victim(frame_id_t *frame_id);
+
+    void pin(frame_id_t frame_id);
+
+    void unpin(frame_id_t frame_id);
+
+    void remove(frame_id_t frame_id);
+
+    size_t Size();
+
+   private:
+    using Entry = std::pair<uint64_t, frame_id_t>;     // <排序时间戳, 帧号>
+
+    void record_access(frame_id_t frame_id);
+
+    Entry get_entry(frame_id_t frame_id) const;
+
+    size_t k_;                              // K值
+    uint64_t current_ts_ = 0;               // 逻辑时钟，每次访问自增
+    std::vector<uint64_t> history_;         // 每个帧最近K次访问的时间戳，按帧号连续存放，每帧K个槽位循环使用
+    std::vector<uint64_t> access_count_;    // 每个帧被记录的访问次数
+    std::vector<uint8_t> pinned_;           // 帧是否处于固定状态，用于识别相关访问
+    std::vector<uint8_t> evictable_;        // 帧是否处于unpinned状态（可被淘汰）
+    std::set<Entry> cold_;                  // 访问次数不足K次的可淘汰帧，按最早访问时间排序
+    std::set<Entry> hot_;                   // 访问次数达到K次的可淘汰帧，按第K近访问时间排序
+};
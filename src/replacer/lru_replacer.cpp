@@ -49,9 +49,10 @@ void LRUReplacer::pin(frame_id_t frame_id) {
     // Todo:
     // 固定指定id的frame
     // 在数据结构中移除该frame
-    if(std::find(LRUlist_.begin(), LRUlist_.end(), frame_id) != LRUlist_.end()){
-        LRUlist_.erase(LRUhash_[frame_id]);
-        LRUhash_.erase(frame_id);
+    auto iter = LRUhash_.find(frame_id);
+    if(iter != LRUhash_.end()){
+        LRUlist_.erase(iter->second);
+        LRUhash_.erase(iter);
     }
     return;
 }
@@ -65,16 +66,11 @@ void LRUReplacer::unpin(frame_id_t frame_id) {
     //  支持并发锁
     //  选择一个frame取消固定
 
-    // std::scoped_lock lock{latch_}; //悲观锁
+    std::scoped_lock lock{latch_};
 
-    if(std::find(LRUlist_.begin(), LRUlist_.end(), frame_id) == LRUlist_.end()){
+    if(LRUhash_.find(frame_id) == LRUhash_.end()){
         // 如果该frame已经是unpin状态，就不需要再更新
-        std::list<frame_id_t>::iterator it;
-        {
-            std::unique_lock<std::mutex> lock(latch_);
-            it = LRUlist_.insert(LRUlist_.begin(), frame_id);
-            LRUhash_[frame_id] = it;
-        }
+        LRUhash_[frame_id] = LRUlist_.insert(LRUlist_.begin(), frame_id);
     }
     return ;
 }
@@ -82,4 +78,7 @@ void LRUReplacer::unpin(frame_id_t frame_id) {
 /**
  * @description: 获取当前replacer中可以被淘汰的页面数量
  */
-size_t LRUReplacer::Size() { return LRUlist_.size(); }
+size_t LRUReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return LRUlist_.size();
+}
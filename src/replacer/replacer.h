@@ -39,6 +39,12 @@ class Replacer {
      */
     virtual void unpin(frame_id_t frame_id) = 0;
 
+    /**
+     * Removes a frame together with its access history, e.g. when its page is deleted from the buffer pool.
+     * @param frame_id the id of the frame to remove
+     */
+    virtual void remove(frame_id_t frame_id) { pin(frame_id); }
+
     /** @return the number of elements in the replacer that can be victimized */
     virtual size_t Size() = 0;
 };
@@ -0,0 +1,97 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "two_q_replacer.h"
+
+TwoQReplacer::TwoQReplacer(size_t num_pages)
+    : iters_(num_pages),
+      queue_(num_pages, FrameQueue::NONE),
+      pinned_(num_pages, 0),
+      evictable_(num_pages, 0),
+      a1_max_size_(static_cast<size_t>(num_pages * TWOQ_A1_RATIO)) {}
+
+/**
+ * @description: 将可淘汰的frame从其所在队列中移除
+ * @param {frame_id_t} frame_id 目标frame的id
+ */
+void TwoQReplacer::erase_evictable(frame_id_t frame_id) {
+    if (!evictable_[frame_id]) {
+        return;
+    }
+    (queue_[frame_id] == FrameQueue::AM ? am_list_ : a1_list_).erase(iters_[frame_id]);
+    evictable_[frame_id] = 0;
+}
+
+/**
+ * @description: 使用2Q策略删除一个victim frame：A1队列过长或Am队列为空时淘汰A1首部，否则淘汰Am首部
+ * @param {frame_id_t*} frame_id 被移除的frame的id
+ * @return {bool} 如果成功淘汰了一个页面则返回true，否则返回false
+ */
+bool TwoQReplacer::victim(frame_id_t* frame_id) {
+    std::list<frame_id_t> *candidates;
+    if (!a1_list_.empty() && (a1_list_.size() > a1_max_size_ || am_list_.empty())) {
+        candidates = &a1_list_;
+    } else if (!am_list_.empty()) {
+        candidates = &am_list_;
+    } else {
+        return false;
+    }
+    *frame_id = candidates->front();
+    candidates->pop_front();
+    evictable_[*frame_id] = 0;
+    queue_[*frame_id] = FrameQueue::NONE;
+    return true;
+}
+
+/**
+ * @description: 固定指定的frame并记录一次访问：首次访问进入A1，再次访问晋升到Am；
+ *               已处于固定状态的frame上的重复访问视为相关访问，不会引起晋升
+ * @param {frame_id_t} frame_id 需要固定的frame的id
+ */
+void TwoQReplacer::pin(frame_id_t frame_id) {
+    erase_evictable(frame_id);
+    if (pinned_[frame_id]) {
+        return;
+    }
+    pinned_[frame_id] = 1;
+    queue_[frame_id] = queue_[frame_id] == FrameQueue::NONE ? FrameQueue::A1 : FrameQueue::AM;
+}
+
+/**
+ * @description: 取消固定一个frame，将其加入所属队列的尾部
+ * @param {frame_id_t} frame_id 取消固定的frame的id
+ */
+void TwoQReplacer::unpin(frame_id_t frame_id) {
+    pinned_[frame_id] = 0;
+    if (evictable_[frame_id]) {
+        return;
+    }
+    if (queue_[frame_id] == FrameQueue::NONE) {
+        queue_[frame_id] = FrameQueue::A1;
+    }
+    std::list<frame_id_t> &list = queue_[frame_id] == FrameQueue::AM ? am_list_ : a1_list_;
+    iters_[frame_id] = list.insert(list.end(), frame_id);
+    evictable_[frame_id] = 1;
+}
+
+/**
+ * @description: 移除一个frame并清空其访问历史，用于页面被删除时
+ * @param {frame_id_t} frame_id 需要移除的frame的id
+ */
+void TwoQReplacer::remove(frame_id_t frame_id) {
+    erase_evictable(frame_id);
+    pinned_[frame_id] = 0;
+    queue_[frame_id] = FrameQueue::NONE;
+}
+
+/**
+ * @description: 获取当前replacer中可以被淘汰的页面数量
+ */
+size_t TwoQReplacer::Size() { return a1_list_.size() + am_list_.size(); }
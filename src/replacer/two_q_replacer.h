@@ -0,0 +1,59 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <list>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/*
+TwoQReplacer实现了简化的2Q替换策略。
+第一次被访问的帧进入A1队列(FIFO)，在unpin之后再次被访问的帧晋升到Am队列(LRU)。
+A1队列的长度超过容量的TWOQ_A1_RATIO时优先从A1淘汰，因此一次性的顺序扫描只会在A1中轮转，不会冲掉Am中的热点页面。
+Replacer只感知帧号而不感知页面号，因此不维护原始2Q中记录已淘汰页面号的A1out队列。
+TwoQReplacer本身不加锁，由调用者(缓冲池分区的latch)保证互斥访问。
+*/
+class TwoQReplacer : public Replacer {
+   public:
+    /**
+     * @description: 创建一个新的TwoQReplacer
+     * @param {size_t} num_pages TwoQReplacer最多需要管理的帧数量，帧号范围为[0, num_pages)
+     */
+    explicit TwoQReplacer(size_t num_pages);
+
+    ~TwoQReplacer() = default;
+
+    bool victim(frame_id_t *frame_id);
+
+    void pin(frame_id_t frame_id);
+
+    void unpin(frame_id_t frame_id);
+
+    void remove(frame_id_t frame_id);
+
+    size_t Size();
+
+   private:
+    /* 帧所属的队列 */
+    enum class FrameQueue : uint8_t { NONE, A1, AM };
+
+    void erase_evictable(frame_id_t frame_id);
+
+    std::list<frame_id_t> a1_list_;     // 只被访问过一次的可淘汰帧，首部为最早加入的帧
+    std::list<frame_id_t> am_list_;     // 被多次访问的可淘汰帧，首部为最久未被访问的帧
+    std::vector<std::list<frame_id_t>::iterator> iters_;    // 可淘汰帧在所属队列中的位置
+    std::vector<FrameQueue> queue_;     // 每个帧所属的队列，NONE表示尚未被访问
+    std::vector<uint8_t> pinned_;       // 帧是否处于固定状态，用于识别相关访问
+    std::vector<uint8_t> evictable_;    // 帧是否处于unpinned状态（可被淘汰）
+    size_t a1_max_size_;                // A1队列的目标长度
+};
@@ -264,9 +264,9 @@ void start_server() {
 }
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    if (argc < 2) {
         // 需要指定数据库名称
-        std::cerr << "Usage: " << argv[0] << " <database>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <database> [--replacer=LRU|CLOCK|LRU-K|2Q] [--io=pread|io_uring]" << std::endl;
         exit(1);
     }
 
@@ -285,6 +285,30 @@ int main(int argc, char **argv) {
                      "\n";
         // Database name is passed by args
         std::string db_name = argv[1];
+        // 服务端参数，需在打开数据库之前设置
+        std::string io_backend = IO_BACKEND;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--replacer=", 0) == 0) {
+                buffer_pool_manager->set_replacer(arg.substr(strlen("--replacer=")));
+            } else if (arg.rfind("--io=", 0) == 0) {
+                io_backend = arg.substr(strlen("--io="));
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                exit(1);
+            }
+        }
+        // 内核不支持或禁止io_uring时退回pread后端
+        try {
+            disk_manager->set_io_backend(io_backend);
+        } catch (UnixError &e) {
+            std::cerr << "io_uring is unavailable (" << e.what() << "), falling back to pread" << std::endl;
+            disk_manager->set_io_backend("pread");
+        }
+        // 启动后台刷盘线程，脏页在后台按页号顺序写回
+        buffer_pool_manager->start_flusher();
+        // 启动后台预读线程，顺序扫描在游标之前异步读入后续页面
+        buffer_pool_manager->start_prefetcher();
         if (!sm_manager->is_dir(db_name)) {
             // Database not found, create a new one
             sm_manager->create_db(db_name);
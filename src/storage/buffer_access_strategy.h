@@ -0,0 +1,53 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "page.h"
+
+/* 缓冲池访问策略的类型 */
+enum class BufferAccessType { NORMAL, BULK_READ };
+
+/**
+ * @description: 缓冲池访问策略(ring buffer)。大表的顺序扫描等批量读取只在一个很小的私有帧环中循环复用帧，
+ * 避免一次性读入的页面冲掉缓冲池中其他查询的热点页面。
+ * 帧只能装入属于其分区的页面，因此环按缓冲池分区划分，每个分区各有一段槽位。
+ * 策略对象只能被一个扫描(线程)使用，由BufferPoolManager在对应分区latch的保护下访问。
+ */
+class BufferAccessStrategy {
+    friend class BufferPoolManager;
+
+   public:
+    /**
+     * @description: 创建访问策略
+     * @param {size_t} partition_num 缓冲池的分区个数
+     * @param {size_t} ring_size 环的总帧数，均分到各个分区，每个分区至少一个槽位
+     */
+    BufferAccessStrategy(size_t partition_num, size_t ring_size) : rings_(partition_num) {
+        size_t slot_num = std::max((ring_size + partition_num - 1) / partition_num, static_cast<size_t>(1));
+        for (auto &ring : rings_) {
+            ring.slots_.assign(slot_num, {INVALID_FRAME_ID, PageId{}});
+        }
+    }
+
+   private:
+    /* 一个分区内的环，每个槽位记录通过该策略读入的帧及其装入的页面 */
+    struct Ring {
+        std::vector<std::pair<frame_id_t, PageId>> slots_;
+        size_t cur_ = 0;    // 下一次读入页面时优先复用的槽位
+    };
+
+    std::vector<Ring> rings_;   // 每个分区一个环
+};
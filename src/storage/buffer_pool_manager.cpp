@@ -11,90 +11,280 @@ See the Mulan PSL v2 for more details. */
 #include "buffer_pool_manager.h"
 
 /**
- * @description: 从free_list或replacer中得到可淘汰帧页的 *frame_id
+ * @description: 根据名称创建置换器
+ * @return {Replacer*} 新建的置换器，由调用者负责释放
+ * @param {string&} replacer_type 置换策略名称，可选"LRU"、"CLOCK"、"LRU-K"、"2Q"
+ * @param {size_t} num_pages 置换器管理的帧数量
+ */
+Replacer *BufferPoolManager::create_replacer(const std::string &replacer_type, size_t num_pages) {
+    if (replacer_type == "LRU") {
+        return new LRUReplacer(num_pages);
+    } else if (replacer_type == "CLOCK") {
+        return new ClockReplacer(num_pages);
+    } else if (replacer_type == "LRU-K") {
+        return new LRUKReplacer(num_pages);
+    } else if (replacer_type == "2Q") {
+        return new TwoQReplacer(num_pages);
+    }
+    throw InternalError("BufferPoolManager::create_replacer: unknown replacer type " + replacer_type);
+}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, const std::string &replacer_type)
+    : pool_size_(pool_size), disk_manager_(disk_manager) {
+    // 为buffer pool分配一块连续的内存空间
+    pages_ = new Page[pool_size_];
+    // 每个分区至少BUFFER_POOL_PARTITION_MIN_SIZE个帧，避免小缓冲池被切分得过碎
+    partition_num_ = std::min(pool_size_ / BUFFER_POOL_PARTITION_MIN_SIZE, static_cast<size_t>(BUFFER_POOL_PARTITIONS));
+    partition_num_ = std::max(partition_num_, static_cast<size_t>(1));
+    partitions_ = new BufferPoolPartition[partition_num_];
+    // 将帧按连续区间均分到各个分区，余数分给前面的分区
+    frame_id_t frame_begin = 0;
+    for (size_t i = 0; i < partition_num_; ++i) {
+        BufferPoolPartition &part = partitions_[i];
+        part.frame_begin_ = frame_begin;
+        part.frame_num_ = pool_size_ / partition_num_ + (i < pool_size_ % partition_num_ ? 1 : 0);
+        part.replacer_ = create_replacer(replacer_type, part.frame_num_);
+        // 初始化时，分区内所有的page都在free_list_中
+        for (size_t j = 0; j < part.frame_num_; ++j) {
+            part.free_list_.emplace_back(static_cast<frame_id_t>(frame_begin + j));
+        }
+        frame_begin += static_cast<frame_id_t>(part.frame_num_);
+    }
+}
+
+BufferPoolManager::~BufferPoolManager() {
+    stop_prefetcher();
+    stop_flusher();
+    for (size_t i = 0; i < partition_num_; ++i) {
+        delete partitions_[i].replacer_;
+    }
+    delete[] partitions_;
+    delete[] pages_;
+}
+
+/**
+ * @description: 更换所有分区的置换策略，只能在缓冲池中尚未缓存任何页面时调用(如服务启动时根据参数设置)
+ * @param {string&} replacer_type 置换策略名称，可选"LRU"、"CLOCK"、"LRU-K"、"2Q"
+ */
+void BufferPoolManager::set_replacer(const std::string &replacer_type) {
+    for (size_t i = 0; i < partition_num_; ++i) {
+        BufferPoolPartition &part = partitions_[i];
+        std::scoped_lock lock{part.latch_};
+        if (part.free_list_.size() != part.frame_num_) {
+            throw InternalError("BufferPoolManager::set_replacer: buffer pool is in use");
+        }
+        Replacer *replacer = create_replacer(replacer_type, part.frame_num_);
+        delete part.replacer_;
+        part.replacer_ = replacer;
+    }
+}
+
+/**
+ * @description: 获取指定类型的缓冲池访问策略
+ * @return {unique_ptr<BufferAccessStrategy>} 访问策略，NORMAL类型返回nullptr，即使用缓冲池的默认置换策略
+ * @param {BufferAccessType} type 访问策略的类型
+ */
+std::unique_ptr<BufferAccessStrategy> BufferPoolManager::get_access_strategy(BufferAccessType type) {
+    switch (type) {
+        case BufferAccessType::BULK_READ:
+            // 环中额外留出一个预读窗口，已预读但尚未被扫描访问的页面不会被环复用
+            return std::make_unique<BufferAccessStrategy>(partition_num_, BULK_READ_RING_SIZE + PREFETCH_MAX_PAGES);
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * @description: 从分区的free_list或replacer中得到可淘汰帧页的 *frame_id。
+ *              若指定了访问策略的环，则优先复用环中当前槽位的帧。
+ *              若被淘汰的是脏页，则在释放分区latch的情况下将其写回磁盘，写回期间该帧标记为io_in_progress_。
+ *              返回时该帧已从页表中移除，且不在free_list和replacer中，由调用者独占。
  * @return {bool} true: 可替换帧查找成功 , false: 可替换帧查找失败
+ * @param {BufferPoolPartition&} part 目标分区
+ * @param {unique_lock&} lock 已持有的分区latch，写回脏页时会临时释放
  * @param {frame_id_t*} frame_id 帧页id指针,返回成功找到的可替换帧id
+ * @param {Ring*} ring 访问策略在该分区中的环，为nullptr时使用默认策略
  */
-bool BufferPoolManager::find_victim_page(frame_id_t* frame_id) {
-    // Todo:
-    // 1 使用BufferPoolManager::free_list_判断缓冲池是否已满需要淘汰页面
-    // 1.1 未满获得frame
-    // 1.2 已满使用lru_replacer中的方法选择淘汰页面
-    if(free_list_.empty()){
-        // 已满，淘汰界面
-        return replacer_->victim(frame_id);
-    }
-    else{
-        *frame_id = free_list_.front();
-        free_list_.pop_front();
+bool BufferPoolManager::find_victim_page(BufferPoolPartition &part, std::unique_lock<std::mutex> &lock,
+                                         frame_id_t* frame_id, BufferAccessStrategy::Ring *ring) {
+    while (true) {
+        frame_id_t victim_frame_id = INVALID_FRAME_ID;
+        // 0 环中当前槽位的帧仍装着之前经该策略读入的页面且未被固定，则直接复用，不再占用缓冲池中的其他帧
+        if (ring != nullptr) {
+            auto &slot = ring->slots_[ring->cur_];
+            if (slot.first != INVALID_FRAME_ID) {
+                Page *page = pages_ + slot.first;
+                if (page->id_ == slot.second && page->pin_count_ == 0 && !page->io_in_progress_) {
+                    part.replacer_->remove(slot.first - part.frame_begin_);
+                    victim_frame_id = slot.first;
+                }
+            }
+        }
+        if (victim_frame_id == INVALID_FRAME_ID) {
+            // 1 分区未满，直接从free_list_中获得frame
+            if (!part.free_list_.empty()) {
+                *frame_id = part.free_list_.front();
+                part.free_list_.pop_front();
+                return true;
+            }
+            // 2 分区已满，使用replacer选择淘汰页面
+            frame_id_t local_frame_id;
+            if (!part.replacer_->victim(&local_frame_id)) {
+                return false;
+            }
+            victim_frame_id = part.frame_begin_ + local_frame_id;
+        }
+        frame_id_t local_frame_id = victim_frame_id - part.frame_begin_;
+        Page *page = pages_ + victim_frame_id;
+        // 后台刷盘线程正在写回该页面，等待其完成；期间页面被重新固定则放弃该帧
+        if (page->io_in_progress_) {
+            wait_for_io(part, lock, page);
+            if (page->pin_count_ > 0) {
+                continue;
+            }
+        }
+        // 3 脏页在latch之外写回磁盘，写回期间页面仍留在页表中，并发的fetch_page会固定它并等待I/O完成
+        if (page->is_dirty_) {
+            page->io_in_progress_ = true;
+            PageId old_page_id = page->id_;
+            lock.unlock();
+            try {
+                disk_manager_->write_page(old_page_id.fd, old_page_id.page_no, page->data_, PAGE_SIZE);
+            } catch (...) {
+                lock.lock();
+                page->io_in_progress_ = false;
+                if (page->pin_count_ == 0) {
+                    part.replacer_->unpin(local_frame_id);
+                }
+                part.io_cv_.notify_all();
+                throw;
+            }
+            lock.lock();
+            page->io_in_progress_ = false;
+            clear_dirty(part, page);
+            part.io_cv_.notify_all();
+            // 前台线程不得不自己写回脏页，说明后台刷盘跟不上，唤醒刷盘线程
+            if (flusher_running_) {
+                {
+                    std::scoped_lock flusher_lock{flusher_latch_};
+                    flush_requested_ = true;
+                }
+                flusher_cv_.notify_one();
+            }
+            // 写回期间页面被重新固定，放弃该帧，由最后一个unpin的线程将其交还replacer
+            if (page->pin_count_ > 0) {
+                continue;
+            }
+        }
+        part.page_table_.erase(page->id_);
+        page->id_.page_no = INVALID_PAGE_ID;
+        *frame_id = victim_frame_id;
         return true;
     }
 }
 
 /**
- * @description: 更新页面数据, 如果为脏页则需写入磁盘，再更新为新页面，更新page元数据(data, is_dirty, page_id)和page table
- * @param {Page*} page 写回页指针
- * @param {PageId} new_page_id 新的page_id
- * @param {frame_id_t} new_frame_id 新的帧frame_id
+ * @description: 将一个未映射到任何页面的帧归还给分区的free_list
+ * @param {BufferPoolPartition&} part 帧所在的分区
+ * @param {frame_id_t} frame_id 归还的帧
  */
-void BufferPoolManager::update_page(Page *page, PageId new_page_id, frame_id_t new_frame_id) {
-    // Todo:
-    // 1 如果是脏页，写回磁盘，并且把dirty置为false
-    // 2 更新page table
-    // 3 重置page的data，更新page id
-    if(page->is_dirty()){
-        disk_manager_->write_page(page->get_page_id().fd,page->get_page_id().page_no,page->get_data(),PAGE_SIZE);
-        page->is_dirty_ = false;
-        page->pin_count_ = 0;
-    }
-    page_table_.erase(page->get_page_id());
-    page_table_[new_page_id] = new_frame_id;
-    
-    page->reset_memory();
-    pages_[new_frame_id].id_ = new_page_id;
-    pages_[new_frame_id].is_dirty_ = false;
-    pages_[new_frame_id].pin_count_ = 0;
-    return;
+void BufferPoolManager::release_frame(BufferPoolPartition &part, frame_id_t frame_id) {
+    Page *page = pages_ + frame_id;
+    page->id_.page_no = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    page->pin_count_ = 0;
+    part.free_list_.push_front(frame_id);
+}
+
+/**
+ * @description: 等待帧上正在进行的I/O完成，调用者需持有分区latch
+ * @param {BufferPoolPartition&} part 帧所在的分区
+ * @param {unique_lock&} lock 已持有的分区latch
+ * @param {Page*} page 目标帧
+ */
+void BufferPoolManager::wait_for_io(BufferPoolPartition &part, std::unique_lock<std::mutex> &lock, Page *page) {
+    part.io_cv_.wait(lock, [page] { return !page->io_in_progress_; });
 }
 
 /**
  * @description: 从buffer pool获取需要的页。
  *              如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。
  *              如果页表不存在page_id（说明该page在磁盘中），则找缓冲池victim page，将其替换为磁盘中读取的page，pin_count置1。
+ *              磁盘读在分区latch之外进行，读入期间到达的其他线程固定该帧并等待读入完成。
+ *              指定访问策略时，未命中的页面只在策略的私有环中读入，命中的页面不受影响。
  * @return {Page*} 若获得了需要的页则将其返回，否则返回nullptr
  * @param {PageId} page_id 需要获取的页的PageId
+ * @param {BufferAccessStrategy*} strategy 访问策略，为nullptr时使用默认策略
  */
-Page* BufferPoolManager::fetch_page(PageId page_id) {
-    std::scoped_lock lock{latch_}; 
-    //Todo:
-    // 1.     从page_table_中搜寻目标页
-    // 1.1    若目标页有被page_table_记录，则将其所在frame固定(pin)，并返回目标页。
-    // 1.2    否则，尝试调用find_victim_page获得一个可用的frame，若失败则返回nullptr
-    frame_id_t frame_id;
-    if(page_table_.find(page_id) != page_table_.end()){
-        frame_id = page_table_[page_id];
-        replacer_->pin(frame_id);
-        pages_[frame_id].pin_count_++;
-        return (pages_+frame_id);
-    }
-    if(!find_victim_page(&frame_id)){
-        return nullptr;
-    }
-    Page* objPage = pages_ + frame_id;
-    // 2.     若获得的可用frame存储的为dirty page，则须调用updata_page将page写回到磁盘
-    // if(objPage->is_dirty()){
-    // 这个判定加上的话会在LINE260随机报错
-    // update_page里有dirty判定，要注意的是不管怎么样都应该给这个page重新分配page_id和frame_id
-    update_page(objPage,page_id,frame_id);
-    // }
-    // 3.     调用disk_manager_的read_page读取目标页到frame
-    disk_manager_->read_page(page_id.fd,page_id.page_no,objPage->get_data(),PAGE_SIZE);
-
-    // 4.     固定目标页，更新pin_count_
-    replacer_->pin(frame_id);
-    objPage->pin_count_++;
-    // 5.     返回目标页
-    return objPage;
+Page* BufferPoolManager::fetch_page(PageId page_id, BufferAccessStrategy *strategy) {
+    size_t partition_no = get_partition_no(page_id);
+    BufferPoolPartition &part = partitions_[partition_no];
+    BufferAccessStrategy::Ring *ring = strategy != nullptr ? &strategy->rings_[partition_no] : nullptr;
+    std::unique_lock<std::mutex> lock{part.latch_};
+    while (true) {
+        // 1.     从page_table_中搜寻目标页，若存在则将其所在frame固定(pin)，等待可能正在进行的I/O后返回
+        auto iter = part.page_table_.find(page_id);
+        if (iter != part.page_table_.end()) {
+            frame_id_t frame_id = iter->second;
+            Page *page = pages_ + frame_id;
+            page->pin_count_++;
+            part.replacer_->pin(frame_id - part.frame_begin_);
+            if (page->io_in_progress_) {
+                wait_for_io(part, lock, page);
+                // 其他线程读入该页失败，帧已被解除映射
+                if (!(page->id_ == page_id)) {
+                    if (--page->pin_count_ == 0) {
+                        part.free_list_.push_front(frame_id);
+                    }
+                    continue;
+                }
+            }
+            return page;
+        }
+        // 2.     否则，尝试调用find_victim_page获得一个可用的frame，若失败则返回nullptr
+        frame_id_t frame_id;
+        if (!find_victim_page(part, lock, &frame_id, ring)) {
+            return nullptr;
+        }
+        // 写回脏页期间latch被释放过，目标页可能已被其他线程读入
+        if (part.page_table_.count(page_id)) {
+            release_frame(part, frame_id);
+            continue;
+        }
+        // 3.     建立映射并固定该帧，标记I/O进行中后在latch之外读取目标页
+        Page *page = pages_ + frame_id;
+        page->id_ = page_id;
+        page->is_dirty_ = false;
+        page->pin_count_ = 1;
+        page->io_in_progress_ = true;
+        part.page_table_[page_id] = frame_id;
+        part.replacer_->pin(frame_id - part.frame_begin_);
+        // 将该帧记入环的当前槽位，环转满一圈后再复用它
+        if (ring != nullptr) {
+            ring->slots_[ring->cur_] = {frame_id, page_id};
+            ring->cur_ = (ring->cur_ + 1) % ring->slots_.size();
+        }
+        lock.unlock();
+        try {
+            disk_manager_->read_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
+        } catch (...) {
+            lock.lock();
+            part.page_table_.erase(page_id);
+            page->id_.page_no = INVALID_PAGE_ID;
+            page->io_in_progress_ = false;
+            part.replacer_->remove(frame_id - part.frame_begin_);
+            if (--page->pin_count_ == 0) {
+                part.free_list_.push_front(frame_id);
+            }
+            part.io_cv_.notify_all();
+            throw;
+        }
+        lock.lock();
+        page->io_in_progress_ = false;
+        part.io_cv_.notify_all();
+        // 4.     返回目标页
+        return page;
+    }
 }
 
 /**
@@ -104,89 +294,123 @@ Page* BufferPoolManager::fetch_page(PageId page_id) {
  * @param {bool} is_dirty 若目标page应该被标记为dirty则为true，否则为false
  */
 bool BufferPoolManager::unpin_page(PageId page_id, bool is_dirty) {
-    // Todo:
-    // 0. lock latch
-    std::scoped_lock lock{latch_}; 
-    // 1. 尝试在page_table_中搜寻page_id对应的页P
-    // 1.1 P在页表中不存在 return false
-    // 1.2 P在页表中存在，获取其pin_count_
-    if(page_table_.find(page_id) == page_table_.end()){
+    BufferPoolPartition &part = get_partition(page_id);
+    std::scoped_lock lock{part.latch_};
+    // 1. 尝试在page_table_中搜寻page_id对应的页P，P在页表中不存在 return false
+    auto iter = part.page_table_.find(page_id);
+    if (iter == part.page_table_.end()) {
         return false;
     }
-    frame_id_t frame_id = page_table_[page_id];
-    int pin_count_ = pages_[frame_id].pin_count_;
+    frame_id_t frame_id = iter->second;
+    Page *page = pages_ + frame_id;
     // 2.1 若pin_count_已经等于0，则返回false
-    // 2.2 若pin_count_大于0，则pin_count_自减一
-    // 2.2.1 若自减后等于0，则调用replacer_的Unpin
-    if(pin_count_ <= 0){
+    // 2.2 若pin_count_大于0，则pin_count_自减一，若自减后等于0，则调用replacer_的Unpin
+    if (page->pin_count_ <= 0) {
         return false;
     }
-    else{
-        pages_[frame_id].pin_count_--;
-        if(pages_[frame_id].pin_count_ == 0){
-            replacer_->unpin(frame_id);
-        }
+    if (--page->pin_count_ == 0) {
+        part.replacer_->unpin(frame_id - part.frame_begin_);
+    }
+    // 3 根据参数is_dirty，更改P的is_dirty_；已经是脏页的不能被清除
+    if (is_dirty) {
+        set_dirty(part, page);
     }
-    // 3 根据参数is_dirty，更改P的is_dirty_
-    pages_[frame_id].is_dirty_ = is_dirty;
     return true;
 }
 
+/**
+ * @description: 获取页面并返回只读句柄，句柄析构时取消固定
+ * @return {ReadPageGuard} 页面句柄，缓冲池中没有可用帧时为空句柄
+ * @param {PageId} page_id 需要获取的页的PageId
+ * @param {BufferAccessStrategy*} strategy 访问策略，为nullptr时使用默认策略
+ */
+ReadPageGuard BufferPoolManager::fetch_page_read(PageId page_id, BufferAccessStrategy *strategy) {
+    Page *page = fetch_page(page_id, strategy);
+    return page == nullptr ? ReadPageGuard() : ReadPageGuard(this, page);
+}
+
+/**
+ * @description: 获取页面并返回读写句柄，句柄析构时取消固定，写过页面数据时标记为脏页
+ * @return {WritePageGuard} 页面句柄，缓冲池中没有可用帧时为空句柄
+ * @param {PageId} page_id 需要获取的页的PageId
+ */
+WritePageGuard BufferPoolManager::fetch_page_write(PageId page_id) {
+    Page *page = fetch_page(page_id);
+    return page == nullptr ? WritePageGuard() : WritePageGuard(this, page);
+}
+
+/**
+ * @description: 创建新页面并返回读写句柄，新页面总是脏页
+ * @return {WritePageGuard} 页面句柄，缓冲池中没有可用帧时为空句柄
+ * @param {PageId*} page_id 指定新页面所在的文件，调用后page_no为新页面的编号
+ */
+WritePageGuard BufferPoolManager::new_page_guarded(PageId *page_id) {
+    Page *page = new_page(page_id);
+    return page == nullptr ? WritePageGuard() : WritePageGuard(this, page);
+}
+
 /**
  * @description: 将目标页写回磁盘，不考虑当前页面是否正在被使用
  * @return {bool} 成功则返回true，否则返回false(只有page_table_中没有目标页时)
  * @param {PageId} page_id 目标页的page_id，不能为INVALID_PAGE_ID
  */
 bool BufferPoolManager::flush_page(PageId page_id) {
-    // Todo:
-    // 0. lock latch
-    std::scoped_lock lock{latch_}; 
-    // 1. 查找页表,尝试获取目标页P
-    // 1.1 目标页P没有被page_table_记录 ，返回false
-    if(page_table_.find(page_id) == page_table_.end()){
-        return false;
+    BufferPoolPartition &part = get_partition(page_id);
+    std::unique_lock<std::mutex> lock{part.latch_};
+    while (true) {
+        // 1. 查找页表,尝试获取目标页P，目标页P没有被page_table_记录 ，返回false
+        auto iter = part.page_table_.find(page_id);
+        if (iter == part.page_table_.end()) {
+            return false;
+        }
+        Page *page = pages_ + iter->second;
+        // 该帧正在读入或写回，等待完成后重新查找
+        if (page->io_in_progress_) {
+            wait_for_io(part, lock, page);
+            continue;
+        }
+        // 2. 无论P是否为脏都将其写回磁盘，并更新P的is_dirty_
+        disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
+        clear_dirty(part, page);
+        return true;
     }
-    frame_id_t frame_id = page_table_[page_id];
-    Page* page = pages_ + frame_id;
-    // 2. 无论P是否为脏都将其写回磁盘。
-    disk_manager_->write_page(page_id.fd,page_id.page_no,page->get_data(),PAGE_SIZE);
-    // 3. 更新P的is_dirty_
-    page->is_dirty_ = false;
-    return true;
 }
 
 /**
  * @description: 创建一个新的page，即从磁盘中移动一个新建的空page到缓冲池某个位置。
+ *              先根据文件下一个待分配的页号确定分区并取得可用帧，再分配页号；
+ *              页号被其他线程抢先分配时重试，获取帧失败时不会消耗页号。
  * @return {Page*} 返回新创建的page，若创建失败则返回nullptr
  * @param {PageId*} page_id 当成功创建一个新的page时存储其page_id
  */
 Page* BufferPoolManager::new_page(PageId* page_id) {
-    std::scoped_lock lock{latch_}; 
-    // 1.   获得一个可用的frame，若无法获得则返回nullptr
-    frame_id_t frame_id;
-    if(!find_victim_page(&frame_id)){
-        return nullptr;
-    }
-    Page* page = pages_ + frame_id;
-    // 2.   在fd对应的文件分配一个新的page_id
-    page_id_t newPageNo = disk_manager_->allocate_page(page_id->fd);
-    page_id->page_no = newPageNo;
-
-    // 3.   将frame的数据写回磁盘
-    if(page->is_dirty()){
-        disk_manager_->write_page(page->get_page_id().fd,page->get_page_id().page_no,page->get_data(),PAGE_SIZE);
+    while (true) {
+        PageId new_page_id = {.fd = page_id->fd, .page_no = disk_manager_->get_fd2pageno(page_id->fd)};
+        BufferPoolPartition &part = get_partition(new_page_id);
+        std::unique_lock<std::mutex> lock{part.latch_};
+        // 1.   获得一个可用的frame，若无法获得则返回nullptr
+        frame_id_t frame_id;
+        if (!find_victim_page(part, lock, &frame_id)) {
+            return nullptr;
+        }
+        // 2.   在fd对应的文件分配新的page_id，若该页号已被其他线程分配则归还帧并重试
+        if (!disk_manager_->try_allocate_page(new_page_id.fd, new_page_id.page_no)) {
+            release_frame(part, frame_id);
+            continue;
+        }
+        // 3.   重置帧并建立映射，固定frame，更新pin_count_；新页面尚未写入磁盘，直接标记为脏页
+        Page *page = pages_ + frame_id;
+        page->reset_memory();
+        page->id_ = new_page_id;
         page->is_dirty_ = false;
-        page->pin_count_ = 0;
+        page->pin_count_ = 1;
+        part.page_table_[new_page_id] = frame_id;
+        part.replacer_->pin(frame_id - part.frame_begin_);
+        set_dirty(part, page);
+        *page_id = new_page_id;
+        // 4.   返回获得的page
+        return page;
     }
-    page->reset_memory();
-    page_table_.erase(page->get_page_id());
-    page_table_[*page_id] = frame_id;
-    page->id_ = *page_id;
-    // 4.   固定frame，更新pin_count_
-    replacer_->pin(frame_id);
-    page->pin_count_++;
-    // 5.   返回获得的page
-   return page;
 }
 
 /**
@@ -195,41 +419,361 @@ Page* BufferPoolManager::new_page(PageId* page_id) {
  * @param {PageId} page_id 目标页
  */
 bool BufferPoolManager::delete_page(PageId page_id) {
-    std::scoped_lock lock{latch_}; 
-    // 1.   在page_table_中查找目标页，若不存在返回true
-    if(page_table_.find(page_id) == page_table_.end()){
+    BufferPoolPartition &part = get_partition(page_id);
+    std::unique_lock<std::mutex> lock{part.latch_};
+    while (true) {
+        // 1.   在page_table_中查找目标页，若不存在返回true
+        auto iter = part.page_table_.find(page_id);
+        if (iter == part.page_table_.end()) {
+            return true;
+        }
+        frame_id_t frame_id = iter->second;
+        Page *page = pages_ + frame_id;
+        if (page->io_in_progress_) {
+            wait_for_io(part, lock, page);
+            continue;
+        }
+        // 2.   若目标页的pin_count不为0，则返回false
+        if (page->pin_count_ != 0) {
+            return false;
+        }
+        // 3.   脏页写回磁盘，从页表和replacer中删除目标页，重置其元数据，将其加入free_list_，返回true
+        if (page->is_dirty_) {
+            disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
+            clear_dirty(part, page);
+        }
+        part.page_table_.erase(iter);
+        part.replacer_->remove(frame_id - part.frame_begin_);
+        page->reset_memory();
+        release_frame(part, frame_id);
         return true;
     }
-    frame_id_t frame_id = page_table_[page_id];
-    Page* page = pages_+frame_id;
-    // 2.   若目标页的pin_count不为0，则返回false
-    if(page->pin_count_ != 0){
-        return false;
-    }
-    // 3.   将目标页数据写回磁盘，从页表中删除目标页，重置其元数据，将其加入free_list_，返回true
-    disk_manager_->write_page(page->get_page_id().fd,page->get_page_id().page_no,page->get_data(),PAGE_SIZE);
-    page_table_.erase(page_id);
-    page->reset_memory();
-    page->is_dirty_ = false;
-    page->pin_count_ = 0;
-    page->id_.page_no = INVALID_PAGE_ID;
-    
-    free_list_.push_back(frame_id);
-    return true;
 }
 
 /**
- * @description: 将buffer_pool中的所有页写回到磁盘
+ * @description: 将buffer_pool中文件fd的所有脏页写回到磁盘，只遍历各分区的脏页集合，代价与脏页数成正比
+ * 未被固定的脏页在释放latch后批量写回，被固定的脏页仍在持有latch时逐个写回
  * @param {int} fd 文件句柄
  */
 void BufferPoolManager::flush_all_pages(int fd) {
-    std::scoped_lock lock{latch_}; 
-    Page* page;
-    for(size_t i = 0;i < pool_size_;i++){
-        page = pages_ + i;
-        if((page->get_page_id().fd == fd) && (page->get_page_id().page_no != INVALID_PAGE_ID)){
-            disk_manager_->write_page(fd,page->get_page_id().page_no,page->get_data(),PAGE_SIZE);
-            page->is_dirty_ = false;
+    for (size_t i = 0; i < partition_num_; ++i) {
+        BufferPoolPartition &part = partitions_[i];
+        std::vector<Page *> batch;
+        std::unique_lock<std::mutex> lock{part.latch_};
+        auto iter = part.dirty_pages_.lower_bound(PageId{fd, std::numeric_limits<page_id_t>::min()});
+        while (iter != part.dirty_pages_.end() && iter->fd == fd) {
+            PageId page_id = *iter;
+            Page *page = pages_ + part.page_table_.at(page_id);
+            ++iter;
+            if (page->io_in_progress_) {
+                // 已加入本批的页面在批量写回时处理，其他线程正在写回的页面等待I/O完成后重新查找
+                if (std::find(batch.begin(), batch.end(), page) != batch.end()) {
+                    continue;
+                }
+                wait_for_io(part, lock, page);
+                iter = part.dirty_pages_.lower_bound(page_id);
+                continue;
+            }
+            if (page->pin_count_ > 0) {
+                disk_manager_->write_page(fd, page_id.page_no, page->data_, PAGE_SIZE);
+                clear_dirty(part, page);
+                continue;
+            }
+            page->io_in_progress_ = true;
+            batch.push_back(page);
+        }
+        lock.unlock();
+        if (!batch.empty() && !write_batch(part, batch)) {
+            throw InternalError("BufferPoolManager::flush_all_pages Error");
+        }
+    }
+}
+
+/**
+ * @description: 将目标页面标记为脏页，调用者需持有该页面的pin
+ * @param {Page*} page 脏页
+ */
+void BufferPoolManager::mark_dirty(Page* page) {
+    BufferPoolPartition &part = get_partition(page->id_);
+    std::scoped_lock lock{part.latch_};
+    set_dirty(part, page);
+}
+
+/**
+ * @description: 将页面标记为脏页并加入分区的脏页集合，调用者需持有分区latch
+ * @param {BufferPoolPartition&} part 页面所在的分区
+ * @param {Page*} page 目标页面
+ */
+void BufferPoolManager::set_dirty(BufferPoolPartition &part, Page *page) {
+    if (!page->is_dirty_) {
+        page->is_dirty_ = true;
+        page->dirty_since_ = std::chrono::steady_clock::now();
+        part.dirty_pages_.insert(page->id_);
+    }
+}
+
+/**
+ * @description: 页面写回磁盘后清除脏页标记并移出分区的脏页集合，调用者需持有分区latch
+ * @param {BufferPoolPartition&} part 页面所在的分区
+ * @param {Page*} page 目标页面
+ */
+void BufferPoolManager::clear_dirty(BufferPoolPartition &part, Page *page) {
+    if (page->is_dirty_) {
+        page->is_dirty_ = false;
+        part.dirty_pages_.erase(page->id_);
+    }
+}
+
+/**
+ * @description: 启动后台刷盘线程
+ * @param {milliseconds} interval 两轮刷盘之间的间隔
+ * @param {milliseconds} dirty_age 脏页达到该年龄后被刷盘
+ */
+void BufferPoolManager::start_flusher(std::chrono::milliseconds interval, std::chrono::milliseconds dirty_age) {
+    if (flusher_running_) {
+        return;
+    }
+    flush_interval_ = interval;
+    dirty_age_ = dirty_age;
+    flusher_running_ = true;
+    flusher_ = std::thread(&BufferPoolManager::flusher_loop, this);
+}
+
+/**
+ * @description: 停止后台刷盘线程并等待其退出，未刷盘的脏页仍由flush_all_pages写回
+ */
+void BufferPoolManager::stop_flusher() {
+    {
+        std::scoped_lock lock{flusher_latch_};
+        if (!flusher_running_) {
+            return;
+        }
+        flusher_running_ = false;
+    }
+    flusher_cv_.notify_all();
+    flusher_.join();
+}
+
+/**
+ * @description: 后台刷盘线程的主循环，每隔flush_interval_依次处理各个分区；前台线程请求时提前开始下一轮
+ */
+void BufferPoolManager::flusher_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{flusher_latch_};
+            flusher_cv_.wait_for(lock, flush_interval_, [this] { return !flusher_running_ || flush_requested_; });
+            flush_requested_ = false;
+            if (!flusher_running_) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < partition_num_; ++i) {
+            flush_partition(partitions_[i]);
+        }
+    }
+}
+
+/**
+ * @description: 刷写一个分区中的脏页：年龄超过dirty_age_的脏页总是被刷写；
+ *              分区中干净帧数低于目标时，未到年龄的脏页也会被刷写以补足干净帧。
+ *              每轮最多刷写FLUSHER_BATCH_SIZE个未被固定的脏页，按(fd, page_no)顺序在分区latch之外写回，
+ *              写回期间页面标记为io_in_progress_，不会被淘汰或修改。
+ * @param {BufferPoolPartition&} part 目标分区
+ */
+void BufferPoolManager::flush_partition(BufferPoolPartition &part) {
+    std::vector<Page *> batch;
+    {
+        std::scoped_lock lock{part.latch_};
+        auto now = std::chrono::steady_clock::now();
+        size_t clean_target = static_cast<size_t>(part.frame_num_ * FLUSHER_CLEAN_RATIO);
+        size_t clean_num = part.frame_num_ - part.dirty_pages_.size();
+        size_t deficit = clean_num < clean_target ? clean_target - clean_num : 0;
+        for (const PageId &page_id : part.dirty_pages_) {
+            if (batch.size() >= static_cast<size_t>(FLUSHER_BATCH_SIZE)) {
+                break;
+            }
+            Page *page = pages_ + part.page_table_.at(page_id);
+            bool aged = now - page->dirty_since_ >= dirty_age_;
+            if ((!aged && deficit == 0) || page->pin_count_ > 0 || page->io_in_progress_) {
+                continue;
+            }
+            if (!aged) {
+                deficit--;
+            }
+            page->io_in_progress_ = true;
+            batch.push_back(page);
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+    // 脏页集合按PageId有序，批量写回时同一文件的相邻页面可以合并
+    write_batch(part, batch);
+}
+
+/**
+ * @description: 在不持有分区latch的情况下批量写回一组已设置io_in_progress_的页面，完成后清除I/O状态并唤醒等待者
+ * @param {BufferPoolPartition&} part 页面所在分区
+ * @param {vector<Page*>&} batch 待写回的页面
+ * @return {bool} 全部写回成功返回true
+ */
+bool BufferPoolManager::write_batch(BufferPoolPartition &part, const std::vector<Page *> &batch) {
+    std::vector<PageIoRequest> requests;
+    requests.reserve(batch.size());
+    for (Page *page : batch) {
+        requests.push_back({page->id_.fd, page->id_.page_no, page->data_});
+    }
+    try {
+        disk_manager_->write_pages_batch(requests);
+    } catch (RMDBError &e) {
+        std::cerr << "BufferPoolManager::write_batch: " << e.what() << std::endl;
+    }
+    bool all_written = true;
+    std::scoped_lock lock{part.latch_};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i]->io_in_progress_ = false;
+        // 写回失败的页面保持脏页状态，之后由前台淘汰、后台刷盘或flush_all_pages重试
+        if (requests[i].ok()) {
+            clear_dirty(part, batch[i]);
+        } else {
+            all_written = false;
+        }
+    }
+    part.io_cv_.notify_all();
+    return all_written;
+}
+
+/**
+ * @description: 预读文件中从first开始的count个页面。不在缓冲池中的页面被装入空闲或可淘汰的帧并标记io_in_progress_，
+ *              之后由后台预读线程批量读入，调用者不等待读入完成；预读线程未启动时在调用者线程中批量读入。
+ *              预读的页面不被固定，读入完成后交给replacer，随后的fetch_page命中它们或等待其读入完成。
+ * @param {PageId} first 第一个预读的页面
+ * @param {int} count 预读的页面个数，调用者需保证这些页面都已在文件中分配
+ * @param {BufferAccessStrategy*} strategy 访问策略，预读的页面与fetch_page一样只在策略的环中装入
+ */
+void BufferPoolManager::prefetch(PageId first, int count, BufferAccessStrategy *strategy) {
+    std::vector<Page *> batch;
+    for (int i = 0; i < count; ++i) {
+        PageId page_id = {first.fd, first.page_no + i};
+        size_t partition_no = get_partition_no(page_id);
+        BufferPoolPartition &part = partitions_[partition_no];
+        BufferAccessStrategy::Ring *ring = strategy != nullptr ? &strategy->rings_[partition_no] : nullptr;
+        std::unique_lock<std::mutex> lock{part.latch_};
+        if (part.page_table_.count(page_id)) {
+            continue;
+        }
+        frame_id_t frame_id;
+        if (!find_victim_page(part, lock, &frame_id, ring)) {
+            // 分区中所有帧都被固定，预读只是优化，直接放弃该页面
+            continue;
+        }
+        if (part.page_table_.count(page_id)) {
+            release_frame(part, frame_id);
+            continue;
+        }
+        Page *page = pages_ + frame_id;
+        page->id_ = page_id;
+        page->is_dirty_ = false;
+        page->pin_count_ = 0;
+        page->io_in_progress_ = true;
+        part.page_table_[page_id] = frame_id;
+        if (ring != nullptr) {
+            ring->slots_[ring->cur_] = {frame_id, page_id};
+            ring->cur_ = (ring->cur_ + 1) % ring->slots_.size();
+        }
+        batch.push_back(page);
+    }
+    if (batch.empty()) {
+        return;
+    }
+    {
+        std::scoped_lock lock{prefetch_latch_};
+        if (prefetcher_running_) {
+            prefetch_queue_.push_back(std::move(batch));
+            prefetch_cv_.notify_one();
+            return;
+        }
+    }
+    read_batch(batch);
+}
+
+/**
+ * @description: 启动后台预读线程，prefetch提交的批次由该线程读入
+ */
+void BufferPoolManager::start_prefetcher() {
+    std::scoped_lock lock{prefetch_latch_};
+    if (prefetcher_running_) {
+        return;
+    }
+    prefetcher_running_ = true;
+    prefetcher_ = std::thread(&BufferPoolManager::prefetcher_loop, this);
+}
+
+/**
+ * @description: 停止后台预读线程，已提交的批次读入完成后线程才退出
+ */
+void BufferPoolManager::stop_prefetcher() {
+    {
+        std::scoped_lock lock{prefetch_latch_};
+        if (!prefetcher_running_) {
+            return;
+        }
+        prefetcher_running_ = false;
+    }
+    prefetch_cv_.notify_all();
+    prefetcher_.join();
+}
+
+/**
+ * @description: 后台预读线程的主循环，依次读入队列中的批次
+ */
+void BufferPoolManager::prefetcher_loop() {
+    while (true) {
+        std::vector<Page *> batch;
+        {
+            std::unique_lock<std::mutex> lock{prefetch_latch_};
+            prefetch_cv_.wait(lock, [this] { return !prefetch_queue_.empty() || !prefetcher_running_; });
+            if (prefetch_queue_.empty()) {
+                return;
+            }
+            batch = std::move(prefetch_queue_.front());
+            prefetch_queue_.pop_front();
+        }
+        read_batch(batch);
+    }
+}
+
+/**
+ * @description: 批量读入一组已建立映射并标记io_in_progress_的帧，完成后清除I/O状态并唤醒等待者。
+ *              读入失败的帧被解除映射，等待该页面的fetch_page会发现映射已变化并自己重新读入。
+ * @param {vector<Page*>&} batch 待读入的帧
+ */
+void BufferPoolManager::read_batch(const std::vector<Page *> &batch) {
+    std::vector<PageIoRequest> requests;
+    requests.reserve(batch.size());
+    for (Page *page : batch) {
+        requests.push_back({page->id_.fd, page->id_.page_no, page->data_});
+    }
+    try {
+        disk_manager_->read_pages_batch(requests);
+    } catch (RMDBError &e) {
+        std::cerr << "BufferPoolManager::read_batch: " << e.what() << std::endl;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Page *page = batch[i];
+        frame_id_t frame_id = static_cast<frame_id_t>(page - pages_);
+        BufferPoolPartition &part = get_partition(page->id_);
+        std::scoped_lock lock{part.latch_};
+        page->io_in_progress_ = false;
+        if (!requests[i].ok()) {
+            part.page_table_.erase(page->id_);
+            page->id_.page_no = INVALID_PAGE_ID;
+            if (page->pin_count_ == 0) {
+                part.free_list_.push_front(frame_id);
+            }
+        } else if (page->pin_count_ == 0) {
+            part.replacer_->unpin(frame_id - part.frame_begin_);
         }
+        part.io_cv_.notify_all();
     }
 }
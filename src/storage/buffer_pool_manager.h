@@ -1,83 +1,154 @@
-/* Copyright (c) 2023 Renmin University of China
-RMDB is licensed under Mulan PSL v2.
-You can use this software according to the terms and conditions of the Mulan PSL v2.
-You may obtain a copy of Mulan PSL v2 at:
-        http://license.coscl.org.cn/MulanPSL2
-THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
-EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
-MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
-See the Mulan PSL v2 for more details. */
-
-#pragma once
-#include <fcntl.h>
-#include <unistd.h>
-
-#include <cassert>
-#include <list>
-#include <unordered_map>
-#include <vector>
-
-#include "disk_manager.h"
-#include "errors.h"
-#include "page.h"
-#include "replacer/lru_replacer.h"
-#include "replacer/replacer.h"
-
-class BufferPoolManager {
-   private:
-    size_t pool_size_;      // buffer_pool中可容纳页面的个数，即帧的个数
-    Page *pages_;           // buffer_pool中的Page对象数组，在构造空间中申请内存空间，在析构函数中释放，大小为BUFFER_POOL_SIZE
-    std::unordered_map<PageId, frame_id_t, PageIdHash> page_table_; // 帧号和页面号的映射哈希表，用于根据页面的PageId定位该页面的帧编号
-    std::list<frame_id_t> free_list_;   // 空闲帧编号的链表
-    DiskManager *disk_manager_;
-    Replacer *replacer_;    // buffer_pool的置换策略，当前赛题中为LRU置换策略
-    std::mutex latch_;      // 用于共享数据结构的并发控制
-
-   public:
-    BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-        : pool_size_(pool_size), disk_manager_(disk_manager) {
-        // 为buffer pool分配一块连续的内存空间
-        pages_ = new Page[pool_size_];
-        // 可以被Replacer改变
-        if (REPLACER_TYPE.compare("LRU"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else if (REPLACER_TYPE.compare("CLOCK"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else {
-            replacer_ = new LRUReplacer(pool_size_);
-        }
-        // 初始化时，所有的page都在free_list_中
-        for (size_t i = 0; i < pool_size_; ++i) {
-            free_list_.emplace_back(static_cast<frame_id_t>(i));  // static_cast转换数据类型
-        }
-    }
-
-    ~BufferPoolManager() {
-        delete[] pages_;
-        delete replacer_;
-    }
-
-    /**
-     * @description: 将目标页面标记为脏页
-     * @param {Page*} page 脏页
-     */
-    static void mark_dirty(Page* page) { page->is_dirty_ = true; }
-
-   public: 
-    Page* fetch_page(PageId page_id);
-
-    bool unpin_page(PageId page_id, bool is_dirty);
-
-    bool flush_page(PageId page_id);
-
-    Page* new_page(PageId* page_id);
-
-    bool delete_page(PageId page_id);
-
-    void flush_all_pages(int fd);
-
-   private:
-    bool find_victim_page(frame_id_t* frame_id);
-
-    void update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id);
-};
\ No newline at end of file
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer_access_strategy.h"
+#include "disk_manager.h"
+#include "errors.h"
+#include "page.h"
+#include "page_guard.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/lru_replacer.h"
+#include "replacer/replacer.h"
+#include "replacer/two_q_replacer.h"
+
+/**
+ * @description: 缓冲池的一个分区。缓冲池按PageId哈希划分为若干分区，每个分区独占一段连续的帧，
+ * 并拥有各自的latch、页表、空闲帧链表和置换器，不同分区上的页面访问互不阻塞
+ */
+struct BufferPoolPartition {
+    std::mutex latch_;                                                // 保护本分区的页表、空闲链表和帧元数据
+    std::condition_variable io_cv_;                                   // 帧上的I/O完成时唤醒等待的线程
+    std::unordered_map<PageId, frame_id_t, PageIdHash> page_table_;  // 本分区内页面号到(全局)帧号的映射
+    std::list<frame_id_t> free_list_;                                 // 本分区空闲帧编号(全局帧号)的链表
+    std::set<PageId> dirty_pages_;                                    // 本分区的脏页，按(fd, page_no)有序，刷盘时顺序写
+    Replacer *replacer_ = nullptr;                                    // 本分区的置换策略，使用分区内的局部帧号
+    frame_id_t frame_begin_ = 0;                                      // 本分区第一个帧的全局帧号
+    size_t frame_num_ = 0;                                            // 本分区的帧数
+};
+
+class BufferPoolManager {
+   private:
+    size_t pool_size_;      // buffer_pool中可容纳页面的个数，即帧的个数
+    Page *pages_;           // buffer_pool中的Page对象数组，在构造空间中申请内存空间，在析构函数中释放，大小为BUFFER_POOL_SIZE
+    size_t partition_num_;  // 分区个数
+    BufferPoolPartition *partitions_;   // 分区数组，页面根据PageId的哈希值落在固定的分区中
+    DiskManager *disk_manager_;
+
+    std::thread flusher_;                       // 后台刷盘线程
+    std::atomic<bool> flusher_running_{false};  // 后台刷盘线程是否在运行
+    std::mutex flusher_latch_;                  // 配合flusher_cv_使用
+    std::condition_variable flusher_cv_;        // 用于唤醒后台刷盘线程：停止时，或前台线程不得不自己写回脏页时
+    bool flush_requested_ = false;              // 前台线程请求立即开始一轮刷盘，由flusher_latch_保护
+    std::chrono::milliseconds flush_interval_;  // 两轮刷盘之间的间隔
+    std::chrono::milliseconds dirty_age_;       // 脏页达到该年龄后被刷盘
+
+    std::thread prefetcher_;                            // 后台预读线程
+    bool prefetcher_running_ = false;                   // 后台预读线程是否在运行，由prefetch_latch_保护
+    std::mutex prefetch_latch_;                         // 保护prefetch_queue_
+    std::condition_variable prefetch_cv_;               // 有新的预读请求或停止时唤醒后台预读线程
+    std::deque<std::vector<Page *>> prefetch_queue_;    // 等待读入的预读批次，批次中的帧已标记io_in_progress_
+
+   public:
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, const std::string &replacer_type = REPLACER_TYPE);
+
+    ~BufferPoolManager();
+
+    void mark_dirty(Page* page);
+
+    /**
+     * @description: 获取缓冲池的帧数
+     */
+    size_t get_pool_size() const { return pool_size_; }
+
+   public: 
+    Page* fetch_page(PageId page_id, BufferAccessStrategy *strategy = nullptr);
+
+    bool unpin_page(PageId page_id, bool is_dirty);
+
+    ReadPageGuard fetch_page_read(PageId page_id, BufferAccessStrategy *strategy = nullptr);
+
+    WritePageGuard fetch_page_write(PageId page_id);
+
+    WritePageGuard new_page_guarded(PageId *page_id);
+
+    bool flush_page(PageId page_id);
+
+    Page* new_page(PageId* page_id);
+
+    bool delete_page(PageId page_id);
+
+    void flush_all_pages(int fd);
+
+    void set_replacer(const std::string &replacer_type);
+
+    std::unique_ptr<BufferAccessStrategy> get_access_strategy(BufferAccessType type);
+
+    static Replacer *create_replacer(const std::string &replacer_type, size_t num_pages);
+
+    void start_flusher(std::chrono::milliseconds interval = std::chrono::milliseconds(FLUSHER_INTERVAL_MS),
+                       std::chrono::milliseconds dirty_age = std::chrono::milliseconds(FLUSHER_DIRTY_AGE_MS));
+
+    void stop_flusher();
+
+    void prefetch(PageId first, int count, BufferAccessStrategy *strategy = nullptr);
+
+    void start_prefetcher();
+
+    void stop_prefetcher();
+
+   private:
+    /**
+     * @description: 获取page_id所属的分区
+     * @param {PageId} page_id 目标页面
+     */
+    size_t get_partition_no(PageId page_id) const { return PageIdHash()(page_id) % partition_num_; }
+
+    BufferPoolPartition &get_partition(PageId page_id) { return partitions_[get_partition_no(page_id)]; }
+
+    bool find_victim_page(BufferPoolPartition &part, std::unique_lock<std::mutex> &lock, frame_id_t* frame_id,
+                          BufferAccessStrategy::Ring *ring = nullptr);
+
+    void release_frame(BufferPoolPartition &part, frame_id_t frame_id);
+
+    void wait_for_io(BufferPoolPartition &part, std::unique_lock<std::mutex> &lock, Page *page);
+
+    void set_dirty(BufferPoolPartition &part, Page *page);
+
+    void clear_dirty(BufferPoolPartition &part, Page *page);
+
+    void flusher_loop();
+
+    void flush_partition(BufferPoolPartition &part);
+
+    bool write_batch(BufferPoolPartition &part, const std::vector<Page *> &batch);
+
+    void prefetcher_loop();
+
+    void read_batch(const std::vector<Page *> &batch);
+};
@@ -11,9 +11,12 @@ See the Mulan PSL v2 for more details. */
 #include "storage/disk_manager.h"
 
 #include <assert.h>    // for assert
+#include <fcntl.h>     // for fallocate
 #include <string.h>    // for memset
 #include <sys/stat.h>  // for stat
+#include <sys/uio.h>   // for preadv, pwritev
 #include <unistd.h>    // for lseek
+#include <climits>     // for IOV_MAX
 #include <cerrno>
 #include <iostream>
 using namespace std;
@@ -34,8 +37,8 @@ void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用write()函数
     // 注意write返回值与num_bytes不等时 throw InternalError("DiskManager::write_page Error");
-    lseek(fd,page_no*PAGE_SIZE,SEEK_SET);
-    int ret = write(fd,offset,num_bytes);
+    // 缓冲池会在不持有latch的情况下并发读写同一文件，使用pwrite避免lseek与write之间的文件偏移竞争
+    ssize_t ret = pwrite(fd, offset, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE);
     if(ret!=num_bytes){
         throw InternalError("DiskManager::write_page Error");
     }
@@ -54,16 +57,94 @@ void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_byt
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用read()函数
     // 注意read返回值与num_bytes不等时，throw InternalError("DiskManager::read_page Error");
-    if(lseek(fd,page_no*PAGE_SIZE,SEEK_SET) == -1){
+    // 同write_page，使用pread在指定偏移处读取，不修改文件偏移
+    ssize_t ret = pread(fd, offset, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE);
+    if(ret == -1){
         throw UnixError();
     }
-    int ret = read(fd,offset,num_bytes);
     if(ret!=num_bytes){
         throw InternalError("DiskManager::read_page Error");
     }
     return;
 }
 
+/**
+ * @description: 批量读取多个页面，整批请求提交后等待全部完成再返回
+ * 读取结果记录在各请求的result字段中，单个请求失败不会抛出异常，由调用者通过PageIoRequest::ok()检查
+ * @param {vector<PageIoRequest>&} requests 读请求
+ */
+void DiskManager::read_pages_batch(std::vector<PageIoRequest> &requests) { submit_pages(requests, false); }
+
+/**
+ * @description: 批量写回多个页面，整批请求提交后等待全部完成再返回，结果的检查方式同read_pages_batch
+ * @param {vector<PageIoRequest>&} requests 写请求，按(fd,page_no)排序时PREAD后端可以合并相邻页面
+ */
+void DiskManager::write_pages_batch(std::vector<PageIoRequest> &requests) { submit_pages(requests, true); }
+
+/**
+ * @description: 选择批量页面I/O使用的后端，应在数据库启动时调用
+ * @param {string&} backend "pread"或"io_uring"，内核不支持io_uring时抛出UnixError
+ */
+void DiskManager::set_io_backend(const std::string &backend) {
+    if (backend == "pread") {
+        io_backend_ = IoBackend::PREAD;
+        io_uring_.reset();
+    } else if (backend == "io_uring") {
+        io_uring_ = std::make_unique<IoUringContext>(IO_URING_QUEUE_DEPTH);
+        io_backend_ = IoBackend::IO_URING;
+    } else {
+        throw InternalError("DiskManager::set_io_backend: unknown io backend " + backend);
+    }
+}
+
+/**
+ * @description: 按当前后端执行一批页面I/O
+ * PREAD后端把同一文件中页号连续的请求合并为一次preadv/pwritev，合并后的调用未完整完成时逐个重试以得到每个请求的结果
+ */
+void DiskManager::submit_pages(std::vector<PageIoRequest> &requests, bool is_write) {
+    if (requests.empty()) {
+        return;
+    }
+    if (io_backend_ == IoBackend::IO_URING) {
+        io_uring_->submit_and_wait(requests.data(), requests.size(), is_write);
+        return;
+    }
+    std::vector<iovec> iovs;
+    size_t begin = 0;
+    while (begin < requests.size()) {
+        // 1. 找到从begin开始的连续页面区间[begin,end)，区间内除最后一个请求外都是整页
+        size_t end = begin + 1;
+        while (end < requests.size() && end - begin < static_cast<size_t>(IOV_MAX) && requests[end].fd == requests[begin].fd &&
+               requests[end].page_no == requests[end - 1].page_no + 1 && requests[end - 1].num_bytes == PAGE_SIZE) {
+            end++;
+        }
+        iovs.clear();
+        ssize_t total = 0;
+        for (size_t i = begin; i < end; ++i) {
+            iovs.push_back({requests[i].buf, static_cast<size_t>(requests[i].num_bytes)});
+            total += requests[i].num_bytes;
+        }
+        off_t offset = static_cast<off_t>(requests[begin].page_no) * PAGE_SIZE;
+        ssize_t ret = is_write ? pwritev(requests[begin].fd, iovs.data(), static_cast<int>(iovs.size()), offset)
+                               : preadv(requests[begin].fd, iovs.data(), static_cast<int>(iovs.size()), offset);
+        // 2. 合并的调用完整完成时所有请求都成功，否则逐个重新执行
+        if (ret == total) {
+            for (size_t i = begin; i < end; ++i) {
+                requests[i].result = requests[i].num_bytes;
+            }
+        } else {
+            for (size_t i = begin; i < end; ++i) {
+                PageIoRequest &request = requests[i];
+                off_t page_offset = static_cast<off_t>(request.page_no) * PAGE_SIZE;
+                ssize_t n = is_write ? pwrite(request.fd, request.buf, request.num_bytes, page_offset)
+                                     : pread(request.fd, request.buf, request.num_bytes, page_offset);
+                request.result = n == -1 ? -errno : n;
+            }
+        }
+        begin = end;
+    }
+}
+
 /**
  * @description: 分配一个新的页号
  * @return {page_id_t} 分配的新页号
@@ -75,7 +156,43 @@ page_id_t DiskManager::allocate_page(int fd) {
     return fd2pageno_[fd]++;
 }
 
-void DiskManager::deallocate_page(__attribute__((unused)) page_id_t page_id) {}
+/**
+ * @description: 仅当文件下一个待分配的页号仍为page_no时分配该页号，用于缓冲池先选定分区再分配页号
+ * @return {bool} 分配成功返回true，页号已被其他线程分配返回false
+ * @param {int} fd 指定文件的文件句柄
+ * @param {page_id_t} page_no 期望分配的页号
+ */
+bool DiskManager::try_allocate_page(int fd, page_id_t page_no) {
+    assert(fd >= 0 && fd < MAX_FD);
+    return fd2pageno_[fd].compare_exchange_strong(page_no, page_no + 1);
+}
+
+/**
+ * @description: 释放页面占用的磁盘空间，页面在文件中的位置保留，之后读到的是全0的页面
+ * 文件系统不支持打洞时不做任何事，页面的内容由调用者保证已经无用
+ * @param {int} fd 指定文件的文件句柄
+ * @param {page_id_t} page_no 要释放的页面
+ */
+void DiskManager::deallocate_page(int fd, page_id_t page_no) {
+    int ret = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(page_no) * PAGE_SIZE,
+                        PAGE_SIZE);
+    if (ret != 0 && errno != EOPNOTSUPP && errno != ENOSYS) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 把文件截断为num_pages个页面，并从num_pages开始重新分配页号
+ * @param {int} fd 指定文件的文件句柄
+ * @param {page_id_t} num_pages 截断后文件的页面个数
+ */
+void DiskManager::truncate_file(int fd, page_id_t num_pages) {
+    assert(fd >= 0 && fd < MAX_FD);
+    if (ftruncate(fd, static_cast<off_t>(num_pages) * PAGE_SIZE) != 0) {
+        throw UnixError();
+    }
+    fd2pageno_[fd] = num_pages;
+}
 
 bool DiskManager::is_dir(const std::string& path) {
     struct stat st;
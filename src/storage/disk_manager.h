@@ -17,11 +17,32 @@ See the Mulan PSL v2 for more details. */
 #include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
 #include "errors.h"  
+#include "io_uring_context.h"
+
+/**
+ * @description: 批量页面I/O中的一个请求，result记录实际读写的字节数，出错时为-errno
+ */
+struct PageIoRequest {
+    int fd;
+    page_id_t page_no;
+    char *buf;
+    int num_bytes = PAGE_SIZE;
+    ssize_t result = 0;
+
+    bool ok() const { return result == num_bytes; }
+};
+
+/**
+ * @description: 批量页面I/O的后端，PREAD使用pread/pwrite并合并相邻页面，IO_URING一次系统调用提交整批请求
+ */
+enum class IoBackend { PREAD, IO_URING };
 
 /**
  * @description: DiskManager的作用主要是根据上层的需要对磁盘文件进行操作
@@ -36,9 +57,21 @@ class DiskManager {
 
     void read_page(int fd, page_id_t page_no, char *offset, int num_bytes);
 
+    void read_pages_batch(std::vector<PageIoRequest> &requests);
+
+    void write_pages_batch(std::vector<PageIoRequest> &requests);
+
+    void set_io_backend(const std::string &backend);
+
+    IoBackend get_io_backend() const { return io_backend_; }
+
     page_id_t allocate_page(int fd);
 
-    void deallocate_page(page_id_t page_id);
+    bool try_allocate_page(int fd, page_id_t page_no);
+
+    void deallocate_page(int fd, page_id_t page_no);
+
+    void truncate_file(int fd, page_id_t num_pages);
 
     /*目录操作*/
     bool is_dir(const std::string &path);
@@ -90,10 +123,15 @@ class DiskManager {
     static constexpr int MAX_FD = 8192;
 
    private:
+    void submit_pages(std::vector<PageIoRequest> &requests, bool is_write);
+
     // 文件打开列表，用于记录文件是否被打开
     std::unordered_map<std::string, int> path2fd_;  //<Page文件磁盘路径,Page fd>哈希表
     std::unordered_map<int, std::string> fd2path_;  //<Page fd,Page文件磁盘路径>哈希表
 
     int log_fd_ = -1;                             // WAL日志文件的文件句柄，默认为-1，代表未打开日志文件
     std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 文件中已经分配的页面个数，初始值为0
+
+    IoBackend io_backend_ = IoBackend::PREAD;      // 批量页面I/O使用的后端
+    std::unique_ptr<IoUringContext> io_uring_;     // IO_URING后端使用的ring
 };
\ No newline at end of file
@@ -0,0 +1,204 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/io_uring_context.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "errors.h"
+#include "storage/disk_manager.h"
+
+#ifdef RMDB_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+IoUringContext::IoUringContext(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = sys_io_uring_setup(entries, &params);
+    if (ring_fd_ < 0) {
+        throw UnixError();
+    }
+    entries_ = params.sq_entries;
+
+    // 1. 映射提交队列、完成队列和提交队列项数组，较新的内核可以用一次mmap同时映射两个队列
+    sq_ring_len_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_len_ = cq_ring_len_ = std::max(sq_ring_len_, cq_ring_len_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        int err = errno;
+        release();
+        errno = err;
+        throw UnixError();
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            int err = errno;
+            release();
+            errno = err;
+            throw UnixError();
+        }
+    }
+    sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        int err = errno;
+        release();
+        errno = err;
+        throw UnixError();
+    }
+
+    // 2. 根据内核给出的偏移量定位队列的头尾指针
+    char *sq = static_cast<char *>(sq_ring_);
+    char *cq = static_cast<char *>(cq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+}
+
+IoUringContext::~IoUringContext() { release(); }
+
+void IoUringContext::release() {
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_len_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_len_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_ != nullptr) {
+        munmap(sq_ring_, sq_ring_len_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+void IoUringContext::submit_and_wait(PageIoRequest *requests, size_t count, bool is_write) {
+    std::scoped_lock lock{latch_};
+    auto *sqes = static_cast<io_uring_sqe *>(sqes_);
+    auto *cqes = static_cast<io_uring_cqe *>(cqes_);
+    std::vector<iovec> iovs(std::min(count, static_cast<size_t>(entries_)));
+
+    size_t done = 0;
+    while (done < count) {
+        unsigned batch = static_cast<unsigned>(std::min(count - done, static_cast<size_t>(entries_)));
+
+        // 1. 填写提交队列项，只有当前线程写sq_tail_，发布时使用release保证内核看到完整的sqe
+        unsigned tail = *sq_tail_;
+        for (unsigned i = 0; i < batch; ++i) {
+            PageIoRequest &request = requests[done + i];
+            iovs[i].iov_base = request.buf;
+            iovs[i].iov_len = request.num_bytes;
+            unsigned index = tail & *sq_mask_;
+            io_uring_sqe *sqe = &sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = request.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(&iovs[i]);
+            sqe->len = 1;
+            sqe->off = static_cast<uint64_t>(request.page_no) * PAGE_SIZE;
+            sqe->user_data = done + i;
+            sq_array_[index] = index;
+            ++tail;
+        }
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+        // 2. 一次系统调用提交整批请求并等待完成，被信号打断或只完成一部分时继续等待剩余的请求
+        unsigned to_submit = batch;
+        unsigned completed = 0;
+        while (completed < batch) {
+            int ret = sys_io_uring_enter(ring_fd_, to_submit, batch - completed, IORING_ENTER_GETEVENTS);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw UnixError();
+            }
+            to_submit -= std::min(static_cast<unsigned>(ret), to_submit);
+
+            unsigned head = *cq_head_;
+            while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                io_uring_cqe *cqe = &cqes[head & *cq_mask_];
+                requests[cqe->user_data].result = cqe->res;
+                ++head;
+                ++completed;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        done += batch;
+    }
+}
+
+bool IoUringContext::is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = sys_io_uring_setup(1, &params);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+#else
+
+IoUringContext::IoUringContext(unsigned entries) {
+    // 与内核不支持io_uring时一样抛出UnixError，调用者据此退回pread后端
+    errno = ENOSYS;
+    throw UnixError();
+}
+
+IoUringContext::~IoUringContext() = default;
+
+void IoUringContext::release() {}
+
+void IoUringContext::submit_and_wait(PageIoRequest *requests, size_t count, bool is_write) {
+    errno = ENOSYS;
+    throw UnixError();
+}
+
+bool IoUringContext::is_supported() { return false; }
+
+#endif
@@ -0,0 +1,74 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define RMDB_HAVE_IO_URING 1
+#endif
+
+struct PageIoRequest;
+
+/**
+ * @description: 基于io_uring系统调用的批量页面I/O，不依赖liburing
+ * 一批请求通过一次io_uring_enter提交，并在同一次调用中等待全部完成；多个线程共享同一个ring时按批串行
+ */
+class IoUringContext {
+   public:
+    /**
+     * @description: 创建io_uring实例，内核不支持或被禁止时抛出UnixError
+     * @param {unsigned} entries 提交队列的长度，单批请求超过该长度时分多轮提交
+     */
+    explicit IoUringContext(unsigned entries);
+
+    ~IoUringContext();
+
+    IoUringContext(const IoUringContext &) = delete;
+    IoUringContext &operator=(const IoUringContext &) = delete;
+
+    /**
+     * @description: 提交一批读或写请求并等待全部完成，每个请求的结果写入其result字段
+     * @param {PageIoRequest*} requests 请求数组
+     * @param {size_t} count 请求个数
+     * @param {bool} is_write true为写请求，false为读请求
+     */
+    void submit_and_wait(PageIoRequest *requests, size_t count, bool is_write);
+
+    /**
+     * @description: 判断当前内核是否可以创建io_uring实例
+     */
+    static bool is_supported();
+
+   private:
+    void release();
+
+    int ring_fd_ = -1;
+    unsigned entries_ = 0;
+
+    void *sq_ring_ = nullptr;   // 提交队列的共享内存
+    size_t sq_ring_len_ = 0;
+    void *cq_ring_ = nullptr;   // 完成队列的共享内存，内核支持IORING_FEAT_SINGLE_MMAP时与sq_ring_相同
+    size_t cq_ring_len_ = 0;
+    void *sqes_ = nullptr;      // 提交队列项数组
+    size_t sqes_len_ = 0;
+
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_mask_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned *cq_mask_ = nullptr;
+    void *cqes_ = nullptr;
+
+    std::mutex latch_;  // 保护提交队列与完成队列，同一时刻只有一批请求在ring中
+};
@@ -10,6 +10,10 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <chrono>
+#include <cstring>
+#include <shared_mutex>
+
 #include "common/config.h"
 
 /**
@@ -21,7 +25,7 @@ struct PageId {
 
     friend bool operator==(const PageId &x, const PageId &y) { return x.fd == y.fd && x.page_no == y.page_no; }
     bool operator<(const PageId& x) const {
-        if(fd < x.fd) return true;
+        if(fd != x.fd) return fd < x.fd;
         return page_no < x.page_no;
     }
 
@@ -71,6 +75,9 @@ class Page {
 
     inline void set_page_lsn(lsn_t page_lsn) { memcpy(get_data() + OFFSET_LSN, &page_lsn, sizeof(lsn_t)); }
 
+    /** 页面内容的读写锁(latch)，由使用者在页面被固定期间按需加锁，缓冲池本身不加此锁 */
+    std::shared_mutex &latch() { return latch_; }
+
    private:
     void reset_memory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }  // 将data_的PAGE_SIZE个字节填充为0
 
@@ -85,6 +92,15 @@ class Page {
     /** 脏页判断 */
     bool is_dirty_ = false;
 
+    /** 页面最近一次由干净变脏的时间，后台刷盘线程据此判断脏页的年龄 */
+    std::chrono::steady_clock::time_point dirty_since_;
+
     /** The pin count of this page. */
     int pin_count_ = 0;
+
+    /** 该帧正在进行磁盘读写(读入新页面或写回脏页)，其他线程需等待I/O完成后才能访问 */
+    bool io_in_progress_ = false;
+
+    /** 页面内容的读写锁 */
+    std::shared_mutex latch_;
 };
\ No newline at end of file
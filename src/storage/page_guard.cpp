@@ -0,0 +1,44 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "page_guard.h"
+
+#include "buffer_pool_manager.h"
+
+PageGuard::PageGuard(PageGuard &&that) noexcept : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&that) noexcept {
+    if (this != &that) {
+        release();
+        bpm_ = that.bpm_;
+        page_ = that.page_;
+        is_dirty_ = that.is_dirty_;
+        that.bpm_ = nullptr;
+        that.page_ = nullptr;
+        that.is_dirty_ = false;
+    }
+    return *this;
+}
+
+/**
+ * @description: 提前取消固定页面，之后句柄为空
+ */
+void PageGuard::release() {
+    if (page_ != nullptr) {
+        bpm_->unpin_page(page_->get_page_id(), is_dirty_);
+        bpm_ = nullptr;
+        page_ = nullptr;
+        is_dirty_ = false;
+    }
+}
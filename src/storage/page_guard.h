@@ -0,0 +1,76 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "page.h"
+
+class BufferPoolManager;
+
+/**
+ * @description: 缓冲池页面固定(pin)的RAII句柄。句柄只能移动不能拷贝，析构或release()时取消固定，
+ * 句柄被标记为脏时以is_dirty=true取消固定。句柄为空(默认构造、已被移走或已释放)时不做任何事。
+ */
+class PageGuard {
+   public:
+    PageGuard() = default;
+
+    PageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+    PageGuard(const PageGuard &) = delete;
+    PageGuard &operator=(const PageGuard &) = delete;
+
+    PageGuard(PageGuard &&that) noexcept;
+
+    PageGuard &operator=(PageGuard &&that) noexcept;
+
+    ~PageGuard() { release(); }
+
+    void release();
+
+    /**
+     * @description: 标记页面已被修改，取消固定时页面成为脏页
+     */
+    void mark_dirty() { is_dirty_ = true; }
+
+    Page *get_page() const { return page_; }
+
+    PageId get_page_id() const { return page_->get_page_id(); }
+
+    explicit operator bool() const { return page_ != nullptr; }
+
+   protected:
+    BufferPoolManager *bpm_ = nullptr;
+    Page *page_ = nullptr;
+    bool is_dirty_ = false;
+};
+
+/**
+ * @description: 只读访问页面的句柄，取消固定时不会把页面标记为脏页
+ */
+class ReadPageGuard : public PageGuard {
+   public:
+    using PageGuard::PageGuard;
+
+    const char *get_data() const { return page_->get_data(); }
+};
+
+/**
+ * @description: 读写访问页面的句柄，通过get_data()取得可写指针后，取消固定时页面成为脏页
+ */
+class WritePageGuard : public PageGuard {
+   public:
+    using PageGuard::PageGuard;
+
+    char *get_data() {
+        is_dirty_ = true;
+        return page_->get_data();
+    }
+};
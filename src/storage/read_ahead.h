@@ -0,0 +1,66 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+
+#include "buffer_pool_manager.h"
+
+/**
+ * @description: 扫描的顺序预读状态。扫描每访问一个页面调用一次access，连续访问相邻页面时判定为顺序扫描并开始预读，
+ * 游标进入上一次预读区域的后半段时发起下一次预读，窗口从PREFETCH_MIN_PAGES开始每次翻倍，直到PREFETCH_MAX_PAGES；
+ * 访问不连续时窗口清零，重新检测。
+ */
+class ReadAhead {
+   public:
+    /**
+     * @param {BufferPoolManager*} bpm 缓冲池
+     * @param {int} fd 扫描的文件
+     * @param {BufferAccessStrategy*} strategy 扫描使用的访问策略，预读的页面同样只装入策略的环中
+     */
+    ReadAhead(BufferPoolManager *bpm, int fd, BufferAccessStrategy *strategy = nullptr)
+        : bpm_(bpm), fd_(fd), strategy_(strategy) {}
+
+    /**
+     * @description: 记录扫描即将访问page_no，必要时发起异步预读
+     * @param {page_id_t} page_no 即将访问的页面
+     * @param {page_id_t} end_page_no 预读不会越过的页号上界，一般为文件的页面个数
+     */
+    void access(page_id_t page_no, page_id_t end_page_no) {
+        bool sequential = page_no == last_page_no_ + 1;
+        last_page_no_ = page_no;
+        if (!sequential) {
+            window_ = 0;
+            next_page_no_ = page_no + 1;
+            return;
+        }
+        // 已预读但尚未访问的页面还多于上一个窗口的一半，暂不预读
+        if (next_page_no_ - page_no > window_ / 2) {
+            return;
+        }
+        page_id_t first = std::max(next_page_no_, page_no + 1);
+        window_ = window_ == 0 ? PREFETCH_MIN_PAGES : std::min(window_ * 2, PREFETCH_MAX_PAGES);
+        int count = std::min(window_, end_page_no - first);
+        if (count <= 0) {
+            return;
+        }
+        bpm_->prefetch(PageId{fd_, first}, count, strategy_);
+        next_page_no_ = first + count;
+    }
+
+   private:
+    BufferPoolManager *bpm_;
+    int fd_;
+    BufferAccessStrategy *strategy_;
+    page_id_t last_page_no_ = INVALID_PAGE_ID;  // 上一次访问的页面
+    page_id_t next_page_no_ = 0;                // 已预读区域之后的第一个页面
+    int window_ = 0;                            // 上一次预读的窗口大小，0表示尚未检测到顺序访问
+};
@@ -117,8 +117,12 @@ void SmManager::open_db(const std::string& db_name) {
 
         TabMeta tab_meta = table->second;
         for (auto index : tab_meta.indexes) {
-            // auto index_hdr_ptr =  ix_manager_->open_index(table->first,index.cols);
-            ihs_.emplace(table->first, ix_manager_->open_index(table->first, index.cols));
+            std::string index_name = ix_manager_->get_index_name(table->first, index.cols);
+            if (index.type == INDEX_HASH) {
+                hash_ihs_.emplace(index_name, ix_manager_->open_hash_index(table->first, index.cols));
+            } else {
+                ihs_.emplace(index_name, ix_manager_->open_index(table->first, index.cols));
+            }
         }
     }
 }
@@ -139,15 +143,20 @@ void SmManager::close_db() {
     // 1. 元数据信息落盘
     std::ofstream ofs(DB_META_NAME);
     ofs << db_;
-    // 2. 关闭所有文件，close_file里实现落盘
+    // 2. 回收表文件中的空页面，再关闭所有文件，close_file里实现落盘
     for (auto it = fhs_.begin(); it != fhs_.end(); it++) {
+        it->second->reclaim_empty_pages();
         rm_manager_->close_file(it->second.get());
     }
     for (auto it = ihs_.begin(); it != ihs_.end(); it++) {
         ix_manager_->close_index(it->second.get());
     }
+    for (auto it = hash_ihs_.begin(); it != hash_ihs_.end(); it++) {
+        ix_manager_->close_hash_index(it->second.get());
+    }
     // 3. 清空ihs_,fhs_
     ihs_.clear();
+    hash_ihs_.clear();
     fhs_.clear();
     // 4. 清空元数据db_
     db_.name_ = "";
@@ -270,7 +279,8 @@ void SmManager::drop_table(const std::string& tab_name, Context* context) {
  * @param {vector<string>&} col_names 索引包含的字段名称
  * @param {Context*} context
  */
-void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
+void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                             IndexType type) {
     // 加锁 TODO 应该加IX吗
     // context->lock_mgr_->lock_IX_on_table(context->txn_,fhs_[tab_name]->GetFd());
     TabMeta& table = db_.get_table(tab_name);
@@ -293,43 +303,83 @@ void SmManager::create_index(const std::string& tab_name, const std::vector<std:
     index.col_tot_len = tot_len;
     index.col_num = col_num;
     index.cols = cols;
+    index.type = type;
 
     table.indexes.push_back(index);
 
-    // create b+ tree file?
-    ix_manager_->create_index(tab_name, cols);
+    if (type == INDEX_HASH) {
+        create_hash_index(tab_name, cols, context);
+        return;
+    }
+
+    // create b+ tree file? 索引列的值可以重复，创建非唯一索引
+    ix_manager_->create_index(tab_name, cols, false);
 
     // insert kv pairs into index_hdr
     auto index_hdr = ix_manager_->open_index(tab_name, cols);
 
     // get the records from table(rm handle)
     RmFileHandle* rm_hdr = fhs_.at(tab_name).get();
+    // 扫描全表收集键值对，排序后自底向上构建B+树，而不是逐条插入
+    IxBulkLoader loader(index_hdr.get());
     // use rm_scan to traverse the table
-    auto scan = RmScan(rm_hdr);
+    auto scan = RmScan(rm_hdr, BufferAccessType::BULK_READ);
+    std::optional<RmPageHandle> page_handle;  // 当前记录所在的页面，同一页面上的记录不重复固定
+    std::vector<char> key(tot_len);
     while (!scan.is_end()) {
         Rid rid = scan.rid();
         // if the table is empty
         if (rid.slot_no < 0 && rid.page_no == 0) break;
-        auto record = rm_hdr->get_record(rid, context);  // record: RmRecord*
-        // record.data是所有col连续存储，要用偏移值找
-        char* key = new char[tot_len + 1];
-        key[0] = '\0';
+        TupleView record = rm_hdr->get_record_view(rid, page_handle, context);
+        // record.data是所有col连续存储，要用偏移值找，按顺序拼接每一个col的值
         int curlen = 0;
         for (int i = 0; i < col_num; i++) {
-            // 按顺序拼接每一个col的值
-            strncat(key, record->data + cols[i].offset, cols[i].len);
+            memcpy(key.data() + curlen, record.data + cols[i].offset, cols[i].len);
             curlen += cols[i].len;
-            key[curlen] = '\0';
         }
-        index_hdr->insert_entry(key, rid, context->txn_);
+        loader.add(key.data(), rid);
         scan.next();
     }
+    page_handle.reset();
+    loader.finish();
 
     // insert the index_hdr into ihs_
     // ix_manager_->close_index(index_hdr.get());  //std::move會修改index_hdr的值
     ihs_.emplace(ix_manager_->get_index_name(tab_name, cols), std::move(index_hdr));
 }
 
+/**
+ * @description: 创建哈希索引文件，逐条插入表中已有的记录；哈希索引没有顺序，不能批量构建
+ * @param {string&} tab_name 表的名称
+ * @param {vector<ColMeta>&} cols 索引包含的字段
+ * @param {Context*} context
+ */
+void SmManager::create_hash_index(const std::string& tab_name, const std::vector<ColMeta>& cols, Context* context) {
+    ix_manager_->create_hash_index(tab_name, cols);
+    auto index_hdr = ix_manager_->open_hash_index(tab_name, cols);
+    RmFileHandle* rm_hdr = fhs_.at(tab_name).get();
+    auto scan = RmScan(rm_hdr, BufferAccessType::BULK_READ);
+    std::optional<RmPageHandle> page_handle;
+    int tot_len = 0;
+    for (auto& col : cols) {
+        tot_len += col.len;
+    }
+    std::vector<char> key(tot_len);
+    for (; !scan.is_end(); scan.next()) {
+        Rid rid = scan.rid();
+        if (rid.slot_no < 0 && rid.page_no == 0) break;
+        TupleView record = rm_hdr->get_record_view(rid, page_handle, context);
+        int curlen = 0;
+        for (auto& col : cols) {
+            memcpy(key.data() + curlen, record.data + col.offset, col.len);
+            curlen += col.len;
+        }
+        index_hdr->insert_entry(key.data(), rid, context->txn_);
+    }
+    page_handle.reset();
+    hash_ihs_.emplace(ix_manager_->get_index_name(tab_name, cols), std::move(index_hdr));
+}
+
 /**
  * @description: 删除索引
  * @param {string&} tab_name 表名称
@@ -348,10 +398,14 @@ void SmManager::drop_index(const std::string& tab_name, const std::vector<std::s
     }
     // 2. ix_manager_删索引文件
     std::string index_name = ix_manager_->get_index_name(tab_name, col_names);
-    ix_manager_->close_index(ihs_.at(index_name).get());
+    if (table.get_index_meta(col_names)->type == INDEX_HASH) {
+        ix_manager_->close_hash_index(hash_ihs_.at(index_name).get());
+        hash_ihs_.erase(index_name);
+    } else {
+        ix_manager_->close_index(ihs_.at(index_name).get());
+        ihs_.erase(index_name);
+    }
     ix_manager_->destroy_index(tab_name, col_names);
-    // 3. 更新ihs_
-    ihs_.erase(index_name);
     // 4. 更新table
     table.indexes.erase(table.get_index_meta(col_names));
 }
@@ -30,6 +30,7 @@ class SmManager {
     DbMeta db_;             // 当前打开的数据库的元数据
     std::unordered_map<std::string, std::unique_ptr<RmFileHandle>> fhs_;    // file name -> record file handle, 当前数据库中每张表的数据文件
     std::unordered_map<std::string, std::unique_ptr<IxIndexHandle>> ihs_;   // file name -> index file handle, 当前数据库中每个索引的文件
+    std::unordered_map<std::string, std::unique_ptr<IxHashIndexHandle>> hash_ihs_;  // file name -> 哈希索引的文件
    private:
     DiskManager* disk_manager_;
     BufferPoolManager* buffer_pool_manager_;
@@ -72,9 +73,13 @@ class SmManager {
 
     void drop_table(const std::string& tab_name, Context* context);
 
-    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
+    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                      IndexType type = INDEX_BTREE);
 
     void drop_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
     
     void drop_index(const std::string& tab_name, const std::vector<ColMeta>& col_names, Context* context);
+
+   private:
+    void create_hash_index(const std::string& tab_name, const std::vector<ColMeta>& cols, Context* context);
 };
\ No newline at end of file
@@ -39,15 +39,19 @@ struct ColMeta {
     }
 };
 
+/* 索引类型：B+树支持范围查询，哈希索引只支持等值查找 */
+enum IndexType { INDEX_BTREE = 0, INDEX_HASH = 1 };
+
 /* 索引元数据 */
 struct IndexMeta {
     std::string tab_name;           // 索引所属表名称
     int col_tot_len;                // 索引字段长度总和
     int col_num;                    // 索引字段数量
     std::vector<ColMeta> cols;      // 索引包含的字段
+    IndexType type = INDEX_BTREE;   // 索引类型
 
     friend std::ostream &operator<<(std::ostream &os, const IndexMeta &index) {
-        os << index.tab_name << " " << index.col_tot_len << " " << index.col_num;
+        os << index.tab_name << " " << index.col_tot_len << " " << index.col_num << " " << index.type;
         for(auto& col: index.cols) {
             os << "\n" << col;
         }
@@ -55,7 +59,9 @@ struct IndexMeta {
     }
 
     friend std::istream &operator>>(std::istream &is, IndexMeta &index) {
-        is >> index.tab_name >> index.col_tot_len >> index.col_num;
+        int type;
+        is >> index.tab_name >> index.col_tot_len >> index.col_num >> type;
+        index.type = static_cast<IndexType>(type);
         for(int i = 0; i < index.col_num; ++i) {
             ColMeta col;
             is >> col;
@@ -76,6 +82,7 @@ struct TabMeta {
     TabMeta(const TabMeta &other) {
         name = other.name;
         for(auto col : other.cols) cols.push_back(col);
+        indexes = other.indexes;
     }
 
     /* 判断当前表中是否存在名为col_name的字段 */
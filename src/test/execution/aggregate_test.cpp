@@ -0,0 +1,158 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <map>
+#include <random>
+
+#include "execution/executor_aggregate.h"
+#include "gtest/gtest.h"
+#include "mock_executor.h"
+
+class AggregateTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> cols_ = make_cols("t", {{"g", TYPE_INT}, {"s", TYPE_STRING}, {"v", TYPE_INT}, {"f", TYPE_FLOAT}});
+    std::vector<std::vector<char>> tuples_;
+    std::vector<TabCol> group_cols_ = {{"t", "g"}, {"t", "s"}};
+    std::vector<AggExpr> aggs_ = {
+        {AGG_COUNT, {"", "*"}, {"", "COUNT(*)"}}, {AGG_SUM, {"t", "v"}, {"", "SUM(v)"}},
+        {AGG_SUM, {"t", "f"}, {"", "SUM(f)"}},    {AGG_MIN, {"t", "s"}, {"", "MIN(s)"}},
+        {AGG_MAX, {"t", "v"}, {"", "MAX(v)"}},    {AGG_AVG, {"t", "v"}, {"", "AVG(v)"}},
+    };
+
+    // 每组的结果：分组键(g, s)对应(COUNT(*), SUM(v), SUM(f), MIN(s), MAX(v), AVG(v))
+    using Row = std::tuple<int, int, float, std::string, int, float>;
+    using Result = std::map<std::pair<int, std::string>, Row>;
+
+    void generate(int num, int num_groups) {
+        std::mt19937 rng(num + num_groups);
+        const char *strs[] = {"a", "b", "abc"};
+        for (int i = 0; i < num; i++) {
+            double g = static_cast<int>(rng() % num_groups) - num_groups / 2;
+            double v = static_cast<int>(rng() % 2000) - 1000;
+            double f = (static_cast<int>(rng() % 100) - 50) / 2.0;
+            tuples_.push_back(make_tuple(cols_, {g, v, f}, {strs[rng() % 3]}));
+        }
+    }
+
+    static std::string get_str(const char *rec, const ColMeta &col) {
+        return std::string(rec + col.offset, strnlen(rec + col.offset, col.len));
+    }
+
+    static float get_float(const char *rec, const ColMeta &col) {
+        float v;
+        memcpy(&v, rec + col.offset, sizeof(float));
+        return v;
+    }
+
+    // 按分组键(g, s)逐个累加得到的结果
+    Result expected() {
+        struct State {
+            int count = 0;
+            int64_t sum_v = 0;
+            double sum_f = 0;
+            std::string min_s;
+            int max_v = 0;
+        };
+        std::map<std::pair<int, std::string>, State> states;
+        for (auto &tuple : tuples_) {
+            const char *rec = tuple.data();
+            auto &state = states[{get_int(rec, cols_[0]), get_str(rec, cols_[1])}];
+            std::string s = get_str(rec, cols_[1]);
+            int v = get_int(rec, cols_[2]);
+            state.min_s = state.count == 0 ? s : std::min(state.min_s, s);
+            state.max_v = state.count == 0 ? v : std::max(state.max_v, v);
+            state.sum_v += v;
+            state.sum_f += get_float(rec, cols_[3]);
+            state.count++;
+        }
+        Result result;
+        for (auto &[key, state] : states) {
+            result[key] = Row{state.count, static_cast<int>(state.sum_v), static_cast<float>(state.sum_f), state.min_s,
+                              state.max_v, static_cast<float>(state.sum_v / static_cast<double>(state.count))};
+        }
+        return result;
+    }
+
+    Result run(AbstractExecutor *exec) {
+        auto &cols = exec->cols();
+        Result result;
+        for (auto &tuple : collect(exec)) {
+            const char *rec = tuple.data();
+            auto key = std::make_pair(get_int(rec, cols[0]), get_str(rec, cols[1]));
+            EXPECT_EQ(result.count(key), 0u);
+            result[key] = Row{get_int(rec, cols[2]), get_int(rec, cols[3]), get_float(rec, cols[4]),
+                              get_str(rec, cols[5]), get_int(rec, cols[6]), get_float(rec, cols[7])};
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief 组数超出内存预算时溢出到分区，分区内仍超出时递归地再分区，结果与全部在内存中相同
+ */
+TEST_F(AggregateTest, HashAggregateTest) {
+    generate(20000, 2000);
+    auto expect = expected();
+    for (size_t mem_budget : {HASH_AGG_MEM, size_t(64 << 10), size_t(256)}) {
+        HashAggregateExecutor agg(std::make_unique<MockExecutor>(cols_, tuples_), group_cols_, aggs_, mem_budget);
+        EXPECT_EQ(run(&agg), expect);
+        // 再次beginTuple()得到相同的结果
+        EXPECT_EQ(run(&agg), expect);
+    }
+}
+
+/**
+ * @brief 输入按分组列有序时流式聚合的结果与哈希聚合相同
+ */
+TEST_F(AggregateTest, SortAggregateTest) {
+    generate(5000, 300);
+    auto expect = expected();
+    tuples_ = stable_sorted(tuples_, cols_, {0, 1}, {false, false});
+    SortAggregateExecutor agg(std::make_unique<MockExecutor>(cols_, tuples_), group_cols_, aggs_);
+    EXPECT_EQ(run(&agg), expect);
+}
+
+/**
+ * @brief 没有GROUP BY时输出一组，空输入的COUNT为0；COUNT和SUM(int)超出int的范围时报错
+ */
+TEST_F(AggregateTest, GlobalAggregateTest) {
+    std::vector<AggExpr> aggs = {{AGG_COUNT, {"", "*"}, {"", "COUNT(*)"}}, {AGG_SUM, {"t", "v"}, {"", "SUM(v)"}}};
+    HashAggregateExecutor empty(std::make_unique<MockExecutor>(cols_, tuples_), {}, aggs);
+    auto rows = collect(&empty);
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(get_int(rows[0].data(), empty.cols()[0]), 0);
+    EXPECT_EQ(get_int(rows[0].data(), empty.cols()[1]), 0);
+
+    for (int i = 0; i < 3; i++) {
+        tuples_.push_back(make_tuple(cols_, {0, 1000000000, 0}, {"a"}));
+    }
+    HashAggregateExecutor hash_agg(std::make_unique<MockExecutor>(cols_, tuples_), {}, aggs);
+    EXPECT_THROW(collect(&hash_agg), IntegerOverflowError);
+    SortAggregateExecutor sort_agg(std::make_unique<MockExecutor>(cols_, tuples_), {}, aggs);
+    EXPECT_THROW(collect(&sort_agg), IntegerOverflowError);
+}
+
+/**
+ * @brief 按批输出与按元组输出的结果相同，包括溢出到分区和没有GROUP BY的情况
+ */
+TEST_F(AggregateTest, NextBatchTest) {
+    HashAggregateExecutor empty(std::make_unique<MockExecutor>(cols_, tuples_), {}, aggs_);
+    auto rows = collect_batches(&empty);
+    EXPECT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows, collect(&empty));
+
+    generate(20000, 2000);
+    for (size_t mem_budget : {HASH_AGG_MEM, size_t(256)}) {
+        HashAggregateExecutor agg(std::make_unique<MockExecutor>(cols_, tuples_), group_cols_, aggs_, mem_budget);
+        rows = collect_batches(&agg);
+        EXPECT_EQ(rows.size(), expected().size());
+        EXPECT_EQ(rows, collect(&agg));
+    }
+}
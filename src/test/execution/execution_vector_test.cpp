@@ -0,0 +1,256 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <random>
+
+#include "execution/execution_sort.h"
+#include "execution/execution_vector.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_batch_adapter.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_projection.h"
+#include "gtest/gtest.h"
+#include "mock_executor.h"
+
+class ExecutionVectorTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> cols_ = make_cols("t", {{"a", TYPE_INT}, {"b", TYPE_INT}, {"f", TYPE_FLOAT}, {"s", TYPE_STRING}, {"r", TYPE_STRING}});
+    std::vector<std::vector<char>> tuples_;
+
+    void SetUp() override {
+        std::mt19937 rng(7);
+        const char *strs[] = {"", "a", "ab", "abc", "b", "zzzzzzzz"};
+        for (int i = 0; i < 3000; i++) {
+            double a = static_cast<int>(rng() % 21) - 10;
+            double b = static_cast<int>(rng() % 21) - 10;
+            double f = (static_cast<int>(rng() % 41) - 20) / 4.0;
+            tuples_.push_back(make_tuple(cols_, {a, b, f}, {strs[rng() % 6], strs[rng() % 6]}));
+        }
+    }
+
+    static Condition val_cond(const std::string &col, CompOp op, Value val, int len) {
+        Condition cond;
+        cond.lhs_col = TabCol{"t", col};
+        cond.op = op;
+        cond.is_rhs_val = true;
+        cond.rhs_val = std::move(val);
+        cond.rhs_val.init_raw(len);
+        return cond;
+    }
+
+    static Condition col_cond(const std::string &lhs, CompOp op, const std::string &rhs) {
+        Condition cond;
+        cond.lhs_col = TabCol{"t", lhs};
+        cond.op = op;
+        cond.is_rhs_val = false;
+        cond.rhs_col = TabCol{"t", rhs};
+        return cond;
+    }
+
+    // 逐个元组计算条件
+    bool eval(const std::vector<char> &tuple, const Condition &cond) {
+        auto lhs = std::find_if(cols_.begin(), cols_.end(), [&](const ColMeta &c) { return c.name == cond.lhs_col.col_name; });
+        int cmp;
+        if (cond.is_rhs_val) {
+            std::vector<char> rhs(tuple.size(), 0);
+            memcpy(rhs.data() + lhs->offset, cond.rhs_val.raw->data, lhs->len);
+            cmp = compare_col(tuple, rhs, *lhs);
+        } else {
+            auto rhs = std::find_if(cols_.begin(), cols_.end(), [&](const ColMeta &c) { return c.name == cond.rhs_col.col_name; });
+            std::vector<char> other(tuple.size(), 0);
+            memcpy(other.data() + lhs->offset, tuple.data() + rhs->offset, lhs->len);
+            cmp = compare_col(tuple, other, *lhs);
+        }
+        switch (cond.op) {
+            case OP_EQ: return cmp == 0;
+            case OP_NE: return cmp != 0;
+            case OP_LT: return cmp < 0;
+            case OP_GT: return cmp > 0;
+            case OP_LE: return cmp <= 0;
+            case OP_GE: return cmp >= 0;
+            default: return false;
+        }
+    }
+};
+
+/**
+ * @brief DataChunk按列存放追加的元组，gather还原为行格式，满BATCH_SIZE行后full()
+ */
+TEST_F(ExecutionVectorTest, DataChunkTest) {
+    DataChunk chunk;
+    chunk.init(cols_);
+    EXPECT_EQ(chunk.size(), 0u);
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        EXPECT_FALSE(chunk.full());
+        chunk.append(tuples_[i].data());
+    }
+    EXPECT_TRUE(chunk.full());
+    EXPECT_EQ(chunk.count(), BATCH_SIZE);
+    std::vector<char> rec(tuples_[0].size());
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        EXPECT_EQ(chunk.sel(i), i);
+        for (size_t c = 0; c < cols_.size(); c++) {
+            EXPECT_EQ(memcmp(chunk.value(c, i), tuples_[i].data() + cols_[c].offset, cols_[c].len), 0);
+        }
+        chunk.gather(i, rec.data());
+        EXPECT_EQ(rec, tuples_[i]);
+    }
+    // int字段的列是连续的int数组
+    const int *a = reinterpret_cast<const int *>(chunk.column(0));
+    EXPECT_EQ(a[5], get_int(tuples_[5].data(), cols_[0]));
+
+    // 布局不变时init()只清空，不重新分配
+    const char *column = chunk.column(3);
+    chunk.init(cols_);
+    EXPECT_EQ(chunk.size(), 0u);
+    EXPECT_EQ(chunk.count(), 0u);
+    EXPECT_EQ(chunk.column(3), column);
+}
+
+/**
+ * @brief project()整列复制被选择的字段，有效行与输入相同
+ */
+TEST_F(ExecutionVectorTest, ProjectTest) {
+    DataChunk input;
+    input.init(cols_);
+    for (size_t i = 0; i < 100; i++) {
+        input.append(tuples_[i].data());
+    }
+    // 只保留偶数行
+    size_t n = 0;
+    for (size_t i = 0; i < input.count(); i += 2) {
+        input.sel_data()[n++] = i;
+    }
+    input.set_count(n);
+
+    std::vector<ColMeta> out_cols = {cols_[3], cols_[0]};
+    out_cols[0].offset = 0;
+    out_cols[1].offset = cols_[3].len;
+    DataChunk out;
+    out.init(out_cols);
+    out.project(input, {3, 0});
+    ASSERT_EQ(out.count(), 50u);
+    for (size_t i = 0; i < out.count(); i++) {
+        size_t row = out.sel(i);
+        EXPECT_EQ(row, 2 * i);
+        EXPECT_EQ(memcmp(out.value(0, row), tuples_[row].data() + cols_[3].offset, cols_[3].len), 0);
+        EXPECT_EQ(memcmp(out.value(1, row), tuples_[row].data() + cols_[0].offset, cols_[0].len), 0);
+    }
+}
+
+/**
+ * @brief BatchFilter对各种类型和比较运算符的结果与逐个元组计算相同，多个条件依次压缩有效行
+ */
+TEST_F(ExecutionVectorTest, BatchFilterTest) {
+    std::vector<std::vector<Condition>> cases;
+    for (CompOp op : {OP_EQ, OP_NE, OP_LT, OP_GT, OP_LE, OP_GE}) {
+        Value int_val, float_val, str_val;
+        int_val.set_int(3);
+        float_val.set_float(-1.25);
+        str_val.set_str("ab");
+        cases.push_back({val_cond("a", op, int_val, sizeof(int))});
+        cases.push_back({val_cond("f", op, float_val, sizeof(float))});
+        cases.push_back({val_cond("s", op, str_val, 8)});
+        cases.push_back({col_cond("a", op, "b")});
+        cases.push_back({col_cond("s", op, "r")});
+    }
+    Value lo, hi;
+    lo.set_int(-5);
+    hi.set_int(5);
+    cases.push_back({val_cond("a", OP_GE, lo, sizeof(int)), val_cond("b", OP_LT, hi, sizeof(int)), col_cond("s", OP_NE, "r")});
+
+    for (auto &conds : cases) {
+        BatchFilter filter(cols_, conds);
+        DataChunk chunk;
+        chunk.init(cols_);
+        size_t next = 0;
+        for (size_t begin = 0; begin < tuples_.size(); begin += BATCH_SIZE) {
+            chunk.reset();
+            for (size_t i = begin; i < std::min(begin + BATCH_SIZE, tuples_.size()); i++) {
+                chunk.append(tuples_[i].data());
+            }
+            filter.apply(chunk);
+            // 有效行升序，依次是满足所有条件的元组
+            for (size_t i = 0; i < chunk.count(); i++) {
+                size_t row = begin + chunk.sel(i);
+                while (next < row) {
+                    bool pass = std::all_of(conds.begin(), conds.end(), [&](auto &c) { return eval(tuples_[next], c); });
+                    EXPECT_FALSE(pass) << "tuple " << next << " should pass";
+                    next++;
+                }
+                for (auto &cond : conds) {
+                    EXPECT_TRUE(eval(tuples_[row], cond)) << "tuple " << row << " should not pass";
+                }
+                next = row + 1;
+            }
+        }
+        while (next < tuples_.size()) {
+            bool pass = std::all_of(conds.begin(), conds.end(), [&](auto &c) { return eval(tuples_[next], c); });
+            EXPECT_FALSE(pass) << "tuple " << next << " should pass";
+            next++;
+        }
+    }
+}
+
+/**
+ * @brief 按批投影与按元组投影的结果相同，儿子节点使用默认的NextBatch()
+ */
+TEST_F(ExecutionVectorTest, ProjectionNextBatchTest) {
+    std::vector<TabCol> sel_cols = {{"t", "s"}, {"t", "a"}, {"t", "f"}};
+    ProjectionExecutor by_tuple(std::make_unique<MockExecutor>(cols_, tuples_), sel_cols);
+    auto expected = collect(&by_tuple);
+
+    ProjectionExecutor by_batch(std::make_unique<MockExecutor>(cols_, tuples_), sel_cols);
+    std::vector<std::vector<char>> result;
+    DataChunk chunk;
+    by_batch.beginTuple();
+    while (by_batch.NextBatch(chunk)) {
+        EXPECT_LE(chunk.count(), BATCH_SIZE);
+        for (size_t i = 0; i < chunk.count(); i++) {
+            std::vector<char> rec(by_batch.tupleLen());
+            chunk.gather(chunk.sel(i), rec.data());
+            result.push_back(rec);
+        }
+    }
+    EXPECT_EQ(result, expected);
+}
+
+/**
+ * @brief 按批执行的排序和投影经过BatchAdapterExecutor逐个提供给只使用元组接口的流式聚合和LIMIT，
+ * 结果与不经过适配时相同
+ */
+TEST_F(ExecutionVectorTest, BatchAdapterTest) {
+    std::vector<TabCol> sel_cols = {{"t", "a"}, {"t", "s"}, {"t", "b"}};
+    auto pipeline = [&]() {
+        auto sort = std::make_unique<SortExecutor>(std::make_unique<MockExecutor>(cols_, tuples_),
+                                                   std::vector<TabCol>{{"t", "a"}, {"t", "s"}}, std::vector<bool>{false, true});
+        return std::make_unique<ProjectionExecutor>(std::move(sort), sel_cols);
+    };
+    auto expected = collect_batches(pipeline().get());
+    ASSERT_EQ(expected.size(), tuples_.size());
+
+    BatchAdapterExecutor adapter(pipeline());
+    EXPECT_EQ(collect(&adapter), expected);
+    // 再次beginTuple()得到相同的结果
+    EXPECT_EQ(collect(&adapter), expected);
+
+    std::vector<TabCol> group_cols = {{"t", "a"}, {"t", "s"}};
+    std::vector<AggExpr> aggs = {{AGG_COUNT, {"", "*"}, {"", "COUNT(*)"}}, {AGG_SUM, {"t", "b"}, {"", "SUM(b)"}}};
+    SortAggregateExecutor by_tuple(pipeline(), group_cols, aggs);
+    SortAggregateExecutor by_batch(std::make_unique<BatchAdapterExecutor>(pipeline()), group_cols, aggs);
+    auto groups = collect(&by_tuple);
+    EXPECT_GT(groups.size(), 1u);
+    EXPECT_EQ(collect(&by_batch), groups);
+
+    // LIMIT跨过多个批，OFFSET落在第二批中
+    LimitExecutor limit(std::make_unique<BatchAdapterExecutor>(pipeline()), BATCH_SIZE + 10, BATCH_SIZE + 5);
+    std::vector<std::vector<char>> range(expected.begin() + BATCH_SIZE + 5, expected.begin() + 2 * BATCH_SIZE + 15);
+    EXPECT_EQ(collect(&limit), range);
+}
@@ -0,0 +1,179 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <random>
+
+#include "execution/executor_hash_join.h"
+#include "gtest/gtest.h"
+#include "mock_executor.h"
+
+static Condition col_cond(const std::string &lhs_tab, const std::string &lhs_col, CompOp op, const std::string &rhs_tab,
+                          const std::string &rhs_col) {
+    Condition cond;
+    cond.lhs_col = TabCol{lhs_tab, lhs_col};
+    cond.op = op;
+    cond.is_rhs_val = false;
+    cond.rhs_col = TabCol{rhs_tab, rhs_col};
+    return cond;
+}
+
+class HashJoinTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> left_cols_ = make_cols("t", {{"a", TYPE_INT}, {"b", TYPE_INT}});
+    std::vector<ColMeta> right_cols_ = make_cols("u", {{"a", TYPE_INT}, {"c", TYPE_INT}});
+    std::vector<std::vector<char>> left_;
+    std::vector<std::vector<char>> right_;
+
+    // 生成两侧的元组，连接键在[0, num_keys)中随机取值
+    void generate(int num_left, int num_right, int num_keys) {
+        std::mt19937 rng(num_left * 31 + num_right);
+        for (int i = 0; i < num_left; i++) {
+            left_.push_back(make_tuple(left_cols_, {static_cast<double>(rng() % num_keys), static_cast<double>(i)}));
+        }
+        for (int i = 0; i < num_right; i++) {
+            right_.push_back(make_tuple(right_cols_, {static_cast<double>(rng() % num_keys), static_cast<double>(i)}));
+        }
+    }
+
+    // 用嵌套循环得到的结果，每项是(t.b, u.c)
+    std::vector<std::pair<int, int>> expected() {
+        std::vector<std::pair<int, int>> result;
+        for (auto &l : left_) {
+            for (auto &r : right_) {
+                if (get_int(l.data(), left_cols_[0]) == get_int(r.data(), right_cols_[0])) {
+                    result.emplace_back(get_int(l.data(), left_cols_[1]), get_int(r.data(), right_cols_[1]));
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<std::pair<int, int>> run(size_t mem_budget) {
+        HashJoinExecutor join(std::make_unique<MockExecutor>(left_cols_, left_),
+                              std::make_unique<MockExecutor>(right_cols_, right_),
+                              {col_cond("t", "a", OP_EQ, "u", "a")}, mem_budget);
+        auto &cols = join.cols();
+        std::vector<std::pair<int, int>> result;
+        for (auto &rec : collect(&join)) {
+            EXPECT_EQ(get_int(rec.data(), cols[0]), get_int(rec.data(), cols[2]));
+            result.emplace_back(get_int(rec.data(), cols[1]), get_int(rec.data(), cols[3]));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+/**
+ * @brief build侧完整地在内存中
+ */
+TEST_F(HashJoinTest, InMemoryTest) {
+    generate(2000, 500, 300);
+    EXPECT_EQ(run(HASH_JOIN_MEM), expected());
+}
+
+/**
+ * @brief build侧超出预算，第一层的分区仍超出预算时递归地再分区
+ */
+TEST_F(HashJoinTest, RecursiveSpillTest) {
+    generate(3000, 8000, 4000);
+    // 第一层每个分区约500项，每项12字节加上两个槽位，超出2KB的预算
+    EXPECT_EQ(run(2048), expected());
+    EXPECT_EQ(run(256), expected());
+}
+
+/**
+ * @brief 大量相同的key无法通过再分区变小时，直接对整个分区建表
+ */
+TEST_F(HashJoinTest, SkewedKeyTest) {
+    generate(200, 0, 1);
+    for (int i = 0; i < 1000; i++) {
+        right_.push_back(make_tuple(right_cols_, {i % 100 == 0 ? 1.0 : 0.0, static_cast<double>(i)}));
+    }
+    auto result = run(512);
+    EXPECT_EQ(result.size(), 200u * 990);
+    EXPECT_EQ(result, expected());
+}
+
+/**
+ * @brief 再次beginTuple()时得到相同的结果，溢出时重新读入两侧
+ */
+TEST_F(HashJoinTest, RescanTest) {
+    generate(500, 2000, 800);
+    for (size_t mem_budget : {HASH_JOIN_MEM, size_t(1024)}) {
+        HashJoinExecutor join(std::make_unique<MockExecutor>(left_cols_, left_),
+                              std::make_unique<MockExecutor>(right_cols_, right_),
+                              {col_cond("t", "a", OP_EQ, "u", "a")}, mem_budget);
+        auto first = collect(&join);
+        auto second = collect(&join);
+        std::sort(first.begin(), first.end());
+        std::sort(second.begin(), second.end());
+        EXPECT_EQ(first, second);
+        EXPECT_EQ(first.size(), expected().size());
+    }
+}
+
+/**
+ * @brief 长度不同的字符串字段不能作为连接键，在连接后的元组上比较，较长一边多出的部分为0时相等
+ */
+TEST_F(HashJoinTest, StringResidualTest) {
+    auto left_cols = make_cols("t", {{"a", TYPE_INT}, {"s", TYPE_STRING}}, 4);
+    auto right_cols = make_cols("u", {{"a", TYPE_INT}, {"s", TYPE_STRING}}, 8);
+    std::vector<std::vector<char>> left = {
+        make_tuple(left_cols, {1}, {"abc"}),
+        make_tuple(left_cols, {1}, {"abcd"}),
+        make_tuple(left_cols, {2}, {"xy"}),
+    };
+    std::vector<std::vector<char>> right = {
+        make_tuple(right_cols, {1}, {"abc"}),
+        make_tuple(right_cols, {1}, {"abcde"}),
+        make_tuple(right_cols, {1}, {"abcd"}),
+        make_tuple(right_cols, {2}, {"xy"}),
+        make_tuple(right_cols, {2}, {"xz"}),
+    };
+    HashJoinExecutor join(std::make_unique<MockExecutor>(left_cols, left),
+                          std::make_unique<MockExecutor>(right_cols, right),
+                          {col_cond("t", "a", OP_EQ, "u", "a"), col_cond("t", "s", OP_EQ, "u", "s")});
+    auto &cols = join.cols();
+    std::vector<std::pair<std::string, std::string>> result;
+    for (auto &rec : collect(&join)) {
+        result.emplace_back(std::string(rec.data() + cols[1].offset, strnlen(rec.data() + cols[1].offset, cols[1].len)),
+                            std::string(rec.data() + cols[3].offset, strnlen(rec.data() + cols[3].offset, cols[3].len)));
+    }
+    std::sort(result.begin(), result.end());
+    std::vector<std::pair<std::string, std::string>> expected = {{"abc", "abc"}, {"abcd", "abcd"}, {"xy", "xy"}};
+    EXPECT_EQ(result, expected);
+
+    // t.s < u.s：较短一边的值是较长一边的前缀时较小
+    HashJoinExecutor less(std::make_unique<MockExecutor>(left_cols, left),
+                          std::make_unique<MockExecutor>(right_cols, right),
+                          {col_cond("t", "a", OP_EQ, "u", "a"), col_cond("t", "s", OP_LT, "u", "s")});
+    EXPECT_EQ(collect(&less).size(), 4u);
+}
+
+/**
+ * @brief 按批输出与按元组输出的结果相同，包括溢出到分区和有其余条件的情况
+ */
+TEST_F(HashJoinTest, NextBatchTest) {
+    generate(3000, 2000, 800);
+    for (size_t mem_budget : {HASH_JOIN_MEM, size_t(2048)}) {
+        for (auto &conds : {std::vector<Condition>{col_cond("t", "a", OP_EQ, "u", "a")},
+                            std::vector<Condition>{col_cond("t", "a", OP_EQ, "u", "a"), col_cond("t", "b", OP_LT, "u", "c")}}) {
+            HashJoinExecutor by_tuple(std::make_unique<MockExecutor>(left_cols_, left_),
+                                      std::make_unique<MockExecutor>(right_cols_, right_), conds, mem_budget);
+            HashJoinExecutor by_batch(std::make_unique<MockExecutor>(left_cols_, left_),
+                                      std::make_unique<MockExecutor>(right_cols_, right_), conds, mem_budget);
+            auto expect = collect(&by_tuple);
+            EXPECT_FALSE(expect.empty());
+            EXPECT_EQ(collect_batches(&by_batch), expect);
+        }
+    }
+}
@@ -0,0 +1,212 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <unistd.h>
+
+#include "analyze/analyze.h"
+#include "execution/executor_index_scan.h"
+#include "execution/executor_seq_scan.h"
+#include "gtest/gtest.h"
+#include "optimizer/planner.h"
+#include "parser/parser.h"
+#include "recovery/log_manager.h"
+#include "transaction/concurrency/lock_manager.h"
+
+const std::string TEST_DB_NAME = "IndexScanTest_db";
+const std::string TEST_TAB_NAME = "t";
+const int NUM_ROWS = 2000;
+
+/**
+ * 表t(id, v)按id降序插入，表数据页面的顺序与索引key的顺序相反：
+ * 按key的顺序扫描时输出的id升序，按rid的顺序扫描时输出的id降序
+ */
+class IndexScanTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<SmManager> sm_;
+    std::unique_ptr<LockManager> lock_manager_;
+    std::unique_ptr<LogManager> log_manager_;
+    std::unique_ptr<Transaction> txn_;
+    std::unique_ptr<Context> context_;
+
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(1000, disk_manager_.get());
+        rm_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        sm_ = std::make_unique<SmManager>(disk_manager_.get(), buffer_pool_manager_.get(), rm_.get(), ix_manager_.get());
+        lock_manager_ = std::make_unique<LockManager>();
+        log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+        txn_ = std::make_unique<Transaction>(0);
+        context_ = std::make_unique<Context>(lock_manager_.get(), log_manager_.get(), txn_.get());
+
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            std::string cmd = "rm -rf " + TEST_DB_NAME;
+            if (system(cmd.c_str()) < 0) {
+                throw UnixError();
+            }
+        }
+        sm_->create_db(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        sm_->create_table(TEST_TAB_NAME, {{"id", TYPE_INT, 4}, {"v", TYPE_INT, 4}}, context_.get());
+        RmFileHandle *fh = sm_->fhs_.at(TEST_TAB_NAME).get();
+        for (int i = 0; i < NUM_ROWS; i++) {
+            int rec[2] = {NUM_ROWS - 1 - i, i};
+            fh->insert_record(reinterpret_cast<char *>(rec), context_.get());
+        }
+        sm_->create_index(TEST_TAB_NAME, {"id"}, context_.get());
+    }
+
+    void TearDown() override {
+        for (auto &entry : sm_->ihs_) {
+            ix_manager_->close_index(entry.second.get());
+        }
+        sm_->ihs_.clear();
+        for (auto &entry : sm_->fhs_) {
+            rm_->close_file(entry.second.get());
+        }
+        sm_->fhs_.clear();
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+    }
+
+    static Condition id_cond(CompOp op, int val) { return col_cond("id", op, val); }
+
+    static Condition col_cond(const std::string &col, CompOp op, int val) {
+        Condition cond;
+        cond.lhs_col = TabCol{TEST_TAB_NAME, col};
+        cond.op = op;
+        cond.is_rhs_val = true;
+        cond.rhs_val.set_int(val);
+        cond.rhs_val.init_raw(sizeof(int));
+        return cond;
+    }
+
+    // 扫描id在[lo, hi)中的元组，返回依次输出的id
+    std::vector<int> scan(int lo, int hi, IndexScanMode mode) {
+        IndexScanExecutor exec(sm_.get(), TEST_TAB_NAME, {id_cond(OP_GE, lo), id_cond(OP_LT, hi)}, {"id"}, context_.get(),
+                               mode);
+        std::vector<int> ids;
+        for (exec.beginTuple(); !exec.is_end(); exec.nextTuple()) {
+            int id;
+            memcpy(&id, exec.view().data, sizeof(int));
+            ids.push_back(id);
+        }
+        return ids;
+    }
+
+    // 执行一条SELECT语句的语法分析和查询计划生成，返回投影之下的计划
+    std::shared_ptr<Plan> select_plan(const std::string &sql) {
+        YY_BUFFER_STATE buf = yy_scan_string(sql.c_str());
+        EXPECT_EQ(yyparse(), 0);
+        yy_delete_buffer(buf);
+        Analyze analyze(sm_.get());
+        Planner planner(sm_.get());
+        auto plan = std::dynamic_pointer_cast<DMLPlan>(planner.do_planner(analyze.do_analyze(ast::parse_tree), context_.get()));
+        auto projection = std::dynamic_pointer_cast<ProjectionPlan>(plan->subplan_);
+        return projection->subplan_;
+    }
+
+    static std::vector<int> range(int lo, int hi, bool desc) {
+        std::vector<int> ids;
+        for (int i = lo; i < hi; i++) {
+            ids.push_back(i);
+        }
+        if (desc) {
+            std::reverse(ids.begin(), ids.end());
+        }
+        return ids;
+    }
+};
+
+/**
+ * @brief KEY_ORDER按key的顺序访问表数据
+ */
+TEST_F(IndexScanTest, KeyOrderTest) {
+    EXPECT_EQ(scan(100, 1100, IndexScanMode::KEY_ORDER), range(100, 1100, false));
+    EXPECT_EQ(scan(5, 10, IndexScanMode::KEY_ORDER), range(5, 10, false));
+}
+
+/**
+ * @brief RID_ORDER按页号访问表数据；范围内不足BITMAP_SCAN_MIN_ROWS个元组时仍按key的顺序
+ */
+TEST_F(IndexScanTest, RidOrderTest) {
+    EXPECT_EQ(scan(100, 1100, IndexScanMode::RID_ORDER), range(100, 1100, true));
+    EXPECT_EQ(scan(0, NUM_ROWS, IndexScanMode::RID_ORDER), range(0, NUM_ROWS, true));
+    int small = static_cast<int>(BITMAP_SCAN_MIN_ROWS) - 1;
+    EXPECT_EQ(scan(500, 500 + small, IndexScanMode::RID_ORDER), range(500, 500 + small, false));
+    int large = static_cast<int>(BITMAP_SCAN_MIN_ROWS);
+    EXPECT_EQ(scan(500, 500 + large, IndexScanMode::RID_ORDER), range(500, 500 + large, true));
+    EXPECT_TRUE(scan(10, 10, IndexScanMode::RID_ORDER).empty());
+}
+
+/**
+ * @brief INDEX_ONLY只从索引key构造元组，字段按索引中的顺序排列；
+ * 对索引字段的其余条件在构造出的元组上检查，结果与顺序扫描表数据后按key排序相同
+ */
+TEST_F(IndexScanTest, IndexOnlyTest) {
+    sm_->create_index(TEST_TAB_NAME, {"v", "id"}, context_.get());
+    std::vector<Condition> conds = {col_cond("v", OP_GE, 300), col_cond("v", OP_LT, 1300), col_cond("id", OP_NE, 1000)};
+
+    std::vector<std::pair<int, int>> expected;
+    SeqScanExecutor seq(sm_.get(), TEST_TAB_NAME, conds, context_.get());
+    for (seq.beginTuple(); !seq.is_end(); seq.nextTuple()) {
+        int rec[2];
+        memcpy(rec, seq.view().data, sizeof(rec));
+        expected.emplace_back(rec[1], rec[0]);
+    }
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(expected.size(), 999u);
+
+    IndexScanExecutor exec(sm_.get(), TEST_TAB_NAME, conds, {"v", "id"}, context_.get(), IndexScanMode::INDEX_ONLY);
+    EXPECT_EQ(exec.tupleLen(), 2 * sizeof(int));
+    std::vector<std::pair<int, int>> result;
+    for (exec.beginTuple(); !exec.is_end(); exec.nextTuple()) {
+        int key[2];
+        memcpy(key, exec.view().data, sizeof(key));
+        result.emplace_back(key[0], key[1]);
+        // rid仍指向表中的对应记录
+        auto rec = sm_->fhs_.at(TEST_TAB_NAME)->get_record(exec.rid(), context_.get());
+        int row[2];
+        memcpy(row, rec->data, sizeof(row));
+        EXPECT_EQ(row[0], key[1]);
+        EXPECT_EQ(row[1], key[0]);
+    }
+    EXPECT_EQ(result, expected);
+}
+
+/**
+ * @brief 输出字段、排序字段和条件涉及的字段都在索引中时选用覆盖索引扫描，否则仍访问表数据
+ */
+TEST_F(IndexScanTest, IndexOnlyPlanTest) {
+    auto scan_tag = [&](const std::string &sql) {
+        auto scan = std::dynamic_pointer_cast<ScanPlan>(select_plan(sql));
+        return scan == nullptr ? T_select : scan->tag;
+    };
+    EXPECT_EQ(scan_tag("select id from t where id > 100;"), T_IndexOnlyScan);
+    EXPECT_EQ(scan_tag("select id from t;"), T_IndexOnlyScan);
+    EXPECT_NE(scan_tag("select id, v from t where id > 100;"), T_IndexOnlyScan);
+    EXPECT_NE(scan_tag("select id from t where v > 100;"), T_IndexOnlyScan);
+    EXPECT_NE(scan_tag("select * from t where id = 5;"), T_IndexOnlyScan);
+
+    // 条件选用的索引不能覆盖时改用能覆盖的索引
+    sm_->create_index(TEST_TAB_NAME, {"v", "id"}, context_.get());
+    auto scan = std::dynamic_pointer_cast<ScanPlan>(select_plan("select v, id from t where v < 10;"));
+    ASSERT_NE(scan, nullptr);
+    EXPECT_EQ(scan->tag, T_IndexOnlyScan);
+    EXPECT_EQ(scan->index_col_names_, (std::vector<std::string>{"v", "id"}));
+}
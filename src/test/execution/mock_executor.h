@@ -0,0 +1,155 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "execution/executor_abstract.h"
+
+// 测试算子时使用的儿子节点，依次输出构造时给定的元组，不访问表和缓冲池
+class MockExecutor : public AbstractExecutor {
+   private:
+    std::vector<ColMeta> cols_;
+    size_t len_;
+    std::vector<std::vector<char>> tuples_;
+    size_t pos_;
+
+   public:
+    MockExecutor(std::vector<ColMeta> cols, std::vector<std::vector<char>> tuples)
+        : cols_(std::move(cols)), tuples_(std::move(tuples)) {
+        len_ = 0;
+        for (auto &col : cols_) {
+            len_ = std::max(len_, static_cast<size_t>(col.offset + col.len));
+        }
+        pos_ = tuples_.size();
+    }
+
+    size_t tupleLen() const override { return len_; };
+
+    const std::vector<ColMeta> &cols() const override { return cols_; };
+
+    std::string getType() override { return "MockExecutor"; };
+
+    bool is_end() const override { return pos_ >= tuples_.size(); };
+
+    // 当前元组的序号，用来检查上层算子从儿子节点取了多少元组
+    size_t pos() const { return pos_; }
+
+    void beginTuple() override { pos_ = 0; }
+
+    void nextTuple() override { pos_++; }
+
+    std::unique_ptr<RmRecord> Next() override { return view().to_record(); }
+
+    TupleView view() override { return TupleView(tuples_[pos_].data(), len_); }
+
+    Rid &rid() override { return _abstract_rid; }
+};
+
+// 依次排列的字段，offset由前面字段的长度累加得到
+inline std::vector<ColMeta> make_cols(const std::string &tab_name,
+                                      const std::vector<std::pair<std::string, ColType>> &names, int str_len = 8) {
+    std::vector<ColMeta> cols;
+    int offset = 0;
+    for (auto &[name, type] : names) {
+        int len = type == TYPE_STRING ? str_len : 4;
+        cols.push_back(ColMeta{tab_name, name, type, len, offset, false});
+        offset += len;
+    }
+    return cols;
+}
+
+// 按cols的布局拼接一个元组，int和float字段依次取vals中的值，字符串字段取strs中的值
+inline std::vector<char> make_tuple(const std::vector<ColMeta> &cols, const std::vector<double> &vals,
+                                    const std::vector<std::string> &strs = {}) {
+    std::vector<char> tuple(cols.back().offset + cols.back().len, 0);
+    size_t val = 0, str = 0;
+    for (auto &col : cols) {
+        char *dest = tuple.data() + col.offset;
+        if (col.type == TYPE_INT) {
+            int v = static_cast<int>(vals[val++]);
+            memcpy(dest, &v, sizeof(int));
+        } else if (col.type == TYPE_FLOAT) {
+            float v = static_cast<float>(vals[val++]);
+            memcpy(dest, &v, sizeof(float));
+        } else {
+            memcpy(dest, strs[str].data(), std::min<size_t>(strs[str].size(), col.len));
+            str++;
+        }
+    }
+    return tuple;
+}
+
+// 读出int字段
+inline int get_int(const char *rec, const ColMeta &col) {
+    int v;
+    memcpy(&v, rec + col.offset, sizeof(int));
+    return v;
+}
+
+// 按字段的类型比较两个元组中的col字段，字符串按memcmp比较
+inline int compare_col(const std::vector<char> &x, const std::vector<char> &y, const ColMeta &col) {
+    const char *a = x.data() + col.offset;
+    const char *b = y.data() + col.offset;
+    if (col.type == TYPE_INT) {
+        int ia = get_int(x.data(), col), ib = get_int(y.data(), col);
+        return (ia > ib) - (ia < ib);
+    } else if (col.type == TYPE_FLOAT) {
+        float fa, fb;
+        memcpy(&fa, a, sizeof(float));
+        memcpy(&fb, b, sizeof(float));
+        return (fa > fb) - (fa < fb);
+    }
+    return memcmp(a, b, col.len);
+}
+
+// 用std::stable_sort按cols中下标为keys的字段排序，作为排序算子的预期结果
+inline std::vector<std::vector<char>> stable_sorted(std::vector<std::vector<char>> tuples,
+                                                    const std::vector<ColMeta> &cols, const std::vector<size_t> &keys,
+                                                    const std::vector<bool> &is_desc) {
+    std::stable_sort(tuples.begin(), tuples.end(), [&](const std::vector<char> &x, const std::vector<char> &y) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            int cmp = compare_col(x, y, cols[keys[i]]);
+            if (cmp != 0) {
+                return is_desc[i] ? cmp > 0 : cmp < 0;
+            }
+        }
+        return false;
+    });
+    return tuples;
+}
+
+// 按元组接口取出儿子节点的全部输出，每个元组按行格式复制
+inline std::vector<std::vector<char>> collect(AbstractExecutor *exec) {
+    std::vector<std::vector<char>> out;
+    for (exec->beginTuple(); !exec->is_end(); exec->nextTuple()) {
+        TupleView rec = exec->view();
+        out.emplace_back(rec.data, rec.data + exec->tupleLen());
+    }
+    return out;
+}
+
+// 按批取出儿子节点的全部输出，每个有效行按行格式复制
+inline std::vector<std::vector<char>> collect_batches(AbstractExecutor *exec) {
+    std::vector<std::vector<char>> out;
+    DataChunk chunk;
+    exec->beginTuple();
+    while (exec->NextBatch(chunk)) {
+        for (size_t i = 0; i < chunk.count(); i++) {
+            out.emplace_back(exec->tupleLen());
+            chunk.gather(chunk.sel(i), out.back().data());
+        }
+    }
+    return out;
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <random>
+
+#include "execution/execution_sort.h"
+#include "gtest/gtest.h"
+#include "mock_executor.h"
+
+class SortTest : public ::testing::Test {
+   public:
+    // id是输入的序号，用来检查键相同的元组保持输入的顺序
+    std::vector<ColMeta> cols_ = make_cols("t", {{"a", TYPE_INT}, {"f", TYPE_FLOAT}, {"s", TYPE_STRING}, {"id", TYPE_INT}});
+    std::vector<std::vector<char>> tuples_;
+
+    void generate(int num, int num_keys) {
+        std::mt19937 rng(num);
+        const char *strs[] = {"", "a", "ab", "abc", "b", "ba", "zzzzzzzz"};
+        for (int i = 0; i < num; i++) {
+            double a = static_cast<int>(rng() % num_keys) - num_keys / 2;
+            double f = (static_cast<int>(rng() % 200) - 100) / 4.0;
+            tuples_.push_back(make_tuple(cols_, {a, f, static_cast<double>(i)}, {strs[rng() % 7]}));
+        }
+    }
+
+    std::vector<std::vector<char>> expected(const std::vector<size_t> &keys, const std::vector<bool> &is_desc) {
+        return stable_sorted(tuples_, cols_, keys, is_desc);
+    }
+
+    std::vector<std::vector<char>> run(const std::vector<size_t> &keys, const std::vector<bool> &is_desc,
+                                       size_t mem_budget) {
+        std::vector<TabCol> sel_cols;
+        for (size_t key : keys) {
+            sel_cols.push_back(TabCol{cols_[key].tab_name, cols_[key].name});
+        }
+        SortExecutor sort(std::make_unique<MockExecutor>(cols_, tuples_), sel_cols, is_desc, mem_budget);
+        return collect(&sort);
+    }
+};
+
+/**
+ * @brief 全部在内存中排序，多个排序键，升序和降序混合
+ */
+TEST_F(SortTest, InMemoryTest) {
+    generate(3000, 50);
+    EXPECT_EQ(run({0, 2}, {false, true}, SORT_MEM), expected({0, 2}, {false, true}));
+    EXPECT_EQ(run({1, 0}, {true, false}, SORT_MEM), expected({1, 0}, {true, false}));
+    EXPECT_EQ(run({2, 1, 0}, {false, false, true}, SORT_MEM), expected({2, 1, 0}, {false, false, true}));
+}
+
+/**
+ * @brief 超出内存预算时写出多个有序的临时文件再归并，结果与内存中排序相同并且是稳定的
+ */
+TEST_F(SortTest, ExternalSortTest) {
+    generate(5000, 20);
+    for (size_t mem_budget : {size_t(4096), size_t(64 << 10)}) {
+        EXPECT_EQ(run({0}, {false}, mem_budget), expected({0}, {false}));
+        EXPECT_EQ(run({2, 1}, {true, false}, mem_budget), expected({2, 1}, {true, false}));
+        EXPECT_EQ(run({1, 2, 0}, {false, true, true}, mem_budget), expected({1, 2, 0}, {false, true, true}));
+    }
+}
+
+/**
+ * @brief 空输入和再次beginTuple()
+ */
+TEST_F(SortTest, RescanTest) {
+    SortExecutor empty(std::make_unique<MockExecutor>(cols_, tuples_), {TabCol{"t", "a"}}, {false}, 1024);
+    empty.beginTuple();
+    EXPECT_TRUE(empty.is_end());
+
+    generate(2000, 10);
+    SortExecutor sort(std::make_unique<MockExecutor>(cols_, tuples_), {TabCol{"t", "s"}}, {true}, 2048);
+    auto first = collect(&sort);
+    EXPECT_EQ(first, expected({2}, {true}));
+    EXPECT_EQ(collect(&sort), first);
+}
+
+/**
+ * @brief 按批输出与按元组输出的结果相同，包括全部在内存中和归并临时文件两种情况
+ */
+TEST_F(SortTest, NextBatchTest) {
+    generate(5000, 20);
+    for (size_t mem_budget : {SORT_MEM, size_t(4096)}) {
+        SortExecutor sort(std::make_unique<MockExecutor>(cols_, tuples_), {TabCol{"t", "s"}, TabCol{"t", "f"}},
+                          {false, true}, mem_budget);
+        EXPECT_EQ(collect_batches(&sort), expected({2, 1}, {false, true}));
+        EXPECT_EQ(collect_batches(&sort), collect(&sort));
+    }
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <random>
+
+#include "execution/executor_limit.h"
+#include "execution/executor_topn.h"
+#include "gtest/gtest.h"
+#include "mock_executor.h"
+
+class TopNLimitTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> cols_ = make_cols("t", {{"a", TYPE_INT}, {"f", TYPE_FLOAT}, {"s", TYPE_STRING}, {"id", TYPE_INT}});
+    std::vector<std::vector<char>> tuples_;
+
+    void SetUp() override {
+        std::mt19937 rng(2023);
+        const char *strs[] = {"", "a", "ab", "b", "zzzzzzzz"};
+        for (int i = 0; i < 3000; i++) {
+            double a = static_cast<int>(rng() % 40) - 20;
+            double f = (static_cast<int>(rng() % 100) - 50) / 2.0;
+            tuples_.push_back(make_tuple(cols_, {a, f, static_cast<double>(i)}, {strs[rng() % 5]}));
+        }
+    }
+
+    std::unique_ptr<TopNExecutor> topn(const std::vector<size_t> &keys, const std::vector<bool> &is_desc, size_t n) {
+        std::vector<TabCol> sel_cols;
+        for (size_t key : keys) {
+            sel_cols.push_back(TabCol{cols_[key].tab_name, cols_[key].name});
+        }
+        return std::make_unique<TopNExecutor>(std::make_unique<MockExecutor>(cols_, tuples_), sel_cols, is_desc, n);
+    }
+
+    // 排序后下标在[begin, end)中的元组
+    std::vector<std::vector<char>> expected(const std::vector<size_t> &keys, const std::vector<bool> &is_desc,
+                                            size_t begin, size_t end) {
+        auto sorted = stable_sorted(tuples_, cols_, keys, is_desc);
+        begin = std::min(begin, sorted.size());
+        end = std::min(end, sorted.size());
+        return std::vector<std::vector<char>>(sorted.begin() + begin, sorted.begin() + end);
+    }
+};
+
+/**
+ * @brief TopN的结果与稳定排序后的前n个元组相同，包括n为0和n超过输入元组数
+ */
+TEST_F(TopNLimitTest, TopNTest) {
+    for (size_t n : {0, 1, 10, 500, 3000, 5000}) {
+        EXPECT_EQ(collect(topn({0}, {false}, n).get()), expected({0}, {false}, 0, n));
+        EXPECT_EQ(collect(topn({2, 1}, {true, false}, n).get()), expected({2, 1}, {true, false}, 0, n));
+        EXPECT_EQ(collect(topn({1, 0, 2}, {false, true, true}, n).get()), expected({1, 0, 2}, {false, true, true}, 0, n));
+    }
+}
+
+/**
+ * @brief LIMIT/OFFSET跳过前offset个元组后最多输出limit个，输出够后不再向儿子节点取元组
+ */
+TEST_F(TopNLimitTest, LimitTest) {
+    auto run = [&](size_t limit, size_t offset) {
+        auto child = std::make_unique<MockExecutor>(cols_, tuples_);
+        MockExecutor *mock = child.get();
+        LimitExecutor exec(std::move(child), limit, offset);
+        auto result = collect(&exec);
+        size_t end = std::min(offset + limit, tuples_.size());
+        EXPECT_EQ(result, std::vector<std::vector<char>>(tuples_.begin() + std::min(offset, end), tuples_.begin() + end));
+        return mock->pos();
+    };
+    // 最后一个输出的元组是儿子节点的第offset+limit-1个
+    EXPECT_EQ(run(10, 0), 9u);
+    EXPECT_EQ(run(10, 5), 14u);
+    EXPECT_EQ(run(1, 2999), 2999u);
+    EXPECT_EQ(run(100, 2950), tuples_.size());
+    EXPECT_EQ(run(10, 5000), tuples_.size());
+    // limit为0时不读儿子节点
+    EXPECT_EQ(run(0, 0), tuples_.size());
+}
+
+/**
+ * @brief ORDER BY ... LIMIT ... OFFSET的计划：TopN保留前offset+limit个，Limit再跳过前offset个
+ */
+TEST_F(TopNLimitTest, TopNWithOffsetTest) {
+    for (auto [limit, offset] : std::vector<std::pair<size_t, size_t>>{{10, 0}, {10, 20}, {100, 2950}, {5, 4000}}) {
+        LimitExecutor exec(topn({2, 0}, {false, true}, limit + offset), limit, offset);
+        EXPECT_EQ(collect(&exec), expected({2, 0}, {false, true}, offset, offset + limit));
+    }
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+// 多线程访问同一个B+树索引的吞吐：每个线程按给定比例执行点查、插入和删除，
+// 分别在整棵树一把互斥锁（原实现）和结点读写锁的latch crabbing两种方式下运行，比较随线程数的扩展性
+// 用法: b_plus_tree_concurrent_benchmark [预先插入的key数] [每个线程的操作数] [点查所占百分比]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "index/ix.h"
+
+const std::string BENCH_TABLE_NAME = "BPlusTreeBenchmarkTable";
+const std::vector<ColMeta> BENCH_COLS = {{BENCH_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+/**
+ * @description: threads个线程各执行ops_per_thread次操作，返回耗时（秒）。
+ * 预先插入的key为[0,2*num_keys)中的偶数，线程t插入和删除的key为奇数且互不重叠；
+ * global_latch不为空时每次操作都持有它，模拟整棵树只有一把锁的情况
+ */
+static double run_round(IxIndexHandle *ih, int num_keys, int threads, int ops_per_thread, int lookup_percent,
+                        std::mutex *global_latch) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([=]() {
+            Transaction txn(t);
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<int> lookup_dist(0, num_keys - 1);
+            std::uniform_int_distribution<int> op_dist(0, 99);
+            std::vector<int> inserted;
+            int next_key = 2 * (t * ops_per_thread) + 1;
+            for (int i = 0; i < ops_per_thread; i++) {
+                std::unique_lock<std::mutex> lock;
+                if (global_latch != nullptr) {
+                    lock = std::unique_lock<std::mutex>(*global_latch);
+                }
+                int op = op_dist(rng);
+                if (op < lookup_percent) {
+                    int key = 2 * lookup_dist(rng);
+                    std::vector<Rid> result;
+                    if (!ih->get_value(reinterpret_cast<const char *>(&key), &result, &txn)) {
+                        throw InternalError("benchmark: preloaded key not found");
+                    }
+                } else if (op % 2 == 1 || inserted.empty()) {
+                    int key = next_key;
+                    next_key += 2;
+                    ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, &txn);
+                    inserted.push_back(key);
+                } else {
+                    int key = inserted.back();
+                    inserted.pop_back();
+                    ih->delete_entry(reinterpret_cast<const char *>(&key), &txn);
+                }
+            }
+            // 清理本线程插入的key，使下一轮从同样的树开始
+            for (int key : inserted) {
+                ih->delete_entry(reinterpret_cast<const char *>(&key), &txn);
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    int num_keys = argc > 1 ? std::stoi(argv[1]) : 200000;
+    int ops_per_thread = argc > 2 ? std::stoi(argv[2]) : 200000;
+    int lookup_percent = argc > 3 ? std::stoi(argv[3]) : 80;
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(BUFFER_POOL_SIZE, &disk_manager);
+    IxManager ix_manager(&disk_manager, &buffer_pool_manager);
+    if (ix_manager.exists(BENCH_TABLE_NAME, BENCH_COLS)) {
+        ix_manager.destroy_index(BENCH_TABLE_NAME, BENCH_COLS);
+    }
+    ix_manager.create_index(BENCH_TABLE_NAME, BENCH_COLS);
+    auto ih = ix_manager.open_index(BENCH_TABLE_NAME, BENCH_COLS);
+
+    Transaction txn(0);
+    for (int i = 0; i < num_keys; i++) {
+        int key = 2 * i;
+        ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, &txn);
+    }
+
+    std::cout << "keys=" << num_keys << " ops/thread=" << ops_per_thread << " lookup=" << lookup_percent << "%"
+              << " hardware threads=" << std::thread::hardware_concurrency() << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(18) << "tree mutex Mops/s"
+              << std::setw(18) << "crabbing Mops/s" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::mutex global_latch;
+        double total_ops = static_cast<double>(threads) * ops_per_thread;
+        double serialized = run_round(ih.get(), num_keys, threads, ops_per_thread, lookup_percent, &global_latch);
+        double latched = run_round(ih.get(), num_keys, threads, ops_per_thread, lookup_percent, nullptr);
+        std::cout << std::left << std::setw(10) << threads << std::right << std::setw(18) << std::fixed
+                  << std::setprecision(3) << total_ops / serialized / 1e6 << std::setw(18) << total_ops / latched / 1e6
+                  << std::endl;
+    }
+
+    ix_manager.close_index(ih.get());
+    ix_manager.destroy_index(BENCH_TABLE_NAME, BENCH_COLS);
+    return 0;
+}
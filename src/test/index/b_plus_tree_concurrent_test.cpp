@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -67,7 +69,8 @@ class BPlusTreeConcurrentTest : public ::testing::Test {
         coldef.push_back({"col1", TYPE_INT, 4});
         coldef.push_back({"col2", TYPE_INT, 4});
         sm_->create_table(TEST_FILE_NAME, coldef, nullptr);
-        sm_->create_index(TEST_FILE_NAME, TEST_COL, nullptr);
+        // 测试唯一索引，由IxManager直接创建；sm_->create_index创建的是非唯一索引，并且需要持有表锁的Context
+        ix_manager_->create_index(TEST_FILE_NAME, {*sm_->db_.get_table(TEST_FILE_NAME).get_col(TEST_COL[0])});
         assert(ix_manager_->exists(TEST_FILE_NAME, TEST_COL));
         // 打开测试文件
         ih_ = ix_manager_->open_index(TEST_FILE_NAME, TEST_COL);
@@ -154,19 +157,17 @@ class BPlusTreeConcurrentTest : public ::testing::Test {
             }
             // Print leaves
             for (int i = 0; i < inner->get_size(); i++) {
-                IxNodeHandle *child_node = ih->fetch_node(inner->value_at(i));
-                ToGraph(ih, child_node, bpm, out);  // 继续递归
+                IxNodeHandle child_node = ih->fetch_node(inner->value_at(i));
+                ToGraph(ih, &child_node, bpm, out);  // 继续递归
                 if (i > 0) {
-                    IxNodeHandle *sibling_node = ih->fetch_node(inner->value_at(i - 1));
-                    if (!sibling_node->is_leaf_page() && !child_node->is_leaf_page()) {
-                        out << "{rank=same " << internal_prefix << sibling_node->get_page_no() << " " << internal_prefix
-                            << child_node->get_page_no() << "};\n";
+                    IxNodeHandle sibling_node = ih->fetch_node(inner->value_at(i - 1));
+                    if (!sibling_node.is_leaf_page() && !child_node.is_leaf_page()) {
+                        out << "{rank=same " << internal_prefix << sibling_node.get_page_no() << " " << internal_prefix
+                            << child_node.get_page_no() << "};\n";
                     }
-                    bpm->unpin_page(sibling_node->get_page_id(), false);
                 }
             }
         }
-        bpm->unpin_page(node->get_page_id(), false);
     }
 
     /**
@@ -179,8 +180,8 @@ class BPlusTreeConcurrentTest : public ::testing::Test {
         std::ofstream out(outf);
         out << "digraph G {" << std::endl;
         
-        IxNodeHandle *node = ih_->fetch_node(ih_->file_hdr_->root_page_);
-        ToGraph(ih_.get(), node, bpm, out);
+        IxNodeHandle node = ih_->fetch_node(ih_->file_hdr_->root_page_);
+        ToGraph(ih_.get(), &node, bpm, out);
         out << "}" << std::endl;
         out.close();
 
@@ -206,16 +207,13 @@ class BPlusTreeConcurrentTest : public ::testing::Test {
         // check leaf list
         page_id_t leaf_no = ih->file_hdr_->first_leaf_;
         while (leaf_no != IX_LEAF_HEADER_PAGE) {
-            IxNodeHandle *curr = ih->fetch_node(leaf_no);
-            IxNodeHandle *prev = ih->fetch_node(curr->get_prev_leaf());
-            IxNodeHandle *next = ih->fetch_node(curr->get_next_leaf());
+            IxNodeHandle curr = ih->fetch_node(leaf_no);
+            IxNodeHandle prev = ih->fetch_node(curr.get_prev_leaf());
+            IxNodeHandle next = ih->fetch_node(curr.get_next_leaf());
             // Ensure prev->next == curr && next->prev == curr
-            ASSERT_EQ(prev->get_next_leaf(), leaf_no);
-            ASSERT_EQ(next->get_prev_leaf(), leaf_no);
-            leaf_no = curr->get_next_leaf();
-            buffer_pool_manager_->unpin_page(curr->get_page_id(), false);
-            buffer_pool_manager_->unpin_page(prev->get_page_id(), false);
-            buffer_pool_manager_->unpin_page(next->get_page_id(), false);
+            ASSERT_EQ(prev.get_next_leaf(), leaf_no);
+            ASSERT_EQ(next.get_prev_leaf(), leaf_no);
+            leaf_no = curr.get_next_leaf();
         }
     }
 
@@ -226,33 +224,29 @@ class BPlusTreeConcurrentTest : public ::testing::Test {
      * @param now_page_no 当前遍历到的结点
      */
     void check_tree(const IxIndexHandle *ih, int now_page_no) {
-        IxNodeHandle *node = ih->fetch_node(now_page_no);
-        if (node->is_leaf_page()) {
-            buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        IxNodeHandle node = ih->fetch_node(now_page_no);
+        if (node.is_leaf_page()) {
             return;
         }
-        for (int i = 0; i < node->get_size(); i++) {                 // 遍历node的所有孩子
-            IxNodeHandle *child = ih->fetch_node(node->value_at(i));  // 第i个孩子
+        for (int i = 0; i < node.get_size(); i++) {                 // 遍历node的所有孩子
+            IxNodeHandle child = ih->fetch_node(node.value_at(i));  // 第i个孩子
             // check parent
-            assert(child->get_parent_page_no() == now_page_no);
+            assert(child.get_parent_page_no() == now_page_no);
             // check first key
-            int node_key = node->key_at(i);  // node的第i个key
-            int child_first_key = child->key_at(0);
-            int child_last_key = child->key_at(child->get_size() - 1);
+            int node_key = node.key_at(i);  // node的第i个key
+            int child_first_key = child.key_at(0);
+            int child_last_key = child.key_at(child.get_size() - 1);
             if (i != 0) {
                 // 除了第0个key之外，node的第i个key与其第i个孩子的第0个key的值相同
                 ASSERT_EQ(node_key, child_first_key);
             }
-            if (i + 1 < node->get_size()) {
+            if (i + 1 < node.get_size()) {
                 // 满足制约大小关系
-                ASSERT_LT(child_last_key, node->key_at(i + 1));  // child_last_key < node->KeyAt(i + 1)
+                ASSERT_LT(child_last_key, node.key_at(i + 1));  // child_last_key < node->KeyAt(i + 1)
             }
 
-            buffer_pool_manager_->unpin_page(child->get_page_id(), false);
-
-            check_tree(ih, node->value_at(i));  // 递归子树
+            check_tree(ih, node.value_at(i));  // 递归子树
         }
-        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
     }
 
     /**
@@ -462,4 +456,72 @@ TEST_F(BPlusTreeConcurrentTest, MixScaleTest) {
         scan.next();
     }
     EXPECT_EQ(size, keys.size() - delete_keys.size());
-}
\ No newline at end of file
+}
+/**
+ * @brief 插入、删除和查找同时进行；order很小，分裂、合并和重分配频繁发生并一直到达根结点
+ */
+TEST_F(BPlusTreeConcurrentTest, ConcurrentInsertDeleteTest) {
+    const int64_t preload = 2000;  // 预先插入的偶数key，整个过程中一直存在
+    const int64_t keys_per_writer = 1000;
+    const uint64_t writer_num = 8;
+    const uint64_t reader_num = 8;
+    const int order = 4;
+
+    assert(order > 2 && order <= ih_->file_hdr_->btree_order_);
+    ih_->file_hdr_->btree_order_ = order;
+
+    std::multimap<int, Rid> mock;
+    std::vector<int64_t> keys;
+    for (int64_t key = 0; key < 2 * preload; key += 2) {
+        keys.push_back(key);
+        mock.insert({static_cast<int>(key), Rid{0, static_cast<int>(key)}});
+    }
+    InsertHelper(ih_.get(), keys);
+
+    // 每个写线程负责一组交错的奇数key：全部乱序插入后，再删除其中的一半
+    std::vector<std::vector<int64_t>> insert_keys(writer_num), delete_keys(writer_num);
+    for (uint64_t w = 0; w < writer_num; w++) {
+        for (int64_t i = 0; i < keys_per_writer; i++) {
+            int64_t key = 2 * (i * writer_num + w) + 1;
+            insert_keys[w].push_back(key);
+            if (i % 2 == 0) {
+                delete_keys[w].push_back(key);
+            } else {
+                mock.insert({static_cast<int>(key), Rid{0, static_cast<int>(key)}});
+            }
+        }
+        std::shuffle(insert_keys[w].begin(), insert_keys[w].end(), std::default_random_engine(w));
+    }
+
+    std::atomic<uint64_t> writers_done{0};
+    auto writer = [&](uint64_t w) {
+        InsertHelper(ih_.get(), insert_keys[w]);
+        DeleteHelper(ih_.get(), delete_keys[w]);
+        writers_done++;
+    };
+    auto reader = [&](uint64_t r) {
+        Transaction transaction(0);
+        std::default_random_engine rng(r);
+        std::vector<Rid> rids;
+        while (writers_done < writer_num) {
+            int32_t key = static_cast<int32_t>(2 * (rng() % preload));
+            rids.clear();
+            EXPECT_TRUE(ih_->get_value((const char *)&key, &rids, &transaction));
+            ASSERT_EQ(rids.size(), 1);
+            EXPECT_EQ(rids[0].slot_no, key);
+        }
+    };
+
+    std::vector<std::thread> thread_group;
+    for (uint64_t w = 0; w < writer_num; w++) {
+        thread_group.emplace_back(writer, w);
+    }
+    for (uint64_t r = 0; r < reader_num; r++) {
+        thread_group.emplace_back(reader, r);
+    }
+    for (auto &thread : thread_group) {
+        thread.join();
+    }
+
+    check_all(ih_.get(), mock);
+}
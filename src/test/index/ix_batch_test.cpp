@@ -0,0 +1,139 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <random>
+
+#include "ix_test_fixture.h"
+
+const std::string TEST_TABLE_NAME = "IxBatchTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+class IxBatchTest : public IxTreeTest {
+   public:
+    std::map<int, std::vector<Rid>> expected_;
+
+    IxBatchTest() : IxTreeTest(TEST_TABLE_NAME, TEST_COLS, false) {}
+
+    int insert_batch(const std::vector<int> &keys, const std::vector<Rid> &rids) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            expected_[keys[i]].push_back(rids[i]);
+        }
+        return ih_->insert_entries(reinterpret_cast<const char *>(keys.data()), rids.data(), keys.size(), &txn_);
+    }
+
+    /**
+     * @brief 点查expected_中的每个key，并从头到尾扫描，检查key有序且每个key的rid集合与expected_一致
+     */
+    void check_tree() {
+        for (auto &[key, rids] : expected_) {
+            std::vector<Rid> result;
+            ASSERT_EQ(ih_->get_value(reinterpret_cast<const char *>(&key), &result, &txn_), !rids.empty());
+            ASSERT_EQ(sorted_rids(result), sorted_rids(rids)) << "key " << key;
+        }
+        std::map<int, std::vector<Rid>> scanned;
+        int prev_key = std::numeric_limits<int>::min();
+        for (IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+             scan.next()) {
+            int key;
+            Rid rid = scan.rid_and_key(reinterpret_cast<char *>(&key));
+            ASSERT_GE(key, prev_key);
+            prev_key = key;
+            scanned[key].push_back(rid);
+        }
+        for (auto &[key, rids] : expected_) {
+            ASSERT_EQ(sorted_rids(scanned[key]), sorted_rids(rids)) << "key " << key;
+        }
+    }
+};
+
+/**
+ * @brief 多批乱序的key批量插入，叶结点和内部结点多次分裂；批量删除一部分使叶结点合并或重分配，
+ * 包括删空整段连续的叶结点；每一步之后点查和扫描的结果都与预期一致
+ */
+TEST_F(IxBatchTest, InsertAndDeleteTest) {
+    std::mt19937 rng(20);
+    std::vector<std::pair<int, Rid>> all;
+    for (int batch = 0; batch < 5; batch++) {
+        std::vector<int> keys;
+        std::vector<Rid> rids;
+        for (int i = 0; i < 8000; i++) {
+            int key = static_cast<int>(rng() % 30000);
+            Rid rid{batch * 100 + i / 100 + 1, i % 100};
+            keys.push_back(key);
+            rids.push_back(rid);
+            all.emplace_back(key, rid);
+        }
+        ASSERT_EQ(insert_batch(keys, rids), static_cast<int>(keys.size()));
+        check_tree();
+    }
+
+    // 删除[5000, 15000)中的全部项和其余项中的一半，另外混入不存在的项
+    std::vector<int> keys;
+    std::vector<Rid> rids;
+    int to_delete = 0;
+    for (size_t i = 0; i < all.size(); i++) {
+        auto &[key, rid] = all[i];
+        if ((key >= 5000 && key < 15000) || i % 2 == 0) {
+            keys.push_back(key);
+            rids.push_back(rid);
+            auto &expected_rids = expected_[key];
+            expected_rids.erase(std::find(expected_rids.begin(), expected_rids.end(), rid));
+            to_delete++;
+        }
+    }
+    for (int i = 0; i < 100; i++) {
+        keys.push_back(i);
+        rids.push_back(Rid{-5, i});
+    }
+    ASSERT_EQ(ih_->delete_entries(reinterpret_cast<const char *>(keys.data()), rids.data(), keys.size(), &txn_),
+              to_delete);
+    check_tree();
+
+    // 删除之后继续逐条插入和批量插入
+    for (int key = 5000; key < 6000; key++) {
+        Rid rid{key, 7};
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    keys.clear();
+    rids.clear();
+    for (int key = 14000; key >= 9000; key--) {
+        keys.push_back(key);
+        rids.push_back(Rid{key, 8});
+    }
+    ASSERT_EQ(insert_batch(keys, rids), static_cast<int>(keys.size()));
+    check_tree();
+}
+
+/**
+ * @brief 唯一索引的批量插入跳过已存在的key，包括同一批中重复的key
+ */
+TEST_F(IxBatchTest, UniqueIndexTest) {
+    const std::string table_name = "IxBatchTestUnique";
+    const std::vector<ColMeta> cols = {{table_name, "col1", TYPE_INT, sizeof(int), 0, true}};
+    if (ix_manager_->exists(table_name, cols)) {
+        ix_manager_->destroy_index(table_name, cols);
+    }
+    ix_manager_->create_index(table_name, cols);
+    auto ih = ix_manager_->open_index(table_name, cols);
+    std::vector<int> keys = {5, 3, 5, 1, 3};
+    std::vector<Rid> rids = {{1, 0}, {1, 1}, {1, 2}, {1, 3}, {1, 4}};
+    ASSERT_EQ(ih->insert_entries(reinterpret_cast<const char *>(keys.data()), rids.data(), keys.size(), &txn_), 3);
+    std::vector<Rid> result;
+    int key = 5;
+    ASSERT_TRUE(ih->get_value(reinterpret_cast<const char *>(&key), &result, &txn_));
+    ASSERT_EQ(result.size(), 1u);
+    ASSERT_EQ(result[0], (Rid{1, 0}));
+    ix_manager_->close_index(ih.get());
+    ix_manager_->destroy_index(table_name, cols);
+}
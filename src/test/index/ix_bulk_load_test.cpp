@@ -0,0 +1,138 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+#include "ix_test_fixture.h"
+
+const std::string TEST_TABLE_NAME = "IxBulkLoadTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+class IxBulkLoadTest : public IxTreeTest {
+   public:
+    IxBulkLoadTest() : IxTreeTest(TEST_TABLE_NAME, TEST_COLS) {}
+
+    /**
+     * @brief 点查每个key，并从头到尾遍历叶结点，检查索引中的内容与expected完全一致
+     */
+    void check_tree(const std::map<int, Rid> &expected) {
+        for (auto &[key, rid] : expected) {
+            std::vector<Rid> result;
+            ASSERT_TRUE(ih_->get_value(reinterpret_cast<const char *>(&key), &result, &txn_));
+            ASSERT_EQ(result.size(), 1u);
+            ASSERT_EQ(result[0], rid);
+        }
+        auto it = expected.begin();
+        for (IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+             scan.next()) {
+            ASSERT_NE(it, expected.end());
+            ASSERT_EQ(scan.rid(), it->second);
+            ++it;
+        }
+        ASSERT_EQ(it, expected.end());
+    }
+};
+
+/**
+ * @brief 乱序且含重复key的输入分多个临时文件排序后批量构建，结果与逐条插入一致，之后仍可正常插入删除
+ */
+TEST_F(IxBulkLoadTest, SpillAndModifyTest) {
+    const int num_rows = 20000;
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> dist(0, num_rows);
+    std::map<int, Rid> expected;
+    // 排序缓冲区只能放下约1000项
+    IxBulkLoader loader(ih_.get(), 0.7, 1000 * (sizeof(int) + sizeof(Rid) + sizeof(size_t)));
+    for (int i = 0; i < num_rows; i++) {
+        int key = dist(rng);
+        Rid rid{i / 100 + 1, i % 100};
+        loader.add(reinterpret_cast<const char *>(&key), rid);
+        // 重复的key保留表扫描中最先出现的记录
+        expected.emplace(key, rid);
+    }
+    loader.finish();
+    EXPECT_GT(loader.num_runs(), 10u);
+    check_tree(expected);
+
+    for (int i = 0; i < num_rows; i++) {
+        int key = dist(rng);
+        if (i % 2 == 0) {
+            Rid rid{-1, i};
+            ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_);
+            expected.emplace(key, rid);
+        } else {
+            EXPECT_EQ(ih_->delete_entry(reinterpret_cast<const char *>(&key), &txn_), expected.erase(key) == 1);
+        }
+    }
+    check_tree(expected);
+}
+
+/**
+ * @brief 空输入保留空的根结点；每个结点恰好填满时根结点有btree_order个孩子的边界情况
+ */
+TEST_F(IxBulkLoadTest, BoundaryTest) {
+    {
+        IxBulkLoader loader(ih_.get());
+        loader.finish();
+        check_tree({});
+        ASSERT_EQ(ih_->leaf_begin(), ih_->leaf_end());
+    }
+    // 填充比例为1时每个结点恰好有btree_order个key
+    std::map<int, Rid> expected;
+    IxBulkLoader loader(ih_.get(), 1.0);
+    int btree_order = static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr)) / (sizeof(int) + sizeof(Rid)) - 1);
+    for (int key = 0; key < btree_order * btree_order; key++) {
+        Rid rid{key, 0};
+        loader.add(reinterpret_cast<const char *>(&key), rid);
+        expected.emplace(key, rid);
+    }
+    loader.finish();
+    check_tree(expected);
+}
+
+/**
+ * @brief 文件头中的标识或版本与IX_FILE_VERSION不一致时拒绝打开，并关闭已打开的文件
+ */
+TEST_F(IxBulkLoadTest, FileFormatVersionTest) {
+    ix_manager_->close_index(ih_.get());
+    ih_.reset();
+
+    std::string ix_name = ix_manager_->get_index_name(TEST_TABLE_NAME, TEST_COLS);
+    char page[PAGE_SIZE];
+    int fd = disk_manager_->open_file(ix_name);
+    disk_manager_->read_page(fd, IX_FILE_HDR_PAGE, page, PAGE_SIZE);
+    disk_manager_->close_file(fd);
+    uint32_t magic, version;
+    memcpy(&magic, page, sizeof(uint32_t));
+    memcpy(&version, page + sizeof(uint32_t), sizeof(uint32_t));
+    EXPECT_EQ(magic, IX_FILE_MAGIC);
+    EXPECT_EQ(version, IX_FILE_VERSION);
+
+    // 模拟旧版本的文件
+    auto rewrite = [&](uint32_t version) {
+        char buf[PAGE_SIZE];
+        memcpy(buf, page, PAGE_SIZE);
+        memcpy(buf + sizeof(uint32_t), &version, sizeof(uint32_t));
+        int fd = disk_manager_->open_file(ix_name);
+        disk_manager_->write_page(fd, IX_FILE_HDR_PAGE, buf, PAGE_SIZE);
+        disk_manager_->close_file(fd);
+    };
+    rewrite(IX_FILE_VERSION - 1);
+    EXPECT_THROW(ix_manager_->open_index(TEST_TABLE_NAME, TEST_COLS), FileFormatError);
+
+    // 打开失败时文件已被关闭，可以再次打开；恢复版本号后正常打开
+    rewrite(IX_FILE_VERSION);
+    ih_ = ix_manager_->open_index(TEST_TABLE_NAME, TEST_COLS);
+    int key = 7;
+    ih_->insert_entry(reinterpret_cast<const char *>(&key), Rid{1, 2}, &txn_);
+    check_tree({{7, Rid{1, 2}}});
+}
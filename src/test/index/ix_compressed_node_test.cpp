@@ -0,0 +1,262 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+const int KEY_LEN = 64;
+const std::string TEST_TABLE_NAME = "IxCompressedNodeTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "name", TYPE_STRING, KEY_LEN, 0, true}};
+const std::string PLAIN_TABLE_NAME = "IxPlainNodeTestTable";
+const std::vector<ColMeta> PLAIN_COLS = {{PLAIN_TABLE_NAME, "name", TYPE_STRING, KEY_LEN, 0, true}};
+
+// 长度为KEY_LEN、末尾补0的字符串key
+static std::string make_key(const std::string &str) {
+    std::string key = str;
+    key.resize(KEY_LEN, '\0');
+    return key;
+}
+
+// 有很长公共前缀的key，与表中按编号生成的名字类似
+static std::string customer_key(int id) {
+    char buf[KEY_LEN];
+    snprintf(buf, sizeof(buf), "warehouse-01/district-07/customer-%06d", id);
+    return make_key(buf);
+}
+
+// 树的高度、叶结点数和内部结点数
+struct TreeStats {
+    int height = 0;
+    int num_leaves = 0;
+    int num_internal = 0;
+};
+
+class IxCompressedNodeTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<IxIndexHandle> ih_;      // 压缩格式的索引
+    std::unique_ptr<IxIndexHandle> plain_;   // 同样的key存放在定长结点中的索引
+    Transaction txn_{0};
+
+    void SetUp() override {
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        if (ix_manager_->exists(TEST_TABLE_NAME, TEST_COLS)) {
+            ix_manager_->destroy_index(TEST_TABLE_NAME, TEST_COLS);
+        }
+        if (ix_manager_->exists(PLAIN_TABLE_NAME, PLAIN_COLS)) {
+            ix_manager_->destroy_index(PLAIN_TABLE_NAME, PLAIN_COLS);
+        }
+        ix_manager_->create_index(TEST_TABLE_NAME, TEST_COLS, true, true);
+        ix_manager_->create_index(PLAIN_TABLE_NAME, PLAIN_COLS, true, false);
+        ih_ = ix_manager_->open_index(TEST_TABLE_NAME, TEST_COLS);
+        plain_ = ix_manager_->open_index(PLAIN_TABLE_NAME, PLAIN_COLS);
+        ASSERT_EQ(ih_->file_hdr_->key_format_, IX_KEY_COMPRESSED);
+        ASSERT_EQ(plain_->file_hdr_->key_format_, IX_KEY_NORMALIZED);
+    }
+
+    void TearDown() override {
+        ix_manager_->close_index(ih_.get());
+        ix_manager_->close_index(plain_.get());
+        ix_manager_->destroy_index(TEST_TABLE_NAME, TEST_COLS);
+        ix_manager_->destroy_index(PLAIN_TABLE_NAME, PLAIN_COLS);
+    }
+
+    TreeStats stats(IxIndexHandle *ih) {
+        TreeStats stats;
+        collect(ih, ih->file_hdr_->root_page_, 1, &stats);
+        return stats;
+    }
+
+    void collect(IxIndexHandle *ih, page_id_t page_no, int depth, TreeStats *stats) {
+        IxNodeHandle node = ih->fetch_node(page_no);
+        stats->height = std::max(stats->height, depth);
+        if (node.is_leaf_page()) {
+            stats->num_leaves++;
+            return;
+        }
+        stats->num_internal++;
+        for (int i = 0; i < node.get_size(); i++) {
+            collect(ih, node.value_at(i), depth + 1, stats);
+        }
+    }
+
+    /**
+     * @brief 检查压缩格式的结点：key有序且都在[下界, 上界)中，内部结点的第i个key等于第i个孩子的下界，
+     * 孩子的上界等于下一个key或父结点的上界，结点不超过容量
+     */
+    void check_structure(page_id_t page_no, const std::string &low, bool has_low, const std::string &high,
+                         bool has_high) {
+        IxNodeHandle node = ih_->fetch_node(page_no);
+        char buf[KEY_LEN];
+        ASSERT_EQ(node.read_low(buf), has_low);
+        ASSERT_EQ(std::string(buf, KEY_LEN), low);
+        ASSERT_EQ(node.read_high(buf), has_high);
+        ASSERT_EQ(std::string(buf, KEY_LEN), high);
+        ASSERT_LE(node.used_bytes(), IxNodeHandle::max_bytes(ih_->file_hdr_));
+        std::vector<std::string> keys;
+        for (int i = 0; i < node.get_size(); i++) {
+            node.read_key(i, buf);
+            keys.emplace_back(buf, KEY_LEN);
+            if (i > 0) {
+                ASSERT_LT(keys[i - 1], keys[i]);
+            }
+            ASSERT_TRUE(!has_low || keys[i] >= low);
+            ASSERT_TRUE(!has_high || keys[i] < high);
+            ASSERT_EQ(node.compare_key(i, buf), 0);
+        }
+        if (node.is_leaf_page()) {
+            return;
+        }
+        ASSERT_EQ(keys[0], low);
+        for (int i = 0; i < node.get_size(); i++) {
+            bool child_has_low = has_low || i > 0;
+            bool child_has_high = has_high || i + 1 < node.get_size();
+            std::string child_high = i + 1 < node.get_size() ? keys[i + 1] : high;
+            check_structure(node.value_at(i), keys[i], child_has_low, child_high, child_has_high);
+        }
+    }
+
+    // 点查和完整的有序扫描都与expected一致，压缩格式的索引还检查结点结构
+    void check_index(IxIndexHandle *ih, const std::map<std::string, Rid> &expected) {
+        for (auto &[key, rid] : expected) {
+            std::vector<Rid> result;
+            ASSERT_TRUE(ih->get_value(key.data(), &result, &txn_));
+            ASSERT_EQ(result.size(), 1u);
+            ASSERT_EQ(result[0], rid);
+        }
+        auto it = expected.begin();
+        char buf[KEY_LEN];
+        for (IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+             scan.next()) {
+            ASSERT_NE(it, expected.end());
+            ASSERT_EQ(scan.rid_and_key(buf), it->second);
+            ASSERT_EQ(std::string(buf, KEY_LEN), it->first);
+            ++it;
+        }
+        ASSERT_EQ(it, expected.end());
+        if (ih == ih_.get()) {
+            std::string zeros(KEY_LEN, '\0');
+            check_structure(ih_->file_hdr_->root_page_, zeros, false, zeros, false);
+        }
+    }
+};
+
+/**
+ * @brief 有长公共前缀的字符串key：压缩格式的结点只存公共前缀之后的后缀，扇出更大，
+ * 叶结点和内部结点都比定长格式少得多，树也更矮
+ * @note 最左和最右一列结点缺少一侧的上下界，没有公共前缀，key较少时内部结点都在这两列上，因此插入足够多的key
+ */
+TEST_F(IxCompressedNodeTest, FanoutTest) {
+    const int num_keys = 100000;
+    std::vector<int> ids(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        ids[i] = i * 7;
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(5));
+    std::map<std::string, Rid> expected;
+    for (int id : ids) {
+        std::string key = customer_key(id);
+        Rid rid{id / 100 + 1, id % 100};
+        ASSERT_TRUE(ih_->insert_entry(key.data(), rid, &txn_));
+        ASSERT_TRUE(plain_->insert_entry(key.data(), rid, &txn_));
+        expected.emplace(key, rid);
+    }
+    check_index(ih_.get(), expected);
+    check_index(plain_.get(), expected);
+
+    TreeStats compressed = stats(ih_.get());
+    TreeStats plain = stats(plain_.get());
+    EXPECT_LT(compressed.num_leaves * 3, plain.num_leaves);
+    EXPECT_LT(compressed.num_internal * 3, plain.num_internal);
+    EXPECT_LT(compressed.height, plain.height);
+}
+
+/**
+ * @brief 长短不一、互为前缀的key随机插入删除，分裂、合并和重分配后结点的上下界和分隔key仍然正确，最后删空
+ */
+TEST_F(IxCompressedNodeTest, InsertDeleteTest) {
+    std::mt19937 rng(17);
+    std::vector<std::string> pool;
+    for (int i = 0; i < 3000; i++) {
+        std::string str = "k" + std::to_string(rng() % 50);
+        int extra = rng() % 40;
+        for (int j = 0; j < extra; j++) {
+            str.push_back("ab\x01\xff"[rng() % 4]);
+        }
+        pool.push_back(make_key(str));
+    }
+    pool.push_back(make_key(""));
+    pool.push_back(make_key(std::string(KEY_LEN, '\xff')));
+    std::map<std::string, Rid> expected;
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 6000; i++) {
+            const std::string &key = pool[rng() % pool.size()];
+            if (rng() % 3 != 0) {
+                Rid rid{round, i};
+                EXPECT_EQ(ih_->insert_entry(key.data(), rid, &txn_), expected.emplace(key, rid).second);
+            } else {
+                EXPECT_EQ(ih_->delete_entry(key.data(), &txn_), expected.erase(key) == 1);
+            }
+        }
+        check_index(ih_.get(), expected);
+    }
+    for (auto &[key, rid] : expected) {
+        ASSERT_TRUE(ih_->delete_entry(key.data(), &txn_));
+    }
+    check_index(ih_.get(), {});
+}
+
+/**
+ * @brief 批量构建的压缩格式结点按字节数填充，同样比定长格式的叶结点少；构建后仍可正常插入删除
+ */
+TEST_F(IxCompressedNodeTest, BulkLoadTest) {
+    const int num_keys = 20000;
+    std::map<std::string, Rid> expected;
+    {
+        IxBulkLoader loader(ih_.get());
+        IxBulkLoader plain_loader(plain_.get());
+        for (int i = 0; i < num_keys; i++) {
+            std::string key = customer_key(i * 3);
+            Rid rid{i / 100 + 1, i % 100};
+            loader.add(key.data(), rid);
+            plain_loader.add(key.data(), rid);
+            expected.emplace(key, rid);
+        }
+        loader.finish();
+        plain_loader.finish();
+    }
+    check_index(ih_.get(), expected);
+    check_index(plain_.get(), expected);
+    EXPECT_LT(stats(ih_.get()).num_leaves * 3, stats(plain_.get()).num_leaves);
+
+    std::mt19937 rng(23);
+    for (int i = 0; i < num_keys; i++) {
+        std::string key = customer_key(rng() % (num_keys * 3));
+        if (i % 2 == 0) {
+            Rid rid{-1, i};
+            EXPECT_EQ(ih_->insert_entry(key.data(), rid, &txn_), expected.emplace(key, rid).second);
+        } else {
+            EXPECT_EQ(ih_->delete_entry(key.data(), &txn_), expected.erase(key) == 1);
+        }
+    }
+    check_index(ih_.get(), expected);
+}
@@ -0,0 +1,194 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>
+
+#include "ix_test_fixture.h"
+
+const std::string TEST_TABLE_NAME = "IxHashIndexTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+class IxHashIndexTest : public IxHashTest {
+   public:
+    std::map<int, std::vector<Rid>> expected_;
+
+    IxHashIndexTest() : IxHashTest(TEST_TABLE_NAME, TEST_COLS) {}
+
+    /**
+     * @brief 点查expected_中的每个key以及若干不存在的key，结果与expected_一致
+     */
+    void check_index() {
+        for (auto &[key, rids] : expected_) {
+            std::vector<Rid> result;
+            ASSERT_EQ(ih_->get_value(reinterpret_cast<const char *>(&key), &result, &txn_), !rids.empty());
+            ASSERT_EQ(sorted_rids(result), sorted_rids(rids)) << "key " << key;
+        }
+        for (int key = -1000; key < 0; key++) {
+            std::vector<Rid> result;
+            ASSERT_FALSE(ih_->get_value(reinterpret_cast<const char *>(&key), &result, &txn_));
+        }
+    }
+};
+
+/**
+ * @brief 大量不同的key使桶不断分裂、目录多次加倍；删除一半后点查结果仍然正确，
+ * 关闭再打开后目录和桶都从文件中恢复，可以继续插入
+ */
+TEST_F(IxHashIndexTest, SplitAndReopenTest) {
+    std::vector<std::pair<int, Rid>> entries;
+    for (int key = 0; key < 50000; key++) {
+        entries.emplace_back(key, Rid{key / 100 + 1, key % 100});
+    }
+    std::mt19937 rng(19);
+    std::shuffle(entries.begin(), entries.end(), rng);
+    for (auto &[key, rid] : entries) {
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    ASSERT_GE(ih_->get_global_depth(), 6);
+    check_index();
+
+    for (size_t i = 0; i < entries.size() / 2; i++) {
+        auto &[key, rid] = entries[i];
+        ASSERT_TRUE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        ASSERT_FALSE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].clear();
+    }
+    check_index();
+
+    int global_depth = ih_->get_global_depth();
+    ix_manager_->close_hash_index(ih_.get());
+    ih_ = ix_manager_->open_hash_index(TEST_TABLE_NAME, TEST_COLS);
+    ASSERT_EQ(ih_->get_global_depth(), global_depth);
+    check_index();
+
+    for (int key = 50000; key < 80000; key++) {
+        Rid rid{key / 100 + 1, key % 100};
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    check_index();
+}
+
+/**
+ * @brief 热点key的重复项超过一个桶的容量时放入溢出页，目录不会因此无限加倍；
+ * 删除溢出页中的项后页面被回收并重用
+ */
+TEST_F(IxHashIndexTest, DuplicateKeysTest) {
+    const int hot_key = 7;
+    std::vector<std::pair<int, Rid>> entries;
+    for (int i = 0; i < 20000; i++) {
+        int key = i % 2 == 0 ? hot_key : i % 300;
+        entries.emplace_back(key, Rid{i / 100 + 1, i % 100});
+    }
+    std::mt19937 rng(7);
+    std::shuffle(entries.begin(), entries.end(), rng);
+    for (auto &[key, rid] : entries) {
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    ASSERT_LT(ih_->get_global_depth(), IX_HASH_MAX_DEPTH);
+    check_index();
+
+    std::shuffle(entries.begin(), entries.end(), rng);
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto &[key, rid] = entries[i];
+        if (i % 4 != 0) {
+            ASSERT_TRUE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+            auto &rids = expected_[key];
+            rids.erase(std::find(rids.begin(), rids.end(), rid));
+        }
+    }
+    check_index();
+
+    for (int i = 0; i < 10000; i++) {
+        Rid rid{i + 1000, 0};
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&hot_key), rid, &txn_));
+        expected_[hot_key].push_back(rid);
+    }
+    check_index();
+}
+
+/**
+ * @brief 多个线程并发插入不同的key，之后每个key都能查到
+ */
+TEST_F(IxHashIndexTest, ConcurrentInsertTest) {
+    const int num_threads = 4;
+    const int keys_per_thread = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([this, t] {
+            Transaction txn(t + 1);
+            for (int i = 0; i < keys_per_thread; i++) {
+                int key = i * num_threads + t;
+                ih_->insert_entry(reinterpret_cast<const char *>(&key), Rid{key / 100 + 1, key % 100}, &txn);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int key = 0; key < num_threads * keys_per_thread; key++) {
+        expected_[key].push_back(Rid{key / 100 + 1, key % 100});
+    }
+    check_index();
+}
+
+/**
+ * @brief 文件头中的标识或版本与IX_HASH_FILE_VERSION不一致时拒绝打开，并关闭已打开的文件；
+ * B+树索引文件也不能作为哈希索引打开
+ */
+TEST_F(IxHashIndexTest, FileFormatVersionTest) {
+    int key = 7;
+    ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), Rid{1, 2}, &txn_));
+    expected_[key].push_back(Rid{1, 2});
+    ix_manager_->close_hash_index(ih_.get());
+    ih_.reset();
+
+    std::string ix_name = ix_manager_->get_index_name(TEST_TABLE_NAME, TEST_COLS);
+    char page[PAGE_SIZE];
+    int fd = disk_manager_->open_file(ix_name);
+    disk_manager_->read_page(fd, IX_FILE_HDR_PAGE, page, PAGE_SIZE);
+    disk_manager_->close_file(fd);
+    uint32_t magic, version;
+    memcpy(&magic, page, sizeof(uint32_t));
+    memcpy(&version, page + sizeof(uint32_t), sizeof(uint32_t));
+    EXPECT_EQ(magic, IX_HASH_FILE_MAGIC);
+    EXPECT_EQ(version, IX_HASH_FILE_VERSION);
+
+    // 模拟旧版本的文件
+    auto rewrite = [&](uint32_t version) {
+        char buf[PAGE_SIZE];
+        memcpy(buf, page, PAGE_SIZE);
+        memcpy(buf + sizeof(uint32_t), &version, sizeof(uint32_t));
+        int fd = disk_manager_->open_file(ix_name);
+        disk_manager_->write_page(fd, IX_FILE_HDR_PAGE, buf, PAGE_SIZE);
+        disk_manager_->close_file(fd);
+    };
+    rewrite(IX_HASH_FILE_VERSION + 1);
+    EXPECT_THROW(ix_manager_->open_hash_index(TEST_TABLE_NAME, TEST_COLS), FileFormatError);
+
+    // 打开失败时文件已被关闭，可以再次打开；恢复版本号后正常打开
+    rewrite(IX_HASH_FILE_VERSION);
+    ih_ = ix_manager_->open_hash_index(TEST_TABLE_NAME, TEST_COLS);
+    check_index();
+    ix_manager_->close_hash_index(ih_.get());
+    ih_.reset();
+
+    ix_manager_->destroy_index(TEST_TABLE_NAME, TEST_COLS);
+    ix_manager_->create_index(TEST_TABLE_NAME, TEST_COLS);
+    EXPECT_THROW(ix_manager_->open_hash_index(TEST_TABLE_NAME, TEST_COLS), FileFormatError);
+    ix_manager_->destroy_index(TEST_TABLE_NAME, TEST_COLS);
+    ix_manager_->create_hash_index(TEST_TABLE_NAME, TEST_COLS);
+    ih_ = ix_manager_->open_hash_index(TEST_TABLE_NAME, TEST_COLS);
+}
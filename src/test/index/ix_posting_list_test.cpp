@@ -0,0 +1,149 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <random>
+
+#include "ix_test_fixture.h"
+
+const std::string TEST_TABLE_NAME = "IxPostingListTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+class IxPostingListTest : public IxTreeTest {
+   public:
+    std::map<int, std::vector<Rid>> expected_;
+
+    IxPostingListTest() : IxTreeTest(TEST_TABLE_NAME, TEST_COLS, false) {}
+
+    /**
+     * @brief 点查每个key得到它的所有rid，并从头到尾扫描，检查每个key出现的次数和rid集合与expected_一致
+     */
+    void check_tree() {
+        for (auto &[key, rids] : expected_) {
+            std::vector<Rid> result;
+            ASSERT_EQ(ih_->get_value(reinterpret_cast<const char *>(&key), &result, &txn_), !rids.empty());
+            ASSERT_EQ(sorted_rids(result), sorted_rids(rids));
+        }
+        std::map<int, std::vector<Rid>> scanned;
+        int prev_key = std::numeric_limits<int>::min();
+        for (IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+             scan.next()) {
+            int key;
+            Rid rid = scan.rid_and_key(reinterpret_cast<char *>(&key));
+            ASSERT_EQ(rid, scan.rid());
+            ASSERT_GE(key, prev_key);
+            prev_key = key;
+            scanned[key].push_back(rid);
+        }
+        for (auto &[key, rids] : expected_) {
+            ASSERT_EQ(sorted_rids(scanned[key]), sorted_rids(rids)) << "key " << key;
+        }
+    }
+};
+
+/**
+ * @brief 少数几个key各有大量重复，其中热点key的posting list占多个页面；按(key, rid)删除一半后
+ * 点查和扫描的结果仍与预期一致，删除不存在的(key, rid)返回false，全部删除后key不再存在
+ */
+TEST_F(IxPostingListTest, DuplicateKeysTest) {
+    const int num_keys = 20;
+    const int hot_key = 7;
+    std::vector<std::pair<int, Rid>> entries;
+    for (int i = 0; i < 20000; i++) {
+        int key = i % 3 == 0 ? hot_key : i % num_keys;
+        entries.emplace_back(key, Rid{i / 100 + 1, i % 100});
+    }
+    // 只出现一次的key直接存放在叶结点中
+    for (int key = 100; key < 2000; key++) {
+        entries.emplace_back(key, Rid{key, 0});
+    }
+    std::mt19937 rng(18);
+    std::shuffle(entries.begin(), entries.end(), rng);
+    for (auto &[key, rid] : entries) {
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    ASSERT_GT(expected_[hot_key].size(), static_cast<size_t>(IX_POSTING_CAPACITY * 3));
+    check_tree();
+
+    std::shuffle(entries.begin(), entries.end(), rng);
+    for (size_t i = 0; i < entries.size() / 2; i++) {
+        auto &[key, rid] = entries[i];
+        ASSERT_TRUE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        auto &rids = expected_[key];
+        rids.erase(std::find(rids.begin(), rids.end(), rid));
+        // 同一项不能删除两次
+        ASSERT_FALSE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+    }
+    check_tree();
+
+    for (size_t i = entries.size() / 2; i < entries.size(); i++) {
+        auto &[key, rid] = entries[i];
+        ASSERT_TRUE(ih_->delete_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+    }
+    for (auto &[key, rids] : expected_) {
+        rids.clear();
+    }
+    check_tree();
+    ASSERT_EQ(ih_->leaf_begin(), ih_->leaf_end());
+}
+
+/**
+ * @brief 批量构建的非唯一索引保留重复key的所有rid，之后可以继续逐条插入删除；
+ * 删除整个key时它的posting list一起被删除
+ */
+TEST_F(IxPostingListTest, BulkLoadDuplicateKeysTest) {
+    IxBulkLoader loader(ih_.get());
+    for (int i = 0; i < 30000; i++) {
+        int key = i % 500 == 0 ? -1 : i % 97;
+        Rid rid{i / 100 + 1, i % 100};
+        loader.add(reinterpret_cast<const char *>(&key), rid);
+        expected_[key].push_back(rid);
+    }
+    loader.finish();
+    check_tree();
+
+    for (int i = 0; i < 2000; i++) {
+        int key = i % 7;
+        Rid rid{i + 1000, 0};
+        ASSERT_TRUE(ih_->insert_entry(reinterpret_cast<const char *>(&key), rid, &txn_));
+        expected_[key].push_back(rid);
+    }
+    int key = 3;
+    ASSERT_TRUE(ih_->delete_entry(reinterpret_cast<const char *>(&key), &txn_));
+    expected_[key].clear();
+    check_tree();
+}
+
+/**
+ * @brief 唯一索引不接受重复的key
+ */
+TEST_F(IxPostingListTest, UniqueIndexTest) {
+    const std::string table_name = "IxPostingListTestUnique";
+    const std::vector<ColMeta> cols = {{table_name, "col1", TYPE_INT, sizeof(int), 0, true}};
+    if (ix_manager_->exists(table_name, cols)) {
+        ix_manager_->destroy_index(table_name, cols);
+    }
+    ix_manager_->create_index(table_name, cols);
+    auto ih = ix_manager_->open_index(table_name, cols);
+    int key = 1;
+    ASSERT_TRUE(ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{1, 0}, &txn_));
+    ASSERT_FALSE(ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{1, 1}, &txn_));
+    std::vector<Rid> result;
+    ASSERT_TRUE(ih->get_value(reinterpret_cast<const char *>(&key), &result, &txn_));
+    ASSERT_EQ(result.size(), 1u);
+    ASSERT_EQ(result[0], (Rid{1, 0}));
+    ASSERT_FALSE(ih->delete_entry(reinterpret_cast<const char *>(&key), Rid{1, 1}, &txn_));
+    ASSERT_TRUE(ih->delete_entry(reinterpret_cast<const char *>(&key), Rid{1, 0}, &txn_));
+    ix_manager_->close_index(ih.get());
+    ix_manager_->destroy_index(table_name, cols);
+}
@@ -0,0 +1,163 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <map>
+#include <random>
+
+#include "ix_test_fixture.h"
+
+const std::string TEST_TABLE_NAME = "IxRangeScanTestTable";
+const std::vector<ColMeta> TEST_COLS = {{TEST_TABLE_NAME, "col1", TYPE_INT, sizeof(int), 0, true}};
+
+class IxRangeScanTest : public IxTreeTest {
+   public:
+    std::map<int, Rid> expected_;
+
+    IxRangeScanTest() : IxTreeTest(TEST_TABLE_NAME, TEST_COLS) {}
+
+    /**
+     * @brief 用[lower,upper)构造IxScan，检查扫描到的key和rid与expected_中对应区间的内容完全一致，
+     * 逆序扫描得到的顺序正好相反
+     */
+    void check_range(const Iid &lower, const Iid &upper, std::map<int, Rid>::const_iterator begin,
+                     std::map<int, Rid>::const_iterator end) {
+        auto it = begin;
+        for (IxScan scan(ih_.get(), lower, upper, buffer_pool_manager_.get()); !scan.is_end(); scan.next()) {
+            ASSERT_NE(it, end);
+            ASSERT_EQ(scan.rid(), it->second);
+            // 覆盖索引扫描直接读取key
+            int key;
+            ASSERT_EQ(scan.rid_and_key(reinterpret_cast<char *>(&key)), it->second);
+            ASSERT_EQ(key, it->first);
+            ++it;
+        }
+        ASSERT_EQ(it, end);
+        for (IxScan scan(ih_.get(), lower, upper, buffer_pool_manager_.get(), true); !scan.is_end(); scan.next()) {
+            ASSERT_NE(it, begin);
+            --it;
+            ASSERT_EQ(scan.rid(), it->second);
+        }
+        ASSERT_EQ(it, begin);
+    }
+};
+
+/**
+ * @brief 多个叶结点中只有偶数key，以叶结点边界两侧、不存在的key以及超出范围的key作为上下界，
+ * lower_bound/upper_bound得到的位置都能直接作为IxScan的起止位置
+ */
+TEST_F(IxRangeScanTest, BoundsAcrossLeavesTest) {
+    const int num_keys = 5000;
+    IxBulkLoader loader(ih_.get());
+    for (int i = 0; i < num_keys; i++) {
+        int key = i * 2;
+        Rid rid{i / 100 + 1, i % 100};
+        loader.add(reinterpret_cast<const char *>(&key), rid);
+        expected_.emplace(key, rid);
+    }
+    loader.finish();
+    ASSERT_NE(ih_->leaf_begin().page_no, ih_->leaf_end().page_no);
+
+    for (int lo = -3; lo <= num_keys * 2 + 2; lo += 37) {
+        for (int hi : {lo - 1, lo, lo + 1, lo + 500, lo + 3001, num_keys * 2 + 5}) {
+            const char *lo_key = reinterpret_cast<const char *>(&lo);
+            const char *hi_key = reinterpret_cast<const char *>(&hi);
+            if (lo <= hi) {
+                // lo <= key <= hi
+                check_range(ih_->lower_bound(lo_key), ih_->upper_bound(hi_key), expected_.lower_bound(lo),
+                            expected_.upper_bound(hi));
+            }
+            if (lo < hi) {
+                // lo < key < hi
+                check_range(ih_->upper_bound(lo_key), ih_->lower_bound(hi_key), expected_.upper_bound(lo),
+                            expected_.lower_bound(hi));
+            }
+        }
+    }
+    int below = -1;
+    int above = num_keys * 2;
+    EXPECT_EQ(ih_->upper_bound(reinterpret_cast<const char *>(&below)), ih_->leaf_begin());
+    EXPECT_EQ(ih_->lower_bound(reinterpret_cast<const char *>(&above)), ih_->leaf_end());
+}
+
+/**
+ * @brief (INT, CHAR(8))组合索引以规范化格式存储：逐条插入后扫描的顺序与逐字段比较的顺序一致，
+ * 以部分字段为前缀的范围可以直接定位，读出的key还原为插入时的格式
+ */
+TEST_F(IxRangeScanTest, NormalizedCompositeKeyTest) {
+    const std::string table_name = "IxRangeScanTestComposite";
+    const std::vector<ColMeta> cols = {{table_name, "col1", TYPE_INT, sizeof(int), 0, true},
+                                       {table_name, "col2", TYPE_STRING, 8, sizeof(int), true}};
+    if (ix_manager_->exists(table_name, cols)) {
+        ix_manager_->destroy_index(table_name, cols);
+    }
+    ix_manager_->create_index(table_name, cols);
+    auto ih = ix_manager_->open_index(table_name, cols);
+
+    auto make_key = [](int a, int b) {
+        std::string key(12, '\0');
+        memcpy(key.data(), &a, sizeof(int));
+        std::string str = "s" + std::to_string(b);
+        memcpy(key.data() + sizeof(int), str.data(), str.size());
+        return key;
+    };
+    std::map<std::pair<int, std::string>, Rid> expected;
+    Transaction txn(0);
+    std::mt19937 rng(5);
+    for (int i = 0; i < 4000; i++) {
+        int a = static_cast<int>(rng() % 41) - 20;
+        int b = static_cast<int>(rng() % 1000);
+        std::string key = make_key(a, b);
+        Rid rid{i / 100 + 1, i % 100};
+        if (expected.emplace(std::make_pair(a, key.substr(sizeof(int))), rid).second) {
+            ih->insert_entry(key.data(), rid, &txn);
+        }
+    }
+
+    auto it = expected.begin();
+    char key[12];
+    for (IxScan scan(ih.get(), ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+         scan.next()) {
+        ASSERT_NE(it, expected.end());
+        ASSERT_EQ(scan.rid_and_key(key), it->second);
+        ASSERT_EQ(*reinterpret_cast<int *>(key), it->first.first);
+        ASSERT_EQ(std::string(key + sizeof(int), 8), it->first.second);
+        ++it;
+    }
+    ASSERT_EQ(it, expected.end());
+
+    // 逐条插入分裂产生的叶结点也能沿prev_leaf逆序遍历
+    for (IxScan scan(ih.get(), ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get(), true); !scan.is_end();
+         scan.next()) {
+        ASSERT_NE(it, expected.begin());
+        --it;
+        ASSERT_EQ(scan.rid_and_key(key), it->second);
+    }
+    ASSERT_EQ(it, expected.begin());
+
+    // col1 = a：下界为(a, 全0)，上界为(a, 全0xff)
+    for (int a = -21; a <= 21; a++) {
+        std::string lower(12, '\0'), upper(12, '\xff');
+        memcpy(lower.data(), &a, sizeof(int));
+        memcpy(upper.data(), &a, sizeof(int));
+        size_t count = 0;
+        for (IxScan scan(ih.get(), ih->lower_bound(lower.data()), ih->upper_bound(upper.data()),
+                         buffer_pool_manager_.get());
+             !scan.is_end(); scan.next()) {
+            scan.rid_and_key(key);
+            ASSERT_EQ(*reinterpret_cast<int *>(key), a);
+            count++;
+        }
+        auto first = expected.lower_bound({a, std::string()});
+        auto last = expected.lower_bound({a + 1, std::string()});
+        ASSERT_EQ(count, static_cast<size_t>(std::distance(first, last)));
+    }
+    ix_manager_->close_index(ih.get());
+    ix_manager_->destroy_index(table_name, cols);
+}
@@ -0,0 +1,103 @@
+#include "index/ix_index_handle.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 在有序的键数组上逐一检查ix_search_typed与std::lower_bound/std::upper_bound的结果一致
+ */
+template <typename T>
+static void check_search(const std::vector<T> &keys, const std::vector<T> &targets) {
+    const char *base = reinterpret_cast<const char *>(keys.data());
+    int n = keys.size();
+    for (T target : targets) {
+        const char *t = reinterpret_cast<const char *>(&target);
+        int lower = std::lower_bound(keys.begin(), keys.end(), target) - keys.begin();
+        int upper = std::upper_bound(keys.begin(), keys.end(), target) - keys.begin();
+        ASSERT_EQ((ix_search_typed<T, false>(base, 0, n, t)), lower);
+        ASSERT_EQ((ix_search_typed<T, true>(base, 0, n, t)), upper);
+        // 内部结点的upper_bound从1开始查找
+        if (n > 1) {
+            ASSERT_EQ((ix_search_typed<T, true>(base, 1, n, t)), std::max(upper, 1));
+        }
+    }
+}
+
+/**
+ * @brief 不同结点大小、含重复键的INT/FLOAT结点中，无分支二分查找的结果与标准库一致
+ */
+TEST(IxSearchTest, TypedSearchTest) {
+    std::mt19937 rng(7);
+    for (int n : {1, 2, 3, 7, 8, 64, 255, 300, 509}) {
+        std::uniform_int_distribution<int> dist(-n, n);
+        std::vector<int> int_keys(n);
+        for (auto &key : int_keys) {
+            key = dist(rng);
+        }
+        std::sort(int_keys.begin(), int_keys.end());
+        std::vector<int> int_targets;
+        for (int i = -n - 2; i <= n + 2; i++) {
+            int_targets.push_back(i);
+        }
+        check_search(int_keys, int_targets);
+
+        std::vector<float> float_keys(n);
+        for (int i = 0; i < n; i++) {
+            float_keys[i] = int_keys[i] * 0.5f;
+        }
+        std::vector<float> float_targets;
+        for (int target : int_targets) {
+            float_targets.push_back(target * 0.5f);
+            float_targets.push_back(target * 0.5f + 0.25f);
+        }
+        check_search(float_keys, float_targets);
+    }
+}
+
+/**
+ * @brief 规范化后的INT/FLOAT/STRING组合key用memcmp比较的结果与逐字段ix_compare一致，且可以还原
+ */
+TEST(IxSearchTest, NormalizedKeyTest) {
+    std::vector<ColType> col_types = {TYPE_INT, TYPE_FLOAT, TYPE_STRING};
+    std::vector<int> col_lens = {sizeof(int), sizeof(float), 4};
+    const int key_len = 12;
+    std::mt19937 rng(11);
+    std::vector<int> ints = {0, 1, -1, 7, -7, std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+    std::vector<float> floats = {0.0f, -0.0f, 1.5f, -1.5f, 1e-30f, -1e-30f, 3e30f, -3e30f,
+                                 std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+    std::vector<std::string> strs = {std::string("\0\0\0\0", 4), "a\0\0\0", "ab\0\0", "b\0\0\0", "\xff\xff\xff\xff"};
+    std::vector<std::vector<char>> keys;
+    for (int i : ints) {
+        for (float f : floats) {
+            for (auto &str : strs) {
+                std::vector<char> key(key_len);
+                memcpy(key.data(), &i, sizeof(int));
+                memcpy(key.data() + 4, &f, sizeof(float));
+                memcpy(key.data() + 8, str.data(), 4);
+                keys.push_back(key);
+            }
+        }
+    }
+    std::vector<std::vector<char>> normalized(keys.size(), std::vector<char>(key_len));
+    for (size_t i = 0; i < keys.size(); i++) {
+        ix_normalize_key(keys[i].data(), normalized[i].data(), col_types, col_lens);
+        std::vector<char> restored(key_len);
+        ix_denormalize_key(normalized[i].data(), restored.data(), col_types, col_lens);
+        // -0.0规范化后与0.0相同，按值比较
+        ASSERT_EQ(ix_compare(restored.data(), keys[i].data(), col_types, col_lens), 0);
+    }
+    auto sign = [](int x) { return (x > 0) - (x < 0); };
+    for (size_t i = 0; i < keys.size(); i++) {
+        size_t j = rng() % keys.size();
+        ASSERT_EQ(sign(memcmp(normalized[i].data(), normalized[j].data(), key_len)),
+                  sign(ix_compare(keys[i].data(), keys[j].data(), col_types, col_lens)));
+        for (size_t k = 0; k < keys.size(); k += 17) {
+            ASSERT_EQ(sign(memcmp(normalized[i].data(), normalized[k].data(), key_len)),
+                      sign(ix_compare(keys[i].data(), keys[k].data(), col_types, col_lens)));
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/ix.h"
+
+// 按(page_no, slot_no)排序，便于比较同一个key的rid集合
+inline std::vector<std::pair<int, int>> sorted_rids(const std::vector<Rid> &rids) {
+    std::vector<std::pair<int, int>> result;
+    for (auto &rid : rids) {
+        result.emplace_back(rid.page_no, rid.slot_no);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// 索引测试的公共部分：创建磁盘管理器、缓冲池和索引管理器，删除上次测试残留的索引文件，测试结束后删除索引文件
+class IxTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    Transaction txn_{0};
+
+    IxTest(std::string table_name, std::vector<ColMeta> cols)
+        : table_name_(std::move(table_name)), cols_(std::move(cols)) {}
+
+    void SetUp() override {
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        if (ix_manager_->exists(table_name_, cols_)) {
+            ix_manager_->destroy_index(table_name_, cols_);
+        }
+    }
+
+    void TearDown() override { ix_manager_->destroy_index(table_name_, cols_); }
+
+   protected:
+    std::string table_name_;
+    std::vector<ColMeta> cols_;
+};
+
+// 每个测试使用一个新建的B+树索引ih_，unique为false时为非唯一索引
+class IxTreeTest : public IxTest {
+   public:
+    std::unique_ptr<IxIndexHandle> ih_;
+
+    IxTreeTest(std::string table_name, std::vector<ColMeta> cols, bool unique = true)
+        : IxTest(std::move(table_name), std::move(cols)), unique_(unique) {}
+
+    void SetUp() override {
+        IxTest::SetUp();
+        ix_manager_->create_index(table_name_, cols_, unique_);
+        ih_ = ix_manager_->open_index(table_name_, cols_);
+    }
+
+    void TearDown() override {
+        ix_manager_->close_index(ih_.get());
+        IxTest::TearDown();
+    }
+
+   private:
+    bool unique_;
+};
+
+// 每个测试使用一个新建的哈希索引ih_
+class IxHashTest : public IxTest {
+   public:
+    std::unique_ptr<IxHashIndexHandle> ih_;
+
+    using IxTest::IxTest;
+
+    void SetUp() override {
+        IxTest::SetUp();
+        ix_manager_->create_hash_index(table_name_, cols_);
+        ih_ = ix_manager_->open_hash_index(table_name_, cols_);
+    }
+
+    void TearDown() override {
+        ix_manager_->close_hash_index(ih_.get());
+        IxTest::TearDown();
+    }
+};
@@ -0,0 +1,109 @@
+-- 测试点10：索引范围扫描。记录按id降序插入，表数据页面的顺序与索引key的顺序相反
+create table item (id int, price int);
+insert into item values (100, 1000);
+insert into item values (99, 990);
+insert into item values (98, 980);
+insert into item values (97, 970);
+insert into item values (96, 960);
+insert into item values (95, 950);
+insert into item values (94, 940);
+insert into item values (93, 930);
+insert into item values (92, 920);
+insert into item values (91, 910);
+insert into item values (90, 900);
+insert into item values (89, 890);
+insert into item values (88, 880);
+insert into item values (87, 870);
+insert into item values (86, 860);
+insert into item values (85, 850);
+insert into item values (84, 840);
+insert into item values (83, 830);
+insert into item values (82, 820);
+insert into item values (81, 810);
+insert into item values (80, 800);
+insert into item values (79, 790);
+insert into item values (78, 780);
+insert into item values (77, 770);
+insert into item values (76, 760);
+insert into item values (75, 750);
+insert into item values (74, 740);
+insert into item values (73, 730);
+insert into item values (72, 720);
+insert into item values (71, 710);
+insert into item values (70, 700);
+insert into item values (69, 690);
+insert into item values (68, 680);
+insert into item values (67, 670);
+insert into item values (66, 660);
+insert into item values (65, 650);
+insert into item values (64, 640);
+insert into item values (63, 630);
+insert into item values (62, 620);
+insert into item values (61, 610);
+insert into item values (60, 600);
+insert into item values (59, 590);
+insert into item values (58, 580);
+insert into item values (57, 570);
+insert into item values (56, 560);
+insert into item values (55, 550);
+insert into item values (54, 540);
+insert into item values (53, 530);
+insert into item values (52, 520);
+insert into item values (51, 510);
+insert into item values (50, 500);
+insert into item values (49, 490);
+insert into item values (48, 480);
+insert into item values (47, 470);
+insert into item values (46, 460);
+insert into item values (45, 450);
+insert into item values (44, 440);
+insert into item values (43, 430);
+insert into item values (42, 420);
+insert into item values (41, 410);
+insert into item values (40, 400);
+insert into item values (39, 390);
+insert into item values (38, 380);
+insert into item values (37, 370);
+insert into item values (36, 360);
+insert into item values (35, 350);
+insert into item values (34, 340);
+insert into item values (33, 330);
+insert into item values (32, 320);
+insert into item values (31, 310);
+insert into item values (30, 300);
+insert into item values (29, 290);
+insert into item values (28, 280);
+insert into item values (27, 270);
+insert into item values (26, 260);
+insert into item values (25, 250);
+insert into item values (24, 240);
+insert into item values (23, 230);
+insert into item values (22, 220);
+insert into item values (21, 210);
+insert into item values (20, 200);
+insert into item values (19, 190);
+insert into item values (18, 180);
+insert into item values (17, 170);
+insert into item values (16, 160);
+insert into item values (15, 150);
+insert into item values (14, 140);
+insert into item values (13, 130);
+insert into item values (12, 120);
+insert into item values (11, 110);
+insert into item values (10, 100);
+insert into item values (9, 90);
+insert into item values (8, 80);
+insert into item values (7, 70);
+insert into item values (6, 60);
+insert into item values (5, 50);
+insert into item values (4, 40);
+insert into item values (3, 30);
+insert into item values (2, 20);
+insert into item values (1, 10);
+create index item(id);
+select * from item where id > 90;
+select * from item where id > 10 and id <= 20;
+select * from item where id > 10 limit 3;
+select * from item where id >= 50 limit 2 offset 5;
+select price from item where id < 80 and price >= 700;
+select * from item where id > 95 and id < 96;
@@ -0,0 +1,23 @@
+-- 测试点6：删除后向同一张表插入，删除的空间和索引项被正确回收
+create table student (id int, name char(9), score float);
+create index student(id);
+insert into student values (1, 'TomTomTom', 90.0);
+insert into student values (2, 'JerryJerr', 85.5);
+insert into student values (3, 'JackJackJ', 70.0);
+insert into student values (4, 'LucyLucyL', 60.25);
+insert into student values (5, 'MaryMaryM', 99.0);
+delete from student where id < 3;
+insert into student values (1, 'AliceAlic', 88.0);
+insert into student values (6, 'BobBobBob', 77.5);
+select * from student;
+select name from student where id = 1;
+select name from student where id = 2;
+delete from student where score > 75.0;
+insert into student values (2, 'CarolCaro', 66.0);
+insert into student values (5, 'DaveDaveD', 55.0);
+select * from student;
+select id, name from student where id >= 2;
+delete from student;
+insert into student values (7, 'EveEveEve', 10.0);
+select * from student;
+select name from student where id = 7;
@@ -0,0 +1,14 @@
+-- 测试点7：分组聚合，SUM(int)超出int的范围时报错
+create table grade (course char(8), student_id int, score int);
+insert into grade values ('Data', 1, 90);
+insert into grade values ('Data', 2, 60);
+insert into grade values ('Calc', 1, 82);
+insert into grade values ('Calc', 2, 71);
+insert into grade values ('Calc', 3, 99);
+insert into grade values ('Algo', 3, 2000000000);
+insert into grade values ('Algo', 4, 2000000000);
+select course, COUNT(*), SUM(score), MIN(score), MAX(score) from grade where score < 100 group by course;
+select COUNT(*), MIN(student_id), MAX(student_id) from grade;
+select course, AVG(student_id) from grade group by course order by course;
+select course, SUM(score) from grade group by course;
+select SUM(student_id) from grade where score > 1000;
@@ -0,0 +1,19 @@
+-- 测试点8：多个排序键的ORDER BY，升序和降序混合
+create table grade (course char(8), student_id int, score float);
+create table student (id int, name char(8));
+insert into grade values ('Data', 1, 90.0);
+insert into grade values ('Data', 2, 60.5);
+insert into grade values ('Calc', 1, 82.0);
+insert into grade values ('Calc', 2, 90.0);
+insert into grade values ('Calc', 3, 99.0);
+insert into grade values ('Algo', 3, 60.5);
+insert into grade values ('Algo', 1, -5.0);
+insert into student values (1, 'Tom');
+insert into student values (2, 'Jerry');
+insert into student values (3, 'Jack');
+select * from grade order by course, score desc;
+select * from grade order by score desc, student_id asc;
+select course, score from grade where score > 60.0 order by score, course desc;
+create index grade(student_id);
+select * from grade order by student_id desc, course;
+select name, course, score from student, grade where student.id = grade.student_id order by name, score desc;
@@ -0,0 +1,20 @@
+-- 测试点9：LIMIT和OFFSET，与ORDER BY和索引顺序扫描配合
+create table grade (course char(8), student_id int, score float);
+insert into grade values ('Data', 1, 90.0);
+insert into grade values ('Data', 2, 60.5);
+insert into grade values ('Calc', 1, 82.0);
+insert into grade values ('Calc', 2, 91.0);
+insert into grade values ('Calc', 3, 99.0);
+insert into grade values ('Algo', 3, 70.5);
+insert into grade values ('Algo', 1, -5.0);
+insert into grade values ('Math', 4, 88.0);
+select * from grade order by score desc limit 3;
+select * from grade order by score limit 2 offset 1;
+select course, score from grade order by course desc, score limit 4 offset 2;
+select * from grade order by score limit 5 offset 10;
+select * from grade order by score limit 0;
+select * from grade where score > 80.0 order by student_id, score desc limit 2;
+create index grade(student_id, score);
+select * from grade order by student_id limit 3;
+select * from grade order by student_id desc, score desc limit 2 offset 1;
+select student_id, score from grade where student_id >= 2 order by student_id limit 2;
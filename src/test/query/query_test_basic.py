@@ -1,8 +1,8 @@
 import os;
 import time;
 # test : basic_query
-NUM_TESTS = 5
-SCORES = [25, 15, 15, 15, 30]
+NUM_TESTS = 10
+SCORES = [25, 15, 15, 15, 30, 10, 10, 10, 10, 10]
 
 # current dir is root/build
 def get_test_name(index):
@@ -2,8 +2,8 @@ import os;
 import time;
 import sys;
 # test : basic_query
-NUM_TESTS = 5
-SCORES = [25, 15, 15, 15, 30]
+NUM_TESTS = 10
+SCORES = [25, 15, 15, 15, 30, 10, 10, 10, 10, 10]
 
 # current dir is root/build
 def get_test_name(index):
@@ -0,0 +1,58 @@
+#include "record/bitmap.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 逐位查找，作为按字扫描的对照
+ */
+static int naive_next_bit(bool bit, const char *bm, int max_n, int curr) {
+    for (int i = curr + 1; i < max_n; i++) {
+        if (Bitmap::is_set(bm, i) == bit) {
+            return i;
+        }
+    }
+    return max_n;
+}
+
+/**
+ * @brief 不同长度、不同密度的位图上，next_bit/count/for_each_set_bit与逐位的结果一致；
+ * 长度覆盖不足一个字节、不足一个字以及超过一个AVX2块的情况，稀疏和稠密的位图会走到整块跳过的路径
+ */
+TEST(BitmapTest, WordScanTest) {
+    std::mt19937 rng(42);
+    for (int max_n : {1, 7, 8, 63, 64, 65, 200, 255, 256, 257, 1000, 3640}) {
+        for (double density : {0.0, 0.002, 0.5, 0.998, 1.0}) {
+            int num_bytes = (max_n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+            // 位图之后的字节填充为1，检查不会越过max_n
+            std::vector<char> buf(num_bytes + BITMAP_AVX2_BYTES, static_cast<char>(0xff));
+            char *bm = buf.data();
+            Bitmap::init(bm, num_bytes);
+            std::bernoulli_distribution dist(density);
+            std::vector<int> set_bits;
+            for (int i = 0; i < max_n; i++) {
+                if (dist(rng)) {
+                    Bitmap::set(bm, i);
+                    set_bits.push_back(i);
+                }
+            }
+            // 最后一个字节中max_n之后的位取随机值
+            for (int i = max_n; i < num_bytes * BITMAP_WIDTH; i++) {
+                rng() % 2 ? Bitmap::set(bm, i) : Bitmap::reset(bm, i);
+            }
+
+            for (bool bit : {false, true}) {
+                for (int curr = -1; curr < max_n; curr++) {
+                    ASSERT_EQ(naive_next_bit(bit, bm, max_n, curr), Bitmap::next_bit(bit, bm, max_n, curr))
+                        << "max_n=" << max_n << " density=" << density << " bit=" << bit << " curr=" << curr;
+                }
+            }
+            EXPECT_EQ(static_cast<int>(set_bits.size()), Bitmap::count(bm, max_n));
+            std::vector<int> visited;
+            Bitmap::for_each_set_bit(bm, max_n, [&](int pos) { visited.push_back(pos); });
+            EXPECT_EQ(set_bits, visited);
+        }
+    }
+}
@@ -177,6 +177,255 @@ TEST_F(BufferPoolManagerTest, LargeScaleTest) {
     disk_manager_->close_file(fd);
 }
 
+/**
+ * @brief 测试BULK_READ访问策略：批量读取只在私有的ring buffer中循环使用帧，不会淘汰已缓存的热点页面
+ * @note 生成测试文件bulk_read_test
+ */
+TEST_F(BufferPoolManagerTest, BulkReadStrategyTest) {
+    const std::string filename = "bulk_read_test";
+    const size_t buffer_pool_size = 2048;
+    const int hot_pages = 256;
+    const int total_pages = 4 * buffer_pool_size;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    // write every page to disk with its page_no as content
+    for (int i = 0; i < total_pages; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        Page *page = bpm->new_page(&page_id);
+        ASSERT_NE(nullptr, page);
+        ASSERT_EQ(i, page_id.page_no);
+        strcpy(page->get_data(), std::to_string(i).c_str());
+        EXPECT_EQ(true, bpm->unpin_page(page_id, true));
+    }
+    bpm->flush_all_pages(fd);
+
+    // warm up the hot pages, then modify them in memory only
+    for (int i = 0; i < hot_pages; i++) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        strcpy(page->get_data(), ("hot" + std::to_string(i)).c_str());
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, i}, false));
+    }
+
+    // bulk read all the other pages through a ring buffer
+    auto strategy = bpm->get_access_strategy(BufferAccessType::BULK_READ);
+    ASSERT_NE(nullptr, strategy);
+    for (int i = hot_pages; i < total_pages; i++) {
+        Page *page = bpm->fetch_page(PageId{fd, i}, strategy.get());
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, strcmp(page->get_data(), std::to_string(i).c_str()));
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, i}, false));
+    }
+
+    // the hot pages were never evicted, so their in-memory content is still there
+    for (int i = 0; i < hot_pages; i++) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, strcmp(page->get_data(), ("hot" + std::to_string(i)).c_str()));
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, i}, false));
+    }
+    EXPECT_EQ(nullptr, bpm->get_access_strategy(BufferAccessType::NORMAL));
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试后台刷盘线程：脏页达到年龄后被写回磁盘，被固定的页面不会被写回
+ * @note 生成测试文件flusher_test
+ */
+TEST_F(BufferPoolManagerTest, FlusherTest) {
+    const std::string filename = "flusher_test";
+    const size_t buffer_pool_size = 64;
+    const int num_pages = 32;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    for (int i = 0; i < num_pages; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        Page *page = bpm->new_page(&page_id);
+        ASSERT_NE(nullptr, page);
+        strcpy(page->get_data(), std::to_string(i).c_str());
+        // keep page 0 pinned
+        if (i != 0) {
+            EXPECT_EQ(true, bpm->unpin_page(page_id, true));
+        }
+    }
+
+    bpm->start_flusher(std::chrono::milliseconds(10), std::chrono::milliseconds(20));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    bpm->stop_flusher();
+
+    char buf[PAGE_SIZE] = {0};
+    for (int i = 1; i < num_pages; i++) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(false, page->is_dirty());
+        disk_manager_->read_page(fd, i, buf, PAGE_SIZE);
+        EXPECT_EQ(0, strcmp(buf, std::to_string(i).c_str()));
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, i}, false));
+    }
+    Page *page0 = bpm->fetch_page(PageId{fd, 0});
+    EXPECT_EQ(true, page0->is_dirty());
+    EXPECT_EQ(true, bpm->unpin_page(PageId{fd, 0}, false));
+    EXPECT_EQ(true, bpm->unpin_page(PageId{fd, 0}, false));
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->read_page(fd, 0, buf, PAGE_SIZE);
+    EXPECT_EQ(0, strcmp(buf, "0"));
+    EXPECT_EQ(false, page0->is_dirty());
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试前台线程不得不自己写回脏页时立即唤醒后台刷盘线程，而不是等到下一个刷盘间隔
+ * @note 生成测试文件flusher_wakeup_test
+ */
+TEST_F(BufferPoolManagerTest, FlusherWakeupTest) {
+    const std::string filename = "flusher_wakeup_test";
+    const size_t buffer_pool_size = 32;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        Page *page = bpm->new_page(&page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(true, bpm->unpin_page(page_id, true));
+    }
+
+    // the interval and the dirty age are far longer than the test
+    bpm->start_flusher(std::chrono::hours(1), std::chrono::hours(1));
+    // every frame is dirty, so this evicts by writing a dirty page in the foreground
+    PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    ASSERT_NE(nullptr, bpm->new_page(&page_id));
+    EXPECT_EQ(true, bpm->unpin_page(page_id, true));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    bpm->stop_flusher();
+
+    int clean = 0;
+    for (int i = 1; i <= static_cast<int>(buffer_pool_size); i++) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        clean += !page->is_dirty();
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, i}, false));
+    }
+    EXPECT_GT(clean, 0);
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试预读：预读的页面无需再次读盘即可命中，读入失败（越过文件末尾）的预读帧被回收
+ * @note 生成测试文件prefetch_test
+ */
+TEST_F(BufferPoolManagerTest, PrefetchTest) {
+    const std::string filename = "prefetch_test";
+    const size_t buffer_pool_size = 64;
+    const int num_pages = 48;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    char buf[PAGE_SIZE] = {0};
+    for (int i = 0; i < num_pages; i++) {
+        strcpy(buf, std::to_string(i).c_str());
+        disk_manager_->write_page(fd, i, buf, PAGE_SIZE);
+    }
+
+    // 分别在调用者线程中和后台预读线程中读入
+    for (bool background : {false, true}) {
+        auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager);
+        if (background) {
+            bpm->start_prefetcher();
+        }
+        bpm->prefetch(PageId{fd, 0}, num_pages);
+        // 预读越过文件末尾的页面，读入失败后帧应回到空闲链表
+        bpm->prefetch(PageId{fd, num_pages}, buffer_pool_size - num_pages);
+        if (background) {
+            bpm->stop_prefetcher();
+        }
+
+        // 修改磁盘上的数据，命中预读页面的fetch_page不应读到新数据
+        for (int i = 0; i < num_pages; i++) {
+            strcpy(buf, "overwritten");
+            disk_manager_->write_page(fd, i, buf, PAGE_SIZE);
+        }
+        for (int i = 0; i < num_pages; i++) {
+            Page *page = bpm->fetch_page(PageId{fd, i});
+            ASSERT_NE(nullptr, page);
+            EXPECT_EQ(0, strcmp(page->get_data(), std::to_string(i).c_str()));
+        }
+        // 剩余的帧仍然可用
+        for (int i = num_pages; i < static_cast<int>(buffer_pool_size); i++) {
+            PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+            disk_manager_->set_fd2pageno(fd, i);
+            EXPECT_NE(nullptr, bpm->new_page(&page_id));
+        }
+        for (int i = 0; i < num_pages; i++) {
+            strcpy(buf, std::to_string(i).c_str());
+            disk_manager_->write_page(fd, i, buf, PAGE_SIZE);
+        }
+    }
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 页面句柄测试：句柄离开作用域时取消固定，移动句柄转移固定，写句柄修改过的页面换出时写回磁盘
+ */
+TEST_F(BufferPoolManagerTest, PageGuardTest) {
+    const std::string filename = "page_guard_test";
+    const size_t buffer_pool_size = 4;
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager_.get());
+
+    // 1. 写句柄离开作用域后页面被取消固定，并作为脏页写回
+    PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    {
+        WritePageGuard guard = bpm->new_page_guarded(&page_id);
+        ASSERT_TRUE(static_cast<bool>(guard));
+        strcpy(guard.get_data(), "guarded");
+    }
+    EXPECT_FALSE(bpm->unpin_page(page_id, false));
+
+    // 2. 移动后只有新句柄持有固定，缓冲池被占满时无法再分配页面
+    std::vector<WritePageGuard> guards;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        PageId tmp_page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        WritePageGuard guard = bpm->new_page_guarded(&tmp_page_id);
+        ASSERT_TRUE(static_cast<bool>(guard));
+        guards.push_back(std::move(guard));
+        EXPECT_FALSE(static_cast<bool>(guard));
+    }
+    PageId full_page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    EXPECT_FALSE(static_cast<bool>(bpm->new_page_guarded(&full_page_id)));
+    guards.back().release();
+    EXPECT_FALSE(static_cast<bool>(guards.back()));
+    EXPECT_TRUE(static_cast<bool>(bpm->new_page_guarded(&full_page_id)));
+    guards.clear();
+
+    // 3. 第一个页面已被换出，重新读入时应读到写句柄写入的数据
+    char buf[PAGE_SIZE] = {0};
+    disk_manager_->read_page(fd, page_id.page_no, buf, PAGE_SIZE);
+    EXPECT_EQ(0, strcmp(buf, "guarded"));
+    ReadPageGuard read_guard = bpm->fetch_page_read(page_id);
+    ASSERT_TRUE(static_cast<bool>(read_guard));
+    EXPECT_EQ(0, strcmp(read_guard.get_data(), "guarded"));
+    read_guard.release();
+    EXPECT_FALSE(bpm->unpin_page(page_id, false));
+
+    disk_manager_->close_file(fd);
+}
+
 /**
  * @brief 多文件测试
  * @note 生成若干测试文件multiple_files_test_*
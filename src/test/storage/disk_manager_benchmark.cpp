@@ -0,0 +1,143 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+// 比较页面I/O路径的吞吐：lseek+read/write（原实现）、逐页pread/pwrite、批量pread/pwrite以及批量io_uring
+// 用法: disk_manager_benchmark [页面数] [批大小]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "storage/disk_manager.h"
+
+const std::string BENCH_FILE_NAME = "DiskManagerBenchmarkFile";
+
+static void lseek_read_page(int fd, page_id_t page_no, char *buf) {
+    lseek(fd, static_cast<off_t>(page_no) * PAGE_SIZE, SEEK_SET);
+    if (read(fd, buf, PAGE_SIZE) != PAGE_SIZE) {
+        throw InternalError("lseek_read_page Error");
+    }
+}
+
+static void lseek_write_page(int fd, page_id_t page_no, const char *buf) {
+    lseek(fd, static_cast<off_t>(page_no) * PAGE_SIZE, SEEK_SET);
+    if (write(fd, buf, PAGE_SIZE) != PAGE_SIZE) {
+        throw InternalError("lseek_write_page Error");
+    }
+}
+
+/**
+ * @description: 按给定页号顺序执行一轮I/O，每batch_size个页面调用一次do_batch，返回耗时（秒）
+ */
+static double run_round(const std::vector<page_id_t> &page_nos, size_t batch_size,
+                        const std::function<void(const page_id_t *, size_t)> &do_batch) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < page_nos.size(); i += batch_size) {
+        do_batch(page_nos.data() + i, std::min(batch_size, page_nos.size() - i));
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const std::string &name, size_t pages, double seconds) {
+    double mb = static_cast<double>(pages) * PAGE_SIZE / (1024 * 1024);
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << mb / seconds << " MB/s" << std::setw(10) << std::setprecision(2)
+              << seconds * 1e6 / pages << " us/page" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    int num_pages = argc > 1 ? std::stoi(argv[1]) : 16384;
+    size_t batch_size = argc > 2 ? std::stoul(argv[2]) : FLUSHER_BATCH_SIZE;
+
+    DiskManager disk_manager;
+    if (disk_manager.is_file(BENCH_FILE_NAME)) {
+        disk_manager.destroy_file(BENCH_FILE_NAME);
+    }
+    disk_manager.create_file(BENCH_FILE_NAME);
+    int fd = disk_manager.open_file(BENCH_FILE_NAME);
+
+    std::vector<std::vector<char>> bufs(batch_size, std::vector<char>(PAGE_SIZE, 'x'));
+    std::vector<page_id_t> sequential(num_pages);
+    for (int i = 0; i < num_pages; i++) {
+        sequential[i] = i;
+    }
+    std::vector<page_id_t> random = sequential;
+    std::shuffle(random.begin(), random.end(), std::mt19937(42));
+
+    // 先写满文件，使后续的读请求不会越过文件末尾
+    for (int i = 0; i < num_pages; i++) {
+        disk_manager.write_page(fd, i, bufs[0].data(), PAGE_SIZE);
+    }
+    fsync(fd);
+
+    auto lseek_path = [&](bool is_write) {
+        return [&, is_write](const page_id_t *page_nos, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                is_write ? lseek_write_page(fd, page_nos[i], bufs[i].data())
+                         : lseek_read_page(fd, page_nos[i], bufs[i].data());
+            }
+        };
+    };
+    auto pread_path = [&](bool is_write) {
+        return [&, is_write](const page_id_t *page_nos, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                is_write ? disk_manager.write_page(fd, page_nos[i], bufs[i].data(), PAGE_SIZE)
+                         : disk_manager.read_page(fd, page_nos[i], bufs[i].data(), PAGE_SIZE);
+            }
+        };
+    };
+    std::vector<PageIoRequest> requests;
+    auto batch_path = [&](bool is_write) {
+        return [&, is_write](const page_id_t *page_nos, size_t n) {
+            requests.clear();
+            for (size_t i = 0; i < n; i++) {
+                requests.push_back({fd, page_nos[i], bufs[i].data()});
+            }
+            is_write ? disk_manager.write_pages_batch(requests) : disk_manager.read_pages_batch(requests);
+            for (auto &request : requests) {
+                if (!request.ok()) {
+                    throw InternalError("batch page io Error");
+                }
+            }
+        };
+    };
+
+    std::vector<std::string> backends = {"pread"};
+    if (IoUringContext::is_supported()) {
+        backends.push_back("io_uring");
+    } else {
+        std::cout << "io_uring is not supported, skip io_uring rounds" << std::endl;
+    }
+
+    std::cout << num_pages << " pages, batch size " << batch_size << std::endl;
+    for (auto &pattern : {std::make_pair(std::string("sequential"), &sequential),
+                          std::make_pair(std::string("random"), &random)}) {
+        for (bool is_write : {false, true}) {
+            std::string op = pattern.first + (is_write ? " write" : " read");
+            std::cout << "-- " << op << std::endl;
+            report("lseek+read/write", num_pages, run_round(*pattern.second, batch_size, lseek_path(is_write)));
+            report("pread/pwrite", num_pages, run_round(*pattern.second, batch_size, pread_path(is_write)));
+            for (auto &backend : backends) {
+                disk_manager.set_io_backend(backend);
+                report("batch " + backend, num_pages, run_round(*pattern.second, batch_size, batch_path(is_write)));
+            }
+            disk_manager.set_io_backend("pread");
+        }
+    }
+
+    disk_manager.close_file(fd);
+    disk_manager.destroy_file(BENCH_FILE_NAME);
+    return 0;
+}
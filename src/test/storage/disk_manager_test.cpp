@@ -147,3 +147,56 @@ TEST_F(DiskManagerTest, PageOperation) {
     disk_manager_->destroy_file(filename);
     EXPECT_EQ(disk_manager_->is_file(filename), false);
 }
+
+/**
+ * @brief 测试批量读写页面 read_pages_batch/write_pages_batch，分别在pread和io_uring后端上测试
+ */
+TEST_F(DiskManagerTest, BatchPageOperation) {
+    const std::string filename = "BatchPageOperationTestFile";
+    std::vector<std::string> backends = {"pread"};
+    if (IoUringContext::is_supported()) {
+        backends.push_back("io_uring");
+    }
+    for (auto &backend : backends) {
+        if (disk_manager_->is_file(filename)) {
+            disk_manager_->destroy_file(filename);
+        }
+        disk_manager_->create_file(filename);
+        int fd = disk_manager_->open_file(filename);
+        disk_manager_->set_io_backend(backend);
+
+        // 写入的页号既有连续的区间也有空洞，请求数超过io_uring队列长度
+        std::vector<std::vector<char>> data(MAX_PAGES * 2, std::vector<char>(PAGE_SIZE));
+        std::vector<PageIoRequest> writes;
+        for (int page_no = 0; page_no < MAX_PAGES * 2; page_no++) {
+            if (page_no % 7 == 3) {
+                continue;
+            }
+            rand_buf(data[page_no].data(), PAGE_SIZE);
+            data[page_no][0] = static_cast<char>(page_no);
+            writes.push_back({fd, page_no, data[page_no].data()});
+        }
+        disk_manager_->write_pages_batch(writes);
+        for (auto &request : writes) {
+            EXPECT_TRUE(request.ok());
+        }
+
+        // 倒序读回，并读取一个超出文件末尾的页面
+        std::vector<std::vector<char>> bufs(writes.size() + 1, std::vector<char>(PAGE_SIZE));
+        std::vector<PageIoRequest> reads;
+        for (size_t i = 0; i < writes.size(); i++) {
+            reads.push_back({fd, writes[writes.size() - 1 - i].page_no, bufs[i].data()});
+        }
+        reads.push_back({fd, MAX_PAGES * 4, bufs.back().data()});
+        disk_manager_->read_pages_batch(reads);
+        for (size_t i = 0; i < writes.size(); i++) {
+            ASSERT_TRUE(reads[i].ok());
+            EXPECT_EQ(std::memcmp(bufs[i].data(), data[reads[i].page_no].data(), PAGE_SIZE), 0);
+        }
+        EXPECT_FALSE(reads.back().ok());
+
+        disk_manager_->set_io_backend("pread");
+        disk_manager_->close_file(fd);
+        disk_manager_->destroy_file(filename);
+    }
+}
@@ -223,4 +223,139 @@ TEST(RecordManagerTest, MultipleFilesTest) {
         std::string filename = filenames[i];
         rm_manager->destroy_file(filename);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 空闲空间映射测试：删除后的空间被插入复用，扫描跳过FSM页面，空页面可以被回收
+ */
+TEST(RecordManagerTest, FreeSpaceMapTest) {
+    char *result = new char[BUFFER_LENGTH];
+    int offset = 0;
+    auto lock_manager = std::make_unique<LockManager>();
+    auto txn = std::make_unique<Transaction>(0);
+    auto context = std::make_unique<Context>(lock_manager.get(), nullptr, txn.get(), result, &offset);
+
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string filename = "fsm_test.txt";
+    if (disk_manager->is_file(filename)) {
+        disk_manager->destroy_file(filename);
+    }
+    rm_manager->create_file(filename, RM_MAX_RECORD_SIZE);
+    auto file_handle = rm_manager->open_file(filename);
+    int records_per_page = file_handle->file_hdr_.num_records_per_page;
+    std::unordered_map<Rid, std::string, rid_hash_t, rid_equal_t> mock;
+    // 扫描得到的记录与mock一致
+    auto check = [&](const RmFileHandle *fh) {
+        size_t num_scanned = 0;
+        std::optional<RmPageHandle> page_handle;
+        for (RmScan scan(fh); !scan.is_end(); scan.next()) {
+            ASSERT_GT(mock.count(scan.rid()), 0);
+            auto rec = fh->get_record(scan.rid(), context.get());
+            ASSERT_EQ(0, memcmp(rec->data, mock.at(scan.rid()).c_str(), fh->file_hdr_.record_size));
+            // 视图直接指向页面中的记录，与物化的记录一致
+            TupleView view = fh->get_record_view(scan.rid(), page_handle, context.get());
+            ASSERT_EQ(view.size, rec->size);
+            ASSERT_EQ(view.data, page_handle->get_slot(scan.rid().slot_no));
+            ASSERT_EQ(0, memcmp(view.data, rec->data, rec->size));
+            num_scanned++;
+        }
+        ASSERT_EQ(num_scanned, mock.size());
+    };
+
+    // 1. 插入的记录跨过第二个FSM页面，FSM页面不存放记录
+    char write_buf[PAGE_SIZE];
+    int num_records = (RM_FSM_PAGE_SPAN + 8) * records_per_page;
+    for (int i = 0; i < num_records; i++) {
+        rand_buf(file_handle->file_hdr_.record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, context.get());
+        ASSERT_FALSE(RmFileHandle::is_fsm_page(rid.page_no));
+        mock[rid] = std::string(write_buf, file_handle->file_hdr_.record_size);
+    }
+    int num_pages = file_handle->file_hdr_.num_pages;
+    EXPECT_EQ(num_pages, 1 + 2 + RM_FSM_PAGE_SPAN + 8);
+    EXPECT_TRUE(RmFileHandle::is_fsm_page(RM_FIRST_RECORD_PAGE + RM_FSM_PAGE_SPAN + 1));
+
+    // 2. 删除前半部分页面中的记录后再插入同样多的记录，只复用空闲空间，文件不增长
+    std::vector<Rid> deleted;
+    for (auto &entry : mock) {
+        if (entry.first.page_no < num_pages / 2) {
+            deleted.push_back(entry.first);
+        }
+    }
+    for (auto &rid : deleted) {
+        file_handle->delete_record(rid, context.get());
+        mock.erase(rid);
+    }
+    for (size_t i = 0; i < deleted.size(); i++) {
+        rand_buf(file_handle->file_hdr_.record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, context.get());
+        EXPECT_LT(rid.page_no, num_pages / 2);
+        mock[rid] = std::string(write_buf, file_handle->file_hdr_.record_size);
+    }
+    EXPECT_EQ(file_handle->file_hdr_.num_pages, num_pages);
+    check(file_handle.get());
+
+    // 3. 删除后半部分页面中的记录，回收后文件末尾的空页面被截断，之后的插入继续复用空闲空间
+    deleted.clear();
+    for (auto &entry : mock) {
+        if (entry.first.page_no >= num_pages / 2) {
+            deleted.push_back(entry.first);
+        }
+    }
+    for (auto &rid : deleted) {
+        file_handle->delete_record(rid, context.get());
+        mock.erase(rid);
+    }
+    file_handle->reclaim_empty_pages();
+    EXPECT_EQ(file_handle->file_hdr_.num_pages, num_pages / 2);
+    EXPECT_EQ(disk_manager->get_file_size(filename), num_pages / 2 * PAGE_SIZE);
+    check(file_handle.get());
+
+    rm_manager->close_file(file_handle.get());
+    file_handle = rm_manager->open_file(filename);
+    for (int i = 0; i < records_per_page; i++) {
+        rand_buf(file_handle->file_hdr_.record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, context.get());
+        mock[rid] = std::string(write_buf, file_handle->file_hdr_.record_size);
+    }
+    EXPECT_EQ(file_handle->file_hdr_.num_pages, num_pages / 2 + 1);
+    check(file_handle.get());
+
+    rm_manager->close_file(file_handle.get());
+    rm_manager->destroy_file(filename);
+    delete[] result;
+}
+
+/**
+ * @brief 文件头的格式版本与当前不一致时拒绝打开
+ */
+TEST(RecordManagerTest, FileFormatVersionTest) {
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string filename = "format.txt";
+    if (disk_manager->is_file(filename)) {
+        disk_manager->destroy_file(filename);
+    }
+    rm_manager->create_file(filename, 16);
+    auto file_handle = rm_manager->open_file(filename);
+    EXPECT_EQ(file_handle->file_hdr_.magic, RM_FILE_MAGIC);
+    EXPECT_EQ(file_handle->file_hdr_.version, RM_FILE_VERSION);
+    rm_manager->close_file(file_handle.get());
+
+    // 改写文件头中的版本号，模拟旧格式的文件
+    int fd = disk_manager->open_file(filename);
+    RmFileHdr file_hdr;
+    disk_manager->read_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
+    file_hdr.version = RM_FILE_VERSION - 1;
+    disk_manager->write_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
+    disk_manager->close_file(fd);
+
+    EXPECT_THROW(rm_manager->open_file(filename), FileFormatError);
+    // 打开失败时文件已被关闭，可以直接删除
+    rm_manager->destroy_file(filename);
+}
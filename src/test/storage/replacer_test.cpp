@@ -0,0 +1,160 @@
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/two_q_replacer.h"
+
+/**
+ * @brief 测试ClockReplacer的second chance行为
+ */
+TEST(ClockReplacerTest, SimpleTest) {
+    ClockReplacer clock_replacer(7);
+
+    // Scenario: unpin six elements, i.e. add them to the replacer.
+    for (int i = 1; i <= 6; i++) {
+        clock_replacer.unpin(i);
+    }
+    clock_replacer.unpin(1);
+    EXPECT_EQ(6, clock_replacer.Size());
+
+    // Scenario: get three victims from the clock. All reference bits are set, so the first sweep clears them.
+    int value;
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(1, value);
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(2, value);
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(3, value);
+
+    // Scenario: pin elements in the replacer. 3 has already been victimized, so pinning 3 has no effect.
+    clock_replacer.pin(3);
+    clock_replacer.pin(4);
+    EXPECT_EQ(2, clock_replacer.Size());
+
+    // Scenario: unpin 4. Its reference bit is set again, so it gets a second chance.
+    clock_replacer.unpin(4);
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(5, value);
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(6, value);
+    EXPECT_TRUE(clock_replacer.victim(&value));
+    EXPECT_EQ(4, value);
+    EXPECT_FALSE(clock_replacer.victim(&value));
+    EXPECT_EQ(0, clock_replacer.Size());
+}
+
+/**
+ * @brief 模拟缓冲池的访问模式：pin表示一次访问，unpin表示访问结束
+ */
+template <typename ReplacerType>
+static void access(ReplacerType &replacer, frame_id_t frame_id) {
+    replacer.pin(frame_id);
+    replacer.unpin(frame_id);
+}
+
+/**
+ * @brief 测试LRUKReplacer：访问次数不足K次的帧先被淘汰，相关访问只记一次
+ */
+TEST(LRUKReplacerTest, SimpleTest) {
+    LRUKReplacer lru_k_replacer(8, 2);
+
+    // frame 0, 1 are accessed twice, frame 2, 3 only once
+    access(lru_k_replacer, 0);
+    access(lru_k_replacer, 1);
+    access(lru_k_replacer, 2);
+    access(lru_k_replacer, 0);
+    access(lru_k_replacer, 1);
+    access(lru_k_replacer, 3);
+    // repeated pins while frame 3 is pinned are correlated and count as one access
+    lru_k_replacer.pin(3);
+    lru_k_replacer.pin(3);
+    lru_k_replacer.unpin(3);
+    EXPECT_EQ(4, lru_k_replacer.Size());
+
+    int value;
+    // frames with +inf backward 2-distance first, ordered by their earliest access
+    EXPECT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(2, value);
+    // frame 3 now has two accesses, so frame 0 has the oldest 2nd most recent access
+    EXPECT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(0, value);
+
+    lru_k_replacer.pin(1);
+    EXPECT_EQ(1, lru_k_replacer.Size());
+    EXPECT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(3, value);
+    EXPECT_FALSE(lru_k_replacer.victim(&value));
+
+    // a removed frame forgets its history
+    lru_k_replacer.unpin(1);
+    lru_k_replacer.remove(1);
+    EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+/**
+ * @brief 测试TwoQReplacer：首次访问的帧在A1中FIFO淘汰，再次访问的帧晋升到Am
+ */
+TEST(TwoQReplacerTest, SimpleTest) {
+    TwoQReplacer two_q_replacer(8);  // A1 target size is 2
+
+    // frame 0, 1 are hot, frame 2..5 come from a sequential scan
+    access(two_q_replacer, 0);
+    access(two_q_replacer, 1);
+    access(two_q_replacer, 0);
+    access(two_q_replacer, 1);
+    for (int i = 2; i <= 5; i++) {
+        access(two_q_replacer, i);
+    }
+    EXPECT_EQ(6, two_q_replacer.Size());
+
+    int value;
+    // A1 is longer than its target size, scan frames are evicted first in FIFO order
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(2, value);
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(3, value);
+    // A1 is within its target size now, evict the least recently used frame of Am
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(0, value);
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(1, value);
+    // Am is empty, fall back to A1
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(4, value);
+    EXPECT_TRUE(two_q_replacer.victim(&value));
+    EXPECT_EQ(5, value);
+    EXPECT_FALSE(two_q_replacer.victim(&value));
+}
+
+/**
+ * @brief 一次性的顺序扫描不应淘汰被反复访问的热点帧
+ */
+TEST(ReplacerTest, ScanResistanceTest) {
+    const int num_frames = 64;
+    const int num_hot = 8;
+    std::vector<std::unique_ptr<Replacer>> replacers;
+    replacers.emplace_back(std::make_unique<LRUKReplacer>(num_frames));
+    replacers.emplace_back(std::make_unique<TwoQReplacer>(num_frames));
+    for (auto &replacer : replacers) {
+        for (int round = 0; round < 2; round++) {
+            for (int i = 0; i < num_hot; i++) {
+                replacer->pin(i);
+                replacer->unpin(i);
+            }
+        }
+        for (int i = num_hot; i < num_frames; i++) {
+            replacer->pin(i);
+            replacer->unpin(i);
+        }
+        // the scan goes on and keeps recycling its own frames
+        for (int i = 0; i < 4 * num_frames; i++) {
+            frame_id_t frame_id;
+            EXPECT_TRUE(replacer->victim(&frame_id));
+            EXPECT_GE(frame_id, num_hot);
+            replacer->pin(frame_id);
+            replacer->unpin(frame_id);
+        }
+    }
+}